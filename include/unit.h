@@ -40,44 +40,112 @@
 
 #ifndef UNIT_TESTING
 
+#include <stddef.h>
+#include <stdint.h>
+
 #define UNIT__NOOP (void)(0)
+// operands of disabled assertions are referenced in the unevaluated `sizeof`, so values computed only to be checked
+// and helpers called only from assertions are not reported as unused
+#define UNIT__REF(a) ((void) sizeof((void) (a), 0))
+#define UNIT__REF2(a, b) ((void) sizeof((void) (a), (void) (b), 0))
+#define UNIT__REF3(a, b, c) ((void) sizeof((void) (a), (void) (b), (void) (c), 0))
+// the index range is the dead loop, so the predicate can reference the index
+#define UNIT__REF_ALL(i, begin, end, x) do { if (0) for (intmax_t i = (begin); i < (end); ++i) (void) (x); } while (0)
 #define UNIT__CONCAT_(a, b) a ## b
 #define UNIT__CONCAT(a, b) UNIT__CONCAT_(a, b)
 #define UNIT_SUITE(Name, ...) __attribute__((unused)) static void UNIT__CONCAT(unit__, __COUNTER__)(void)
 #define UNIT_DESCRIBE(Name, ...) while(0)
 #define UNIT_TEST(Description, ...) while(0)
 
+// options are only type-checked, so functions referenced by them are not reported as unused
+struct unit__options {
+    int dummy__;
+    int failing;
+    int skip;
+    void (* before_all)(void);
+    void (* after_all)(void);
+    void (* before_each)(void);
+    void (* after_each)(void);
+    void (* row_name)(char* buf, size_t size, const void* row);
+};
+#define UNIT__OPTIONS_REF(...) ((void) sizeof((struct unit__options){ __VA_ARGS__ }), 0)
+
+// `Row` is declared for the body, the body is never run
+#ifdef __cplusplus
+#include <iterator>
+#define UNIT_TEST_EACH(Description, Rows, Row, ...) \
+    for (auto Row = std::begin(Rows); ((void) Row, UNIT__OPTIONS_REF(__VA_ARGS__));)
+#else
+#define UNIT_TEST_EACH(Description, Rows, Row, ...) \
+    for (__typeof__(&(Rows)[0]) Row = (Rows); ((void) Row, UNIT__OPTIONS_REF(__VA_ARGS__));)
+#endif
+
+#define UNIT_PROPERTY(Description, Cases, ...) while (UNIT__OPTIONS_REF(__VA_ARGS__))
+
 #define UNIT_ECHO(...) UNIT__NOOP
 
-#define UNIT_WARN(x, ...) UNIT__NOOP
-#define UNIT_WARN_FALSE(x, ...) UNIT__NOOP
-#define UNIT_WARN_EQ(a, b, ...) UNIT__NOOP
-#define UNIT_WARN_NE(a, b, ...) UNIT__NOOP
-#define UNIT_WARN_GT(a, b, ...) UNIT__NOOP
-#define UNIT_WARN_GE(a, b, ...) UNIT__NOOP
-#define UNIT_WARN_LT(a, b, ...) UNIT__NOOP
-#define UNIT_WARN_LE(a, b, ...) UNIT__NOOP
-
-#define UNIT_CHECK(x, ...) UNIT__NOOP
-#define UNIT_CHECK_FALSE(x, ...) UNIT__NOOP
-#define UNIT_CHECK_EQ(a, b, ...) UNIT__NOOP
-#define UNIT_CHECK_NE(a, b, ...) UNIT__NOOP
-#define UNIT_CHECK_GT(a, b, ...) UNIT__NOOP
-#define UNIT_CHECK_GE(a, b, ...) UNIT__NOOP
-#define UNIT_CHECK_LT(a, b, ...) UNIT__NOOP
-#define UNIT_CHECK_LE(a, b, ...) UNIT__NOOP
-
-#define UNIT_REQUIRE(x, ...) UNIT__NOOP
-#define UNIT_REQUIRE_FALSE(x, ...) UNIT__NOOP
-#define UNIT_REQUIRE_EQ(a, b, ...) UNIT__NOOP
-#define UNIT_REQUIRE_NE(a, b, ...) UNIT__NOOP
-#define UNIT_REQUIRE_GT(a, b, ...) UNIT__NOOP
-#define UNIT_REQUIRE_GE(a, b, ...) UNIT__NOOP
-#define UNIT_REQUIRE_LT(a, b, ...) UNIT__NOOP
-#define UNIT_REQUIRE_LE(a, b, ...) UNIT__NOOP
+#define UNIT_WARN(x, ...) UNIT__REF(x)
+#define UNIT_WARN_FALSE(x, ...) UNIT__REF(x)
+#define UNIT_WARN_EQ(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_WARN_NE(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_WARN_GT(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_WARN_GE(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_WARN_LT(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_WARN_LE(a, b, ...) UNIT__REF2(a, b)
+
+#define UNIT_CHECK(x, ...) UNIT__REF(x)
+#define UNIT_CHECK_FALSE(x, ...) UNIT__REF(x)
+#define UNIT_CHECK_EQ(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_CHECK_NE(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_CHECK_GT(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_CHECK_GE(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_CHECK_LT(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_CHECK_LE(a, b, ...) UNIT__REF2(a, b)
+
+#define UNIT_REQUIRE(x, ...) UNIT__REF(x)
+#define UNIT_REQUIRE_FALSE(x, ...) UNIT__REF(x)
+#define UNIT_REQUIRE_EQ(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_REQUIRE_NE(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_REQUIRE_GT(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_REQUIRE_GE(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_REQUIRE_LT(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_REQUIRE_LE(a, b, ...) UNIT__REF2(a, b)
+
+#define UNIT_WARN_MEM_EQ(a, b, n, ...) UNIT__REF3(a, b, n)
+#define UNIT_WARN_ARRAY_EQ(a, b, count, ...) UNIT__REF3(a, b, count)
+#define UNIT_CHECK_MEM_EQ(a, b, n, ...) UNIT__REF3(a, b, n)
+#define UNIT_CHECK_ARRAY_EQ(a, b, count, ...) UNIT__REF3(a, b, count)
+#define UNIT_REQUIRE_MEM_EQ(a, b, n, ...) UNIT__REF3(a, b, n)
+#define UNIT_REQUIRE_ARRAY_EQ(a, b, count, ...) UNIT__REF3(a, b, count)
+#define UNIT_WARN_ARRAY_NEAR(a, b, n, ...) UNIT__REF3(a, b, n)
+#define UNIT_CHECK_ARRAY_NEAR(a, b, n, ...) UNIT__REF3(a, b, n)
+#define UNIT_REQUIRE_ARRAY_NEAR(a, b, n, ...) UNIT__REF3(a, b, n)
+#define UNIT_WARN_ALL(i, begin, end, pred) UNIT__REF_ALL(i, begin, end, pred)
+#define UNIT_CHECK_ALL(i, begin, end, pred) UNIT__REF_ALL(i, begin, end, pred)
+#define UNIT_REQUIRE_ALL(i, begin, end, pred) UNIT__REF_ALL(i, begin, end, pred)
+#define UNIT_WARN_ALL_EQ(i, begin, end, a, b) UNIT__REF_ALL(i, begin, end, ((void) (a), (void) (b)))
+#define UNIT_CHECK_ALL_EQ(i, begin, end, a, b) UNIT__REF_ALL(i, begin, end, ((void) (a), (void) (b)))
+#define UNIT_REQUIRE_ALL_EQ(i, begin, end, a, b) UNIT__REF_ALL(i, begin, end, ((void) (a), (void) (b)))
+
+#define UNIT_FIXTURE(Name) __attribute__((unused)) static void Name(void)
+#define UNIT_BEFORE_ALL(Fixture) .before_all=(Fixture)
+#define UNIT_AFTER_ALL(Fixture) .after_all=(Fixture)
+#define UNIT_BEFORE_EACH(Fixture) .before_each=(Fixture)
+#define UNIT_AFTER_EACH(Fixture) .after_each=(Fixture)
+#define UNIT_ROW_NAME(Formatter) .row_name=(Formatter)
 
 #define UNIT_SKIP(...) UNIT__NOOP
 
+#define unit_scratch_alloc(size, align) ((void*)0)
+
+#define unit_gen_int(min, max) (min)
+#define unit_gen_uint(min, max) (min)
+#define unit_gen_double(min, max) (min)
+#define unit_gen_bytes(buf, size) UNIT__REF2(buf, size)
+#define unit_gen_len(max) ((size_t) 0)
+#define unit_gen_str(buf, size, alphabet) (UNIT__REF3(buf, size, alphabet), (size_t) 0)
+#define UNIT_GEN_ARRAY(Array, Capacity, Gen) ((void) sizeof((Array)[0] = (Gen)), (size_t) 0)
+
 #define unit_main(...) (0)
 
 
@@ -91,7 +159,20 @@
 #include <string.h>
 #include <time.h>
 
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+
+#include <setjmp.h>
+
+#define UNIT__HAS_CRASH_RECOVERY 1
+
+#endif // unix
+
 #ifdef __cplusplus
+// `std::begin` and `std::next` for the rows of `UNIT_TEST_EACH`
+#include <iterator>
+// signedness of operands for mixed comparisons
+#include <type_traits>
+
 extern "C" {
 #endif
 
@@ -137,6 +218,39 @@ struct unit__options {
     bool dummy__;
     bool failing;
     bool skip;
+
+    // fixtures for `SUITE` / `DESCRIBE` scope: once per scope, or once per each test in the scope
+    void (* before_all)(void);
+    void (* after_all)(void);
+    void (* before_each)(void);
+    void (* after_each)(void);
+
+    // names the row of `UNIT_TEST_EACH` in reports, the row index is used by default
+    void (* row_name)(char* buf, size_t size, const void* row);
+};
+
+// static description of the assertion call site
+struct unit__assert_site {
+    int level;
+    const char* file;
+    int line;
+    const char* comment;
+    const char* desc;
+};
+
+struct unit_resources {
+    // user and system CPU time in nanoseconds
+    int64_t user;
+    int64_t sys;
+    // resident set size and peak resident set size in bytes
+    int64_t rss;
+    int64_t max_rss;
+    // minor and major page faults
+    int64_t minflt;
+    int64_t majflt;
+    // voluntary and involuntary context switches
+    int64_t nvcsw;
+    int64_t nivcsw;
 };
 
 struct unit_test {
@@ -149,22 +263,46 @@ struct unit_test {
     int type;
     struct unit__options options;
 
-    double t0;
-    double elapsed;
+    // wall and thread CPU time in nanoseconds, printers work is excluded
+    int64_t t0;
+    int64_t elapsed;
+    int64_t cpu_t0;
+    int64_t cpu_elapsed;
+    int64_t excluded_t0;
+    // time spent in fixtures of this node, not included in `elapsed`
+    int64_t fixtures_elapsed;
+    // `before_all` fixture of this node failed, its children are skipped
+    bool fixture_failed;
+
+    // sampled only with `--resources` option: snapshot on begin, and usage delta on end
+    struct unit_resources res0;
+    struct unit_resources res;
+
+    // scratch arena top on begin, and high-water mark of scratch memory used by this node in bytes
+    size_t scratch_mark;
+    size_t scratch_peak;
 
     struct unit_test* next;
     struct unit_test* children;
+    // the last child, so children are appended in constant time
+    struct unit_test* children_last;
     struct unit_test* parent;
 
     int total;
     int passed;
+    // number of evaluated assertions, counted in `unit__hot` while the node is running
+    int64_t assertions;
 
     // test
     // status of current assertion
     int status;
-    // state for this test scope
+    // state for this test scope, kept in `unit__hot` while the node is running
     // позволять ли дальше работать другим проверкам в рамках этого теста
     int state;
+    // current assertion, fields below are expanded from it only for printers
+    const struct unit__assert_site* assert_site;
+    // the last failure of this node, valid until the next test begins
+    const struct unit__fail_record* fail_record;
     const char* assert_comment;
     const char* assert_desc;
     const char* assert_file;
@@ -186,14 +324,50 @@ struct unit_run_options {
     int animate;
     int doctest_xml;
     int short_filenames;
+    // seeds `srand` and cases of `PROPERTY` tests together with the test path
     unsigned seed;
     const char* program;
+    // new options are appended after existing ones, so positional initializers keep their meaning
+    int strict_env;
+    const char* cpus;
+    const char* clock;
+    int resources;
+    const char* trace_out;
+    int profile;
+    const char* profile_out;
+    int catch_crashes;
+    int junit;
+    int ndjson;
+    // binary events log, reports are printed from it by `unit_report`
+    const char* events_out;
+    // human-readable reporter, enabled by default if no other reporter is selected
+    int console;
+    // destination files of reporters selected with `-r=name:FILE`, `stdout` if not set
+    const char* console_out;
+    const char* xml_out;
+    const char* junit_out;
+    const char* ndjson_out;
+    // reporters are notified by their own thread
+    int async_report;
+    // number of the slowest tests and suites to report
+    int durations;
+    // runs only tests which path matches the glob pattern
+    const char* filter;
+    // measures frequency governor and timer jitter for the environment line, implied by `strict_env` and `cpus`
+    int env;
 };
 
 extern struct unit_run_options unit__opts;
 
+#define UNIT__EVENT(Cmd) (1u << UNIT__PRINTER_ ## Cmd)
+#define UNIT__EVENTS_ALL 0x7Fu
+
 struct unit_printer {
     void (* callback)(int cmd, struct unit_test* unit, const char* msg);
+    // mask of `UNIT__EVENT(Cmd)` the printer is interested in
+    unsigned events;
+    // output of the reporter, NULL for printers writing their own files
+    FILE* out;
 
     struct unit_printer* next;
 };
@@ -204,8 +378,18 @@ void unit__end(struct unit_test* unit);
 
 void unit__echo(const char* msg);
 
+// union of all printers events, passing assertions don't call printers without `ASSERTION` subscriber
+extern unsigned unit__events;
+
+void* unit_scratch_alloc(size_t size, size_t align);
+
 int unit_main(struct unit_run_options options);
 
+/**
+ * Prints report of the run from the events log written with `--events-out`, using printers selected by `options`
+ */
+int unit_report(const char* path, struct unit_run_options options);
+
 // https://gcc.gnu.org/onlinedocs/cpp/Stringizing.html
 #define UNIT__STR(x) #x
 #define UNIT__X_STR(x) UNIT__STR(x)
@@ -222,7 +406,7 @@ int unit_main(struct unit_run_options options);
 #define UNIT__SUITE(Var, Name, ...) \
     static void Var(void); \
     __attribute__((constructor)) static void UNIT__CONCAT(Var, _ctor)(void) { \
-        static struct unit_test u = (struct unit_test){ .name=Name, .file=__FILE__, .line=__LINE__, .fn=Var, .type=UNIT__TYPE_CASE, .options=(struct unit__options){ __VA_ARGS__ } }; \
+        static struct unit_test u = { .name=Name, .file=__FILE__, .line=__LINE__, .fn=Var, .type=UNIT__TYPE_CASE, .options={ __VA_ARGS__ } }; \
         u.next = unit_tests; unit_tests = &u; \
     } \
     static void Var(void)
@@ -230,54 +414,310 @@ int unit_main(struct unit_run_options options);
 #define UNIT_SUITE_(Name, ...) UNIT__SUITE(UNIT__X_CONCAT(unit__, __COUNTER__), Name, __VA_ARGS__)
 #define UNIT_SUITE(Name, ...) UNIT__SUITE(UNIT__X_CONCAT(unit__, __COUNTER__), #Name, __VA_ARGS__)
 
+#ifdef UNIT__HAS_CRASH_RECOVERY
+
+sigjmp_buf* unit__crash_point(struct unit_test* unit);
+
+// with `--catch-crashes` each node is a recovery point: crash inside jumps back here, the body is skipped
+// and `unit__end` reports the crash; `sigsetjmp` is the whole controlling expression as C11 7.13.1.1 requires
+#define UNIT__CRASH_POINT(Unit) switch (sigsetjmp(*unit__crash_point(Unit), unit__opts.catch_crashes)) case 0:
+
+#else
+
+#define UNIT__CRASH_POINT(Unit)
+
+#endif // UNIT__HAS_CRASH_RECOVERY
+
 #define UNIT__DECL(Type, Var, Name, ...) \
-    static struct unit_test Var = (struct unit_test){ .name=Name, .file=__FILE__, .line=__LINE__, .fn=NULL, .type=Type, .options=(struct unit__options){ __VA_ARGS__ } }; \
-    UNIT_TRY_SCOPE(unit__begin(&Var), unit__end(&Var))
+    static struct unit_test Var = { .name=Name, .file=__FILE__, .line=__LINE__, .fn=NULL, .type=Type, .options={ __VA_ARGS__ } }; \
+    UNIT_TRY_SCOPE(unit__begin(&Var), unit__end(&Var)) UNIT__CRASH_POINT(&Var)
 
 #define UNIT_DESCRIBE(Name, ...) UNIT__DECL(UNIT__TYPE_CASE, UNIT__X_CONCAT(u__, __COUNTER__), #Name, __VA_ARGS__)
 #define UNIT_TEST(Name, ...) UNIT__DECL(UNIT__TYPE_TEST, UNIT__X_CONCAT(u__, __COUNTER__), "" Name, __VA_ARGS__)
 
-bool unit__prepare_assert(int level, const char* file, int line, const char* comment, const char* desc);
+#ifndef UNIT_ROW_NAME_MAX
+// maximum length of the row name of `UNIT_TEST_EACH`
+#define UNIT_ROW_NAME_MAX 64
+#endif
+
+// result node of the table row, nodes are allocated once for all rows of the table
+struct unit__row {
+    struct unit_test node;
+    char name[UNIT_ROW_NAME_MAX];
+};
+
+size_t unit__rows(struct unit_test* scope, struct unit__row** rows, size_t* rows_num, size_t count);
+
+struct unit_test* unit__row(struct unit_test* scope, struct unit__row* rows, size_t index, const void* row);
+
+#ifdef __cplusplus
+// `Row` is the iterator of the array or the container: the table is bound once per run, so the temporary container
+// lives through all rows, and the iterator is advanced row by row, so lists are not walked from the beginning
+#define UNIT__ROWS_BIND(Var, Rows) \
+    for (int UNIT__CONCAT(Var, _bind) = 1; UNIT__CONCAT(Var, _bind);) \
+    for (auto&& UNIT__CONCAT(Var, _table) = Rows; UNIT__CONCAT(Var, _bind); UNIT__CONCAT(Var, _bind) = 0) \
+    for (auto UNIT__CONCAT(Var, _it) = std::begin(UNIT__CONCAT(Var, _table)); UNIT__CONCAT(Var, _bind); UNIT__CONCAT(Var, _bind) = 0)
+#define UNIT__ROWS_NUM(Var, Rows) \
+    ((size_t) std::distance(std::begin(UNIT__CONCAT(Var, _table)), std::end(UNIT__CONCAT(Var, _table))))
+#define UNIT__ROW_NEXT(Var) ++UNIT__CONCAT(Var, _it)
+#define UNIT__ROW_VAR(Row, Var, Rows) auto Row = UNIT__CONCAT(Var, _it)
+#else
+// `Row` is the pointer to the array element
+#define UNIT__ROWS_BIND(Var, Rows)
+#define UNIT__ROWS_NUM(Var, Rows) (sizeof(Rows) / sizeof((Rows)[0]))
+#define UNIT__ROW_NEXT(Var) (void) 0
+#define UNIT__ROW_VAR(Row, Var, Rows) __typeof__(&(Rows)[0]) Row = &(Rows)[UNIT__CONCAT(Var, _i)]
+#endif // __cplusplus
+
+#define UNIT__EACH(Var, Name, Rows, Row, ...) \
+    static struct unit_test Var = { .name=Name, .file=__FILE__, .line=__LINE__, .fn=NULL, .type=UNIT__TYPE_CASE, .options={ __VA_ARGS__ } }; \
+    static struct unit__row* UNIT__CONCAT(Var, _rows) = NULL; \
+    static size_t UNIT__CONCAT(Var, _rows_num) = 0; \
+    UNIT_TRY_SCOPE(unit__begin(&Var), unit__end(&Var)) UNIT__CRASH_POINT(&Var) \
+    UNIT__ROWS_BIND(Var, Rows) \
+    for (size_t UNIT__CONCAT(Var, _i) = 0, UNIT__CONCAT(Var, _once) = 1, \
+            UNIT__CONCAT(Var, _n) = unit__rows(&Var, &UNIT__CONCAT(Var, _rows), &UNIT__CONCAT(Var, _rows_num), UNIT__ROWS_NUM(Var, Rows)); \
+         UNIT__CONCAT(Var, _i) < UNIT__CONCAT(Var, _n); ++UNIT__CONCAT(Var, _i), UNIT__ROW_NEXT(Var), UNIT__CONCAT(Var, _once) = 1) \
+    for (UNIT__ROW_VAR(Row, Var, Rows); UNIT__CONCAT(Var, _once); UNIT__CONCAT(Var, _once) = 0) \
+    UNIT_TRY_SCOPE(unit__begin(unit__row(&Var, UNIT__CONCAT(Var, _rows), UNIT__CONCAT(Var, _i), &*Row)), \
+                   unit__end(&UNIT__CONCAT(Var, _rows)[UNIT__CONCAT(Var, _i)].node)) \
+    UNIT__CRASH_POINT(&UNIT__CONCAT(Var, _rows)[UNIT__CONCAT(Var, _i)].node)
+
+// runs the body for each row of the table `Rows`: the array, or any container in C++,
+// each row is the test of its own, so it is reported, timed and selected by `--filter` separately
+#define UNIT_TEST_EACH(Name, Rows, Row, ...) UNIT__EACH(UNIT__X_CONCAT(u__, __COUNTER__), "" Name, Rows, Row, __VA_ARGS__)
+
+// generators of `UNIT_PROPERTY` cases, values shrink to zero clamped to the range, empty buffers and strings
+int64_t unit_gen_int(int64_t min, int64_t max);
+
+uint64_t unit_gen_uint(uint64_t min, uint64_t max);
+
+double unit_gen_double(double min, double max);
+
+void unit_gen_bytes(void* buf, size_t size);
+
+// length in `[0, max]`
+size_t unit_gen_len(size_t max);
+
+// fills `buf` with the null-terminated string of `alphabet` characters, printable ASCII if `alphabet` is NULL
+size_t unit_gen_str(char* buf, size_t size, const char* alphabet);
+
+// fills the array with `Gen` values, returns the length in `[0, Capacity]`
+#define UNIT_GEN_ARRAY(Array, Capacity, Gen) ({ \
+    const size_t n__ = unit_gen_len(Capacity); \
+    for (size_t i__ = 0; i__ < n__; ++i__) (Array)[i__] = (Gen); \
+    n__; \
+})
+
+void unit__prop_begin(struct unit_test* unit, int64_t cases);
+
+bool unit__prop_next(void);
+
+#define UNIT__PROPERTY(Var, Name, Cases, ...) \
+    static struct unit_test Var = { .name=Name, .file=__FILE__, .line=__LINE__, .fn=NULL, .type=UNIT__TYPE_TEST, .options={ __VA_ARGS__ } }; \
+    UNIT_TRY_SCOPE(unit__begin(&Var), unit__end(&Var)) UNIT__CRASH_POINT(&Var) \
+    for (unit__prop_begin(&Var, Cases); unit__prop_next();)
+
+// runs the body for `Cases` random cases made by `unit_gen_*` generators, the failed case is shrunk
+// to the simplest one and reported with its values and the seed to reproduce it
+#define UNIT_PROPERTY(Name, Cases, ...) UNIT__PROPERTY(UNIT__X_CONCAT(u__, __COUNTER__), "" Name, Cases, __VA_ARGS__)
+
+// assertion state of the calling thread: tests could assert from threads they spawn
+struct unit__thread {
+    // call site of the current assertion
+    const struct unit__assert_site* site;
+    // thread running the tests, other threads count assertions atomically and queue failures
+    bool owner;
+};
+
+extern __thread struct unit__thread unit__tls;
+
+// fields of the running node written by every assertion, kept in the single cache line apart from cold node data,
+// they are stored to the node when the nested node begins or the node ends
+struct unit__hot {
+    int64_t assertions;
+    int state;
+} __attribute__((aligned(64)));
+
+extern struct unit__hot unit__hot;
+
+void unit__skip_assert(void);
+
+void unit__notify_assert(int status);
+
+void unit__assert_pass_thread(void);
+
+static inline bool unit__prepare_assert(const struct unit__assert_site* site) {
+    unit__tls.site = site;
+    if (__atomic_load_n(&unit__hot.state, __ATOMIC_RELAXED) & UNIT__LEVEL_REQUIRE) {
+        unit__skip_assert();
+        return false;
+    }
+    return true;
+}
+
+static inline void unit__assert_pass(void) {
+    if (__builtin_expect(!unit__tls.owner, 0)) {
+        unit__assert_pass_thread();
+        return;
+    }
+    ++unit__hot.assertions;
+    if (unit__events & UNIT__EVENT(ASSERTION)) {
+        unit__notify_assert(UNIT_STATUS_SUCCESS);
+    }
+}
 
 // устанавливает читаемое описание проверки, в случае нормального состояния выполняет проверку,
 // если установлено состояние пропускать тесты - НЕ ВЫЧИСЛЯЕТ аргументы для проверки
 #define UNIT__ASSERT_LAZY(Assertion, Level, Comment, Description) \
-if(unit__prepare_assert(Level, __FILE__, __LINE__, Comment, Description)) Assertion
+if(unit__prepare_assert(({ \
+    static const struct unit__assert_site s__ = {Level, __FILE__, __LINE__, Comment, Description}; \
+    &s__; \
+}))) Assertion
 
 #define UNIT__IS_TRUE(_, x) (!!(x))
 #define UNIT__IS_NOT_EMPTY_STR(_, x) ((x) && (x)[0])
-#define UNIT__CMP(a, b) ((a) == (b) ? 0 : ((a) > (b) ? 1 : -1))
+#define UNIT__REL(a, b, Rel) ((a) Rel (b))
 #define UNIT__STRCMP(a, b) ((a) == (b) ? 0 : strcmp((a) ? (a) : "", (b) ? (b) : ""))
+#define UNIT__STRREL(a, b, Rel) (UNIT__STRCMP(a, b) Rel 0)
 
+// Tag, Type, binary relation, unary predicate
 #define UNIT__FOR_ASSERTS(macro) \
-macro(int, intmax_t, %jd, UNIT__CMP, UNIT__IS_TRUE) \
-macro(uint, uintmax_t, %ju, UNIT__CMP, UNIT__IS_TRUE) \
-macro(dbl, long double, %Lg, UNIT__CMP, UNIT__IS_TRUE) \
-macro(ptr, const void*, %p, UNIT__CMP, UNIT__IS_TRUE) \
-macro(str, const char*, %s, UNIT__STRCMP, UNIT__IS_NOT_EMPTY_STR)
+macro(int, int, UNIT__REL, UNIT__IS_TRUE) \
+macro(uint, unsigned int, UNIT__REL, UNIT__IS_TRUE) \
+macro(long, long, UNIT__REL, UNIT__IS_TRUE) \
+macro(ulong, unsigned long, UNIT__REL, UNIT__IS_TRUE) \
+macro(llong, long long, UNIT__REL, UNIT__IS_TRUE) \
+macro(ullong, unsigned long long, UNIT__REL, UNIT__IS_TRUE) \
+macro(flt, float, UNIT__REL, UNIT__IS_TRUE) \
+macro(dbl, double, UNIT__REL, UNIT__IS_TRUE) \
+macro(ldbl, long double, UNIT__REL, UNIT__IS_TRUE) \
+macro(ptr, const void*, UNIT__REL, UNIT__IS_TRUE) \
+macro(str, const char*, UNIT__STRREL, UNIT__IS_NOT_EMPTY_STR)
+
+// signed and unsigned integers are compared by value, not in the unsigned common type:
+// a negative operand is less than any unsigned one, otherwise both are compared as `uintmax_t`
+static inline int unit__cmp_su(intmax_t a, uintmax_t b) {
+    return a < 0 ? -1 : ((uintmax_t) a > b) - ((uintmax_t) a < b);
+}
+
+#define UNIT__SU_REL(a, b, Rel) (unit__cmp_su(a, b) Rel 0)
+#define UNIT__US_REL(a, b, Rel) (0 Rel unit__cmp_su(b, a))
+
+// Tag, Type of `a`, Type of `b`, binary relation, unary predicate, value tags of `a` and `b`
+#define UNIT__FOR_MIXED_ASSERTS(macro) \
+macro(su, intmax_t, uintmax_t, UNIT__SU_REL, UNIT__IS_TRUE, imax, umax) \
+macro(us, uintmax_t, intmax_t, UNIT__US_REL, UNIT__IS_TRUE, umax, imax)
+
+// comparison is inlined at the call site, only failure is reported out of line,
+// `Op` enum name is a part of the function name: `unit__assert_int_UNIT__OP_EQ`
+#define UNIT__ASSERT_KERNEL(Tag, TypeA, TypeB, Op, Pass) \
+static inline void unit__assert_ ## Tag ## _ ## Op(TypeA a, TypeB b, const char* sa, const char* sb) { \
+    (void) a; \
+    if (Pass) { \
+        unit__assert_pass(); \
+    } else { \
+        unit__fail_ ## Tag(a, b, Op, sa, sb); \
+    } \
+}
 
-#define UNIT__DEFINE_ASSERT(Tag, Type, ...) \
-void unit__assert_ ## Tag(Type a, Type b, int op, const char* expr, const char* sa, const char* sb);
+#define UNIT__DEFINE_MIXED_ASSERT(Tag, TypeA, TypeB, Rel, Unary, ...) \
+void unit__fail_ ## Tag(TypeA a, TypeB b, int op, const char* sa, const char* sb); \
+UNIT__ASSERT_KERNEL(Tag, TypeA, TypeB, UNIT__OP_TRUE, Unary(a, b)) \
+UNIT__ASSERT_KERNEL(Tag, TypeA, TypeB, UNIT__OP_FALSE, !Unary(a, b)) \
+UNIT__ASSERT_KERNEL(Tag, TypeA, TypeB, UNIT__OP_EQ, Rel(a, b, ==)) \
+UNIT__ASSERT_KERNEL(Tag, TypeA, TypeB, UNIT__OP_NE, Rel(a, b, !=)) \
+UNIT__ASSERT_KERNEL(Tag, TypeA, TypeB, UNIT__OP_LT, Rel(a, b, <)) \
+UNIT__ASSERT_KERNEL(Tag, TypeA, TypeB, UNIT__OP_LE, Rel(a, b, <=)) \
+UNIT__ASSERT_KERNEL(Tag, TypeA, TypeB, UNIT__OP_GT, Rel(a, b, >)) \
+UNIT__ASSERT_KERNEL(Tag, TypeA, TypeB, UNIT__OP_GE, Rel(a, b, >=))
+
+#define UNIT__DEFINE_ASSERT(Tag, Type, Rel, Unary) UNIT__DEFINE_MIXED_ASSERT(Tag, Type, Type, Rel, Unary)
 
 UNIT__FOR_ASSERTS(UNIT__DEFINE_ASSERT)
+UNIT__FOR_MIXED_ASSERTS(UNIT__DEFINE_MIXED_ASSERT)
+
+// operands are compared in their common type: `1 ? a : b` applies usual arithmetic conversions,
+// or gives composite pointer type, so `char`, `short` and `bool` are promoted to `int` without losses;
+// only a signed integer converted to the unsigned common type would change its value, such pairs go to
+// `unit__assert_su_*` or `unit__assert_us_*`, so `CHECK_GT(size, -1)` passes and `-1` is printed as `-1`
+
+#ifdef __cplusplus
+
+// `_Generic` is not available for C++ sources, select assertion by overloading
+}
+extern "C++" {
+#define UNIT__SELECT_ASSERT_CXX_OP(TypeA, TypeB, Tag, Op) \
+static inline void unit__assert_ ## Op(TypeA a, TypeB b, const char* sa, const char* sb) { unit__assert_ ## Tag ## _ ## Op(a, b, sa, sb); }
+
+#define UNIT__SELECT_MIXED_ASSERT_CXX(Tag, TypeA, TypeB, ...) \
+UNIT__SELECT_ASSERT_CXX_OP(TypeA, TypeB, Tag, UNIT__OP_TRUE) \
+UNIT__SELECT_ASSERT_CXX_OP(TypeA, TypeB, Tag, UNIT__OP_FALSE) \
+UNIT__SELECT_ASSERT_CXX_OP(TypeA, TypeB, Tag, UNIT__OP_EQ) \
+UNIT__SELECT_ASSERT_CXX_OP(TypeA, TypeB, Tag, UNIT__OP_NE) \
+UNIT__SELECT_ASSERT_CXX_OP(TypeA, TypeB, Tag, UNIT__OP_LT) \
+UNIT__SELECT_ASSERT_CXX_OP(TypeA, TypeB, Tag, UNIT__OP_LE) \
+UNIT__SELECT_ASSERT_CXX_OP(TypeA, TypeB, Tag, UNIT__OP_GT) \
+UNIT__SELECT_ASSERT_CXX_OP(TypeA, TypeB, Tag, UNIT__OP_GE)
+
+#define UNIT__SELECT_ASSERT_CXX(Tag, Type, ...) UNIT__SELECT_MIXED_ASSERT_CXX(Tag, Type, Type)
+
+UNIT__FOR_ASSERTS(UNIT__SELECT_ASSERT_CXX)
+UNIT__FOR_MIXED_ASSERTS(UNIT__SELECT_MIXED_ASSERT_CXX)
+// `bool` is not promoted by the conditional operator in C++
+UNIT__SELECT_ASSERT_CXX(int, bool)
+
+// operand `T` is a signed integer converted to the unsigned common type `Common`
+template<class T, class Common>
+struct unit__sign_mix : std::integral_constant<bool,
+    std::is_integral<typename std::decay<T>::type>::value && std::is_signed<typename std::decay<T>::type>::value &&
+    std::is_unsigned<typename std::decay<Common>::type>::value> {};
+
+// type of operand `T` compared with operand `Other`: the common type, or `intmax_t` and `uintmax_t` for mixed signs
+template<class T, class Other, class Common>
+struct unit__operand : std::conditional<unit__sign_mix<T, Common>::value, intmax_t,
+    typename std::conditional<unit__sign_mix<Other, Common>::value, uintmax_t, Common>::type> {};
+}
+extern "C" {
+
+// operands are converted at the call site, where `0` is still a null pointer constant
+#define UNIT__OPERAND_CXX(x, y, a, b) (unit__operand<decltype(x), decltype(y), decltype(1 ? (a) : (b))>::type) (x)
+
+#define UNIT__CALL_ASSERT(Op, a, b) unit__assert_ ## Op(UNIT__OPERAND_CXX(a, b, a, b), UNIT__OPERAND_CXX(b, a, a, b), #a, #b)
+
+#else
 
-#define UNIT__SELECT_ASSERT(x) \
-    _Generic((x), \
-        void*: unit__assert_ptr, \
-        const void*: unit__assert_ptr, \
-        char*: unit__assert_str, \
-        const char*: unit__assert_str, \
-        bool: unit__assert_int, \
-        int: unit__assert_int, \
-        long long: unit__assert_int, \
-        unsigned int: unit__assert_uint, \
-        unsigned long: unit__assert_uint, \
-        unsigned long long: unit__assert_uint, \
-        float: unit__assert_dbl, \
-        double: unit__assert_dbl, \
-        long double: unit__assert_dbl)
-
-#define UNIT__ASSERT(Level, Op, a, b, Desc, ...)  UNIT__ASSERT_LAZY(UNIT__SELECT_ASSERT(b)(a, b, Op, Desc, #a, #b), Level, "" #__VA_ARGS__, Desc)
+#define UNIT__IS_SIGNED_INT(x) _Generic((x), char: 1, signed char: 1, short: 1, int: 1, long: 1, long long: 1, default: 0)
+#define UNIT__IS_UNSIGNED_INT(x) _Generic((x), unsigned int: 1, unsigned long: 1, unsigned long long: 1, default: 0)
+
+// 1 if only `a` is signed, 2 if only `b` is, and 0 if the common type keeps values of both
+#define UNIT__SIGN_MIX(a, b) (UNIT__IS_UNSIGNED_INT(1 ? (a) : (b)) * (UNIT__IS_SIGNED_INT(a) + 2 * UNIT__IS_SIGNED_INT(b)))
+
+// the sign mix is an integer constant, so it selects by the size of the array type
+#define UNIT__SELECT_MIXED(a, b, Su, Us, Common) \
+    _Generic((char (*)[1 + UNIT__SIGN_MIX(a, b)]) 0, char (*)[2]: Su, char (*)[3]: Us, default: Common)
+
+#define UNIT__CALL_ASSERT(Op, a, b) \
+    UNIT__SELECT_MIXED(a, b, unit__assert_su_ ## Op, unit__assert_us_ ## Op, UNIT__SELECT_ASSERT(Op, a, b))(a, b, #a, #b)
+
+#define UNIT__SELECT_ASSERT(Op, a, b) \
+    _Generic(1 ? (a) : (b), \
+        int: unit__assert_int_ ## Op, \
+        unsigned int: unit__assert_uint_ ## Op, \
+        long: unit__assert_long_ ## Op, \
+        unsigned long: unit__assert_ulong_ ## Op, \
+        long long: unit__assert_llong_ ## Op, \
+        unsigned long long: unit__assert_ullong_ ## Op, \
+        float: unit__assert_flt_ ## Op, \
+        double: unit__assert_dbl_ ## Op, \
+        long double: unit__assert_ldbl_ ## Op, \
+        char*: unit__assert_str_ ## Op, \
+        const char*: unit__assert_str_ ## Op, \
+        default: unit__assert_ptr_ ## Op)
+
+#endif // __cplusplus
+
+#define UNIT__ASSERT(Level, Op, a, b, Desc, ...)  UNIT__ASSERT_LAZY(UNIT__CALL_ASSERT(Op, a, b), Level, "" #__VA_ARGS__, Desc)
 
 #define UNIT_WARN(x, ...)       UNIT__ASSERT(UNIT__LEVEL_WARN, UNIT__OP_TRUE,  0, x, "warn " #x, __VA_ARGS__)
 #define UNIT_WARN_FALSE(x, ...) UNIT__ASSERT(UNIT__LEVEL_WARN, UNIT__OP_FALSE, 0, x, "warn " #x " is not true", __VA_ARGS__)
@@ -306,7 +746,164 @@ UNIT__FOR_ASSERTS(UNIT__DEFINE_ASSERT)
 #define UNIT_REQUIRE_LT(a, b, ...) UNIT__ASSERT(UNIT__LEVEL_REQUIRE, UNIT__OP_LT, a, b, "require " #a " < " #b, __VA_ARGS__)
 #define UNIT_REQUIRE_LE(a, b, ...) UNIT__ASSERT(UNIT__LEVEL_REQUIRE, UNIT__OP_LE, a, b, "require " #a " <= " #b, __VA_ARGS__)
 
-#define UNIT_SKIP() unit_cur->state |= UNIT__LEVEL_REQUIRE
+void unit__assert_mem(const void* a, const void* b, size_t size, size_t elem_size, const char* sa, const char* sb);
+
+// size of array element, arrays with different element types could not be compared
+#define UNIT__ELEM_SIZE(a, b) (sizeof *(a) + 0 * sizeof(char[sizeof *(a) == sizeof *(b) ? 1 : -1]))
+
+#define UNIT__ASSERT_MEM(Level, a, b, Size, ElemSize, Desc, ...) \
+    UNIT__ASSERT_LAZY(unit__assert_mem(a, b, Size, ElemSize, #a, #b), Level, "" #__VA_ARGS__, Desc)
+
+#define UNIT_WARN_MEM_EQ(a, b, n, ...) UNIT__ASSERT_MEM(UNIT__LEVEL_WARN, a, b, n, 1, "warn " #a " == " #b " (" #n " bytes)", __VA_ARGS__)
+#define UNIT_CHECK_MEM_EQ(a, b, n, ...) UNIT__ASSERT_MEM(UNIT__LEVEL_CHECK, a, b, n, 1, "check " #a " == " #b " (" #n " bytes)", __VA_ARGS__)
+#define UNIT_REQUIRE_MEM_EQ(a, b, n, ...) UNIT__ASSERT_MEM(UNIT__LEVEL_REQUIRE, a, b, n, 1, "require " #a " == " #b " (" #n " bytes)", __VA_ARGS__)
+
+#define UNIT_WARN_ARRAY_EQ(a, b, count, ...) UNIT__ASSERT_MEM(UNIT__LEVEL_WARN, a, b, (count) * UNIT__ELEM_SIZE(a, b), UNIT__ELEM_SIZE(a, b), "warn " #a " == " #b " (" #count " elements)", __VA_ARGS__)
+#define UNIT_CHECK_ARRAY_EQ(a, b, count, ...) UNIT__ASSERT_MEM(UNIT__LEVEL_CHECK, a, b, (count) * UNIT__ELEM_SIZE(a, b), UNIT__ELEM_SIZE(a, b), "check " #a " == " #b " (" #count " elements)", __VA_ARGS__)
+#define UNIT_REQUIRE_ARRAY_EQ(a, b, count, ...) UNIT__ASSERT_MEM(UNIT__LEVEL_REQUIRE, a, b, (count) * UNIT__ELEM_SIZE(a, b), UNIT__ELEM_SIZE(a, b), "require " #a " == " #b " (" #count " elements)", __VA_ARGS__)
+
+// tolerances for `UNIT_CHECK_ARRAY_NEAR`, element passes if it is within any of them
+struct unit_tolerance {
+    // maximum distance in units in the last place
+    unsigned ulps;
+    // maximum relative error
+    double rel;
+    // maximum absolute error
+    double abs;
+};
+
+void unit__assert_near_flt(const float* a, const float* b, size_t n, struct unit_tolerance tol, const char* sa, const char* sb);
+
+void unit__assert_near_dbl(const double* a, const double* b, size_t n, struct unit_tolerance tol, const char* sa, const char* sb);
+
+#ifdef __cplusplus
+}
+extern "C++" {
+static inline decltype(&unit__assert_near_flt) unit__select_near(float) { return unit__assert_near_flt; }
+static inline decltype(&unit__assert_near_dbl) unit__select_near(double) { return unit__assert_near_dbl; }
+}
+extern "C" {
+#define UNIT__SELECT_NEAR(x) unit__select_near(x)
+#else
+#define UNIT__SELECT_NEAR(x) _Generic((x), float: unit__assert_near_flt, double: unit__assert_near_dbl)
+#endif // __cplusplus
+
+// options are `struct unit_tolerance` fields: `UNIT_CHECK_ARRAY_NEAR(a, b, n, .ulps=4, .rel=1e-6)`, 4 ULPs by default
+#define UNIT__ASSERT_NEAR(Level, a, b, n, Desc, ...) \
+    UNIT__ASSERT_LAZY(UNIT__SELECT_NEAR(*(a))(a, b, n, (struct unit_tolerance) { __VA_ARGS__ }, #a, #b), Level, "", Desc)
+
+#define UNIT_WARN_ARRAY_NEAR(a, b, n, ...) UNIT__ASSERT_NEAR(UNIT__LEVEL_WARN, a, b, n, "warn " #a " ~ " #b " (" #n " elements)", __VA_ARGS__)
+#define UNIT_CHECK_ARRAY_NEAR(a, b, n, ...) UNIT__ASSERT_NEAR(UNIT__LEVEL_CHECK, a, b, n, "check " #a " ~ " #b " (" #n " elements)", __VA_ARGS__)
+#define UNIT_REQUIRE_ARRAY_NEAR(a, b, n, ...) UNIT__ASSERT_NEAR(UNIT__LEVEL_REQUIRE, a, b, n, "require " #a " ~ " #b " (" #n " elements)", __VA_ARGS__)
+
+#ifndef UNIT_ALL_SAMPLES
+// number of the first failing indices reported by `UNIT_CHECK_ALL`
+#define UNIT_ALL_SAMPLES 8
+#endif
+
+// failures of the range assertion, only the first samples are kept
+struct unit__all {
+    intmax_t fails;
+    int samples;
+    intmax_t index[UNIT_ALL_SAMPLES];
+    // formatted operands for `UNIT_CHECK_ALL_EQ`, stored in the per-test arena
+    const char* values[UNIT_ALL_SAMPLES];
+};
+
+void unit__all_fail(struct unit__all* all, intmax_t index);
+
+void unit__all_end(const struct unit__all* all, intmax_t begin, intmax_t end, const char* var, const char* expr);
+
+#define UNIT__DEFINE_MIXED_ALL_EQ(Tag, TypeA, TypeB, Rel, ...) \
+void unit__all_fail_ ## Tag(struct unit__all* all, intmax_t index, TypeA a, TypeB b); \
+static inline void unit__all_eq_ ## Tag(struct unit__all* all, intmax_t index, TypeA a, TypeB b) { \
+    if (__builtin_expect(!Rel(a, b, ==), 0)) { \
+        unit__all_fail_ ## Tag(all, index, a, b); \
+    } \
+}
+
+#define UNIT__DEFINE_ALL_EQ(Tag, Type, Rel, Unary) UNIT__DEFINE_MIXED_ALL_EQ(Tag, Type, Type, Rel, Unary)
+
+UNIT__FOR_ASSERTS(UNIT__DEFINE_ALL_EQ)
+UNIT__FOR_MIXED_ASSERTS(UNIT__DEFINE_MIXED_ALL_EQ)
+
+#ifdef __cplusplus
+}
+extern "C++" {
+#define UNIT__SELECT_MIXED_ALL_EQ_CXX(Tag, TypeA, TypeB, ...) \
+static inline void unit__all_eq(struct unit__all* all, intmax_t index, TypeA a, TypeB b) { unit__all_eq_ ## Tag(all, index, a, b); }
+
+#define UNIT__SELECT_ALL_EQ_CXX(Tag, Type, ...) UNIT__SELECT_MIXED_ALL_EQ_CXX(Tag, Type, Type)
+
+UNIT__FOR_ASSERTS(UNIT__SELECT_ALL_EQ_CXX)
+UNIT__FOR_MIXED_ASSERTS(UNIT__SELECT_MIXED_ALL_EQ_CXX)
+UNIT__SELECT_ALL_EQ_CXX(int, bool)
+}
+extern "C" {
+#define UNIT__CALL_ALL_EQ(All, Index, a, b) unit__all_eq(All, Index, UNIT__OPERAND_CXX(a, b, a, b), UNIT__OPERAND_CXX(b, a, a, b))
+#else
+#define UNIT__CALL_ALL_EQ(All, Index, a, b) \
+    UNIT__SELECT_MIXED(a, b, unit__all_eq_su, unit__all_eq_us, UNIT__SELECT_ALL_EQ(a, b))(All, Index, a, b)
+
+#define UNIT__SELECT_ALL_EQ(a, b) \
+    _Generic(1 ? (a) : (b), \
+        int: unit__all_eq_int, \
+        unsigned int: unit__all_eq_uint, \
+        long: unit__all_eq_long, \
+        unsigned long: unit__all_eq_ulong, \
+        long long: unit__all_eq_llong, \
+        unsigned long long: unit__all_eq_ullong, \
+        float: unit__all_eq_flt, \
+        double: unit__all_eq_dbl, \
+        long double: unit__all_eq_ldbl, \
+        char*: unit__all_eq_str, \
+        const char*: unit__all_eq_str, \
+        default: unit__all_eq_ptr)
+#endif // __cplusplus
+
+// the whole range is a single assertion: the loop body is the inlined check, failures are counted out of line
+#define UNIT__ALL_LOOP(Var, Begin, End, Check, Expr) \
+do { \
+    struct unit__all all__; \
+    all__.fails = 0; \
+    all__.samples = 0; \
+    const intmax_t begin__ = (Begin); \
+    const intmax_t end__ = (End); \
+    for (intmax_t Var = begin__; Var < end__; ++Var) { \
+        Check; \
+    } \
+    unit__all_end(&all__, begin__, end__, #Var, Expr); \
+} while (0)
+
+#define UNIT__ALL_PRED(Var, Pred) if (__builtin_expect(!(Pred), 0)) unit__all_fail(&all__, Var)
+
+#define UNIT__ASSERT_ALL(Level, Var, Begin, End, Pred, Desc) \
+    UNIT__ASSERT_LAZY(UNIT__ALL_LOOP(Var, Begin, End, UNIT__ALL_PRED(Var, Pred), #Pred), Level, "", Desc)
+
+#define UNIT__ASSERT_ALL_EQ(Level, Var, Begin, End, a, b, Desc) \
+    UNIT__ASSERT_LAZY(UNIT__ALL_LOOP(Var, Begin, End, UNIT__CALL_ALL_EQ(&all__, Var, a, b), #a " == " #b), Level, "", Desc)
+
+// `UNIT_CHECK_ALL(i, 0, n, out[i] >= 0)` checks the predicate for each index in `[begin, end)`
+#define UNIT_WARN_ALL(i, begin, end, pred) UNIT__ASSERT_ALL(UNIT__LEVEL_WARN, i, begin, end, pred, "warn all " #i " in [" #begin ", " #end "): " #pred)
+#define UNIT_CHECK_ALL(i, begin, end, pred) UNIT__ASSERT_ALL(UNIT__LEVEL_CHECK, i, begin, end, pred, "check all " #i " in [" #begin ", " #end "): " #pred)
+#define UNIT_REQUIRE_ALL(i, begin, end, pred) UNIT__ASSERT_ALL(UNIT__LEVEL_REQUIRE, i, begin, end, pred, "require all " #i " in [" #begin ", " #end "): " #pred)
+
+// `UNIT_CHECK_ALL_EQ(i, 0, n, out[i], ref[i])` also reports values of the first failed elements
+#define UNIT_WARN_ALL_EQ(i, begin, end, a, b) UNIT__ASSERT_ALL_EQ(UNIT__LEVEL_WARN, i, begin, end, a, b, "warn all " #i " in [" #begin ", " #end "): " #a " == " #b)
+#define UNIT_CHECK_ALL_EQ(i, begin, end, a, b) UNIT__ASSERT_ALL_EQ(UNIT__LEVEL_CHECK, i, begin, end, a, b, "check all " #i " in [" #begin ", " #end "): " #a " == " #b)
+#define UNIT_REQUIRE_ALL_EQ(i, begin, end, a, b) UNIT__ASSERT_ALL_EQ(UNIT__LEVEL_REQUIRE, i, begin, end, a, b, "require all " #i " in [" #begin ", " #end "): " #a " == " #b)
+
+// fixture function declaration: `UNIT_FIXTURE(open_db) { ... }`
+#define UNIT_FIXTURE(Name) static void Name(void)
+
+// fixture options: `SUITE(db, UNIT_BEFORE_ALL(open_db), UNIT_AFTER_ALL(close_db))`
+#define UNIT_BEFORE_ALL(Fixture) .before_all=(Fixture)
+#define UNIT_AFTER_ALL(Fixture) .after_all=(Fixture)
+#define UNIT_BEFORE_EACH(Fixture) .before_each=(Fixture)
+#define UNIT_AFTER_EACH(Fixture) .after_each=(Fixture)
+#define UNIT_ROW_NAME(Formatter) .row_name=(Formatter)
+
+#define UNIT_SKIP() ((void) __atomic_or_fetch(&unit__hot.state, UNIT__LEVEL_REQUIRE, __ATOMIC_RELAXED))
 #define UNIT_ECHO(msg) unit__echo(msg)
 
 #ifdef __cplusplus
@@ -319,6 +916,9 @@ UNIT__FOR_ASSERTS(UNIT__DEFINE_ASSERT)
 #define DESCRIBE(...) UNIT_DESCRIBE(__VA_ARGS__)
 #define IT(...) UNIT_TEST(__VA_ARGS__)
 #define TEST(...) UNIT_TEST(__VA_ARGS__)
+#define IT_EACH(...) UNIT_TEST_EACH(__VA_ARGS__)
+#define TEST_EACH(...) UNIT_TEST_EACH(__VA_ARGS__)
+#define PROPERTY(...) UNIT_PROPERTY(__VA_ARGS__)
 #define ECHO(...) UNIT_ECHO(__VA_ARGS__)
 
 #define WARN(...)       UNIT_WARN(__VA_ARGS__)
@@ -348,6 +948,31 @@ UNIT__FOR_ASSERTS(UNIT__DEFINE_ASSERT)
 #define REQUIRE_LT(...)    UNIT_REQUIRE_LT(__VA_ARGS__)
 #define REQUIRE_LE(...)    UNIT_REQUIRE_LE(__VA_ARGS__)
 
+#define WARN_MEM_EQ(...) UNIT_WARN_MEM_EQ(__VA_ARGS__)
+#define WARN_ARRAY_EQ(...) UNIT_WARN_ARRAY_EQ(__VA_ARGS__)
+#define CHECK_MEM_EQ(...) UNIT_CHECK_MEM_EQ(__VA_ARGS__)
+#define CHECK_ARRAY_EQ(...) UNIT_CHECK_ARRAY_EQ(__VA_ARGS__)
+#define REQUIRE_MEM_EQ(...) UNIT_REQUIRE_MEM_EQ(__VA_ARGS__)
+#define REQUIRE_ARRAY_EQ(...) UNIT_REQUIRE_ARRAY_EQ(__VA_ARGS__)
+#define WARN_ARRAY_NEAR(...) UNIT_WARN_ARRAY_NEAR(__VA_ARGS__)
+#define CHECK_ARRAY_NEAR(...) UNIT_CHECK_ARRAY_NEAR(__VA_ARGS__)
+#define REQUIRE_ARRAY_NEAR(...) UNIT_REQUIRE_ARRAY_NEAR(__VA_ARGS__)
+#define WARN_ALL(...) UNIT_WARN_ALL(__VA_ARGS__)
+#define CHECK_ALL(...) UNIT_CHECK_ALL(__VA_ARGS__)
+#define REQUIRE_ALL(...) UNIT_REQUIRE_ALL(__VA_ARGS__)
+#define WARN_ALL_EQ(...) UNIT_WARN_ALL_EQ(__VA_ARGS__)
+#define CHECK_ALL_EQ(...) UNIT_CHECK_ALL_EQ(__VA_ARGS__)
+#define REQUIRE_ALL_EQ(...) UNIT_REQUIRE_ALL_EQ(__VA_ARGS__)
+
+#define FIXTURE(...) UNIT_FIXTURE(__VA_ARGS__)
+#define BEFORE_ALL(...) UNIT_BEFORE_ALL(__VA_ARGS__)
+#define AFTER_ALL(...) UNIT_AFTER_ALL(__VA_ARGS__)
+#define BEFORE_EACH(...) UNIT_BEFORE_EACH(__VA_ARGS__)
+#define AFTER_EACH(...) UNIT_AFTER_EACH(__VA_ARGS__)
+#define ROW_NAME(...) UNIT_ROW_NAME(__VA_ARGS__)
+
+#define GEN_ARRAY(...) UNIT_GEN_ARRAY(__VA_ARGS__)
+
 #define SKIP(...) UNIT_SKIP(__VA_ARGS__)
 
 
@@ -376,760 +1001,5601 @@ UNIT__FOR_ASSERTS(UNIT__DEFINE_ASSERT)
 #ifdef __cplusplus
 extern "C" {
 #endif
-#include <stdio.h>
+#if defined(__x86_64__) || defined(__i386__)
 
-#ifdef _WIN32
+#include <x86intrin.h>
+#include <cpuid.h>
 
-/* https://github.com/Arryboom/fmemopen_windows  */
-#include <windows.h>
-#include <share.h>
-#include <io.h>
-#include <fcntl.h>
-#include <sys/stat.h>
-
-FILE* fmemopen(void* buf, size_t len, const char* type) {
-    int fd;
-    FILE* fp;
-    char tp[MAX_PATH - 13];
-    char fn[MAX_PATH + 1];
-    int* pfd = &fd;
-    int retner = -1;
-    char tfname[] = "MemTF_";
-    if (!GetTempPathA(sizeof(tp), tp))
-        return NULL;
-    if (!GetTempFileNameA(tp, tfname, 0, fn))
-        return NULL;
-    retner = _sopen_s(pfd, fn, _O_CREAT | _O_SHORT_LIVED | _O_TEMPORARY | _O_RDWR | _O_BINARY | _O_NOINHERIT,
-                      _SH_DENYRW, _S_IREAD | _S_IWRITE);
-    if (retner != 0)
-        return NULL;
-    if (fd == -1)
-        return NULL;
-    fp = _fdopen(fd, "wb+");
-    if (!fp) {
-        _close(fd);
-        return NULL;
-    }
-    /*File descriptors passed into _fdopen are owned by the returned FILE * stream.If _fdopen is successful, do not call _close on the file descriptor.Calling fclose on the returned FILE * also closes the file descriptor.*/
-    fwrite(buf, len, 1, fp);
-    rewind(fp);
-    return fp;
-}
+#define UNIT__HAS_TSC 1
 
-#endif
+#endif // x86
 
+#if defined(_WIN32) && !defined(UNIT_NO_TIME)
 
-// region Цвета, текстовые сообщения и логи
+#include <windows.h>
 
-#define UNIT_COLOR_RESET "\033[m"
-#define UNIT_COLOR_BOLD "\033[1m"
-#define UNIT_COLOR_DIM "\033[2m"
-#define UNIT_COLOR_UNDERLINE "\033[4m"
-#define UNIT_COLOR_MAYBE "\033[35m"
-#define UNIT_COLOR_COMMENT "\033[36m"
-#define UNIT_COLOR_SUCCESS "\033[32m"
-#define UNIT_COLOR_FAIL "\033[31m"
-#define UNIT_COLOR_DESC "\033[33m"
-#define UNIT_COLOR_INVERT_PASS "\033[30;42m"
-#define UNIT_COLOR_LABEL_PASS UNIT_COLOR_BOLD UNIT_COLOR_INVERT_PASS
-#define UNIT_COLOR_LABEL_FAIL UNIT_COLOR_BOLD "\033[30;41m"
-#define UNIT_COLOR_LABEL_SKIP UNIT_COLOR_BOLD "\033[30;47m"
-#define UNIT_COLOR_LABEL_RUNS UNIT_COLOR_BOLD "\033[30;46m"
+#endif // _WIN32
 
-/**
- * Alternative icons:
- * message icons: "💬 ", "# ", "ℹ ", " ⃫ "
- * skip icons: "Ⅱ "
- */
+// region часы: монотонное время, TSC и процессорное время потока
 
-enum {
-    ICON_RUN = 0,
-    ICON_OK = 1,
-    ICON_SKIP = 2,
-    ICON_FAIL = 3,
-    ICON_ASSERT = 4,
-    ICON_MSG = 5
+struct unit_clock {
+    const char* name;
+    // current time in nanoseconds
+    int64_t (* now)(void);
+    // calibrated cost of the single `now()` call in nanoseconds
+    int64_t overhead;
 };
 
-static const char* icon(int type) {
-    static const char* fancy[] = {
-            UNIT_COLOR_BOLD UNIT_COLOR_SUCCESS "▶ " UNIT_COLOR_RESET,
-            UNIT_COLOR_BOLD UNIT_COLOR_SUCCESS "✓ " UNIT_COLOR_RESET,
-            UNIT_COLOR_BOLD UNIT_COLOR_DIM "∅ " UNIT_COLOR_RESET,
-            UNIT_COLOR_BOLD UNIT_COLOR_FAIL "✕ " UNIT_COLOR_RESET,
-            UNIT_COLOR_BOLD UNIT_COLOR_FAIL "● " UNIT_COLOR_RESET,
-            UNIT_COLOR_BOLD UNIT_COLOR_COMMENT "» " UNIT_COLOR_RESET,
-    };
-    static const char* ascii[] = {
-            "> ",
-            "+ ",
-            ". ",
-            "x ",
-            "! ",
-            "# ",
-    };
-    return unit__opts.ascii ? ascii[type] : fancy[type];
+#if defined(_WIN32) && !defined(UNIT_NO_TIME)
+
+// `timespec_get` gives wall clock time on Windows, performance counter is monotonic
+static int64_t unit__clock_mono(void) {
+    static int64_t frequency = 0;
+    if (!frequency) {
+        LARGE_INTEGER f;
+        QueryPerformanceFrequency(&f);
+        frequency = f.QuadPart;
+    }
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    // whole seconds and the remainder are scaled separately, so nanoseconds don't overflow
+    return counter.QuadPart / frequency * 1000000000 + counter.QuadPart % frequency * 1000000000 / frequency;
 }
 
-// region reporting
+#else // _WIN32
 
-static void unit__sleep(double seconds) {
-#ifndef _WIN32
-    const long secs = (long) seconds;
-    const long nanos = (long) ((seconds - (double) secs) * 1000000000.0);
-    struct timespec ts = {secs, nanos};
-    nanosleep(&ts, NULL);
-#endif
+static int64_t unit__clock_mono(void) {
+    struct timespec ts = {0};
+#ifndef UNIT_NO_TIME
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif // !UNIT_NO_TIME
+    return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
 }
 
-static void print_wait(FILE* f) {
-    fflush(f);
-    if (unit__opts.animate) {
-        unit__sleep(0.1);
-    }
-}
+#endif // !_WIN32
 
-void begin_style(FILE* file, const char* style) {
-    if (style && !unit__opts.ascii) {
-        fputs(style, file);
-    }
+#ifdef UNIT__HAS_TSC
+
+// ticks are converted to nanoseconds as `ticks * mult >> shift`, `mult` is less than 2^32
+static uint64_t unit__tsc_mult = 0;
+static unsigned unit__tsc_shift = 0;
+
+static int64_t unit__clock_tsc(void) {
+    const uint64_t ticks = __rdtsc();
+    // high and low 32-bit halves are scaled separately, so products don't overflow
+    return (int64_t) ((((ticks >> 32) * unit__tsc_mult) << (32 - unit__tsc_shift)) +
+                      (((ticks & 0xFFFFFFFFu) * unit__tsc_mult) >> unit__tsc_shift));
 }
 
-void end_style(FILE* file) {
-    if (!unit__opts.ascii) {
-        fputs(UNIT_COLOR_RESET, file);
-    }
+/**
+ * Invariant TSC (CPUID 0x80000007, EDX bit 8) ticks at constant rate in all P-, C- and T-states,
+ * otherwise the rate follows CPU frequency and ticks can't be converted to time
+ */
+static bool unit__tsc_invariant(void) {
+    unsigned eax, ebx, ecx, edx;
+    return __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1u << 8)) != 0;
 }
 
-void print_text(FILE* file, const char* text, const char* style) {
-    begin_style(file, style);
-    fputs(text, file);
-    end_style(file);
+static bool unit__tsc_calibrate(void) {
+    if (!unit__tsc_invariant()) {
+        return false;
+    }
+    const int64_t t0 = unit__clock_mono();
+    const uint64_t c0 = __rdtsc();
+    int64_t t1;
+    do {
+        t1 = unit__clock_mono();
+    } while (t1 - t0 < 10000000);
+    const uint64_t c1 = __rdtsc();
+    if (c1 <= c0) {
+        return false;
+    }
+    // the most precise `shift` keeping `mult` in 32 bits, elapsed time is about 2^24 ns, so it doesn't overflow
+    unsigned shift = 32;
+    uint64_t mult = ((uint64_t) (t1 - t0) << shift) / (c1 - c0);
+    while (mult >> 32 && shift > 0) {
+        --shift;
+        mult = ((uint64_t) (t1 - t0) << shift) / (c1 - c0);
+    }
+    if (!mult || mult >> 32) {
+        return false;
+    }
+    unit__tsc_mult = mult;
+    unit__tsc_shift = shift;
+    return true;
 }
 
-static char unit__fails_mem[4096];
-static FILE* unit__fails = 0;
+#endif // UNIT__HAS_TSC
 
-static const char* unit_spaces[8] = {
-        "",
-        "  ",
-        "    ",
-        "      ",
-        "        ",
-        "          ",
-        "            ",
-        "              "
-};
+struct unit_clock unit__clock = {"mono", unit__clock_mono, 0};
 
-static const char* get_spaces(int n) {
-    const int len = sizeof unit_spaces / sizeof unit_spaces[0];
-    if(n < 0) n = 0;
-    if(n >= len) n = len - 1;
-    return unit_spaces[n];
+/**
+ * CPU time consumed by the calling thread in nanoseconds
+ */
+static int64_t unit__cpu_time(void) {
+#if defined(UNIT_NO_TIME)
+    return 0;
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec ts = {0};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+    return (int64_t) ((double) clock() * (1000000000.0 / CLOCKS_PER_SEC));
+#endif
 }
 
-void print_elapsed_time(FILE* f, double elapsed_time) {
-    if (elapsed_time >= 0.00001) {
-        begin_style(f, UNIT_COLOR_DIM);
-        fprintf(f, " (%0.2f ms)", 1000.0 * elapsed_time);
-        end_style(f);
+static int64_t unit__clock_measure_overhead(void) {
+    int64_t best = INT64_MAX;
+    for (int i = 0; i < 64; ++i) {
+        const int64_t t0 = unit__clock.now();
+        const int64_t t1 = unit__clock.now();
+        if (t1 - t0 < best) {
+            best = t1 - t0;
+        }
     }
+    return best > 0 ? best : 0;
 }
 
-static const char* beautify_name(const char* name) {
+/**
+ * Selects time source by `--clock=` option and measures clock read overhead
+ */
+static void unit__clock_setup(void) {
+    unit__clock = (struct unit_clock) {"mono", unit__clock_mono, 0};
+    const char* name = unit__opts.clock;
+    if (name && strcmp(name, "tsc") == 0) {
+        bool selected = false;
+#ifdef UNIT__HAS_TSC
+        if (unit__tsc_calibrate()) {
+            unit__clock = (struct unit_clock) {"tsc", unit__clock_tsc, 0};
+            selected = true;
+        }
+#endif // UNIT__HAS_TSC
+        if (!selected && !unit__opts.quiet) {
+            fputs("unit: warning: invariant TSC clock is not available, fallback to monotonic clock\n", stderr);
+        }
+    } else if (name && name[0] && strcmp(name, "mono") != 0 && !unit__opts.quiet) {
+        fprintf(stderr, "unit: warning: unknown clock `%s`, fallback to monotonic clock\n", name);
+    }
+    unit__clock.overhead = unit__clock_measure_overhead();
+}
+
+// endregion
+
+#ifdef __linux__
+
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#endif // __linux__
+
+// region окружение запуска: привязка к CPU, governor, шум таймера
+
+#ifndef UNIT_ENV_MAX_JITTER
+// maximum allowed relative interquartile range of calibration loop timings
+#define UNIT_ENV_MAX_JITTER 0.05
+#endif
+
+#define UNIT__ENV_SAMPLES 21
+#define UNIT__ENV_MAX_CPUS 1024
+
+struct unit_env {
+    // requested cpu list from `--cpus=`, empty if process is not pinned
+    char cpus[64];
+    // number of CPUs in the effective affinity set, 0 if unknown
+    int cpus_count;
+    // `scaling_governor` shared by the CPUs, "mixed" or "unknown"
+    char governor[32];
+    // median time of calibration loop, nanoseconds, 0 if the environment is not measured
+    int64_t calibration;
+    // relative interquartile range of calibration loop timings
+    double jitter;
+    // the first reason why environment is not suitable for benchmarking, NULL if suitable
+    const char* issue;
+};
+
+struct unit_env unit__env;
+
+static unsigned long unit__env_mask[UNIT__ENV_MAX_CPUS / (8 * sizeof(unsigned long))];
+
+static int unit__env_parse_cpus(const char* list, unsigned long* mask, int max_cpus) {
+    int count = 0;
+    const char* p = list;
+    while (p && *p) {
+        char* end;
+        const long first = strtol(p, &end, 10);
+        long last = first;
+        if (end == p || first < 0) {
+            return -1;
+        }
+        p = end;
+        if (*p == '-') {
+            ++p;
+            last = strtol(p, &end, 10);
+            if (end == p || last < first) {
+                return -1;
+            }
+            p = end;
+        }
+        if (*p == ',') {
+            ++p;
+        } else if (*p) {
+            return -1;
+        }
+        for (long cpu = first; cpu <= last && cpu < max_cpus; ++cpu) {
+            const int bits = (int) (8 * sizeof mask[0]);
+            if (!(mask[cpu / bits] & (1ul << (cpu % bits)))) {
+                mask[cpu / bits] |= 1ul << (cpu % bits);
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+static const char* unit__env_pin(const char* list) {
+    unsigned long* mask = unit__env_mask;
+    memset(unit__env_mask, 0, sizeof unit__env_mask);
+    const int count = unit__env_parse_cpus(list, mask, UNIT__ENV_MAX_CPUS);
+    if (count <= 0) {
+        return "invalid `--cpus` list";
+    }
+    unit__env.cpus_count = count;
+#ifdef __linux__
+    if (syscall(SYS_sched_setaffinity, 0, sizeof unit__env_mask, mask) != 0) {
+        return "unable to set CPU affinity";
+    }
+    return NULL;
+#else // __linux__
+    return "CPU affinity is not supported on this platform";
+#endif // !__linux__
+}
+
+static int unit__env_cpu_pinned(int cpu) {
+    if (!unit__env.cpus_count || !unit__env.cpus[0]) {
+        return 1;
+    }
+    const int bits = (int) (8 * sizeof unit__env_mask[0]);
+    return (unit__env_mask[cpu / bits] & (1ul << (cpu % bits))) != 0;
+}
+
+static void unit__env_read_governor(void) {
+    strcpy(unit__env.governor, "unknown");
+    bool found = false;
+    for (int cpu = 0; cpu < UNIT__ENV_MAX_CPUS; ++cpu) {
+        char path[96];
+        snprintf(path, sizeof path, "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_governor", cpu);
+        FILE* f = fopen(path, "r");
+        if (!f) {
+            // CPUs are enumerated sequentially
+            break;
+        }
+        char governor[32] = {0};
+        if (fgets(governor, sizeof governor, f)) {
+            governor[strcspn(governor, "\r\n")] = 0;
+        }
+        fclose(f);
+        if (!unit__env_cpu_pinned(cpu)) {
+            continue;
+        }
+        if (!found) {
+            strcpy(unit__env.governor, governor);
+            found = true;
+        } else if (strcmp(unit__env.governor, governor) != 0) {
+            strcpy(unit__env.governor, "mixed");
+        }
+    }
+}
+
+static int unit__env_cmp_time(const void* a, const void* b) {
+    const int64_t x = *(const int64_t*) a;
+    const int64_t y = *(const int64_t*) b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static void unit__env_calibrate(void) {
+    int64_t samples[UNIT__ENV_SAMPLES];
+    volatile unsigned acc = 0;
+    for (int i = 0; i < UNIT__ENV_SAMPLES; ++i) {
+        const int64_t t0 = unit__clock.now();
+        for (unsigned j = 0; j < 100000; ++j) {
+            acc = acc * 1664525u + 1013904223u;
+        }
+        samples[i] = unit__clock.now() - t0;
+    }
+    qsort(samples, UNIT__ENV_SAMPLES, sizeof samples[0], unit__env_cmp_time);
+    const int64_t q1 = samples[UNIT__ENV_SAMPLES / 4];
+    const int64_t median = samples[UNIT__ENV_SAMPLES / 2];
+    const int64_t q3 = samples[3 * UNIT__ENV_SAMPLES / 4];
+    unit__env.calibration = median;
+    // interquartile range is not affected by single preemption spikes
+    unit__env.jitter = median > 0 ? (double) (q3 - q1) / (double) median : 0.0;
+}
+
+/**
+ * Pins the runner to `--cpus`, captures frequency governor and timer jitter.
+ * Returns false if environment is not suitable for benchmarking and `--strict-env` is set.
+ */
+static bool unit__env_setup(void) {
+    unit__env = (struct unit_env) {0};
+    strcpy(unit__env.governor, "unknown");
+    if (unit__opts.cpus && unit__opts.cpus[0]) {
+        snprintf(unit__env.cpus, sizeof unit__env.cpus, "%s", unit__opts.cpus);
+        unit__env.issue = unit__env_pin(unit__opts.cpus);
+    }
+#ifdef __linux__
+    if (!unit__env.cpus_count) {
+        unit__env.cpus_count = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    }
+#endif // __linux__
+    const bool benchmarking = unit__env.cpus[0] || unit__opts.strict_env;
+    if (!benchmarking && !unit__opts.env) {
+        // the governor scan and the calibration loop are not paid by regular runs
+        return true;
+    }
+    unit__env_read_governor();
+    unit__env_calibrate();
+
+    if (!unit__env.issue && strcmp(unit__env.governor, "performance") != 0 &&
+        strcmp(unit__env.governor, "unknown") != 0) {
+        unit__env.issue = "CPU frequency governor is not `performance`";
+    }
+    if (!unit__env.issue && unit__env.jitter > UNIT_ENV_MAX_JITTER) {
+        unit__env.issue = "calibration loop jitter is too high";
+    }
+
+    if (unit__env.issue && benchmarking && !unit__opts.quiet) {
+        fprintf(stderr, "unit: %s: %s (governor: %s, jitter: %0.2f%%)\n",
+                unit__opts.strict_env ? "error" : "warning", unit__env.issue,
+                unit__env.governor, 100.0 * unit__env.jitter);
+    }
+    return !(unit__env.issue && unit__opts.strict_env);
+}
+
+// endregion
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#define UNIT__HAS_RUSAGE 1
+
+#if defined(__linux__) && !defined(RUSAGE_THREAD)
+// available without `_GNU_SOURCE` since Linux 2.6.26
+#define RUSAGE_THREAD 1
+#endif
+
+#endif // unix
+
+// region использование ресурсов: время CPU, память, page faults, переключения контекста
+
+static int64_t unit__read_rss(void) {
+    int64_t rss = 0;
+#ifdef __linux__
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (f) {
+        long size = 0;
+        long resident = 0;
+        if (fscanf(f, "%ld %ld", &size, &resident) == 2) {
+            rss = (int64_t) resident * sysconf(_SC_PAGESIZE);
+        }
+        fclose(f);
+    }
+#endif // __linux__
+    return rss;
+}
+
+static void unit__sample_resources(struct unit_resources* out) {
+    *out = (struct unit_resources) {0};
+#ifdef UNIT__HAS_RUSAGE
+    struct rusage ru = {0};
+#ifdef RUSAGE_THREAD
+    if (getrusage(RUSAGE_THREAD, &ru) != 0)
+#endif // RUSAGE_THREAD
+        getrusage(RUSAGE_SELF, &ru);
+    out->user = (int64_t) ru.ru_utime.tv_sec * 1000000000 + (int64_t) ru.ru_utime.tv_usec * 1000;
+    out->sys = (int64_t) ru.ru_stime.tv_sec * 1000000000 + (int64_t) ru.ru_stime.tv_usec * 1000;
+#ifdef __APPLE__
+    out->max_rss = ru.ru_maxrss;
+#else // __APPLE__
+    out->max_rss = (int64_t) ru.ru_maxrss * 1024;
+#endif // !__APPLE__
+    out->minflt = ru.ru_minflt;
+    out->majflt = ru.ru_majflt;
+    out->nvcsw = ru.ru_nvcsw;
+    out->nivcsw = ru.ru_nivcsw;
+#endif // UNIT__HAS_RUSAGE
+    out->rss = unit__read_rss();
+}
+
+/**
+ * Converts `end` snapshot to usage delta since `begin`, peak RSS stays absolute
+ */
+static void unit__diff_resources(struct unit_resources* end, const struct unit_resources* begin) {
+    end->user -= begin->user;
+    end->sys -= begin->sys;
+    end->rss -= begin->rss;
+    end->minflt -= begin->minflt;
+    end->majflt -= begin->majflt;
+    end->nvcsw -= begin->nvcsw;
+    end->nivcsw -= begin->nivcsw;
+}
+
+// endregion
+
+#if defined(_WIN32)
+
+#include <windows.h>
+
+#define UNIT__SCRATCH_VIRTUAL_ALLOC 1
+
+#elif (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+
+#include <sys/mman.h>
+#include <pthread.h>
+
+#define UNIT__SCRATCH_MMAP 1
+
+#endif
+
+// region scratch-арена: временная память теста, освобождается в конце теста
+
+#ifndef UNIT_SCRATCH_RESERVE
+// address space reserved for each thread's arena, pages are committed on demand
+#if defined(UNIT__SCRATCH_MMAP) || defined(UNIT__SCRATCH_VIRTUAL_ALLOC)
+#define UNIT_SCRATCH_RESERVE ((size_t) 1 << 30)
+#else
+#define UNIT_SCRATCH_RESERVE ((size_t) 64 << 20)
+#endif
+#endif // !UNIT_SCRATCH_RESERVE
+
+#ifndef UNIT_SCRATCH_POISON
+// fill rewound memory to catch use of scratch memory after the test end
+#ifdef NDEBUG
+#define UNIT_SCRATCH_POISON 0
+#else
+#define UNIT_SCRATCH_POISON 1
+#endif
+#endif // !UNIT_SCRATCH_POISON
+
+#define UNIT__SCRATCH_POISON_BYTE 0xDD
+#define UNIT__SCRATCH_COMMIT_CHUNK ((size_t) 1 << 20)
+
+struct unit__arena {
+    char* base;
+    size_t top;
+    // high-water mark since the current node begin
+    size_t high;
+    // committed bytes (`VirtualAlloc` only)
+    size_t committed;
+    // test end counter when arena was rewound
+    unsigned epoch;
+};
+
+static __thread struct unit__arena unit__scratch;
+// incremented at each test end, arenas of other threads are rewound lazily
+static unsigned unit__scratch_epoch = 0;
+
+#ifdef UNIT__SCRATCH_MMAP
+
+// arenas of threads spawned by tests are unmapped at the thread exit
+static pthread_key_t unit__scratch_key;
+static pthread_once_t unit__scratch_key_once = PTHREAD_ONCE_INIT;
+
+static void unit__scratch_release(void* ptr) {
+    struct unit__arena* arena = (struct unit__arena*) ptr;
+    munmap(arena->base, UNIT_SCRATCH_RESERVE);
+    arena->base = NULL;
+    arena->top = 0;
+    arena->high = 0;
+}
+
+static void unit__scratch_key_create(void) {
+    pthread_key_create(&unit__scratch_key, unit__scratch_release);
+}
+
+#endif // UNIT__SCRATCH_MMAP
+
+static bool unit__arena_reserve(struct unit__arena* arena) {
+#if defined(UNIT__SCRATCH_MMAP)
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+    flags |= MAP_NORESERVE;
+#endif // MAP_NORESERVE
+    void* base = mmap(NULL, UNIT_SCRATCH_RESERVE, PROT_READ | PROT_WRITE, flags, -1, 0);
+    arena->base = base == MAP_FAILED ? NULL : (char*) base;
+    if (arena->base) {
+        pthread_once(&unit__scratch_key_once, unit__scratch_key_create);
+        pthread_setspecific(unit__scratch_key, arena);
+    }
+#elif defined(UNIT__SCRATCH_VIRTUAL_ALLOC)
+    arena->base = (char*) VirtualAlloc(NULL, UNIT_SCRATCH_RESERVE, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    arena->base = (char*) malloc(UNIT_SCRATCH_RESERVE);
+#endif
+    return arena->base != NULL;
+}
+
+static bool unit__arena_commit(struct unit__arena* arena, size_t size) {
+#ifdef UNIT__SCRATCH_VIRTUAL_ALLOC
+    if (size > arena->committed) {
+        size_t end = (size + UNIT__SCRATCH_COMMIT_CHUNK - 1) & ~(UNIT__SCRATCH_COMMIT_CHUNK - 1);
+        if (end > UNIT_SCRATCH_RESERVE) {
+            end = UNIT_SCRATCH_RESERVE;
+        }
+        if (!VirtualAlloc(arena->base + arena->committed, end - arena->committed, MEM_COMMIT, PAGE_READWRITE)) {
+            return false;
+        }
+        arena->committed = end;
+    }
+#else // UNIT__SCRATCH_VIRTUAL_ALLOC
+    (void) arena;
+    (void) size;
+#endif // !UNIT__SCRATCH_VIRTUAL_ALLOC
+    return true;
+}
+
+static void unit__arena_rewind(struct unit__arena* arena, size_t mark) {
+    if (arena->top > mark) {
+#if UNIT_SCRATCH_POISON
+        memset(arena->base + mark, UNIT__SCRATCH_POISON_BYTE, arena->top - mark);
+#endif // UNIT_SCRATCH_POISON
+        arena->top = mark;
+    }
+}
+
+/**
+ * Allocates temporary memory for the current test.
+ * Memory is valid until the end of the test, there is no need to free it.
+ * Each thread has own arena, so the function could be used from threads spawned by the test.
+ * Returns NULL if arena capacity `UNIT_SCRATCH_RESERVE` is exceeded.
+ */
+void* unit_scratch_alloc(size_t size, size_t align) {
+    struct unit__arena* arena = &unit__scratch;
+    if (!arena->base && !unit__arena_reserve(arena)) {
+        return NULL;
+    }
+    const unsigned epoch = __atomic_load_n(&unit__scratch_epoch, __ATOMIC_ACQUIRE);
+    if (arena->epoch != epoch) {
+        // memory allocated by this thread during the previous test
+        unit__arena_rewind(arena, 0);
+        arena->high = 0;
+        arena->epoch = epoch;
+    }
+    if (align == 0 || (align & (align - 1)) != 0) {
+        align = sizeof(void*);
+    }
+    const size_t begin = (arena->top + align - 1) & ~(align - 1);
+    if (begin > UNIT_SCRATCH_RESERVE || size > UNIT_SCRATCH_RESERVE - begin ||
+        !unit__arena_commit(arena, begin + size)) {
+        return NULL;
+    }
+    arena->top = begin + size;
+    if (arena->top > arena->high) {
+        arena->high = arena->top;
+    }
+    return arena->base + begin;
+}
+
+static void unit__scratch_begin(struct unit_test* unit) {
+    struct unit__arena* arena = &unit__scratch;
+    arena->epoch = unit__scratch_epoch;
+    unit->scratch_mark = arena->top;
+    unit->scratch_peak = arena->high;
+    arena->high = arena->top;
+}
+
+static void unit__scratch_end(struct unit_test* unit) {
+    struct unit__arena* arena = &unit__scratch;
+    const size_t high = arena->high;
+    // parent's high-water mark is saved in `scratch_peak` until the node end
+    const size_t parent_high = unit->scratch_peak;
+    unit->scratch_peak = high - unit->scratch_mark;
+    arena->high = high > parent_high ? high : parent_high;
+    unit__arena_rewind(arena, unit->scratch_mark);
+    if (unit->type == UNIT__TYPE_TEST) {
+        __atomic_add_fetch(&unit__scratch_epoch, 1, __ATOMIC_RELEASE);
+        arena->epoch = unit__scratch_epoch;
+    }
+}
+
+// endregion
+
+// region записи об ошибках: типизированные значения, форматируются каждым принтером по необходимости
+
+#ifndef UNIT_FAIL_RECORDS
+// maximum number of failure records stored for the single test, the last record is reused on overflow
+#define UNIT_FAIL_RECORDS 16
+#endif
+
+#ifndef UNIT_FAIL_TEXT
+// capacity of the per-test arena for copied string operands and bulk assertion details
+#define UNIT_FAIL_TEXT 16384
+#endif
+
+// style markers in formatted failure text: printers replace them with colors or strip them
+#define UNIT__MARK_SUCCESS '\x01'
+#define UNIT__MARK_FAIL '\x02'
+#define UNIT__MARK_RESET '\x03'
+#define UNIT__MARK_SUCCESS_S "\x01"
+#define UNIT__MARK_FAIL_S "\x02"
+#define UNIT__MARK_RESET_S "\x03"
+
+// operands are stored widened, the tag keeps the original precision for formatting
+enum {
+    UNIT__VALUE_INT = 0,
+    UNIT__VALUE_UINT = 1,
+    UNIT__VALUE_FLT = 2,
+    UNIT__VALUE_DBL = 3,
+    UNIT__VALUE_LDBL = 4,
+    UNIT__VALUE_PTR = 5,
+    UNIT__VALUE_STR = 6
+};
+
+struct unit__value {
+    int tag;
+    union {
+        intmax_t i;
+        uintmax_t u;
+        long double d;
+        const void* p;
+        const char* s;
+    };
+};
+
+enum {
+    // binary or unary comparison of two values
+    UNIT__FAIL_COMPARE = 0,
+    // pre-formatted details of bulk assertion
+    UNIT__FAIL_TEXT = 1
+};
+
+struct unit__fail_record {
+    int kind;
+    int op;
+    const struct unit__assert_site* site;
+    // stringified operand expressions
+    const char* sa;
+    const char* sb;
+    struct unit__value a;
+    struct unit__value b;
+    // marked text of `UNIT__FAIL_TEXT` record, stored in the arena
+    const char* text;
+};
+
+static struct unit__fail_record unit__fail_pool[UNIT_FAIL_RECORDS];
+static int unit__fail_pool_num = 0;
+static char unit__fail_arena[UNIT_FAIL_TEXT];
+static size_t unit__fail_arena_len = 0;
+
+static const char* unit__op_expl[] = {
+        " is true",
+        " is false",
+        " == ",
+        " != ",
+        " < ",
+        " <= ",
+        " > ",
+        " >= ",
+};
+
+static const char* unit__op_nexpl[] = {
+        " is not true",
+        " is not false",
+        " != ",
+        " == ",
+        " >= ",
+        " > ",
+        " <= ",
+        " < ",
+};
+
+// records of other threads are queued with their strings in the heap, they are freed when the queue is drained
+struct unit__fail_node {
+    struct unit__fail_record record;
+    struct unit__fail_node* next;
+};
+
+// the record of other thread when the heap is exhausted: it's not queued, but the failed level is still set
+static __thread struct unit__fail_node unit__fail_lost;
+// the string copy of other thread when the heap is exhausted
+static char unit__fail_lost_str[1];
+
+// lock-free stack of failures from other threads, drained by the tests thread at the node end
+static struct unit__fail_node* unit__fail_queue = NULL;
+
+// records are valid until the next test begins
+static void unit__fail_pool_reset(void) {
+    unit__fail_pool_num = 0;
+    unit__fail_arena_len = 0;
+}
+
+static struct unit__fail_record* unit__fail_alloc(int kind) {
+    struct unit__fail_record* r;
+    if (!unit__tls.owner) {
+        struct unit__fail_node* node = (struct unit__fail_node*) malloc(sizeof *node);
+        r = &(node ? node : &unit__fail_lost)->record;
+    } else if (unit__fail_pool_num < UNIT_FAIL_RECORDS) {
+        r = unit__fail_pool + unit__fail_pool_num++;
+    } else {
+        r = unit__fail_pool + UNIT_FAIL_RECORDS - 1;
+    }
+    memset(r, 0, sizeof *r);
+    r->kind = kind;
+    r->site = unit__tls.site;
+    return r;
+}
+
+/**
+ * Copies string to the per-test arena, truncates it if the arena is full.
+ * Other threads copy to the heap, strings are moved to the per-test arena when the queue is drained.
+ */
+static const char* unit__fail_strdup(const char* str) {
+    if (!unit__tls.owner && str) {
+        const size_t size = strlen(str) + 1;
+        char* copy = (char*) malloc(size);
+        return copy ? (const char*) memcpy(copy, str, size) : unit__fail_lost_str;
+    }
+    const size_t available = sizeof unit__fail_arena - unit__fail_arena_len;
+    if (!str || available == 0) {
+        return str ? "" : NULL;
+    }
+    size_t len = strlen(str);
+    if (len >= available) {
+        len = available - 1;
+    }
+    char* copy = unit__fail_arena + unit__fail_arena_len;
+    memcpy(copy, str, len);
+    copy[len] = 0;
+    unit__fail_arena_len += len + 1;
+    return copy;
+}
+
+/**
+ * Frees the string copied by other thread, copies of the tests thread are in the per-test arena
+ */
+static void unit__fail_strfree(const char* str) {
+    if (!unit__tls.owner && str != unit__fail_lost_str) {
+        free((void*) str);
+    }
+}
+
+static void unit__fail_free(struct unit__fail_node* node) {
+    const struct unit__fail_record* r = &node->record;
+    const char* strs[] = {r->a.tag == UNIT__VALUE_STR ? r->a.s : NULL, r->b.tag == UNIT__VALUE_STR ? r->b.s : NULL, r->text};
+    for (size_t i = 0; i < sizeof strs / sizeof *strs; ++i) {
+        if (strs[i] != unit__fail_lost_str) {
+            free((void*) strs[i]);
+        }
+    }
+    if (node != &unit__fail_lost) {
+        free(node);
+    }
+}
+
+static void unit__fail_post(struct unit__fail_record* record) {
+    struct unit__fail_node* node = (struct unit__fail_node*) record;
+    if (node == &unit__fail_lost) {
+        unit__fail_free(node);
+        return;
+    }
+    node->next = __atomic_load_n(&unit__fail_queue, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&unit__fail_queue, &node->next, node, true, __ATOMIC_RELEASE,
+                                        __ATOMIC_RELAXED)) {
+    }
+}
+
+/**
+ * Takes all queued records in posting order
+ */
+static struct unit__fail_node* unit__fail_take(void) {
+    struct unit__fail_node* node = __atomic_exchange_n(&unit__fail_queue, NULL, __ATOMIC_ACQUIRE);
+    struct unit__fail_node* list = NULL;
+    while (node) {
+        struct unit__fail_node* next = node->next;
+        node->next = list;
+        list = node;
+        node = next;
+    }
+    return list;
+}
+
+/**
+ * Copies queued record to the pool of the tests thread
+ */
+static struct unit__fail_record* unit__fail_adopt(const struct unit__fail_record* queued) {
+    struct unit__fail_record* r = unit__fail_alloc(queued->kind);
+    *r = *queued;
+    if (r->a.tag == UNIT__VALUE_STR) {
+        r->a.s = unit__fail_strdup(r->a.s);
+    }
+    if (r->b.tag == UNIT__VALUE_STR) {
+        r->b.s = unit__fail_strdup(r->b.s);
+    }
+    r->text = unit__fail_strdup(r->text);
+    return r;
+}
+
+#define UNIT__VALUE(Tag, Type, Member, TagId) \
+static struct unit__value unit__value_ ## Tag(Type x) { \
+    struct unit__value v; \
+    v.tag = TagId; \
+    v.Member = x; \
+    return v; \
+}
+
+UNIT__VALUE(int, int, i, UNIT__VALUE_INT)
+UNIT__VALUE(uint, unsigned int, u, UNIT__VALUE_UINT)
+UNIT__VALUE(long, long, i, UNIT__VALUE_INT)
+UNIT__VALUE(ulong, unsigned long, u, UNIT__VALUE_UINT)
+UNIT__VALUE(llong, long long, i, UNIT__VALUE_INT)
+UNIT__VALUE(ullong, unsigned long long, u, UNIT__VALUE_UINT)
+UNIT__VALUE(flt, float, d, UNIT__VALUE_FLT)
+UNIT__VALUE(dbl, double, d, UNIT__VALUE_DBL)
+UNIT__VALUE(ldbl, long double, d, UNIT__VALUE_LDBL)
+UNIT__VALUE(ptr, const void*, p, UNIT__VALUE_PTR)
+UNIT__VALUE(imax, intmax_t, i, UNIT__VALUE_INT)
+UNIT__VALUE(umax, uintmax_t, u, UNIT__VALUE_UINT)
+
+static struct unit__value unit__value_str(const char* x) {
+    struct unit__value v;
+    v.tag = UNIT__VALUE_STR;
+    // operand could be freed right after the assertion
+    v.s = unit__fail_strdup(x);
+    return v;
+}
+
+struct unit__text {
+    char* data;
+    size_t cap;
+    size_t len;
+};
+
+__attribute__((format(printf, 2, 3)))
+static void unit__text_printf(struct unit__text* text, const char* fmt, ...) {
+    if (text->len + 1 >= text->cap) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    const int n = vsnprintf(text->data + text->len, text->cap - text->len, fmt, args);
+    va_end(args);
+    if (n > 0) {
+        text->len += (size_t) n;
+        if (text->len >= text->cap) {
+            text->len = text->cap - 1;
+        }
+    }
+}
+
+/**
+ * Prints the shortest representation which is parsed back to the same value
+ */
+static void unit__format_real(struct unit__text* text, long double x, int tag) {
+    char buf[64];
+    const int max_digits = tag == UNIT__VALUE_FLT ? 9 : (tag == UNIT__VALUE_DBL ? 17 : 21);
+    for (int digits = 6; digits <= max_digits; ++digits) {
+        snprintf(buf, sizeof buf, "%.*Lg", digits, x);
+        const bool exact = tag == UNIT__VALUE_FLT ? strtof(buf, NULL) == (float) x :
+                           (tag == UNIT__VALUE_DBL ? strtod(buf, NULL) == (double) x : strtold(buf, NULL) == x);
+        if (exact) {
+            break;
+        }
+    }
+    unit__text_printf(text, "%s", buf);
+}
+
+static void unit__format_value(struct unit__text* text, const struct unit__value* v) {
+    switch (v->tag) {
+        case UNIT__VALUE_INT:
+            unit__text_printf(text, "%jd", v->i);
+            break;
+        case UNIT__VALUE_UINT:
+            unit__text_printf(text, "%ju", v->u);
+            break;
+        case UNIT__VALUE_FLT:
+        case UNIT__VALUE_DBL:
+        case UNIT__VALUE_LDBL:
+            unit__format_real(text, v->d, v->tag);
+            break;
+        case UNIT__VALUE_PTR:
+            unit__text_printf(text, "%p", v->p);
+            break;
+        case UNIT__VALUE_STR:
+            unit__text_printf(text, "%s", v->s ? v->s : "(null)");
+            break;
+    }
+}
+
+/**
+ * Formats failure message with style markers
+ */
+static void unit__format_fail(struct unit__text* text, const struct unit__fail_record* r) {
+    if (r->kind == UNIT__FAIL_TEXT) {
+        unit__text_printf(text, "%s", r->text);
+        return;
+    }
+    const char* expl = unit__op_expl[r->op];
+    const char* nexpl = unit__op_nexpl[r->op];
+    if (r->op < UNIT__OP_EQ) {
+        unit__text_printf(text, "Expected " UNIT__MARK_SUCCESS_S "`%s`%s" UNIT__MARK_RESET_S ", but got "
+                                UNIT__MARK_FAIL_S "`", r->sb, expl);
+        unit__format_value(text, &r->b);
+        unit__text_printf(text, "%s`" UNIT__MARK_RESET_S, nexpl);
+    } else {
+        unit__text_printf(text, "Expected " UNIT__MARK_SUCCESS_S "`%s`%s`%s`" UNIT__MARK_RESET_S ", but got "
+                                UNIT__MARK_FAIL_S "`", r->sa, expl, r->sb);
+        unit__format_value(text, &r->a);
+        unit__text_printf(text, "%s", nexpl);
+        unit__format_value(text, &r->b);
+        unit__text_printf(text, "`" UNIT__MARK_RESET_S);
+    }
+}
+
+/**
+ * Formats failure message as plain text without style markers
+ */
+static void unit__format_fail_plain(char* buffer, size_t size, const struct unit__fail_record* r) {
+    struct unit__text text = {buffer, size, 0};
+    buffer[0] = 0;
+    unit__format_fail(&text, r);
+    char* out = buffer;
+    for (const char* p = buffer; *p; ++p) {
+        if (*p != UNIT__MARK_SUCCESS && *p != UNIT__MARK_FAIL && *p != UNIT__MARK_RESET) {
+            *(out++) = *p;
+        }
+    }
+    *out = 0;
+}
+
+// endregion
+
+// region самые медленные тесты: `--durations=N`, ограниченные min-heap без выделения памяти на каждый узел
+
+#ifndef UNIT_DURATIONS_MAX
+// maximum number of reported slowest tests and suites
+#define UNIT_DURATIONS_MAX 64
+#endif
+
+// min-heap by elapsed time: the root is the fastest of kept nodes, it is replaced by a slower node
+struct unit__durations {
+    struct unit_test* nodes[UNIT_DURATIONS_MAX];
+    int num;
+};
+
+static struct unit__durations unit__slowest_tests;
+static struct unit__durations unit__slowest_suites;
+
+static void unit__durations_push(struct unit__durations* heap, int limit, struct unit_test* node) {
+    struct unit_test** h = heap->nodes;
+    int i;
+    if (heap->num < limit) {
+        i = heap->num++;
+        while (i > 0 && node->elapsed < h[(i - 1) / 2]->elapsed) {
+            h[i] = h[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        h[i] = node;
+        return;
+    }
+    if (heap->num == 0 || node->elapsed <= h[0]->elapsed) {
+        return;
+    }
+    i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= heap->num) {
+            break;
+        }
+        if (child + 1 < heap->num && h[child + 1]->elapsed < h[child]->elapsed) {
+            ++child;
+        }
+        if (h[child]->elapsed >= node->elapsed) {
+            break;
+        }
+        h[i] = h[child];
+        i = child;
+    }
+    h[i] = node;
+}
+
+// copies kept nodes to `out` starting from the slowest one, returns the number of nodes
+static int unit__durations_sorted(const struct unit__durations* heap, struct unit_test** out) {
+    for (int i = 0; i < heap->num; ++i) {
+        struct unit_test* node = heap->nodes[i];
+        int j = i;
+        for (; j > 0 && out[j - 1]->elapsed < node->elapsed; --j) {
+            out[j] = out[j - 1];
+        }
+        out[j] = node;
+    }
+    return heap->num;
+}
+
+static void printer_durations(int cmd, struct unit_test* node, const char* msg) {
+    (void) msg;
+    const int limit = unit__opts.durations < UNIT_DURATIONS_MAX ? unit__opts.durations : UNIT_DURATIONS_MAX;
+    switch (cmd) {
+        case UNIT__PRINTER_SETUP:
+            unit__slowest_tests.num = 0;
+            unit__slowest_suites.num = 0;
+            break;
+        case UNIT__PRINTER_END:
+            if (node->status == UNIT_STATUS_SKIPPED) {
+                break;
+            }
+            if (node->type == UNIT__TYPE_TEST) {
+                unit__durations_push(&unit__slowest_tests, limit, node);
+            }
+            if (!node->parent) {
+                unit__durations_push(&unit__slowest_suites, limit, node);
+            }
+            break;
+    }
+}
+
+// endregion
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <unistd.h>
+
+#endif // unix
+
+// region Цвета, текстовые сообщения и логи
+
+#define UNIT_COLOR_RESET "\033[m"
+#define UNIT_COLOR_BOLD "\033[1m"
+#define UNIT_COLOR_DIM "\033[2m"
+#define UNIT_COLOR_UNDERLINE "\033[4m"
+#define UNIT_COLOR_MAYBE "\033[35m"
+#define UNIT_COLOR_COMMENT "\033[36m"
+#define UNIT_COLOR_SUCCESS "\033[32m"
+#define UNIT_COLOR_FAIL "\033[31m"
+#define UNIT_COLOR_DESC "\033[33m"
+#define UNIT_COLOR_INVERT_PASS "\033[30;42m"
+#define UNIT_COLOR_LABEL_PASS UNIT_COLOR_BOLD UNIT_COLOR_INVERT_PASS
+#define UNIT_COLOR_LABEL_FAIL UNIT_COLOR_BOLD "\033[30;41m"
+#define UNIT_COLOR_LABEL_SKIP UNIT_COLOR_BOLD "\033[30;47m"
+#define UNIT_COLOR_LABEL_RUNS UNIT_COLOR_BOLD "\033[30;46m"
+
+/**
+ * Alternative icons:
+ * message icons: "💬 ", "# ", "ℹ ", " ⃫ "
+ * skip icons: "Ⅱ "
+ */
+
+enum {
+    ICON_RUN = 0,
+    ICON_OK = 1,
+    ICON_SKIP = 2,
+    ICON_FAIL = 3,
+    ICON_ASSERT = 4,
+    ICON_MSG = 5
+};
+
+static const char* icon(int type) {
+    static const char* fancy[] = {
+            UNIT_COLOR_BOLD UNIT_COLOR_SUCCESS "▶ " UNIT_COLOR_RESET,
+            UNIT_COLOR_BOLD UNIT_COLOR_SUCCESS "✓ " UNIT_COLOR_RESET,
+            UNIT_COLOR_BOLD UNIT_COLOR_DIM "∅ " UNIT_COLOR_RESET,
+            UNIT_COLOR_BOLD UNIT_COLOR_FAIL "✕ " UNIT_COLOR_RESET,
+            UNIT_COLOR_BOLD UNIT_COLOR_FAIL "● " UNIT_COLOR_RESET,
+            UNIT_COLOR_BOLD UNIT_COLOR_COMMENT "» " UNIT_COLOR_RESET,
+    };
+    static const char* ascii[] = {
+            "> ",
+            "+ ",
+            ". ",
+            "x ",
+            "! ",
+            "# ",
+    };
+    return unit__opts.ascii ? ascii[type] : fancy[type];
+}
+
+// region reporting
+
+static void unit__sleep(double seconds) {
+#ifndef _WIN32
+    const long secs = (long) seconds;
+    const long nanos = (long) ((seconds - (double) secs) * 1000000000.0);
+    struct timespec ts = {secs, nanos};
+    nanosleep(&ts, NULL);
+#endif
+}
+
+#ifndef UNIT_OUTPUT_BUFFER
+// size of the library buffer for `stdout` output, it is written when the suite ends or the buffer is full
+#define UNIT_OUTPUT_BUFFER (64 * 1024)
+#endif
+
+#ifndef UNIT_OUTPUT_TICK
+// interval between progress flushes in nanoseconds, if output is a terminal
+#define UNIT_OUTPUT_TICK 50000000
+#endif
+
+// printers output to `stdout` is collected here and written with `fwrite`, the buffering mode of `stdout`
+// belongs to the program, and the pending output is written at exit and by the crash handler
+static char unit__output_buffer[UNIT_OUTPUT_BUFFER];
+static size_t unit__output_size = 0;
+// destination of the notified printer, reporters selected with `-r=name:FILE` write to their own files,
+// it is per thread because reporters may be notified by the reporter thread, see `--async-report`
+static __thread FILE* unit__printer_out = NULL;
+static bool unit__output_tty = false;
+static int64_t unit__output_flushed = 0;
+
+static bool unit__is_tty(FILE* f) {
+#if defined(__unix__) || defined(__APPLE__)
+    return isatty(fileno(f)) != 0;
+#elif defined(_WIN32)
+    return _isatty(_fileno(f)) != 0;
+#else
+    (void) f;
+    return false;
+#endif
+}
+
+static void unit__output_write(void) {
+    if (unit__output_size) {
+        fwrite(unit__output_buffer, 1, unit__output_size, stdout);
+        unit__output_size = 0;
+    }
+}
+
+static void unit__output_flush(FILE* f) {
+    if (f == stdout) {
+        unit__output_write();
+    }
+    fflush(f);
+    unit__output_flushed = unit__clock.now();
+}
+
+static void unit__output_exit(void) {
+    unit__output_flush(stdout);
+}
+
+/**
+ * Writes pending output from the crash handler before the default action kills the process,
+ * only `write` is async-signal-safe there
+ */
+static void unit__output_crash_drain(void) {
+#if defined(__unix__) || defined(__APPLE__)
+    size_t written = 0;
+    while (written < unit__output_size) {
+        const ssize_t n = write(STDOUT_FILENO, unit__output_buffer + written, unit__output_size - written);
+        if (n <= 0) {
+            break;
+        }
+        written += (size_t) n;
+    }
+    unit__output_size = 0;
+#endif
+}
+
+static void unit__output_setup(void) {
+    static bool registered = false;
+    if (!registered) {
+        atexit(unit__output_exit);
+        registered = true;
+    }
+    unit__output_tty = unit__is_tty(stdout);
+    unit__output_flushed = unit__clock.now();
+}
+
+static void unit__fwrite(const void* data, size_t size, FILE* f) {
+    if (f != stdout) {
+        fwrite(data, 1, size, f);
+        return;
+    }
+    if (unit__output_size + size > sizeof unit__output_buffer) {
+        unit__output_write();
+        if (size > sizeof unit__output_buffer) {
+            fwrite(data, 1, size, stdout);
+            return;
+        }
+    }
+    memcpy(unit__output_buffer + unit__output_size, data, size);
+    unit__output_size += size;
+}
+
+static void unit__fputs(const char* text, FILE* f) {
+    unit__fwrite(text, strlen(text), f);
+}
+
+static void unit__fputc(int c, FILE* f) {
+    const char ch = (char) c;
+    unit__fwrite(&ch, 1, f);
+}
+
+__attribute__((format(printf, 2, 3)))
+static void unit__fprintf(FILE* f, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    if (f != stdout) {
+        vfprintf(f, format, args);
+    } else {
+        va_list retry;
+        va_copy(retry, args);
+        const size_t space = sizeof unit__output_buffer - unit__output_size;
+        const int n = vsnprintf(unit__output_buffer + unit__output_size, space, format, args);
+        if (n >= 0 && (size_t) n < space) {
+            unit__output_size += (size_t) n;
+        } else if (n >= 0) {
+            // the text is truncated: write the buffer and format the text again, directly if it's too long
+            unit__output_write();
+            if ((size_t) n < sizeof unit__output_buffer) {
+                unit__output_size = (size_t) vsnprintf(unit__output_buffer, sizeof unit__output_buffer, format, retry);
+            } else {
+                vfprintf(stdout, format, retry);
+            }
+        }
+        va_end(retry);
+    }
+    va_end(args);
+}
+
+/**
+ * Called after each printed fragment: flushes every fragment only for `--animate`,
+ * and shows progress on terminal not more often than `UNIT_OUTPUT_TICK`
+ */
+static void print_wait(FILE* f) {
+    if (unit__opts.animate) {
+        unit__output_flush(f);
+        unit__sleep(0.1);
+    } else if (unit__output_tty && f == stdout && unit__clock.now() - unit__output_flushed >= UNIT_OUTPUT_TICK) {
+        unit__output_flush(f);
+    }
+}
+
+void begin_style(FILE* file, const char* style) {
+    if (style && !unit__opts.ascii) {
+        unit__fputs(style, file);
+    }
+}
+
+void end_style(FILE* file) {
+    if (!unit__opts.ascii) {
+        unit__fputs(UNIT_COLOR_RESET, file);
+    }
+}
+
+void print_text(FILE* file, const char* text, const char* style) {
+    begin_style(file, style);
+    unit__fputs(text, file);
+    end_style(file);
+}
+
+/**
+ * Prints failure text, replacing style markers with colors
+ */
+static void print_marked(FILE* f, const char* text) {
+    for (const char* p = text; *p; ++p) {
+        switch (*p) {
+            case UNIT__MARK_SUCCESS:
+                begin_style(f, UNIT_COLOR_SUCCESS);
+                break;
+            case UNIT__MARK_FAIL:
+                begin_style(f, UNIT_COLOR_FAIL);
+                break;
+            case UNIT__MARK_RESET:
+                end_style(f);
+                break;
+            default:
+                unit__fputc(*p, f);
+                break;
+        }
+    }
+}
+
+static void print_fail_message(FILE* f, struct unit_test* unit) {
+    if (unit->fail_record) {
+        char buffer[UNIT_FAIL_TEXT];
+        struct unit__text text = {buffer, sizeof buffer, 0};
+        buffer[0] = 0;
+        unit__format_fail(&text, unit->fail_record);
+        print_marked(f, buffer);
+    }
+}
+
+#ifndef UNIT_FAIL_JOURNAL
+// failures of the suite are kept in memory up to this size, and spill to anonymous temporary file beyond it
+#define UNIT_FAIL_JOURNAL (64 * 1024)
+#endif
+
+// failures are printed after the suite progress line
+static char unit__journal_mem[UNIT_FAIL_JOURNAL];
+static FILE* unit__fails = 0;
+
+/**
+ * Opens anonymous read-write file: in-memory `memfd` on Linux or `tmpfile`,
+ * data is written to the file only when the memory buffer is full
+ */
+static FILE* unit__journal_open(void) {
+    FILE* f = NULL;
+#if defined(__linux__) && defined(SYS_memfd_create)
+    const int fd = (int) syscall(SYS_memfd_create, "unit-fails", 0);
+    if (fd >= 0) {
+        f = fdopen(fd, "w+");
+        if (!f) {
+            close(fd);
+        }
+    }
+#endif // memfd
+    if (!f) {
+        f = tmpfile();
+    }
+    if (f) {
+        setvbuf(f, unit__journal_mem, _IOFBF, sizeof unit__journal_mem);
+    }
+    return f;
+}
+
+/**
+ * Copies all journal content to the output and closes the journal
+ */
+static void unit__journal_replay(FILE* journal, FILE* out) {
+    char chunk[4096];
+    fflush(journal);
+    rewind(journal);
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof chunk, journal)) > 0) {
+        unit__fwrite(chunk, n, out);
+    }
+    fclose(journal);
+}
+
+static const char* unit_spaces[8] = {
+        "",
+        "  ",
+        "    ",
+        "      ",
+        "        ",
+        "          ",
+        "            ",
+        "              "
+};
+
+static const char* get_spaces(int n) {
+    const int len = sizeof unit_spaces / sizeof unit_spaces[0];
+    if(n < 0) n = 0;
+    if(n >= len) n = len - 1;
+    return unit_spaces[n];
+}
+
+void print_elapsed_time(FILE* f, struct unit_test* node) {
+    if (node->elapsed >= 10000) {
+        begin_style(f, UNIT_COLOR_DIM);
+        unit__fprintf(f, " (%0.2f ms, cpu %0.2f ms)", node->elapsed / 1000000.0, node->cpu_elapsed / 1000000.0);
+        end_style(f);
+    }
+    if (node->fixtures_elapsed >= 10000) {
+        begin_style(f, UNIT_COLOR_DIM);
+        unit__fprintf(f, " (fixtures %0.2f ms)", node->fixtures_elapsed / 1000000.0);
+        end_style(f);
+    }
+    if (node->scratch_peak) {
+        begin_style(f, UNIT_COLOR_DIM);
+        unit__fprintf(f, " (scratch %0.1f KB)", node->scratch_peak / 1024.0);
+        end_style(f);
+    }
+}
+
+static void print_resources(FILE* f, struct unit_test* node) {
+    if (unit__opts.resources) {
+        const struct unit_resources* r = &node->res;
+        begin_style(f, UNIT_COLOR_DIM);
+        unit__fprintf(f, " [user %0.2f ms, sys %0.2f ms, rss %+0.1f KB, max rss %0.1f MB, faults %lld/%lld, csw %lld/%lld]",
+                r->user / 1000000.0, r->sys / 1000000.0, r->rss / 1024.0, r->max_rss / (1024.0 * 1024.0),
+                (long long) r->minflt, (long long) r->majflt, (long long) r->nvcsw, (long long) r->nivcsw);
+        end_style(f);
+    }
+}
+
+static const char* beautify_name(const char* name) {
     return (name && name[0]) ? name : "(anonymous)";
 }
 
-static const char* short_filename(const char* file) {
-    if (file) {
-        const char* p = strrchr(file, '/');
-        if (p) {
-            return p + 1;
+static void print_json_string(FILE* f, const char* str) {
+    unit__fputc('"', f);
+    for (const char* p = str ? str : ""; *p; ++p) {
+        const unsigned char c = (unsigned char) *p;
+        switch (c) {
+            case '"':
+                unit__fputs("\\\"", f);
+                break;
+            case '\\':
+                unit__fputs("\\\\", f);
+                break;
+            case '\n':
+                unit__fputs("\\n", f);
+                break;
+            case '\r':
+                unit__fputs("\\r", f);
+                break;
+            case '\t':
+                unit__fputs("\\t", f);
+                break;
+            default:
+                if (c < 0x20) {
+                    unit__fprintf(f, "\\u%04x", c);
+                } else {
+                    unit__fputc(c, f);
+                }
+                break;
+        }
+    }
+    unit__fputc('"', f);
+}
+
+/**
+ * Prints string escaped for XML attribute or text, control characters which are not allowed in XML 1.0 are dropped
+ */
+static void print_xml_string(FILE* f, const char* str) {
+    for (const char* p = str ? str : ""; *p; ++p) {
+        const unsigned char c = (unsigned char) *p;
+        switch (c) {
+            case '&':
+                unit__fputs("&amp;", f);
+                break;
+            case '<':
+                unit__fputs("&lt;", f);
+                break;
+            case '>':
+                unit__fputs("&gt;", f);
+                break;
+            case '"':
+                unit__fputs("&quot;", f);
+                break;
+            case '\'':
+                unit__fputs("&apos;", f);
+                break;
+            case '\n':
+            case '\r':
+            case '\t':
+                unit__fputc(c, f);
+                break;
+            default:
+                if (c >= 0x20) {
+                    unit__fputc(c, f);
+                }
+                break;
+        }
+    }
+}
+
+static const char* short_filename(const char* file) {
+    if (file) {
+        const char* p = strrchr(file, '/');
+        if (p) {
+            return p + 1;
+        }
+    }
+    return file;
+}
+
+static const char* beautify_filename(const char* file) {
+    return unit__opts.short_filenames ? short_filename(file) : file;
+}
+
+static void print_env(FILE* f) {
+    begin_style(f, UNIT_COLOR_DIM);
+    unit__fprintf(f, "cpus: %s (%d) | ", unit__env.cpus[0] ? unit__env.cpus : "any", unit__env.cpus_count);
+    if (unit__env.calibration) {
+        unit__fprintf(f, "governor: %s | jitter: %0.2f%% | ", unit__env.governor, 100.0 * unit__env.jitter);
+    }
+    unit__fprintf(f, "clock: %s (%d ns)", unit__clock.name, (int) unit__clock.overhead);
+    end_style(f);
+    unit__fputc('\n', f);
+}
+
+static void print_label(FILE* f, struct unit_test* node) {
+    static const char* fancy[] = {
+            UNIT_COLOR_LABEL_RUNS " RUNS " UNIT_COLOR_RESET,
+            UNIT_COLOR_LABEL_PASS " PASS " UNIT_COLOR_RESET,
+            UNIT_COLOR_LABEL_SKIP " SKIP " UNIT_COLOR_RESET,
+            UNIT_COLOR_LABEL_FAIL " FAIL " UNIT_COLOR_RESET,
+    };
+    static const char* ascii[] = {
+            "[ RUNS ]",
+            "[ PASS ]",
+            "[ SKIP ]",
+            "[ FAIL ]",
+    };
+    const int type = node->status;
+    const char* lbl = (unit__opts.ascii ? ascii : fancy)[type];
+
+    unit__fputs(lbl, f);
+    unit__fputc(' ', f);
+    begin_style(f, UNIT_COLOR_BOLD);
+    unit__fputs(beautify_name(node->name), f);
+    end_style(f);
+    unit__fputc(' ', f);
+    switch (node->status) {
+        case UNIT_STATUS_RUN:
+            break;
+        case UNIT_STATUS_SUCCESS:
+        case UNIT_STATUS_FAILED:
+            unit__fprintf(f, ": passed %d/%d tests", node->passed, node->total);
+            print_elapsed_time(f, node);
+            print_resources(f, node);
+            break;
+        default:
+            break;
+    }
+    print_wait(f);
+}
+
+void printer_def_begin(struct unit_test* unit) {
+    FILE* f = unit__printer_out;
+    if (!unit->parent) {
+        print_label(f, unit);
+    }
+}
+
+int def_depth = 0;
+
+const char* unit__spaces(int delta) {
+    return get_spaces(def_depth + delta);
+}
+
+static void print_node(struct unit_test* node) {
+    FILE* f = unit__printer_out;
+    ++def_depth;
+    const char* name = beautify_name(node->name);
+    unit__fputs(unit__spaces(0), f);
+    if (node->type == UNIT__TYPE_CASE) {
+        if (node->status == UNIT_STATUS_SKIPPED) {
+            print_text(f, name, UNIT_COLOR_DIM);
+        } else {
+            print_text(f, name, NULL);
+        }
+    } else {
+        unit__fputs(icon(node->status), f);
+        print_text(f, name, UNIT_COLOR_DIM);
+    }
+    print_elapsed_time(f, node);
+    print_resources(f, node);
+    unit__fputc('\n', f);
+    print_wait(f);
+    for (struct unit_test* child = node->children; child; child = child->next) {
+        print_node(child);
+    }
+    --def_depth;
+}
+
+void printer_def_end(struct unit_test* unit) {
+    FILE* f = unit__printer_out;
+    if (unit->parent) {
+        if (unit->type == UNIT__TYPE_TEST) {
+            unit__fputs(icon(unit->status), f);
+            print_wait(f);
+        }
+        return;
+    }
+    // go back to the beginning of line
+    // unit__fputc('\n', f);
+    // begin_style(f, "\033[1A\033[999D");
+    unit__fputc('\r', f);
+    print_label(f, unit);
+    unit__fputc('\n', f);
+
+    if (unit__fails) {
+        for (struct unit_test* child = unit->children; child; child = child->next) {
+            print_node(child);
+        }
+        unit__fputc('\n', f);
+
+        if (unit__fails != f) {
+            unit__journal_replay(unit__fails, f);
+        }
+        unit__fails = 0;
+
+        unit__fputc('\n', f);
+    }
+    unit__output_flush(f);
+}
+
+static void unit__breadcrumbs(FILE* f, struct unit_test* test, const char* style) {
+    if (test->parent) {
+        unit__breadcrumbs(f, test->parent, style);
+        print_text(f, unit__opts.ascii ? " > " : " → ", UNIT_COLOR_BOLD UNIT_COLOR_DIM);
+    }
+    print_text(f, beautify_name(test->name), style);
+}
+
+void printer_def_fail(struct unit_test* unit) {
+    if (unit__fails == 0) {
+        unit__fails = unit__journal_open();
+        if (!unit__fails) {
+            // print immediately rather than lose the failure
+            unit__fails = unit__printer_out;
+            unit__fputc('\n', unit__printer_out);
+        }
+    }
+    FILE* f = unit__fails;
+    unit__fputs(unit_spaces[1], f);
+    unit__fputs(icon(ICON_ASSERT), f);
+    unit__breadcrumbs(f, unit, UNIT_COLOR_BOLD UNIT_COLOR_FAIL);
+    unit__fputc('\n', f);
+    unit__fputc('\n', f);
+
+    unit__fputs(unit_spaces[2], f);
+    print_fail_message(f, unit);
+    unit__fputc('\n', f);
+    if (unit->assert_file) {
+        unit__fputs(unit_spaces[2], f);
+        print_text(f, "@ ", UNIT_COLOR_COMMENT UNIT_COLOR_DIM UNIT_COLOR_BOLD);
+        begin_style(f, UNIT_COLOR_COMMENT UNIT_COLOR_UNDERLINE);
+        unit__fprintf(f, "%s:%d", beautify_filename(unit->assert_file), unit->assert_line);
+        end_style(f);
+        unit__fputc('\n', f);
+    }
+    unit__fputc('\n', f);
+}
+
+static void print_durations(FILE* f, const char* title, const struct unit__durations* heap) {
+    struct unit_test* nodes[UNIT_DURATIONS_MAX];
+    const int num = unit__durations_sorted(heap, nodes);
+    if (!num) {
+        return;
+    }
+    print_text(f, title, UNIT_COLOR_BOLD);
+    unit__fputc('\n', f);
+    for (int i = 0; i < num; ++i) {
+        struct unit_test* node = nodes[i];
+        unit__fputs(unit_spaces[1], f);
+        begin_style(f, UNIT_COLOR_DESC);
+        unit__fprintf(f, "%10.2f ms", node->elapsed / 1000000.0);
+        end_style(f);
+        unit__fputs("  ", f);
+        unit__breadcrumbs(f, node, UNIT_COLOR_BOLD);
+        print_text(f, " @ ", UNIT_COLOR_COMMENT UNIT_COLOR_DIM UNIT_COLOR_BOLD);
+        begin_style(f, UNIT_COLOR_COMMENT UNIT_COLOR_UNDERLINE);
+        unit__fprintf(f, "%s:%d", beautify_filename(node->file), node->line);
+        end_style(f);
+        unit__fputc('\n', f);
+    }
+    unit__fputc('\n', f);
+}
+
+// endregion reporting
+
+static void printer_def(int cmd, struct unit_test* unit, const char* msg) {
+    switch (cmd) {
+        case UNIT__PRINTER_SETUP:
+            unit__fputs(unit__opts.ascii ? "\n[ unit ] v" UNIT_VERSION "\n\n" :
+                  "\n\033[1;30;42m" " ✓ηỉτ " "\033[0;30;46m" " v" UNIT_VERSION " " "\33[m\n\n", unit__printer_out);
+            print_env(unit__printer_out);
+            unit__fputc('\n', unit__printer_out);
+            print_wait(unit__printer_out);
+            break;
+        case UNIT__PRINTER_SHUTDOWN:
+            print_durations(unit__printer_out, "slowest tests:", &unit__slowest_tests);
+            print_durations(unit__printer_out, "slowest suites:", &unit__slowest_suites);
+            unit__output_flush(unit__printer_out);
+            break;
+        case UNIT__PRINTER_BEGIN:
+            printer_def_begin(unit);
+            break;
+        case UNIT__PRINTER_END:
+            printer_def_end(unit);
+            break;
+        case UNIT__PRINTER_FAIL:
+            printer_def_fail(unit);
+            break;
+            //case UNIT__PRINTER_ASSERTION:
+            //    unit__fputs(icon(unit->assert_status), stdout);
+            //    print_wait(stdout);
+            //    break;
+    }
+}
+
+// region tracing printer
+static int trace_depth = 0;
+
+static const char* trace_spaces(int delta) {
+    return get_spaces(trace_depth + delta);
+}
+
+static void printer_tracing(int cmd, struct unit_test* unit, const char* msg) {
+    FILE* f = unit__printer_out;
+    switch (cmd) {
+        case UNIT__PRINTER_SETUP:
+            print_env(f);
+            break;
+        case UNIT__PRINTER_SHUTDOWN:
+            unit__fputc('\n', f);
+            print_durations(f, "slowest tests:", &unit__slowest_tests);
+            print_durations(f, "slowest suites:", &unit__slowest_suites);
+            break;
+        case UNIT__PRINTER_BEGIN:
+            unit__fputs(trace_spaces(0), f);
+            print_text(f, beautify_name(unit->name), UNIT_COLOR_BOLD);
+            print_text(f, " {\n", UNIT_COLOR_DIM);
+            ++trace_depth;
+            break;
+        case UNIT__PRINTER_END:
+            --trace_depth;
+            unit__fputs(trace_spaces(0), f);
+            print_text(f, "}", UNIT_COLOR_DIM);
+            print_elapsed_time(f, unit);
+            print_resources(f, unit);
+            unit__fputc('\n', f);
+            if (!unit->parent) {
+                unit__output_flush(f);
+            }
+            break;
+        case UNIT__PRINTER_ECHO:
+            unit__fputs(trace_spaces(0), f);
+            unit__fputs(icon(ICON_MSG), f);
+            print_text(f, msg, UNIT_COLOR_COMMENT);
+            unit__fputc('\n', f);
+            break;
+        case UNIT__PRINTER_FAIL:
+            unit__fputs(trace_spaces(0), f);
+            unit__fputs("    Failed: ", f);
+            unit__fputs(beautify_name(unit->name), f);
+            unit__fputc('\n', f);
+
+            unit__fputs(trace_spaces(0), f);
+            unit__fputs("    ", f);
+            print_fail_message(f, unit);
+            unit__fputc('\n', f);
+            break;
+        case UNIT__PRINTER_ASSERTION: {
+            unit__fputs(trace_spaces(0), f);
+            unit__fputs(icon(unit->assert_status), f);
+
+            const char* cm = unit->assert_comment;
+            const char* desc = (cm && cm[0] != '\0') ? cm : unit->assert_desc;
+            unit__fputs(desc, f);
+
+            unit__fputc('\n', f);
+        }
+            break;
+    }
+}
+
+// endregion
+
+static int doctest_depth = 0;
+
+static const char* doctest_spaces(int delta) {
+    return get_spaces(doctest_depth + delta);
+}
+
+static const char* doctest_get_node_type(struct unit_test* node) {
+    if (node->parent) {
+        if (node->parent->parent) {
+            return "SubCase";
+        }
+        return "TestCase";
+    }
+    return "TestSuite";
+}
+
+static void print_xml_path(FILE* f, struct unit_test* node) {
+    if (node->parent) {
+        print_xml_path(f, node->parent);
+        unit__fputs(" &gt; ", f);
+    }
+    print_xml_string(f, beautify_name(node->name));
+}
+
+static void print_xml_durations(FILE* f, const char* type, const struct unit__durations* heap) {
+    struct unit_test* nodes[UNIT_DURATIONS_MAX];
+    const int num = unit__durations_sorted(heap, nodes);
+    for (int i = 0; i < num; ++i) {
+        unit__fprintf(f, "  <Slowest type=\"%s\" path=\"", type);
+        print_xml_path(f, nodes[i]);
+        unit__fputs("\" filename=\"", f);
+        print_xml_string(f, beautify_filename(nodes[i]->file));
+        unit__fprintf(f, "\" line=\"%d\" duration=\"%0.6f\"/>\n", nodes[i]->line, nodes[i]->elapsed / 1e9);
+    }
+}
+
+static void printer_xml_doctest(int cmd, struct unit_test* node, const char* msg) {
+    FILE* f = unit__printer_out;
+    switch (cmd) {
+        case UNIT__PRINTER_SETUP:
+            unit__fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+            // binary="/absolute/path/to/test/executable"
+            unit__fprintf(f, "<unit version=\"" UNIT_VERSION "\">\n");
+            unit__fprintf(f, "  <!-- cpus=\"%s\" cpus_count=\"%d\" governor=\"%s\" jitter=\"%0.4f\" clock=\"%s\" -->\n",
+                    unit__env.cpus[0] ? unit__env.cpus : "any", unit__env.cpus_count,
+                    unit__env.governor, unit__env.jitter, unit__clock.name);
+            unit__fprintf(f,
+                    "  <Options order_by=\"file\" rand_seed=\"0\" first=\"0\" last=\"4294967295\" abort_after=\"0\" subcase_filter_levels=\"2147483647\" case_sensitive=\"false\" no_throw=\"false\" no_skip=\"false\"/>\n");
+            ++doctest_depth;
+            break;
+        case UNIT__PRINTER_SHUTDOWN: {
+            int total = 0;
+            int passed = 0;
+            for (struct unit_test* u = unit_tests; u; u = u->next) {
+                passed += u->passed;
+                total += u->total;
+            }
+            unit__fprintf(f, "  <OverallResultsTestCases successes=\"%d\" failures=\"%d\" expectedFailures=\"%d\" />\n",
+                    passed, total - passed, 0);
+            print_xml_durations(f, "test", &unit__slowest_tests);
+            print_xml_durations(f, "suite", &unit__slowest_suites);
+        }
+            --doctest_depth;
+            unit__fprintf(f, "</unit>\n");
+            unit__output_flush(f);
+            break;
+        case UNIT__PRINTER_BEGIN:
+            unit__fputs(doctest_spaces(0), f);
+            unit__fprintf(f, "<%s name=\"", doctest_get_node_type(node));
+            print_xml_string(f, node->name);
+            unit__fputs("\" filename=\"", f);
+            print_xml_string(f, node->file);
+            unit__fprintf(f, "\" line=\"%d\" skipped=\"%s\">\n", node->line,
+                    node->status == UNIT_STATUS_SKIPPED ? "true" : "false");
+            ++doctest_depth;
+            break;
+        case UNIT__PRINTER_END:
+            if (unit__opts.resources) {
+                const struct unit_resources* r = &node->res;
+                unit__fputs(doctest_spaces(0), f);
+                unit__fprintf(f, "<!-- user_ns=\"%lld\" sys_ns=\"%lld\" rss_delta=\"%lld\" max_rss=\"%lld\" minflt=\"%lld\" majflt=\"%lld\" nvcsw=\"%lld\" nivcsw=\"%lld\" -->\n",
+                        (long long) r->user, (long long) r->sys, (long long) r->rss, (long long) r->max_rss,
+                        (long long) r->minflt, (long long) r->majflt, (long long) r->nvcsw, (long long) r->nivcsw);
+            }
+            --doctest_depth;
+            unit__fputs(doctest_spaces(0), f);
+            unit__fprintf(f, "</%s>\n", doctest_get_node_type(node));
+            break;
+        case UNIT__PRINTER_FAIL:
+            unit__fputs(doctest_spaces(0), f);
+            unit__fprintf(f, "<Expression success=\"%s\" type=\"%s\" filename=\"",
+                    node->status != UNIT_STATUS_FAILED ? "true" : "false", "REQUIRE");
+            print_xml_string(f, beautify_filename(node->assert_file));
+            unit__fprintf(f, "\" line=\"%d\">\n", node->assert_line);
+            unit__fputs(doctest_spaces(1), f);
+            unit__fprintf(f, "<Original>\n");
+            unit__fputs(doctest_spaces(1), f);
+            print_xml_string(f, node->assert_desc);
+            unit__fputc('\n', f);
+            unit__fputs(doctest_spaces(1), f);
+            unit__fprintf(f, "</Original>\n");
+            unit__fputs(doctest_spaces(1), f);
+            unit__fprintf(f, "<Expanded>\n");
+            unit__fputs(doctest_spaces(1), f);
+            if (node->fail_record) {
+                char expanded[UNIT_FAIL_TEXT];
+                unit__format_fail_plain(expanded, sizeof expanded, node->fail_record);
+                print_xml_string(f, expanded);
+            } else {
+                print_xml_string(f, node->assert_desc);
+            }
+            unit__fputc('\n', f);
+            unit__fputs(doctest_spaces(1), f);
+            unit__fprintf(f, "</Expanded>\n");
+            unit__fputs(doctest_spaces(0), f);
+            unit__fprintf(f, "</Expression>\n");
+            break;
+    }
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <unistd.h>
+
+#endif // unix
+
+// region Chrome trace-event printer: `--trace-out=run.json`, loads in `chrome://tracing` or Perfetto
+
+#ifndef UNIT_TRACE_BUFFER
+// number of events buffered in memory before writing them to the file
+#define UNIT_TRACE_BUFFER 4096
+#endif
+
+// node values are copied when the event happens: the node is changed by the next run of the suite, or reused
+// by the next row of `IT_EACH`, before buffered events are written
+struct unit__trace_event {
+    int64_t ts;
+    long tid;
+    union {
+        struct {
+            const char* file;
+            int line;
+            int type;
+        } begin;
+        struct {
+            int64_t cpu_elapsed;
+            int64_t fixtures_elapsed;
+            int64_t assertions;
+            size_t scratch_peak;
+            int status;
+            int passed;
+            int total;
+        } end;
+    };
+    // offsets of node name and message copies in `unit__trace_strings`, -1 if there is no string
+    int name;
+    int msg;
+    // `B`egin, `E`nd or instant event: `F`ail or `M`essage
+    char kind;
+};
+
+static struct unit__trace_event unit__trace_events[UNIT_TRACE_BUFFER];
+static int unit__trace_events_num = 0;
+static char unit__trace_strings[UNIT_TRACE_BUFFER * 16];
+static int unit__trace_strings_len = 0;
+static FILE* unit__trace_file = NULL;
+static int64_t unit__trace_t0 = 0;
+static bool unit__trace_first = true;
+
+static long unit__trace_pid(void) {
+#if defined(__unix__) || defined(__APPLE__)
+    return (long) getpid();
+#else
+    return 1;
+#endif
+}
+
+static long unit__trace_tid(void) {
+#ifdef __linux__
+    // the system call is made once per thread
+    static __thread long tid = 0;
+    if (!tid) {
+        tid = (long) syscall(SYS_gettid);
+    }
+    return tid;
+#else
+    return unit__trace_pid();
+#endif
+}
+
+static const char* unit__trace_string(int offset) {
+    return offset >= 0 ? unit__trace_strings + offset : NULL;
+}
+
+static void unit__trace_flush(void) {
+    FILE* f = unit__trace_file;
+    const long pid = unit__trace_pid();
+    for (int i = 0; i < unit__trace_events_num; ++i) {
+        const struct unit__trace_event* e = unit__trace_events + i;
+        fputs(unit__trace_first ? "\n" : ",\n", f);
+        unit__trace_first = false;
+        const char ph = (e->kind == 'B' || e->kind == 'E') ? e->kind : 'i';
+        fprintf(f, "{\"ph\":\"%c\",\"pid\":%ld,\"tid\":%ld,\"ts\":%0.3f", ph, pid, e->tid, e->ts / 1000.0);
+        switch (e->kind) {
+            case 'B':
+                fputs(",\"cat\":\"", f);
+                fputs(e->begin.type == UNIT__TYPE_TEST ? "test" : "case", f);
+                fputs("\",\"name\":", f);
+                print_json_string(f, beautify_name(unit__trace_string(e->name)));
+                fprintf(f, ",\"args\":{\"file\":");
+                print_json_string(f, beautify_filename(e->begin.file));
+                fprintf(f, ",\"line\":%d}", e->begin.line);
+                break;
+            case 'E':
+                fprintf(f, ",\"args\":{\"status\":%d,\"passed\":%d,\"total\":%d,\"cpu_ms\":%0.3f,\"fixtures_ms\":%0.3f,\"scratch\":%zu,\"assertions\":%lld}",
+                        e->end.status, e->end.passed, e->end.total, e->end.cpu_elapsed / 1000000.0,
+                        e->end.fixtures_elapsed / 1000000.0, e->end.scratch_peak, (long long) e->end.assertions);
+                break;
+            case 'F':
+            case 'M':
+                fputs(e->kind == 'F' ? ",\"cat\":\"fail\"" : ",\"cat\":\"echo\"", f);
+                fputs(",\"s\":\"t\",\"name\":", f);
+                print_json_string(f, unit__trace_string(e->msg));
+                fputs(",\"args\":{\"test\":", f);
+                print_json_string(f, beautify_name(unit__trace_string(e->name)));
+                fputc('}', f);
+                break;
+        }
+        fputc('}', f);
+    }
+    unit__trace_events_num = 0;
+    unit__trace_strings_len = 0;
+}
+
+// copies the string to the strings buffer, huge strings are truncated to fit the half of it
+static int unit__trace_copy(const char* str) {
+    if (!str) {
+        return -1;
+    }
+    const int max_len = (int) sizeof unit__trace_strings / 2;
+    const int size = (int) strnlen(str, (size_t) max_len - 1) + 1;
+    const int offset = unit__trace_strings_len;
+    memcpy(unit__trace_strings + offset, str, (size_t) size - 1);
+    unit__trace_strings[offset + size - 1] = 0;
+    unit__trace_strings_len += size;
+    return offset;
+}
+
+static void unit__trace_push(char kind, struct unit_test* node, const char* msg) {
+    const size_t max_len = sizeof unit__trace_strings / 2;
+    const size_t strings_len = (node && node->name ? strnlen(node->name, max_len) + 1 : 0) +
+                               (msg ? strnlen(msg, max_len) + 1 : 0);
+    if (unit__trace_events_num == UNIT_TRACE_BUFFER ||
+        unit__trace_strings_len + strings_len > sizeof unit__trace_strings) {
+        unit__trace_flush();
+    }
+    struct unit__trace_event* e = unit__trace_events + unit__trace_events_num++;
+    e->ts = unit__clock.now() - unit__trace_t0;
+    e->tid = unit__trace_tid();
+    e->kind = kind;
+    e->name = unit__trace_copy(node ? node->name : NULL);
+    e->msg = unit__trace_copy(msg);
+    if (kind == 'B') {
+        e->begin.file = node->file;
+        e->begin.line = node->line;
+        e->begin.type = node->type;
+    } else if (kind == 'E') {
+        e->end.cpu_elapsed = node->cpu_elapsed;
+        e->end.fixtures_elapsed = node->fixtures_elapsed;
+        e->end.assertions = node->assertions;
+        e->end.scratch_peak = node->scratch_peak;
+        e->end.status = node->status;
+        e->end.passed = node->passed;
+        e->end.total = node->total;
+    }
+}
+
+static void printer_trace_events(int cmd, struct unit_test* unit, const char* msg) {
+    switch (cmd) {
+        case UNIT__PRINTER_SETUP:
+            unit__trace_file = fopen(unit__opts.trace_out, "w");
+            if (!unit__trace_file) {
+                fprintf(stderr, "unit: warning: unable to open trace file `%s`\n", unit__opts.trace_out);
+                break;
+            }
+            unit__trace_t0 = unit__clock.now();
+            unit__trace_first = true;
+            unit__trace_events_num = 0;
+            unit__trace_strings_len = 0;
+            fputs("{\"displayTimeUnit\":\"ms\",\"otherData\":{\"version\":\"" UNIT_VERSION "\",\"governor\":", unit__trace_file);
+            print_json_string(unit__trace_file, unit__env.governor);
+            fprintf(unit__trace_file, ",\"jitter\":%0.4f,\"clock\":\"%s\"},\"traceEvents\":[", unit__env.jitter,
+                    unit__clock.name);
+            break;
+        case UNIT__PRINTER_SHUTDOWN:
+            if (unit__trace_file) {
+                unit__trace_flush();
+                fprintf(unit__trace_file,
+                        "%s{\"ph\":\"M\",\"pid\":%ld,\"tid\":%ld,\"name\":\"thread_name\",\"args\":{\"name\":\"unit\"}}\n]}\n",
+                        unit__trace_first ? "\n" : ",\n", unit__trace_pid(), unit__trace_tid());
+                fclose(unit__trace_file);
+                unit__trace_file = NULL;
+            }
+            break;
+        case UNIT__PRINTER_BEGIN:
+            if (unit__trace_file) {
+                unit__trace_push('B', unit, NULL);
+            }
+            break;
+        case UNIT__PRINTER_END:
+            if (unit__trace_file) {
+                unit__trace_push('E', unit, NULL);
+            }
+            break;
+        case UNIT__PRINTER_ECHO:
+            if (unit__trace_file) {
+                unit__trace_push('M', unit, msg);
+            }
+            break;
+        case UNIT__PRINTER_FAIL:
+            if (unit__trace_file && unit->fail_record) {
+                char text[UNIT_FAIL_TEXT];
+                unit__format_fail_plain(text, sizeof text, unit->fail_record);
+                unit__trace_push('F', unit, text);
+            }
+            break;
+    }
+}
+
+// endregion
+
+// region машинные отчёты: `-r=junit` и `-r=ndjson`, пишутся по мере завершения узлов без накопления в памяти
+
+// start time of `ndjson` report, events timestamps are relative to it
+static int64_t unit__ndjson_t0 = 0;
+
+// failures of the current test, records are valid until the next test begins
+static const struct unit__fail_record* unit__junit_fails[UNIT_FAIL_RECORDS];
+static int unit__junit_fails_num = 0;
+
+static const char* unit__level_name(int level) {
+    static const char* names[] = {"warn", "check", "require"};
+    return level >= 0 && level < 3 ? names[level] : "check";
+}
+
+static const char* unit__status_name(int status) {
+    static const char* names[] = {"run", "success", "skipped", "failed"};
+    return status >= 0 && status < 4 ? names[status] : "run";
+}
+
+// JUnit `classname`: names of enclosing nodes joined with dots
+static void unit__junit_classname(FILE* f, struct unit_test* node) {
+    if (node) {
+        if (node->parent) {
+            unit__junit_classname(f, node->parent);
+            unit__fputc('.', f);
+        }
+        print_xml_string(f, beautify_name(node->name));
+    }
+}
+
+static void unit__junit_failure(FILE* f, const struct unit__fail_record* r) {
+    char text[UNIT_FAIL_TEXT];
+    unit__format_fail_plain(text, sizeof text, r);
+    // the first line is the message, details are in the element text
+    char message[256];
+    size_t len = strcspn(text, "\n");
+    if (len >= sizeof message) {
+        len = sizeof message - 1;
+    }
+    memcpy(message, text, len);
+    message[len] = 0;
+    unit__fputs("      <failure message=\"", f);
+    print_xml_string(f, message);
+    unit__fprintf(f, "\" type=\"%s\">", unit__level_name(r->site ? r->site->level : UNIT__LEVEL_CHECK));
+    print_xml_string(f, text);
+    if (r->site) {
+        unit__fputs("\n@ ", f);
+        print_xml_string(f, beautify_filename(r->site->file));
+        unit__fprintf(f, ":%d", r->site->line);
+    }
+    unit__fputs("</failure>\n", f);
+}
+
+static void unit__junit_testcase(FILE* f, struct unit_test* node) {
+    unit__fputs("    <testcase classname=\"", f);
+    unit__junit_classname(f, node->parent);
+    unit__fputs("\" name=\"", f);
+    print_xml_string(f, beautify_name(node->name));
+    unit__fputs("\" file=\"", f);
+    print_xml_string(f, beautify_filename(node->file));
+    unit__fprintf(f, "\" line=\"%d\" time=\"%0.6f\" assertions=\"%lld\"", node->line, node->elapsed / 1e9,
+            (long long) node->assertions);
+    if (node->status == UNIT_STATUS_SKIPPED) {
+        unit__fputs(">\n      <skipped/>\n    </testcase>\n", f);
+    } else if (node->status == UNIT_STATUS_FAILED) {
+        unit__fputs(">\n", f);
+        for (int i = 0; i < unit__junit_fails_num; ++i) {
+            const struct unit__fail_record* r = unit__junit_fails[i];
+            if (!r->site || r->site->level > UNIT__LEVEL_WARN) {
+                unit__junit_failure(f, r);
+            }
+        }
+        unit__fputs("    </testcase>\n", f);
+    } else {
+        unit__fputs("/>\n", f);
+    }
+}
+
+static void printer_junit(int cmd, struct unit_test* node, const char* msg) {
+    (void) msg;
+    FILE* f = unit__printer_out;
+    switch (cmd) {
+        case UNIT__PRINTER_SETUP:
+            unit__fputs("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<testsuites name=\"unit\">\n", f);
+            break;
+        case UNIT__PRINTER_SHUTDOWN:
+            unit__fputs("</testsuites>\n", f);
+            unit__output_flush(f);
+            break;
+        case UNIT__PRINTER_BEGIN:
+            if (node->type == UNIT__TYPE_TEST) {
+                unit__junit_fails_num = 0;
+            }
+            // test counts are not known yet, consumers compute them from `testcase` elements
+            if (!node->parent) {
+                unit__fputs("  <testsuite name=\"", f);
+                print_xml_string(f, beautify_name(node->name));
+                unit__fputs("\" file=\"", f);
+                print_xml_string(f, beautify_filename(node->file));
+                unit__fputs("\">\n", f);
+            }
+            break;
+        case UNIT__PRINTER_END:
+            if (node->type == UNIT__TYPE_TEST) {
+                unit__junit_testcase(f, node);
+            }
+            if (!node->parent) {
+                unit__fputs("  </testsuite>\n", f);
+                unit__output_flush(f);
+            }
+            break;
+        case UNIT__PRINTER_FAIL:
+            if (node->fail_record && unit__junit_fails_num < UNIT_FAIL_RECORDS) {
+                unit__junit_fails[unit__junit_fails_num++] = node->fail_record;
+            }
+            break;
+    }
+}
+
+static void unit__ndjson_path(FILE* f, struct unit_test* node) {
+    if (node->parent) {
+        unit__ndjson_path(f, node->parent);
+        unit__fputc(',', f);
+    }
+    print_json_string(f, beautify_name(node->name));
+}
+
+static void unit__ndjson_begin(FILE* f, const char* event, struct unit_test* node) {
+    unit__fprintf(f, "{\"event\":\"%s\",\"ts\":%lld", event, (long long) (unit__clock.now() - unit__ndjson_t0));
+    if (node) {
+        unit__fputs(",\"path\":[", f);
+        unit__ndjson_path(f, node);
+        unit__fputc(']', f);
+    }
+}
+
+static void unit__ndjson_durations(FILE* f, const char* type, const struct unit__durations* heap) {
+    struct unit_test* nodes[UNIT_DURATIONS_MAX];
+    const int num = unit__durations_sorted(heap, nodes);
+    for (int i = 0; i < num; ++i) {
+        unit__ndjson_begin(f, "slowest", nodes[i]);
+        unit__fprintf(f, ",\"type\":\"%s\",\"file\":", type);
+        print_json_string(f, beautify_filename(nodes[i]->file));
+        unit__fprintf(f, ",\"line\":%d,\"elapsed_ms\":%0.6f}\n", nodes[i]->line, nodes[i]->elapsed / 1e6);
+    }
+}
+
+static void printer_ndjson(int cmd, struct unit_test* node, const char* msg) {
+    FILE* f = unit__printer_out;
+    switch (cmd) {
+        case UNIT__PRINTER_SETUP:
+            unit__ndjson_t0 = unit__clock.now();
+            unit__ndjson_begin(f, "setup", NULL);
+            unit__fputs(",\"version\":\"" UNIT_VERSION "\",\"cpus\":", f);
+            print_json_string(f, unit__env.cpus[0] ? unit__env.cpus : "any");
+            unit__fputs(",\"governor\":", f);
+            print_json_string(f, unit__env.governor);
+            unit__fprintf(f, ",\"jitter\":%0.4f,\"clock\":\"%s\"}\n", unit__env.jitter, unit__clock.name);
+            break;
+        case UNIT__PRINTER_SHUTDOWN: {
+            int total = 0;
+            int passed = 0;
+            for (struct unit_test* u = unit_tests; u; u = u->next) {
+                passed += u->passed;
+                total += u->total;
+            }
+            unit__ndjson_durations(f, "test", &unit__slowest_tests);
+            unit__ndjson_durations(f, "suite", &unit__slowest_suites);
+            unit__ndjson_begin(f, "shutdown", NULL);
+            unit__fprintf(f, ",\"passed\":%d,\"total\":%d}\n", passed, total);
+            unit__output_flush(f);
+        }
+            break;
+        case UNIT__PRINTER_BEGIN:
+            unit__ndjson_begin(f, "begin", node);
+            unit__fprintf(f, ",\"type\":\"%s\",\"file\":", !node->parent ? "suite" :
+                                                     (node->type == UNIT__TYPE_TEST ? "test" : "case"));
+            print_json_string(f, beautify_filename(node->file));
+            unit__fprintf(f, ",\"line\":%d}\n", node->line);
+            break;
+        case UNIT__PRINTER_END:
+            unit__ndjson_begin(f, "end", node);
+            unit__fprintf(f, ",\"status\":\"%s\",\"elapsed_ms\":%0.6f,\"cpu_ms\":%0.6f,\"fixtures_ms\":%0.6f,"
+                       "\"assertions\":%lld,\"passed\":%d,\"total\":%d,\"scratch\":%zu}\n",
+                    unit__status_name(node->status), node->elapsed / 1e6, node->cpu_elapsed / 1e6,
+                    node->fixtures_elapsed / 1e6, (long long) node->assertions, node->passed, node->total,
+                    node->scratch_peak);
+            if (!node->parent) {
+                unit__output_flush(f);
+            }
+            break;
+        case UNIT__PRINTER_ECHO:
+            unit__ndjson_begin(f, "echo", node);
+            unit__fputs(",\"message\":", f);
+            print_json_string(f, msg);
+            unit__fputs("}\n", f);
+            break;
+        case UNIT__PRINTER_FAIL:
+            unit__ndjson_begin(f, "fail", node);
+            unit__fprintf(f, ",\"level\":\"%s\",\"file\":", unit__level_name(node->assert_level));
+            print_json_string(f, beautify_filename(node->assert_file));
+            unit__fprintf(f, ",\"line\":%d,\"desc\":", node->assert_line);
+            print_json_string(f, node->assert_desc);
+            unit__fputs(",\"message\":", f);
+            if (node->fail_record) {
+                char text[UNIT_FAIL_TEXT];
+                unit__format_fail_plain(text, sizeof text, node->fail_record);
+                print_json_string(f, text);
+            } else {
+                print_json_string(f, node->assert_desc);
+            }
+            unit__fputs("}\n", f);
+            break;
+    }
+}
+
+// endregion
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define UNIT__LOG_MMAP 1
+
+#endif // unix && !__EMSCRIPTEN__
+
+// region бинарный журнал событий: `--events-out=run.ulog`, отчёты строятся из него позже утилитой `unit-report`
+
+#ifndef UNIT_EVENTS_LOG_CHUNK
+// initial size of the mapped events log file, it is doubled when the mapping is full
+#define UNIT_EVENTS_LOG_CHUNK (1024 * 1024)
+#endif
+
+#define UNIT__LOG_MAGIC "unit-log"
+#define UNIT__LOG_VERSION 1
+
+enum {
+    UNIT__LOG_HEADER = 0,
+    UNIT__LOG_STRING = 1,
+    UNIT__LOG_SETUP = 2,
+    UNIT__LOG_NODE = 3,
+    UNIT__LOG_BEGIN = 4,
+    UNIT__LOG_END = 5,
+    UNIT__LOG_RESOURCES = 6,
+    UNIT__LOG_ECHO = 7,
+    UNIT__LOG_FAIL = 8,
+    UNIT__LOG_ASSERTION = 9
+};
+
+// id of the last transient string: messages are referenced by the next event only, so they are not kept by readers
+#define UNIT__LOG_TRANSIENT 0xFFFFFFFFu
+
+/**
+ * Fixed-size record of the events log. Bytes of `UNIT__LOG_STRING` follow its record, padded to the record size.
+ * Strings and nodes are written once, events refer to them by id, id 0 is NULL
+ */
+struct unit__log_record {
+    uint16_t kind;
+    // node status on begin and end, assertion level on failure, node type on declaration, transient string flag
+    uint16_t status;
+    // node id, or string id of `UNIT__LOG_STRING`
+    uint32_t id;
+    // nanoseconds since the run start
+    int64_t ts;
+    union {
+        struct {
+            char magic[8];
+            uint32_t version;
+            uint32_t record_size;
+            // resources are sampled for each node
+            uint32_t resources;
+        } header;
+        struct {
+            uint32_t len;
+        } string;
+        struct {
+            uint32_t clock;
+            uint32_t governor;
+            uint32_t cpus;
+            int32_t cpus_count;
+            int64_t calibration;
+            int64_t overhead;
+            double jitter;
+        } setup;
+        struct {
+            uint32_t parent;
+            uint32_t name;
+            uint32_t file;
+            int32_t line;
+        } node;
+        struct {
+            int32_t passed;
+            int32_t total;
+            int64_t elapsed;
+            int64_t cpu_elapsed;
+            int64_t fixtures_elapsed;
+            int64_t assertions;
+            int64_t scratch_peak;
+        } end;
+        // also used by `UNIT__LOG_ASSERTION`, with assertion status and without text
+        struct {
+            uint32_t file;
+            uint32_t desc;
+            uint32_t comment;
+            uint32_t text;
+            int32_t line;
+            int32_t level;
+        } fail;
+        struct {
+            uint32_t text;
+        } echo;
+        struct unit_resources resources;
+    };
+};
+
+// open addressing table of interned node and string pointers
+struct unit__log_ids {
+    const void** keys;
+    uint32_t* ids;
+    uint32_t cap;
+    uint32_t num;
+};
+
+/**
+ * Serializes printer events to records, the same writer feeds the events log file and the asynchronous reporter
+ */
+struct unit__log_writer {
+    // sink of records, called only while the writer is active
+    void (* write)(struct unit__log_writer* writer, const void* data, size_t size);
+    struct unit__log_ids ids;
+    uint32_t nodes_num;
+    uint32_t strings_num;
+    int64_t t0;
+    bool active;
+};
+
+static struct unit__log_writer unit__log_file_writer;
+
+#ifdef UNIT__LOG_MMAP
+static int unit__log_fd = -1;
+static unsigned char* unit__log_data = NULL;
+static size_t unit__log_len = 0;
+static size_t unit__log_cap = 0;
+#else
+static FILE* unit__log_file = NULL;
+#endif // UNIT__LOG_MMAP
+
+static uint32_t unit__log_hash(const void* key, uint32_t cap) {
+    return (uint32_t) (((uintptr_t) key >> 3) * 0x9E3779B97F4A7C15ull >> 32) & (cap - 1);
+}
+
+/**
+ * Finds id slot of the pointer, the slot is 0 if the pointer is seen the first time.
+ * Slots are invalidated by the next call, NULL is returned if the table could not grow
+ */
+static uint32_t* unit__log_slot(struct unit__log_ids* table, const void* key) {
+    if (2 * (table->num + 1) > table->cap) {
+        const uint32_t cap = table->cap ? 2 * table->cap : 1024;
+        const void** keys = (const void**) calloc(cap, sizeof *keys);
+        uint32_t* ids = (uint32_t*) calloc(cap, sizeof *ids);
+        if (!keys || !ids) {
+            free(keys);
+            free(ids);
+            return NULL;
+        }
+        for (uint32_t i = 0; i < table->cap; ++i) {
+            if (table->keys[i]) {
+                uint32_t j = unit__log_hash(table->keys[i], cap);
+                while (keys[j]) {
+                    j = (j + 1) & (cap - 1);
+                }
+                keys[j] = table->keys[i];
+                ids[j] = table->ids[i];
+            }
+        }
+        free(table->keys);
+        free(table->ids);
+        table->keys = keys;
+        table->ids = ids;
+        table->cap = cap;
+    }
+    uint32_t i = unit__log_hash(key, table->cap);
+    while (table->keys[i] && table->keys[i] != key) {
+        i = (i + 1) & (table->cap - 1);
+    }
+    if (!table->keys[i]) {
+        table->keys[i] = key;
+        table->ids[i] = 0;
+        ++table->num;
+    }
+    return table->ids + i;
+}
+
+static void unit__log_ids_free(struct unit__log_ids* table) {
+    free(table->keys);
+    free(table->ids);
+    memset(table, 0, sizeof *table);
+}
+
+static void unit__log_writer_begin(struct unit__log_writer* writer) {
+    writer->nodes_num = 0;
+    writer->strings_num = 0;
+    writer->t0 = unit__clock.now();
+    writer->active = true;
+}
+
+static void unit__log_writer_end(struct unit__log_writer* writer) {
+    unit__log_ids_free(&writer->ids);
+    writer->active = false;
+}
+
+static void unit__log_write(struct unit__log_writer* writer, const void* data, size_t size) {
+    if (writer->active) {
+        writer->write(writer, data, size);
+    }
+}
+
+/**
+ * Writes the string record. Messages are transient: they are not interned and readers keep only the last one
+ */
+static uint32_t unit__log_put_string(struct unit__log_writer* writer, const char* str, bool transient) {
+    static const unsigned char zeros[sizeof(struct unit__log_record)] = {0};
+    if (!str) {
+        return 0;
+    }
+    struct unit__log_record r;
+    memset(&r, 0, sizeof r);
+    const size_t len = strlen(str);
+    r.kind = UNIT__LOG_STRING;
+    r.status = transient;
+    r.id = transient ? UNIT__LOG_TRANSIENT : ++writer->strings_num;
+    r.string.len = (uint32_t) len;
+    unit__log_write(writer, &r, sizeof r);
+    unit__log_write(writer, str, len + 1);
+    // keep records aligned
+    unit__log_write(writer, zeros, (sizeof r - (len + 1) % sizeof r) % sizeof r);
+    return r.id;
+}
+
+static uint32_t unit__log_string(struct unit__log_writer* writer, const char* str) {
+    if (!str) {
+        return 0;
+    }
+    uint32_t* slot = unit__log_slot(&writer->ids, str);
+    if (slot && *slot) {
+        return *slot;
+    }
+    const uint32_t id = unit__log_put_string(writer, str, false);
+    slot = unit__log_slot(&writer->ids, str);
+    if (slot) {
+        *slot = id;
+    }
+    return id;
+}
+
+// declares the node and its parents on the first event
+static uint32_t unit__log_node(struct unit__log_writer* writer, struct unit_test* node) {
+    if (!node) {
+        return 0;
+    }
+    uint32_t* slot = unit__log_slot(&writer->ids, node);
+    if (!slot) {
+        fputs("unit: warning: out of memory for events log, it is incomplete\n", stderr);
+        writer->active = false;
+        return 0;
+    }
+    if (*slot) {
+        return *slot;
+    }
+    struct unit__log_record r;
+    memset(&r, 0, sizeof r);
+    r.kind = UNIT__LOG_NODE;
+    r.status = (uint16_t) node->type;
+    r.node.parent = unit__log_node(writer, node->parent);
+    r.node.name = unit__log_string(writer, node->name);
+    r.node.file = unit__log_string(writer, node->file);
+    r.node.line = node->line;
+    r.id = ++writer->nodes_num;
+    unit__log_write(writer, &r, sizeof r);
+    slot = unit__log_slot(&writer->ids, node);
+    if (slot) {
+        *slot = r.id;
+    }
+    return r.id;
+}
+
+static void unit__log_setup(struct unit__log_writer* writer) {
+    struct unit__log_record r;
+    memset(&r, 0, sizeof r);
+    r.kind = UNIT__LOG_HEADER;
+    memcpy(r.header.magic, UNIT__LOG_MAGIC, sizeof r.header.magic);
+    r.header.version = UNIT__LOG_VERSION;
+    r.header.record_size = (uint32_t) sizeof r;
+    r.header.resources = (uint32_t) unit__opts.resources;
+    unit__log_write(writer, &r, sizeof r);
+
+    memset(&r, 0, sizeof r);
+    r.kind = UNIT__LOG_SETUP;
+    r.setup.clock = unit__log_string(writer, unit__clock.name);
+    r.setup.governor = unit__log_put_string(writer, unit__env.governor, false);
+    r.setup.cpus = unit__log_put_string(writer, unit__env.cpus, false);
+    r.setup.cpus_count = unit__env.cpus_count;
+    r.setup.calibration = unit__env.calibration;
+    r.setup.overhead = unit__clock.overhead;
+    r.setup.jitter = unit__env.jitter;
+    unit__log_write(writer, &r, sizeof r);
+}
+
+// writes node event, `SETUP` and `SHUTDOWN` are handled by the owner of the writer
+static void unit__log_event(struct unit__log_writer* writer, int cmd, struct unit_test* unit, const char* msg) {
+    struct unit__log_record r;
+    memset(&r, 0, sizeof r);
+    r.ts = unit__clock.now() - writer->t0;
+    r.id = unit__log_node(writer, unit);
+    switch (cmd) {
+        case UNIT__PRINTER_BEGIN:
+            r.kind = UNIT__LOG_BEGIN;
+            r.status = (uint16_t) unit->status;
+            unit__log_write(writer, &r, sizeof r);
+            break;
+        case UNIT__PRINTER_END:
+            if (unit__opts.resources) {
+                r.kind = UNIT__LOG_RESOURCES;
+                r.resources = unit->res;
+                unit__log_write(writer, &r, sizeof r);
+            }
+            r.kind = UNIT__LOG_END;
+            r.status = (uint16_t) unit->status;
+            r.end.passed = unit->passed;
+            r.end.total = unit->total;
+            r.end.elapsed = unit->elapsed;
+            r.end.cpu_elapsed = unit->cpu_elapsed;
+            r.end.fixtures_elapsed = unit->fixtures_elapsed;
+            r.end.assertions = unit->assertions;
+            r.end.scratch_peak = (int64_t) unit->scratch_peak;
+            unit__log_write(writer, &r, sizeof r);
+            break;
+        case UNIT__PRINTER_ECHO:
+            r.kind = UNIT__LOG_ECHO;
+            r.echo.text = unit__log_put_string(writer, msg, true);
+            unit__log_write(writer, &r, sizeof r);
+            break;
+        case UNIT__PRINTER_FAIL:
+        case UNIT__PRINTER_ASSERTION:
+            r.kind = cmd == UNIT__PRINTER_FAIL ? UNIT__LOG_FAIL : UNIT__LOG_ASSERTION;
+            r.status = (uint16_t) unit->assert_status;
+            r.fail.level = unit->assert_level;
+            r.fail.file = unit__log_string(writer, unit->assert_file);
+            r.fail.desc = unit__log_string(writer, unit->assert_desc);
+            r.fail.comment = unit__log_string(writer, unit->assert_comment);
+            r.fail.line = unit->assert_line;
+            if (cmd == UNIT__PRINTER_FAIL && unit->fail_record) {
+                // keep style markers, so the report is colored like the original output
+                char text[UNIT_FAIL_TEXT];
+                struct unit__text t = {text, sizeof text, 0};
+                text[0] = 0;
+                unit__format_fail(&t, unit->fail_record);
+                r.fail.text = unit__log_put_string(writer, text, true);
+            }
+            unit__log_write(writer, &r, sizeof r);
+            break;
+    }
+}
+
+static void unit__log_close(void) {
+#ifdef UNIT__LOG_MMAP
+    if (unit__log_data) {
+        munmap(unit__log_data, unit__log_cap);
+        unit__log_data = NULL;
+    }
+    if (unit__log_fd >= 0) {
+        // drop unused tail of the last mapping
+        if (ftruncate(unit__log_fd, (off_t) unit__log_len) != 0) {
+            fputs("unit: warning: unable to truncate events log\n", stderr);
+        }
+        close(unit__log_fd);
+        unit__log_fd = -1;
+    }
+#else
+    if (unit__log_file) {
+        fclose(unit__log_file);
+        unit__log_file = NULL;
+    }
+#endif // UNIT__LOG_MMAP
+    unit__log_writer_end(&unit__log_file_writer);
+}
+
+#ifdef UNIT__LOG_MMAP
+
+static bool unit__log_grow(size_t size) {
+    size_t cap = unit__log_cap ? unit__log_cap : UNIT_EVENTS_LOG_CHUNK;
+    while (cap < size) {
+        cap *= 2;
+    }
+    if (unit__log_data) {
+        munmap(unit__log_data, unit__log_cap);
+        unit__log_data = NULL;
+    }
+    if (ftruncate(unit__log_fd, (off_t) cap) != 0) {
+        return false;
+    }
+    void* data = mmap(NULL, cap, PROT_READ | PROT_WRITE, MAP_SHARED, unit__log_fd, 0);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    unit__log_data = (unsigned char*) data;
+    unit__log_cap = cap;
+    return true;
+}
+
+#endif // UNIT__LOG_MMAP
+
+static void unit__log_file_write(struct unit__log_writer* writer, const void* data, size_t size) {
+#ifdef UNIT__LOG_MMAP
+    if (unit__log_len + size > unit__log_cap && !unit__log_grow(unit__log_len + size)) {
+        fputs("unit: warning: unable to map events log, it is incomplete\n", stderr);
+        // the file is closed on shutdown
+        writer->active = false;
+        return;
+    }
+    memcpy(unit__log_data + unit__log_len, data, size);
+    unit__log_len += size;
+#else
+    (void) writer;
+    fwrite(data, 1, size, unit__log_file);
+#endif // UNIT__LOG_MMAP
+}
+
+static void unit__log_open(const char* path) {
+#ifdef UNIT__LOG_MMAP
+    unit__log_fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    const bool opened = unit__log_fd >= 0;
+    unit__log_len = 0;
+    unit__log_cap = 0;
+#else
+    unit__log_file = fopen(path, "wb");
+    const bool opened = unit__log_file != NULL;
+#endif // UNIT__LOG_MMAP
+    if (!opened) {
+        fprintf(stderr, "unit: warning: unable to open events log `%s`\n", path);
+        return;
+    }
+    unit__log_file_writer.write = unit__log_file_write;
+    unit__log_writer_begin(&unit__log_file_writer);
+    unit__log_setup(&unit__log_file_writer);
+}
+
+static void printer_events_log(int cmd, struct unit_test* unit, const char* msg) {
+    switch (cmd) {
+        case UNIT__PRINTER_SETUP:
+            unit__log_open(unit__opts.events_out);
+            break;
+        case UNIT__PRINTER_SHUTDOWN:
+            unit__log_close();
+            break;
+        default:
+            if (unit__log_file_writer.active) {
+                unit__log_event(&unit__log_file_writer, cmd, unit, msg);
+            }
+            break;
+    }
+}
+
+// endregion
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__) && defined(__has_include)
+#if __has_include(<execinfo.h>)
+
+#include <errno.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#define UNIT__HAS_PROFILER 1
+
+#endif // <execinfo.h>
+#endif // unix
+
+// region профилировщик: `--profile`, сэмплы SIGPROF в folded stacks для flame graphs
+
+#ifndef UNIT_PROFILE_SAMPLES
+// capacity of the samples ring, drained after each node
+#define UNIT_PROFILE_SAMPLES 4096
+#endif
+
+#ifndef UNIT_PROFILE_DEPTH
+// maximum number of captured frames for the single sample
+#define UNIT_PROFILE_DEPTH 48
+#endif
+
+#ifndef UNIT_PROFILE_HZ
+#define UNIT_PROFILE_HZ 1000
+#endif
+
+#ifdef UNIT__HAS_PROFILER
+
+struct unit__sample {
+    struct unit_test* node;
+    int depth;
+    void* frames[UNIT_PROFILE_DEPTH];
+};
+
+static struct unit__sample unit__profile_ring[UNIT_PROFILE_SAMPLES];
+// written only by signal handler
+static unsigned unit__profile_head = 0;
+// written only by the runner when samples are drained
+static unsigned unit__profile_tail = 0;
+static unsigned unit__profile_dropped = 0;
+static FILE* unit__profile_file = NULL;
+static struct sigaction unit__profile_prev_action;
+
+static void unit__profile_handler(int sig) {
+    (void) sig;
+    const int prev_errno = errno;
+    const unsigned head = __atomic_load_n(&unit__profile_head, __ATOMIC_RELAXED);
+    const unsigned tail = __atomic_load_n(&unit__profile_tail, __ATOMIC_ACQUIRE);
+    if (head - tail < UNIT_PROFILE_SAMPLES) {
+        struct unit__sample* sample = unit__profile_ring + head % UNIT_PROFILE_SAMPLES;
+        sample->node = unit_cur;
+        sample->depth = backtrace(sample->frames, UNIT_PROFILE_DEPTH);
+        __atomic_store_n(&unit__profile_head, head + 1, __ATOMIC_RELEASE);
+    } else {
+        __atomic_fetch_add(&unit__profile_dropped, 1, __ATOMIC_RELAXED);
+    }
+    errno = prev_errno;
+}
+
+#define UNIT__PROFILE_LINE 4096
+
+struct unit__profile_line {
+    char text[UNIT__PROFILE_LINE];
+    size_t len;
+};
+
+static void unit__profile_append(struct unit__profile_line* line, const char* str, size_t len) {
+    for (size_t i = 0; i < len && str[i] && line->len + 1 < UNIT__PROFILE_LINE; ++i) {
+        // `;` separates frames in folded format
+        const char c = str[i] == ';' ? ':' : str[i];
+        line->text[line->len++] = c == '\n' ? ' ' : c;
+    }
+    line->text[line->len] = 0;
+}
+
+static void unit__profile_append_separator(struct unit__profile_line* line) {
+    if (line->len + 1 < UNIT__PROFILE_LINE) {
+        line->text[line->len++] = ';';
+        line->text[line->len] = 0;
+    }
+}
+
+static void unit__profile_append_path(struct unit__profile_line* line, struct unit_test* node) {
+    if (node) {
+        if (node->parent) {
+            unit__profile_append_path(line, node->parent);
+            unit__profile_append_separator(line);
+        }
+        const char* name = beautify_name(node->name);
+        unit__profile_append(line, name, strlen(name));
+    } else {
+        unit__profile_append(line, "(runner)", 8);
+    }
+}
+
+/**
+ * Extracts function name from `backtrace_symbols` format: `module(function+0x1f) [0xaddress]`,
+ * falls back to `module+offset` for symbols which are not exported
+ */
+static void unit__profile_append_symbol(struct unit__profile_line* line, const char* symbol) {
+    const char* begin = strchr(symbol, '(');
+    const char* end = begin ? strpbrk(begin, "+)") : NULL;
+    if (begin && end && end > begin + 1) {
+        unit__profile_append(line, begin + 1, (size_t) (end - begin - 1));
+        return;
+    }
+    const char* module = short_filename(symbol);
+    const char* module_end = strpbrk(module, "( ");
+    unit__profile_append(line, module, module_end ? (size_t) (module_end - module) : strlen(module));
+    const char* offset = begin ? strchr(begin, '+') : NULL;
+    if (offset) {
+        const char* offset_end = strchr(offset, ')');
+        unit__profile_append(line, offset, offset_end ? (size_t) (offset_end - offset) : strlen(offset));
+    }
+}
+
+/**
+ * Formats folded stack: test path as root frames, then call stack from the outermost frame
+ */
+static void unit__profile_format(struct unit__profile_line* line, const struct unit__sample* sample) {
+    line->len = 0;
+    unit__profile_append_path(line, sample->node);
+    // skip signal handler and signal trampoline frames
+    const int skip = 2;
+    if (sample->depth > skip) {
+        char** symbols = backtrace_symbols(sample->frames + skip, sample->depth - skip);
+        for (int i = sample->depth - skip - 1; symbols && i >= 0; --i) {
+            unit__profile_append_separator(line);
+            unit__profile_append_symbol(line, symbols[i]);
+        }
+        free(symbols);
+    }
+}
+
+/**
+ * Writes collected samples, equal consecutive stacks are merged to single line
+ */
+static void unit__profile_drain(void) {
+    static struct unit__profile_line lines[2];
+    const unsigned head = __atomic_load_n(&unit__profile_head, __ATOMIC_ACQUIRE);
+    unsigned tail = unit__profile_tail;
+    struct unit__profile_line* prev = NULL;
+    int count = 0;
+    for (; tail != head; ++tail) {
+        struct unit__profile_line* line = lines + (prev == lines ? 1 : 0);
+        unit__profile_format(line, unit__profile_ring + tail % UNIT_PROFILE_SAMPLES);
+        if (prev && prev->len == line->len && memcmp(prev->text, line->text, line->len) == 0) {
+            ++count;
+            continue;
+        }
+        if (prev) {
+            fprintf(unit__profile_file, "%s %d\n", prev->text, count);
+        }
+        prev = line;
+        count = 1;
+    }
+    if (prev) {
+        fprintf(unit__profile_file, "%s %d\n", prev->text, count);
+    }
+    __atomic_store_n(&unit__profile_tail, head, __ATOMIC_RELEASE);
+}
+
+/**
+ * Drains samples of the ended node with the timer paused: symbolizing calls `malloc` and `dladdr`,
+ * and `unit_cur` is still the ended node, so its samples would be counted against the test
+ */
+static void unit__profile_drain_paused(void) {
+    const struct itimerval paused = {{0, 0}, {0, 0}};
+    struct itimerval timer;
+    setitimer(ITIMER_PROF, &paused, &timer);
+    unit__profile_drain();
+    if (timer.it_value.tv_sec == 0 && timer.it_value.tv_usec == 0) {
+        // zero remaining time would disarm the timer
+        timer.it_value = timer.it_interval;
+    }
+    setitimer(ITIMER_PROF, &timer, NULL);
+}
+
+static void unit__profile_start(void) {
+    unit__profile_file = fopen(unit__opts.profile_out, "w");
+    if (!unit__profile_file) {
+        fprintf(stderr, "unit: warning: unable to open profile file `%s`\n", unit__opts.profile_out);
+        return;
+    }
+    // `backtrace` loads unwinder lazily on the first call, it should not happen inside signal handler
+    void* warmup[1];
+    backtrace(warmup, 1);
+    unit__profile_head = 0;
+    unit__profile_tail = 0;
+    unit__profile_dropped = 0;
+
+    struct sigaction action = {0};
+    action.sa_handler = unit__profile_handler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, &unit__profile_prev_action);
+
+    const long interval = 1000000 / UNIT_PROFILE_HZ;
+    struct itimerval timer = {{0, interval}, {0, interval}};
+    setitimer(ITIMER_PROF, &timer, NULL);
+}
+
+static void unit__profile_stop(void) {
+    if (!unit__profile_file) {
+        return;
+    }
+    struct itimerval timer = {{0, 0}, {0, 0}};
+    setitimer(ITIMER_PROF, &timer, NULL);
+    sigaction(SIGPROF, &unit__profile_prev_action, NULL);
+    unit__profile_drain();
+    fclose(unit__profile_file);
+    unit__profile_file = NULL;
+    if (unit__profile_dropped && !unit__opts.quiet) {
+        fprintf(stderr, "unit: warning: profiler dropped %u samples, increase UNIT_PROFILE_SAMPLES\n",
+                unit__profile_dropped);
+    }
+}
+
+#endif // UNIT__HAS_PROFILER
+
+static void printer_profile(int cmd, struct unit_test* unit, const char* msg) {
+    (void) unit;
+    (void) msg;
+#ifdef UNIT__HAS_PROFILER
+    switch (cmd) {
+        case UNIT__PRINTER_SETUP:
+            unit__profile_start();
+            break;
+        case UNIT__PRINTER_SHUTDOWN:
+            unit__profile_stop();
+            break;
+        case UNIT__PRINTER_END:
+            if (unit__profile_file) {
+                unit__profile_drain_paused();
+            }
+            break;
+    }
+#else // UNIT__HAS_PROFILER
+    if (cmd == UNIT__PRINTER_SETUP && !unit__opts.quiet) {
+        fputs("unit: warning: `--profile` is not supported on this platform\n", stderr);
+    }
+#endif // !UNIT__HAS_PROFILER
+}
+
+// endregion
+
+// region тесты свойств: `PROPERTY`, генераторы поверх записанных выборов xoshiro256** и сжатие контрпримера
+
+#ifndef UNIT_PROPERTY_DRAWS
+// maximum number of random draws recorded for the single case, longer cases are reported without shrinking
+#define UNIT_PROPERTY_DRAWS 4096
+#endif
+
+#ifndef UNIT_PROPERTY_SHRINKS
+// maximum number of runs spent on shrinking the failed case
+#define UNIT_PROPERTY_SHRINKS 10000
+#endif
+
+#ifndef UNIT_PROPERTY_EXAMPLE
+// capacity of the printed counterexample
+#define UNIT_PROPERTY_EXAMPLE 1024
+#endif
+
+// the largest chunk of draws deleted or zeroed by the single shrink step
+#define UNIT__SHRINK_CHUNK 8
+
+enum {
+    UNIT__PROP_START = 0,
+    UNIT__PROP_GENERATE = 1,
+    UNIT__PROP_SHRINK = 2,
+    UNIT__PROP_REPORT = 3,
+
+    UNIT__SHRINK_DELETE = 0,
+    UNIT__SHRINK_ZERO = 1,
+    UNIT__SHRINK_MINIMIZE = 2,
+    UNIT__SHRINK_SWEEP = 3,
+};
+
+// every generated value is made from recorded draws, so the case is shrunk by simplifying draws and running it again:
+// generators map smaller draws to simpler values and the zero draw to the simplest one
+struct unit__prop {
+    // running property node, NULL outside of `PROPERTY`
+    struct unit_test* node;
+    int phase;
+    // failures of probing runs are counted without reporting
+    bool probing;
+    bool failed;
+    // draws are taken from `rng` or replayed from `replay`
+    bool random;
+    // the case took more draws than recorded
+    bool overflow;
+    int64_t cases;
+    int64_t cases_num;
+    int64_t failed_case;
+    int shrinks;
+    uint64_t seed;
+    uint64_t rng[4];
+    uint64_t draws[UNIT_PROPERTY_DRAWS];
+    // marks draws of lengths, the length is decremented together with deleted elements
+    unsigned char lens[UNIT_PROPERTY_DRAWS];
+    uint32_t draws_num;
+    uint64_t replay[UNIT_PROPERTY_DRAWS];
+    uint32_t replay_num;
+    // the simplest failed case found so far, it's regenerated from the seed if its draws were not recorded
+    uint64_t best[UNIT_PROPERTY_DRAWS];
+    unsigned char best_lens[UNIT_PROPERTY_DRAWS];
+    uint32_t best_num;
+    bool best_random;
+    // shrink cursor: the pass, the chunk at `index`, the search range of the draw at `index` without its lowest bit
+    int pass;
+    uint32_t size;
+    uint32_t index;
+    bool adjust;
+    uint64_t lo;
+    uint64_t hi;
+    bool improved;
+    // printers events and the node state are restored for the reported run
+    unsigned events;
+    int state;
+    struct unit__text example;
+    char example_data[UNIT_PROPERTY_EXAMPLE];
+};
+
+static struct unit__prop unit__prop;
+
+// reports the counterexample with the last failed assertion site, see `unit.c`
+static void unit__fail_text(const char* text);
+
+static void unit__format_path(char* path, size_t size, struct unit_test* parent, const char* name);
+
+static uint64_t unit__splitmix64(uint64_t* x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t unit__rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// xoshiro256** by David Blackman and Sebastiano Vigna
+static inline uint64_t unit__xoshiro(uint64_t* s) {
+    const uint64_t result = unit__rotl(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = unit__rotl(s[3], 45);
+    return result;
+}
+
+// each case has its own stream, so the case is regenerated from the seed and its index alone
+static void unit__prop_seed(uint64_t* s, uint64_t seed, int64_t index) {
+    uint64_t x = seed ^ ((uint64_t) index * 0xD1B54A32D192ED03ull);
+    for (int i = 0; i < 4; ++i) {
+        s[i] = unit__splitmix64(&x);
+    }
+}
+
+static uint64_t unit__prop_draw(void) {
+    struct unit__prop* p = &unit__prop;
+    if (p->draws_num >= UNIT_PROPERTY_DRAWS) {
+        p->overflow = true;
+        return p->random ? unit__xoshiro(p->rng) : 0;
+    }
+    // replayed case is completed with zero draws, they give the simplest values
+    const uint64_t v = p->random ? unit__xoshiro(p->rng) :
+                       (p->draws_num < p->replay_num ? p->replay[p->draws_num] : 0);
+    p->lens[p->draws_num] = 0;
+    p->draws[p->draws_num++] = v;
+    return v;
+}
+
+// the draw reduced to `[0, span]` is recorded instead of the raw one, so shrinking searches the index of the value
+static uint64_t unit__prop_draw_index(uint64_t span) {
+    struct unit__prop* p = &unit__prop;
+    const uint32_t at = p->draws_num;
+    const uint64_t v = unit__prop_draw();
+    const uint64_t k = span == UINT64_MAX ? v : v % (span + 1);
+    if (at < p->draws_num) {
+        p->draws[at] = k;
+    }
+    return k;
+}
+
+__attribute__((format(printf, 1, 2)))
+static void unit__prop_example(const char* fmt, ...) {
+    struct unit__prop* p = &unit__prop;
+    if (!p->node || p->phase != UNIT__PROP_REPORT) {
+        return;
+    }
+    struct unit__text* text = &p->example;
+    if (text->len) {
+        unit__text_printf(text, ", ");
+    }
+    if (text->len + 1 >= text->cap) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    const int n = vsnprintf(text->data + text->len, text->cap - text->len, fmt, args);
+    va_end(args);
+    if (n > 0) {
+        text->len += (size_t) n;
+        if (text->len >= text->cap) {
+            text->len = text->cap - 1;
+        }
+    }
+}
+
+// maps the draw to the range, values are ordered by the distance from zero clamped to the range: 0, 1, -1, 2, -2...
+static int64_t unit__gen_int(int64_t min, int64_t max) {
+    if (max <= min) {
+        return min;
+    }
+    const uint64_t k = unit__prop_draw_index((uint64_t) max - (uint64_t) min);
+    const int64_t origin = min > 0 ? min : (max < 0 ? max : 0);
+    const uint64_t up = (uint64_t) max - (uint64_t) origin;
+    const uint64_t down = (uint64_t) origin - (uint64_t) min;
+    const uint64_t m = up < down ? up : down;
+    if (k <= 2 * m) {
+        return (int64_t) (k & 1 ? (uint64_t) origin + (k + 1) / 2 : (uint64_t) origin - k / 2);
+    }
+    // one side of the range is exhausted, the rest is on the other side
+    return (int64_t) (up > down ? (uint64_t) origin + (k - m) : (uint64_t) origin - (k - m));
+}
+
+int64_t unit_gen_int(int64_t min, int64_t max) {
+    const int64_t x = unit__gen_int(min, max);
+    unit__prop_example("%lld", (long long) x);
+    return x;
+}
+
+uint64_t unit_gen_uint(uint64_t min, uint64_t max) {
+    if (max <= min) {
+        return min;
+    }
+    const uint64_t x = min + unit__prop_draw_index(max - min);
+    unit__prop_example("%llu", (unsigned long long) x);
+    return x;
+}
+
+double unit_gen_double(double min, double max) {
+    if (!(max > min)) {
+        return min;
+    }
+    const uint64_t v = unit__prop_draw();
+    const double origin = min > 0.0 ? min : (max < 0.0 ? max : 0.0);
+    const double up = max - origin;
+    const double down = origin - min;
+    const double m = up < down ? up : down;
+    // the distance is uniform in the unfolded range, the lowest bit selects the side while both sides have room
+    const double d = (double) (v >> 11) * 0x1p-53 * (max - min);
+    double x;
+    if (d < 2.0 * m) {
+        x = v & 1 ? origin - 0.5 * d : origin + 0.5 * d;
+    } else {
+        x = up > down ? origin + (d - m) : origin - (d - m);
+    }
+    x = x < min ? min : (x > max ? max : x);
+    unit__prop_example("%.17g", x);
+    return x;
+}
+
+void unit_gen_bytes(void* buf, size_t size) {
+    unsigned char* dst = (unsigned char*) buf;
+    for (size_t i = 0; i < size; i += 8) {
+        const uint64_t v = unit__prop_draw();
+        const size_t n = size - i < 8 ? size - i : 8;
+        for (size_t j = 0; j < n; ++j) {
+            dst[i + j] = (unsigned char) (v >> (8 * j));
+        }
+    }
+    if (unit__prop.node && unit__prop.phase == UNIT__PROP_REPORT) {
+        char hex[3 * 32 + 1];
+        struct unit__text text = {hex, sizeof hex, 0};
+        hex[0] = 0;
+        for (size_t i = 0; i < size && i < 32; ++i) {
+            unit__text_printf(&text, i ? " %02x" : "%02x", dst[i]);
+        }
+        unit__prop_example(size > 32 ? "[%s ... (%zu bytes)]" : "[%s]", hex, size);
+    }
+}
+
+static size_t unit__gen_len(size_t max) {
+    struct unit__prop* p = &unit__prop;
+    const uint32_t at = p->draws_num;
+    const size_t n = (size_t) unit__gen_int(0, (int64_t) max);
+    if (at < p->draws_num) {
+        p->lens[at] = 1;
+    }
+    return n;
+}
+
+size_t unit_gen_len(size_t max) {
+    const size_t n = unit__gen_len(max);
+    unit__prop_example("len %zu", n);
+    return n;
+}
+
+size_t unit_gen_str(char* buf, size_t size, const char* alphabet) {
+    if (!size) {
+        return 0;
+    }
+    // printable ASCII, the first character is the simplest one
+    static const char printable[] = "a !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`bcdefghijklmnopqrstuvwxyz{|}~";
+    const char* chars = alphabet && *alphabet ? alphabet : printable;
+    const int64_t chars_num = (int64_t) strlen(chars);
+    const size_t len = unit__gen_len(size - 1);
+    for (size_t i = 0; i < len; ++i) {
+        buf[i] = chars[unit__gen_int(0, chars_num - 1)];
+    }
+    buf[len] = 0;
+    unit__prop_example("\"%s\"", buf);
+    return len;
+}
+
+// shortlex order: shorter sequence of draws is simpler, then the lexicographically smaller one
+static bool unit__prop_simpler(const uint64_t* a, uint32_t a_num, const uint64_t* b, uint32_t b_num) {
+    if (a_num != b_num) {
+        return a_num < b_num;
+    }
+    for (uint32_t i = 0; i < a_num; ++i) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i];
+        }
+    }
+    return false;
+}
+
+static void unit__prop_keep(struct unit__prop* p) {
+    memcpy(p->best, p->draws, p->draws_num * sizeof *p->draws);
+    memcpy(p->best_lens, p->lens, p->draws_num);
+    p->best_num = p->draws_num;
+}
+
+static void unit__prop_sweep(struct unit__prop* p) {
+    p->pass = UNIT__SHRINK_DELETE;
+    p->size = UNIT__SHRINK_CHUNK;
+    p->index = 0;
+    p->adjust = false;
+    p->improved = false;
+}
+
+// the nearest length drawn before `index`, elements of the sequence follow its length
+static bool unit__prop_find_len(const struct unit__prop* p, uint32_t* at) {
+    for (uint32_t i = p->index; i-- > 0;) {
+        if (p->best_lens[i]) {
+            *at = i;
+            return p->best[i] >= p->size;
+        }
+    }
+    return false;
+}
+
+// builds the next candidate from the best failed case, returns false if the last sweep made no progress
+static bool unit__prop_candidate(struct unit__prop* p) {
+    for (;;) {
+        const uint32_t n = p->best_num;
+        if (p->pass == UNIT__SHRINK_DELETE || p->pass == UNIT__SHRINK_ZERO) {
+            if (p->index + p->size > n) {
+                if (p->size > 1) {
+                    p->size /= 2;
+                } else {
+                    ++p->pass;
+                    p->size = UNIT__SHRINK_CHUNK;
+                    p->adjust = false;
+                    p->lo = 0;
+                    p->hi = n ? p->best[0] >> 1 : 0;
+                }
+                p->index = 0;
+                continue;
+            }
+            memcpy(p->replay, p->best, n * sizeof *p->best);
+            if (p->pass == UNIT__SHRINK_DELETE) {
+                uint32_t len = 0;
+                if (p->adjust) {
+                    // the shorter sequence keeps the following draws in place
+                    if (!unit__prop_find_len(p, &len)) {
+                        p->adjust = false;
+                        ++p->index;
+                        continue;
+                    }
+                    p->replay[len] -= p->size;
+                }
+                memmove(p->replay + p->index, p->replay + p->index + p->size,
+                        (n - p->index - p->size) * sizeof *p->replay);
+                p->replay_num = n - p->size;
+                return true;
+            }
+            uint64_t any = 0;
+            for (uint32_t i = p->index; i < p->index + p->size; ++i) {
+                any |= p->replay[i];
+                p->replay[i] = 0;
+            }
+            if (any) {
+                p->replay_num = n;
+                return true;
+            }
+            ++p->index;
+        } else if (p->pass == UNIT__SHRINK_MINIMIZE) {
+            if (p->index >= n) {
+                ++p->pass;
+            } else if (p->lo < p->hi) {
+                // binary search of the smallest failing draw with the same lowest bit: it's the sign of zig-zagged
+                // integers and the side of doubles, so the value goes monotonically towards the origin
+                memcpy(p->replay, p->best, n * sizeof *p->best);
+                p->replay[p->index] = (p->lo + (p->hi - p->lo) / 2) << 1 | (p->best[p->index] & 1);
+                p->replay_num = n;
+                return true;
+            } else if (!p->adjust && p->best[p->index]) {
+                // the adjacent smaller draw flips the lowest bit: the boundary value of the other parity
+                memcpy(p->replay, p->best, n * sizeof *p->best);
+                p->replay[p->index] = p->best[p->index] - 1;
+                p->replay_num = n;
+                p->adjust = true;
+                return true;
+            } else {
+                ++p->index;
+                p->adjust = false;
+                p->lo = 0;
+                p->hi = p->index < n ? p->best[p->index] >> 1 : 0;
+            }
+        } else {
+            if (!p->improved) {
+                return false;
+            }
+            unit__prop_sweep(p);
+        }
+    }
+}
+
+// moves the shrink cursor after the candidate run
+static void unit__prop_shrunk(struct unit__prop* p, bool accepted) {
+    if (accepted) {
+        unit__prop_keep(p);
+        p->improved = true;
+    }
+    switch (p->pass) {
+        case UNIT__SHRINK_DELETE:
+            // the next chunk has moved to the same index, the rejected chunk is deleted with its length then
+            if (accepted || p->adjust) {
+                p->index += accepted ? 0 : 1;
+                p->adjust = false;
+            } else {
+                p->adjust = true;
+            }
+            break;
+        case UNIT__SHRINK_ZERO:
+            ++p->index;
+            break;
+        case UNIT__SHRINK_MINIMIZE:
+            if (p->adjust) {
+                // the smaller draw of the other parity is searched again
+                p->adjust = !accepted;
+                p->lo = 0;
+                p->hi = accepted && p->index < p->best_num ? p->best[p->index] >> 1 : 0;
+            } else if (accepted) {
+                p->hi = p->index < p->best_num ? p->best[p->index] >> 1 : 0;
+            } else {
+                p->lo = (p->replay[p->index] >> 1) + 1;
+            }
+            break;
+    }
+}
+
+static void unit__prop_stop(void) {
+    struct unit__prop* p = &unit__prop;
+    if (p->node) {
+        unit__events = p->events;
+        p->probing = false;
+        p->node = NULL;
+    }
+}
+
+static void unit__prop_fail(struct unit__prop* p, const char* what) {
+    static struct unit__assert_site site;
+    site.level = UNIT__LEVEL_CHECK;
+    site.file = p->node->file;
+    site.line = p->node->line;
+    site.comment = "";
+    site.desc = "property";
+    unit__tls.site = &site;
+
+    char path[512];
+    unit__format_path(path, sizeof path, p->node->parent, p->node->name);
+    char buffer[UNIT_PROPERTY_EXAMPLE + 1024];
+    struct unit__text text = {buffer, sizeof buffer, 0};
+    buffer[0] = 0;
+    unit__text_printf(&text, "%s case %lld of %lld", what, (long long) p->failed_case + 1, (long long) p->cases_num);
+    if (p->phase == UNIT__PROP_REPORT) {
+        unit__text_printf(&text, ", shrunk in %d runs to " UNIT__MARK_FAIL_S "(%s)" UNIT__MARK_RESET_S, p->shrinks,
+                          p->example.data);
+    }
+    unit__text_printf(&text, "\n    Reproduce with " UNIT__MARK_SUCCESS_S "`--seed=%u --filter=\"%s\"`" UNIT__MARK_RESET_S,
+                      unit__opts.seed, path);
+    unit__fail_text(buffer);
+}
+
+// the crash inside the case is reported by `--catch-crashes`, the case is reported to reproduce it
+static void unit__prop_crashed(void) {
+    struct unit__prop* p = &unit__prop;
+    if (p->node) {
+        const bool probing = p->probing;
+        if (p->phase == UNIT__PROP_GENERATE) {
+            p->failed_case = p->cases;
+        }
+        unit__events = p->events;
+        p->probing = false;
+        if (probing) {
+            unit__prop_fail(p, "Crashed at");
+        }
+        p->node = NULL;
+    }
+}
+
+void unit__prop_begin(struct unit_test* unit, int64_t cases) {
+    struct unit__prop* p = &unit__prop;
+    char path[512];
+    unit__format_path(path, sizeof path, unit->parent, unit->name);
+    // the stream depends on `--seed` and the test path, so cases don't change when other tests are added
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (const char* c = path; *c; ++c) {
+        hash = (hash ^ (unsigned char) *c) * 0x100000001B3ull;
+    }
+    uint64_t x = unit__opts.seed;
+    p->seed = hash ^ unit__splitmix64(&x);
+    p->node = unit;
+    p->phase = UNIT__PROP_START;
+    p->cases = 0;
+    p->cases_num = cases;
+    p->shrinks = 0;
+    p->failed = false;
+    p->events = unit__events;
+    p->state = __atomic_load_n(&unit__hot.state, __ATOMIC_RELAXED);
+    p->example = (struct unit__text) {p->example_data, sizeof p->example_data, 0};
+    p->example_data[0] = 0;
+    // passing assertions and echo of probing runs are not printed
+    p->probing = true;
+    unit__events &= ~(UNIT__EVENT(ASSERTION) | UNIT__EVENT(ECHO));
+}
+
+// failures posted by threads of the probing run fail its case without reporting, as failures of the tests thread do
+static void unit__prop_drain(struct unit__prop* p) {
+    struct unit__fail_node* node = unit__fail_take();
+    while (node) {
+        struct unit__fail_node* next = node->next;
+        p->failed = p->failed || node->record.site->level > UNIT__LEVEL_WARN;
+        unit__fail_free(node);
+        node = next;
+    }
+}
+
+bool unit__prop_next(void) {
+    struct unit__prop* p = &unit__prop;
+    if (!p->node) {
+        return false;
+    }
+    if (p->probing) {
+        unit__prop_drain(p);
+    }
+    switch (p->phase) {
+        case UNIT__PROP_START:
+            p->phase = UNIT__PROP_GENERATE;
+            break;
+        case UNIT__PROP_GENERATE:
+            if (p->failed) {
+                p->failed_case = p->cases;
+                unit__prop_keep(p);
+                p->best_random = p->overflow;
+                p->phase = p->overflow ? UNIT__PROP_REPORT : UNIT__PROP_SHRINK;
+                unit__prop_sweep(p);
+            } else if (++p->cases >= p->cases_num) {
+                unit__prop_stop();
+                return false;
+            }
+            break;
+        case UNIT__PROP_SHRINK:
+            ++p->shrinks;
+            unit__prop_shrunk(p, p->failed && !p->overflow &&
+                                 unit__prop_simpler(p->draws, p->draws_num, p->best, p->best_num));
+            break;
+        case UNIT__PROP_REPORT:
+            unit__prop_fail(p, "Falsified by");
+            unit__prop_stop();
+            return false;
+    }
+    if (p->phase == UNIT__PROP_SHRINK && (p->shrinks >= UNIT_PROPERTY_SHRINKS || !unit__prop_candidate(p))) {
+        p->phase = UNIT__PROP_REPORT;
+    }
+
+    p->failed = false;
+    p->overflow = false;
+    p->draws_num = 0;
+    __atomic_store_n(&unit__hot.state, p->state, __ATOMIC_RELAXED);
+    unit__fail_pool_reset();
+    switch (p->phase) {
+        case UNIT__PROP_GENERATE:
+            p->random = true;
+            unit__prop_seed(p->rng, p->seed, p->cases);
+            break;
+        case UNIT__PROP_SHRINK:
+            p->random = false;
+            break;
+        case UNIT__PROP_REPORT:
+            // the simplest case is run once more with printers to report its failures and values
+            unit__events = p->events;
+            p->probing = false;
+            p->random = p->best_random;
+            if (p->best_random) {
+                unit__prop_seed(p->rng, p->seed, p->failed_case);
+            } else {
+                memcpy(p->replay, p->best, p->best_num * sizeof *p->best);
+                p->replay_num = p->best_num;
+            }
+            break;
+    }
+    return true;
+}
+
+// endregion
+
+
+struct unit_test* unit_tests = NULL;
+struct unit_test* unit_cur = NULL;
+
+struct unit_printer* unit__printers;
+unsigned unit__events = 0;
+
+#define UNIT__EACH_PRINTER_IN(List, Func, ...) \
+for(struct unit_printer* p = (List); p; p = p->next) { \
+    if (p->events & UNIT__EVENT(Func)) { unit__printer_out = p->out; p->callback(UNIT__PRINTER_ ## Func, __VA_ARGS__); } \
+}
+
+#define UNIT__EACH_PRINTER(Func, ...) \
+if (unit__events & UNIT__EVENT(Func)) UNIT__EACH_PRINTER_IN(unit__printers, Func, __VA_ARGS__)
+
+// total time spent in printers and fixtures, excluded from measured time of running nodes
+static int64_t unit__excluded_time = 0;
+
+__thread struct unit__thread unit__tls;
+
+struct unit__hot unit__hot;
+
+// assertions passed in other threads, added to the current node when failures are drained
+static int64_t unit__thread_assertions = 0;
+
+// fills assertion fields for printers, hot path stores only the call site pointer
+static void unit__expand_site(const struct unit__assert_site* site, int status) {
+    unit_cur->assert_site = site;
+    unit_cur->assert_comment = site->comment;
+    unit_cur->assert_desc = site->desc;
+    unit_cur->assert_level = site->level;
+    unit_cur->assert_file = site->file;
+    unit_cur->assert_line = site->line;
+    unit_cur->assert_status = status;
+}
+
+void unit__skip_assert(void) {
+    // пропустить проверку
+    if (unit__tls.owner && (unit__events & UNIT__EVENT(ASSERTION))) {
+        unit__expand_site(unit__tls.site, UNIT_STATUS_SKIPPED);
+        UNIT__EACH_PRINTER(ASSERTION, unit_cur, 0);
+    }
+}
+
+void unit__notify_assert(int status) {
+    unit__expand_site(unit__tls.site, status);
+    UNIT__EACH_PRINTER(ASSERTION, unit_cur, 0);
+}
+
+void unit__assert_pass_thread(void) {
+    __atomic_add_fetch(&unit__thread_assertions, 1, __ATOMIC_RELAXED);
+}
+
+static void unit__fail(struct unit__fail_record* record) {
+    const int level = record->site->level;
+    if (level > UNIT__LEVEL_WARN) {
+        // failed `REQUIRE` stops assertions in all threads immediately
+        __atomic_or_fetch(&unit__hot.state, level, __ATOMIC_RELAXED);
+    }
+    if (unit__prop.probing && unit__tls.owner) {
+        // the case is reported only after it's shrunk
+        unit__prop.failed = unit__prop.failed || level > UNIT__LEVEL_WARN;
+        return;
+    }
+    if (!unit__tls.owner) {
+        // printers are not thread-safe, the failure is reported by the tests thread
+        unit__fail_post(record);
+        return;
+    }
+    ++unit__hot.assertions;
+    unit__expand_site(record->site, UNIT_STATUS_FAILED);
+    UNIT__EACH_PRINTER(ASSERTION, unit_cur, 0);
+    if (level > UNIT__LEVEL_WARN) {
+        for (struct unit_test* n = unit_cur; n; n = n->parent) {
+            if (n->options.failing) {
+                break;
+            }
+            n->status = UNIT_STATUS_FAILED;
+        }
+    }
+    unit_cur->fail_record = record;
+    UNIT__EACH_PRINTER(FAIL, unit_cur, NULL);
+}
+
+// reports failures and counts assertions of other threads in the current node
+static void unit__fail_drain(void) {
+    unit__hot.assertions += __atomic_exchange_n(&unit__thread_assertions, 0, __ATOMIC_RELAXED);
+    struct unit__fail_node* node = unit__fail_take();
+    while (node) {
+        struct unit__fail_node* next = node->next;
+        unit__fail(unit__fail_adopt(&node->record));
+        unit__fail_free(node);
+        node = next;
+    }
+}
+
+// failure with pre-formatted marked text
+static void unit__fail_text(const char* text) {
+    struct unit__fail_record* r = unit__fail_alloc(UNIT__FAIL_TEXT);
+    r->text = unit__fail_strdup(text);
+    unit__fail(r);
+}
+
+// each operand is formatted with its own signedness
+#define UNIT__IMPLEMENT_MIXED_ASSERT(Tag, TypeA, TypeB, Rel, Unary, ValueA, ValueB) \
+void unit__fail_ ## Tag(TypeA a, TypeB b, int op, const char* sa, const char* sb) { \
+    struct unit__fail_record* r = unit__fail_alloc(UNIT__FAIL_COMPARE); \
+    r->op = op; \
+    r->sa = sa; \
+    r->sb = sb; \
+    r->a = unit__value_ ## ValueA(a); \
+    r->b = unit__value_ ## ValueB(b); \
+    unit__fail(r); \
+}
+
+#define UNIT__IMPLEMENT_ASSERT(Tag, Type, Rel, Unary) UNIT__IMPLEMENT_MIXED_ASSERT(Tag, Type, Type, Rel, Unary, Tag, Tag)
+
+UNIT__FOR_ASSERTS(UNIT__IMPLEMENT_ASSERT)
+UNIT__FOR_MIXED_ASSERTS(UNIT__IMPLEMENT_MIXED_ASSERT)
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+#define UNIT__SIMD_AVX2 1
+#define UNIT__SIMD_SSE2 1
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+#include <emmintrin.h>
+
+#define UNIT__SIMD_SSE2 1
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+#include <arm_neon.h>
+
+#define UNIT__SIMD_NEON 1
+
+#endif
+
+// region сравнение блоков памяти: `CHECK_MEM_EQ`, `CHECK_ARRAY_EQ`
+
+// number of elements printed around the first mismatch, bytes window is twice wider
+#define UNIT__DIFF_WINDOW 8
+
+/**
+ * Returns offset of the first different byte, or `size` if blocks are equal
+ */
+static size_t unit__mismatch(const unsigned char* a, const unsigned char* b, size_t size) {
+    size_t i = 0;
+#ifdef UNIT__SIMD_AVX2
+    // fast path for long equal runs: 128 bytes per iteration, exact position is found below
+    for (; i + 128 <= size; i += 128) {
+        __m256i d = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*) (a + i)),
+                                     _mm256_loadu_si256((const __m256i*) (b + i)));
+        for (size_t j = 32; j < 128; j += 32) {
+            d = _mm256_or_si256(d, _mm256_xor_si256(_mm256_loadu_si256((const __m256i*) (a + i + j)),
+                                                    _mm256_loadu_si256((const __m256i*) (b + i + j))));
+        }
+        if (!_mm256_testz_si256(d, d)) {
+            break;
+        }
+    }
+    for (; i + 32 <= size; i += 32) {
+        const __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) (a + i)),
+                                             _mm256_loadu_si256((const __m256i*) (b + i)));
+        const unsigned mask = ~(unsigned) _mm256_movemask_epi8(eq);
+        if (mask) {
+            return i + (size_t) __builtin_ctz(mask);
+        }
+    }
+#endif // UNIT__SIMD_AVX2
+#ifdef UNIT__SIMD_SSE2
+    for (; i + 64 <= size; i += 64) {
+        __m128i d = _mm_xor_si128(_mm_loadu_si128((const __m128i*) (a + i)),
+                                  _mm_loadu_si128((const __m128i*) (b + i)));
+        for (size_t j = 16; j < 64; j += 16) {
+            d = _mm_or_si128(d, _mm_xor_si128(_mm_loadu_si128((const __m128i*) (a + i + j)),
+                                              _mm_loadu_si128((const __m128i*) (b + i + j))));
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(d, _mm_setzero_si128())) != 0xFFFF) {
+            break;
+        }
+    }
+    for (; i + 16 <= size; i += 16) {
+        const __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (a + i)),
+                                          _mm_loadu_si128((const __m128i*) (b + i)));
+        const unsigned mask = ~(unsigned) _mm_movemask_epi8(eq) & 0xFFFFu;
+        if (mask) {
+            return i + (size_t) __builtin_ctz(mask);
+        }
+    }
+#endif // UNIT__SIMD_SSE2
+#ifdef UNIT__SIMD_NEON
+    for (; i + 16 <= size; i += 16) {
+        const uint8x16_t eq = vceqq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+        if (vminvq_u8(eq) != 0xFF) {
+            // exact position is found by the scalar loop
+            break;
+        }
+    }
+#endif // UNIT__SIMD_NEON
+    for (; i + 8 <= size; i += 8) {
+        uint64_t x, y;
+        memcpy(&x, a + i, 8);
+        memcpy(&y, b + i, 8);
+        if (x != y) {
+            break;
+        }
+    }
+    for (; i < size; ++i) {
+        if (a[i] != b[i]) {
+            return i;
+        }
+    }
+    return size;
+}
+
+/**
+ * Counts elements with different bytes, starting from the element containing `from` offset
+ */
+static size_t unit__count_mismatches(const unsigned char* a, const unsigned char* b, size_t size, size_t elem_size,
+                                     size_t from) {
+    size_t count = 0;
+    size_t i = from;
+    while (i < size) {
+        i += unit__mismatch(a + i, b + i, size - i);
+        if (i >= size) {
+            break;
+        }
+        ++count;
+        i = (i / elem_size + 1) * elem_size;
+    }
+    return count;
+}
+
+static void unit__fail_null(const char* sa, const char* sb, const char* null_expr, const char* op) {
+    char buffer[512];
+    struct unit__text text = {buffer, sizeof buffer, 0};
+    buffer[0] = 0;
+    unit__text_printf(&text, "Expected " UNIT__MARK_SUCCESS_S "`%s` %s `%s`" UNIT__MARK_RESET_S ", but got "
+                             UNIT__MARK_FAIL_S "`%s` is NULL" UNIT__MARK_RESET_S, sa, op, sb, null_expr);
+    unit__fail_text(buffer);
+}
+
+static void unit__print_elem(struct unit__text* text, const unsigned char* p, size_t elem_size) {
+    switch (elem_size) {
+        case 1:
+            unit__text_printf(text, "%02x", p[0]);
+            break;
+        case 2: {
+            uint16_t v;
+            memcpy(&v, p, 2);
+            unit__text_printf(text, "%04x", v);
+        }
+            break;
+        case 4: {
+            uint32_t v;
+            memcpy(&v, p, 4);
+            unit__text_printf(text, "%08x", v);
+        }
+            break;
+        case 8: {
+            uint64_t v;
+            memcpy(&v, p, 8);
+            unit__text_printf(text, "%016llx", (unsigned long long) v);
+        }
+            break;
+        default:
+            for (size_t i = 0; i < elem_size && i < 16; ++i) {
+                unit__text_printf(text, "%02x", p[i]);
+            }
+            if (elem_size > 16) {
+                unit__text_printf(text, "..");
+            }
+            break;
+    }
+}
+
+/**
+ * Prints one row of hex window, mismatched elements are highlighted
+ */
+static void unit__print_window_row(struct unit__text* text, const char* name, const unsigned char* p,
+                                   const unsigned char* other, size_t begin, size_t end, size_t elem_size) {
+    unit__text_printf(text, "\n    %s:", name);
+    for (size_t i = begin; i < end; ++i) {
+        const unsigned char* e = p + i * elem_size;
+        const bool diff = memcmp(e, other + i * elem_size, elem_size) != 0;
+        unit__text_printf(text, " %s", diff ? UNIT__MARK_FAIL_S : "");
+        unit__print_elem(text, e, elem_size);
+        unit__text_printf(text, "%s", diff ? UNIT__MARK_RESET_S : "");
+    }
+}
+
+void unit__assert_mem(const void* a, const void* b, size_t size, size_t elem_size, const char* sa, const char* sb) {
+    const unsigned char* pa = (const unsigned char*) a;
+    const unsigned char* pb = (const unsigned char*) b;
+    size_t offset = size;
+    if (pa != pb && size) {
+        offset = pa && pb ? unit__mismatch(pa, pb, size) : 0;
+    }
+    if (offset == size) {
+        unit__assert_pass();
+        return;
+    }
+    if (!pa || !pb) {
+        unit__fail_null(sa, sb, pa ? sb : sa, "==");
+        return;
+    }
+    if (elem_size == 0) {
+        elem_size = 1;
+    }
+    const size_t count = size / elem_size;
+    const size_t index = offset / elem_size;
+    const size_t mismatches = unit__count_mismatches(pa, pb, size, elem_size, index * elem_size);
+    const size_t window = elem_size == 1 ? 2 * UNIT__DIFF_WINDOW : UNIT__DIFF_WINDOW;
+    const size_t begin = index > window / 2 ? index - window / 2 : 0;
+    const size_t end = begin + window < count ? begin + window : count;
+
+    char buffer[2048];
+    struct unit__text text = {buffer, sizeof buffer, 0};
+    buffer[0] = 0;
+    unit__text_printf(&text, "Expected " UNIT__MARK_SUCCESS_S "`%s` == `%s`" UNIT__MARK_RESET_S ", but got " UNIT__MARK_FAIL_S,
+                      sa, sb);
+    if (elem_size == 1) {
+        unit__text_printf(&text, "%zu of %zu bytes differ, first at offset %zu", mismatches, size, offset);
+    } else {
+        unit__text_printf(&text, "%zu of %zu elements differ, first at index %zu (byte %zu)", mismatches, count,
+                          index, offset);
+    }
+    unit__text_printf(&text, UNIT__MARK_RESET_S "\n    [%zu..%zu)", begin, end);
+    unit__print_window_row(&text, sa, pa, pb, begin, end, elem_size);
+    unit__print_window_row(&text, sb, pb, pa, begin, end, elem_size);
+    unit__fail_text(buffer);
+}
+
+// endregion
+
+// region приближённое сравнение массивов чисел с плавающей точкой: `CHECK_ARRAY_NEAR`
+
+#ifndef UNIT_NEAR_WORST
+// number of the worst elements printed on failure
+#define UNIT_NEAR_WORST 5
+#endif
+
+// default tolerance if no one is set
+#define UNIT__NEAR_DEFAULT_ULPS 4
+
+struct unit__near_stats {
+    uint64_t max_ulps;
+    double max_rel;
+    size_t fails;
+};
+
+struct unit__near_elem {
+    size_t index;
+    uint64_t ulps;
+    double rel;
+};
+
+// distance in units in the last place: bits are mapped to ordered integers, so adjacent floats differ by 1,
+// the distance fits the unsigned integer of the same width as the floating type
+#define UNIT__IMPLEMENT_NEAR(Tag, Type, Int, UInt, Abs, Format) \
+/* branch-free: the sign-magnitude bits are mapped to the two's complement, so `-0` and `+0` are 0 ulps apart */ \
+static inline UInt unit__ulps_ ## Tag(Type x, Type y) { \
+    Int ix, iy; \
+    memcpy(&ix, &x, sizeof ix); \
+    memcpy(&iy, &y, sizeof iy); \
+    const Int magnitude = (Int) (((UInt) 1 << (8 * sizeof(Int) - 1)) - 1); \
+    const Int sx = ix >> (8 * sizeof(Int) - 1); \
+    const Int sy = iy >> (8 * sizeof(Int) - 1); \
+    const Int kx = (Int) (((UInt) (ix & magnitude) ^ (UInt) sx) - (UInt) sx); \
+    const Int ky = (Int) (((UInt) (iy & magnitude) ^ (UInt) sy) - (UInt) sy); \
+    const UInt lt = -(UInt) (kx < ky); \
+    return (((UInt) kx - (UInt) ky) ^ lt) - lt; \
+} \
+\
+static inline UInt unit__bits_ ## Tag(Type x) { \
+    UInt u; \
+    memcpy(&u, &x, sizeof u); \
+    return u; \
+} \
+\
+static inline Type unit__from_bits_ ## Tag(UInt u) { \
+    Type x; \
+    memcpy(&x, &u, sizeof x); \
+    return x; \
+} \
+\
+/* tolerances in the precision of compared elements, rounded down so the comparison is exact; */ \
+/* the relative one is kept as bits: not negative floats are ordered as their bits */ \
+struct unit__near_tol_ ## Tag { \
+    UInt ulps; \
+    UInt rel; \
+    Type abs; \
+}; \
+\
+/* the conversion rounds to nearest, so one step on the bits down to the adjacent float is enough */ \
+static Type unit__near_round_down_ ## Tag(double x) { \
+    const Type t = (Type) x; \
+    if (!((double) t > x)) { \
+        return t; \
+    } \
+    const UInt u = unit__bits_ ## Tag(t); \
+    const UInt sign = (UInt) 1 << (8 * sizeof(UInt) - 1); \
+    return unit__from_bits_ ## Tag(t > 0 ? u - 1 : (t < 0 ? u + 1 : sign | 1)); \
+} \
+\
+static struct unit__near_tol_ ## Tag unit__near_tol_ ## Tag(struct unit_tolerance tol) { \
+    struct unit__near_tol_ ## Tag t; \
+    t.ulps = (UInt) tol.ulps; \
+    /* a negative relative tolerance passes nothing beyond the equal elements, which pass by 0 ulps anyway */ \
+    t.rel = unit__bits_ ## Tag(unit__near_round_down_ ## Tag(tol.rel > 0.0 ? tol.rel : 0.0)); \
+    t.abs = unit__near_round_down_ ## Tag(tol.abs); \
+    return t; \
+} \
+\
+/* `ulps` is all ones for NaN against a number, `rel` is the bits of the relative error: never NaN nor negative */ \
+struct unit__near_result_ ## Tag { \
+    UInt ulps; \
+    UInt rel; \
+    UInt pass; \
+}; \
+\
+/* every condition is a lane mask and every value is computed unconditionally, */ \
+/* so the kernel inlined into a loop is if-converted and the loop is vectorized */ \
+static inline __attribute__((always_inline)) struct unit__near_result_ ## Tag \
+unit__near_elem_ ## Tag(Type x, Type y, struct unit__near_tol_ ## Tag tol) { \
+    const Type d = Abs(x - y); \
+    const Type ax = Abs(x); \
+    const Type ay = Abs(y); \
+    const Type q = d / (ax > ay ? ax : ay); \
+    const UInt x_nan = -(UInt) (x != x); \
+    const UInt y_nan = -(UInt) (y != y); \
+    const UInt both_nan = x_nan & y_nan; \
+    const UInt nan = x_nan ^ y_nan; \
+    const UInt same = both_nan | -(UInt) (x == y); \
+    const UInt inf = nan | -(UInt) (q != q); \
+    struct unit__near_result_ ## Tag r; \
+    r.ulps = ~both_nan & (nan | unit__ulps_ ## Tag(x, y)); \
+    r.rel = ~same & ((inf & unit__bits_ ## Tag((Type) __builtin_inf())) | (~inf & unit__bits_ ## Tag(q))); \
+    r.pass = (same | (~nan & -(UInt) (d <= tol.abs)) | -(UInt) (r.rel <= tol.rel) | -(UInt) (r.ulps <= tol.ulps)) & 1; \
+    return r; \
+} \
+\
+/* one flat pass with loop-local reductions, vectorized by the compiler: for `float` with SSE2 and NEON already, */ \
+/* for `double` where 64-bit lanes compare natively (SSE4.2, AVX2, AArch64 NEON) */ \
+static struct unit__near_stats unit__near_stats_ ## Tag(const Type* a, const Type* b, size_t n, struct unit_tolerance tol) { \
+    const struct unit__near_tol_ ## Tag t = unit__near_tol_ ## Tag(tol); \
+    UInt max_ulps = 0; \
+    UInt max_rel = 0; \
+    size_t fails = 0; \
+    for (size_t i = 0; i < n; ++i) { \
+        const struct unit__near_result_ ## Tag r = unit__near_elem_ ## Tag(a[i], b[i], t); \
+        fails += r.pass ^ 1; \
+        max_ulps = r.ulps > max_ulps ? r.ulps : max_ulps; \
+        max_rel = r.rel > max_rel ? r.rel : max_rel; \
+    } \
+    struct unit__near_stats stats; \
+    stats.max_ulps = max_ulps == (UInt) -1 ? UINT64_MAX : max_ulps; \
+    stats.max_rel = unit__from_bits_ ## Tag(max_rel); \
+    stats.fails = fails; \
+    return stats; \
+} \
+\
+void unit__assert_near_ ## Tag(const Type* a, const Type* b, size_t n, struct unit_tolerance tol, const char* sa, const char* sb) { \
+    if (!tol.ulps && tol.rel == 0.0 && tol.abs == 0.0) { \
+        tol.ulps = UNIT__NEAR_DEFAULT_ULPS; \
+    } \
+    struct unit__near_stats stats = {0, 0.0, 0}; \
+    if (a != b && n) { \
+        stats = a && b ? unit__near_stats_ ## Tag(a, b, n, tol) : (struct unit__near_stats) {UINT64_MAX, 0.0, n}; \
+    } \
+    if (!stats.fails) { \
+        unit__assert_pass(); \
+        return; \
+    } \
+    if (!a || !b) { \
+        unit__fail_null(sa, sb, a ? sb : sa, "~"); \
+        return; \
+    } \
+    /* the second pass only on failure: the worst elements sorted by ULP distance */ \
+    const struct unit__near_tol_ ## Tag t = unit__near_tol_ ## Tag(tol); \
+    struct unit__near_elem worst[UNIT_NEAR_WORST]; \
+    int worst_num = 0; \
+    for (size_t i = 0; i < n; ++i) { \
+        const struct unit__near_result_ ## Tag r = unit__near_elem_ ## Tag(a[i], b[i], t); \
+        const uint64_t ulps = r.ulps == (UInt) -1 ? UINT64_MAX : r.ulps; \
+        const double rel = unit__from_bits_ ## Tag(r.rel); \
+        if (r.pass || (worst_num == UNIT_NEAR_WORST && ulps <= worst[worst_num - 1].ulps)) { \
+            continue; \
+        } \
+        int j = worst_num < UNIT_NEAR_WORST ? worst_num++ : worst_num - 1; \
+        for (; j > 0 && worst[j - 1].ulps < ulps; --j) { \
+            worst[j] = worst[j - 1]; \
+        } \
+        worst[j] = (struct unit__near_elem) {i, ulps, rel}; \
+    } \
+    char buffer[2048]; \
+    struct unit__text text = {buffer, sizeof buffer, 0}; \
+    buffer[0] = 0; \
+    unit__text_printf(&text, "Expected " UNIT__MARK_SUCCESS_S "`%s` ~ `%s` (ulps %u, rel %g, abs %g)" UNIT__MARK_RESET_S \
+                      ", but got " UNIT__MARK_FAIL_S "%zu of %zu elements out of tolerance" UNIT__MARK_RESET_S \
+                      "\n    max error: %llu ulps, rel %g", sa, sb, tol.ulps, tol.rel, tol.abs, \
+                      stats.fails, n, (unsigned long long) stats.max_ulps, stats.max_rel); \
+    for (int i = 0; i < worst_num; ++i) { \
+        const size_t k = worst[i].index; \
+        unit__text_printf(&text, "\n    [%zu] " UNIT__MARK_FAIL_S Format " != " Format UNIT__MARK_RESET_S \
+                          " (%llu ulps, rel %g)", k, a[k], b[k], (unsigned long long) worst[i].ulps, worst[i].rel); \
+    } \
+    unit__fail_text(buffer); \
+}
+
+UNIT__IMPLEMENT_NEAR(flt, float, int32_t, uint32_t, __builtin_fabsf, "%.9g")
+UNIT__IMPLEMENT_NEAR(dbl, double, int64_t, uint64_t, __builtin_fabs, "%.17g")
+
+// endregion
+
+// region проверка диапазона одним утверждением: `CHECK_ALL`, `CHECK_ALL_EQ`
+
+/**
+ * Prints integer with thousands separators: `1,000,000`
+ */
+static void unit__format_count(struct unit__text* text, intmax_t x) {
+    char digits[32];
+    const int n = snprintf(digits, sizeof digits, "%jd", x);
+    const int sign = digits[0] == '-';
+    char buf[48];
+    int len = 0;
+    for (int i = 0; i < n; ++i) {
+        if (i > sign && (n - i) % 3 == 0) {
+            buf[len++] = ',';
+        }
+        buf[len++] = digits[i];
+    }
+    buf[len] = 0;
+    unit__text_printf(text, "%s", buf);
+}
+
+void unit__all_fail(struct unit__all* all, intmax_t index) {
+    if (all->samples < UNIT_ALL_SAMPLES) {
+        all->values[all->samples] = NULL;
+        all->index[all->samples++] = index;
+    }
+    ++all->fails;
+}
+
+#define UNIT__IMPLEMENT_MIXED_ALL_FAIL(Tag, TypeA, TypeB, Rel, Unary, ValueA, ValueB) \
+void unit__all_fail_ ## Tag(struct unit__all* all, intmax_t index, TypeA a, TypeB b) { \
+    const int k = all->samples; \
+    unit__all_fail(all, index); \
+    if (k < all->samples) { \
+        const struct unit__value va = unit__value_ ## ValueA(a); \
+        const struct unit__value vb = unit__value_ ## ValueB(b); \
+        char buffer[256]; \
+        struct unit__text text = {buffer, sizeof buffer, 0}; \
+        buffer[0] = 0; \
+        unit__format_value(&text, &va); \
+        unit__text_printf(&text, " != "); \
+        unit__format_value(&text, &vb); \
+        unit__fail_strfree(va.tag == UNIT__VALUE_STR ? va.s : NULL); \
+        unit__fail_strfree(vb.tag == UNIT__VALUE_STR ? vb.s : NULL); \
+        all->values[k] = unit__fail_strdup(buffer); \
+    } \
+}
+
+#define UNIT__IMPLEMENT_ALL_FAIL(Tag, Type, Rel, Unary) UNIT__IMPLEMENT_MIXED_ALL_FAIL(Tag, Type, Type, Rel, Unary, Tag, Tag)
+
+UNIT__FOR_ASSERTS(UNIT__IMPLEMENT_ALL_FAIL)
+UNIT__FOR_MIXED_ASSERTS(UNIT__IMPLEMENT_MIXED_ALL_FAIL)
+
+void unit__all_end(const struct unit__all* all, intmax_t begin, intmax_t end, const char* var, const char* expr) {
+    if (!all->fails) {
+        unit__assert_pass();
+        return;
+    }
+    char buffer[2048];
+    struct unit__text text = {buffer, sizeof buffer, 0};
+    buffer[0] = 0;
+    unit__text_printf(&text, "Expected " UNIT__MARK_SUCCESS_S "`%s` for all %s in [", expr, var);
+    unit__format_count(&text, begin);
+    unit__text_printf(&text, ", ");
+    unit__format_count(&text, end);
+    unit__text_printf(&text, ")" UNIT__MARK_RESET_S ", but got " UNIT__MARK_FAIL_S);
+    unit__format_count(&text, all->fails);
+    unit__text_printf(&text, " of ");
+    unit__format_count(&text, end - begin);
+    unit__text_printf(&text, " failed, first at %s=%jd" UNIT__MARK_RESET_S, var, all->index[0]);
+    for (int i = 0; i < all->samples; ++i) {
+        if (all->values[i]) {
+            unit__text_printf(&text, "\n    %s=%jd: " UNIT__MARK_FAIL_S "%s" UNIT__MARK_RESET_S, var, all->index[i],
+                              all->values[i]);
+        } else {
+            unit__text_printf(&text, "%s%jd", i ? ", " : "\n    failed at: ", all->index[i]);
+        }
+    }
+    if (all->fails > all->samples) {
+        unit__text_printf(&text, "%s...", all->values[0] ? "\n    " : ", ");
+    }
+    for (int i = 0; i < all->samples; ++i) {
+        unit__fail_strfree(all->values[i]);
+    }
+    unit__fail_text(buffer);
+}
+
+// endregion
+
+#ifdef UNIT__HAS_CRASH_RECOVERY
+
+#include <signal.h>
+
+#if defined(__has_include)
+#if __has_include(<execinfo.h>)
+
+#include <execinfo.h>
+
+#define UNIT__CRASH_BACKTRACE 1
+
+#endif // <execinfo.h>
+#endif // __has_include
+
+#endif // UNIT__HAS_CRASH_RECOVERY
+
+// region восстановление после падения теста: `--catch-crashes`, переход к следующему тесту без перезапуска процесса
+
+#ifndef UNIT_CRASH_NODES
+// maximum nesting of recovery points, crash in deeper node is recovered by its parent
+#define UNIT_CRASH_NODES 32
+#endif
+
+#ifndef UNIT_CRASH_FRAMES
+// maximum number of frames in the crash backtrace
+#define UNIT_CRASH_FRAMES 32
+#endif
+
+#ifndef UNIT_CRASH_STACK
+// size of alternate signal stack, so stack overflow is recovered too
+#define UNIT_CRASH_STACK (64 * 1024)
+#endif
+
+// nodes are ended without fixtures while recovery unwinds them to the recovery point
+static bool unit__crash_unwinding = false;
+
+#ifdef UNIT__HAS_CRASH_RECOVERY
+
+static const int unit__crash_signals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+#define UNIT__CRASH_SIGNALS_NUM ((int) (sizeof unit__crash_signals / sizeof unit__crash_signals[0]))
+
+struct unit__crash_point {
+    sigjmp_buf jmp;
+    // node which armed the point, cleared at the node end, so returned frames are never used
+    struct unit_test* node;
+};
+
+static struct unit__crash_point unit__crash_points[UNIT_CRASH_NODES];
+// point for too deep nodes and runs without `--catch-crashes`, it is never armed
+static sigjmp_buf unit__crash_unused;
+static struct sigaction unit__crash_prev_actions[UNIT__CRASH_SIGNALS_NUM];
+static stack_t unit__crash_prev_stack;
+static char unit__crash_stack[UNIT_CRASH_STACK];
+static bool unit__crash_installed = false;
+
+// written by the signal handler before the jump
+static volatile sig_atomic_t unit__crash_recovering = 0;
+// node of the recovery point the crash jumped to, the crash is reported when the node ends
+static struct unit_test* unit__crash_jumped = NULL;
+static int unit__crash_sig;
+static void* unit__crash_addr;
+static void* unit__crash_frames[UNIT_CRASH_FRAMES];
+static int unit__crash_frames_num;
+
+// prints events pending in the reporter thread, see `async.c`
+static void unit__async_crash_drain(void);
+
+static int unit__node_depth(const struct unit_test* unit) {
+    int depth = 0;
+    for (; unit->parent; unit = unit->parent) {
+        ++depth;
+    }
+    return depth;
+}
+
+sigjmp_buf* unit__crash_point(struct unit_test* unit) {
+    if (!unit__opts.catch_crashes) {
+        return &unit__crash_unused;
+    }
+    const int depth = unit__node_depth(unit);
+    if (depth >= UNIT_CRASH_NODES) {
+        return &unit__crash_unused;
+    }
+    unit__crash_points[depth].node = unit;
+    return &unit__crash_points[depth].jmp;
+}
+
+static void unit__crash_disarm(struct unit_test* unit) {
+    const int depth = unit__node_depth(unit);
+    if (depth < UNIT_CRASH_NODES && unit__crash_points[depth].node == unit) {
+        unit__crash_points[depth].node = NULL;
+    }
+}
+
+static void unit__crash_handler(int sig, siginfo_t* info, void* context) {
+    (void) context;
+    struct unit__crash_point* point = NULL;
+    // jump is possible only to the frame of the same thread
+    if (unit__tls.owner && !unit__crash_recovering) {
+        for (struct unit_test* n = unit_cur; n && !point; n = n->parent) {
+            const int depth = unit__node_depth(n);
+            if (depth < UNIT_CRASH_NODES && unit__crash_points[depth].node == n) {
+                point = unit__crash_points + depth;
+            }
         }
     }
-    return file;
+    if (!point) {
+        // not recoverable: the default action is taken when the handler returns
+        unit__async_crash_drain();
+        unit__output_crash_drain();
+        struct sigaction action = {0};
+        action.sa_handler = SIG_DFL;
+        sigemptyset(&action.sa_mask);
+        sigaction(sig, &action, NULL);
+        raise(sig);
+        return;
+    }
+    unit__crash_sig = sig;
+    unit__crash_addr = info ? info->si_addr : NULL;
+#ifdef UNIT__CRASH_BACKTRACE
+    unit__crash_frames_num = backtrace(unit__crash_frames, UNIT_CRASH_FRAMES);
+#else
+    unit__crash_frames_num = 0;
+#endif
+    unit__crash_recovering = 1;
+    unit__crash_jumped = point->node;
+    siglongjmp(point->jmp, 1);
 }
 
-static const char* beautify_filename(const char* file) {
-    return unit__opts.short_filenames ? short_filename(file) : file;
+static const char* unit__signal_name(int sig) {
+    switch (sig) {
+        case SIGSEGV:
+            return "SIGSEGV";
+        case SIGBUS:
+            return "SIGBUS";
+        case SIGFPE:
+            return "SIGFPE";
+        case SIGILL:
+            return "SIGILL";
+        case SIGABRT:
+            return "SIGABRT";
+    }
+    return "signal";
 }
 
-static void print_label(FILE* f, struct unit_test* node) {
-    static const char* fancy[] = {
-            UNIT_COLOR_LABEL_RUNS " RUNS " UNIT_COLOR_RESET,
-            UNIT_COLOR_LABEL_PASS " PASS " UNIT_COLOR_RESET,
-            UNIT_COLOR_LABEL_SKIP " SKIP " UNIT_COLOR_RESET,
-            UNIT_COLOR_LABEL_FAIL " FAIL " UNIT_COLOR_RESET,
+static void unit__crash_report(struct unit_test* crashed) {
+    static struct unit__assert_site site;
+    site.level = UNIT__LEVEL_CHECK;
+    site.file = crashed->file;
+    site.line = crashed->line;
+    site.comment = "";
+    site.desc = "crash";
+    unit__tls.site = &site;
+
+    char buffer[4096];
+    struct unit__text text = {buffer, sizeof buffer, 0};
+    buffer[0] = 0;
+    unit__text_printf(&text, "Crashed with " UNIT__MARK_FAIL_S "%s" UNIT__MARK_RESET_S " (%d) at address %p",
+                      unit__signal_name(unit__crash_sig), unit__crash_sig, unit__crash_addr);
+#ifdef UNIT__CRASH_BACKTRACE
+    // skip signal handler and signal trampoline frames
+    const int skip = 2;
+    if (unit__crash_frames_num > skip) {
+        char** symbols = backtrace_symbols(unit__crash_frames + skip, unit__crash_frames_num - skip);
+        for (int i = 0; symbols && i < unit__crash_frames_num - skip; ++i) {
+            unit__text_printf(&text, "\n    #%d %s", i, symbols[i]);
+        }
+        free(symbols);
+    }
+#endif // UNIT__CRASH_BACKTRACE
+    unit__fail_text(buffer);
+}
+
+/**
+ * Continues after the jump to the recovery point of `unit`: reports the crash and ends nested nodes,
+ * the `unit` node itself is ended by the caller
+ */
+static void unit__crash_recover(struct unit_test* unit) {
+    struct unit_test* crashed = unit_cur;
+    unit__prop_crashed();
+    unit__crash_report(crashed);
+    unit__crash_unwinding = true;
+    while (unit_cur && unit_cur != unit) {
+        unit__end(unit_cur);
+    }
+    unit__crash_unwinding = false;
+    unit__crash_recovering = 0;
+}
+
+// called by `unit__end` first: the body of the jumped node was skipped by the recovery point
+static void unit__crash_land(struct unit_test* unit) {
+    if (unit__crash_jumped == unit) {
+        unit__crash_jumped = NULL;
+        unit__crash_recover(unit);
+    }
+}
+
+static void unit__crash_install(void) {
+    if (unit__crash_installed) {
+        return;
+    }
+#ifdef UNIT__CRASH_BACKTRACE
+    // `backtrace` loads unwinder lazily on the first call, it should not happen inside signal handler
+    void* warmup[1];
+    backtrace(warmup, 1);
+#endif // UNIT__CRASH_BACKTRACE
+    stack_t stack = {0};
+    stack.ss_sp = unit__crash_stack;
+    stack.ss_size = sizeof unit__crash_stack;
+    sigaltstack(&stack, &unit__crash_prev_stack);
+
+    struct sigaction action = {0};
+    action.sa_sigaction = unit__crash_handler;
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    for (int i = 0; i < UNIT__CRASH_SIGNALS_NUM; ++i) {
+        sigaction(unit__crash_signals[i], &action, unit__crash_prev_actions + i);
+    }
+    unit__crash_installed = true;
+}
+
+static void unit__crash_uninstall(void) {
+    if (!unit__crash_installed) {
+        return;
+    }
+    for (int i = 0; i < UNIT__CRASH_SIGNALS_NUM; ++i) {
+        sigaction(unit__crash_signals[i], unit__crash_prev_actions + i, NULL);
+    }
+    sigaltstack(&unit__crash_prev_stack, NULL);
+    unit__crash_installed = false;
+}
+
+#else // UNIT__HAS_CRASH_RECOVERY
+
+static void unit__crash_disarm(struct unit_test* unit) {
+    (void) unit;
+}
+
+static void unit__crash_land(struct unit_test* unit) {
+    (void) unit;
+}
+
+static void unit__crash_install(void) {
+    if (!unit__opts.quiet) {
+        fputs("unit: warning: crash recovery is not supported on this platform\n", stderr);
+    }
+}
+
+static void unit__crash_uninstall(void) {
+}
+
+#endif // !UNIT__HAS_CRASH_RECOVERY
+
+// endregion
+
+
+// region начало конец запуска каждого теста
+
+static void add_child(struct unit_test* parent, struct unit_test* child) {
+    //assert (!child->parent);
+    if (parent) {
+        if (parent->children_last) {
+            parent->children_last->next = child;
+        } else {
+            parent->children = child;
+        }
+        parent->children_last = child;
+    }
+    child->parent = parent;
+}
+
+static int64_t unit__run_fixture(void (* fixture)(void)) {
+    const int64_t t0 = unit__clock.now();
+    fixture();
+    const int64_t elapsed = unit__clock.now() - t0;
+    unit__excluded_time += elapsed;
+    return elapsed;
+}
+
+// runs `before_each` fixtures of all enclosing scopes, from the outermost one
+static void unit__run_before_each(struct unit_test* test, struct unit_test* scope) {
+    if (scope) {
+        unit__run_before_each(test, scope->parent);
+        if (scope->options.before_each && !(unit__hot.state & UNIT__LEVEL_REQUIRE)) {
+            test->fixtures_elapsed += unit__run_fixture(scope->options.before_each);
+        }
+    }
+}
+
+// runs `after_each` fixtures of all enclosing scopes, from the innermost one
+static void unit__run_after_each(struct unit_test* test) {
+    for (struct unit_test* scope = test->parent; scope; scope = scope->parent) {
+        if (scope->options.after_each) {
+            test->fixtures_elapsed += unit__run_fixture(scope->options.after_each);
+        }
+    }
+}
+
+// `*` matches any substring, `?` matches any single character, the whole string should match
+static bool unit__glob(const char* pattern, const char* str) {
+    const char* star = NULL;
+    const char* resume = NULL;
+    while (*str) {
+        if (*pattern == '?' || (*pattern != '*' && *pattern == *str)) {
+            ++pattern;
+            ++str;
+        } else if (*pattern == '*') {
+            star = pattern++;
+            resume = str;
+        } else if (star) {
+            pattern = star + 1;
+            str = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (*pattern == '*') {
+        ++pattern;
+    }
+    return !*pattern;
+}
+
+#ifndef UNIT_FILTER_DEPTH
+// maximum depth of the test path matched by `--filter`
+#define UNIT_FILTER_DEPTH 64
+#endif
+
+// the path is names of enclosing nodes and the test joined with `/`, the test could be not linked to the tree yet
+static void unit__format_path(char* path, size_t size, struct unit_test* parent, const char* name) {
+    const char* names[UNIT_FILTER_DEPTH];
+    int depth = 0;
+    names[depth++] = beautify_name(name);
+    for (struct unit_test* u = parent; u && depth < UNIT_FILTER_DEPTH; u = u->parent) {
+        names[depth++] = beautify_name(u->name);
+    }
+    size_t len = 0;
+    path[0] = 0;
+    while (depth-- > 0 && len < size) {
+        len += (size_t) snprintf(path + len, size - len, depth ? "%s/" : "%s", names[depth]);
+    }
+}
+
+static bool unit__filter_test(struct unit_test* test) {
+    char path[1024];
+    unit__format_path(path, sizeof path, unit_cur, test->name);
+    return unit__glob(unit__opts.filter, path);
+}
+
+size_t unit__rows(struct unit_test* scope, struct unit__row** rows, size_t* rows_num, size_t count) {
+    if (!*rows && count) {
+        // nodes are linked to the tree, so they live until the process exits
+        *rows = (struct unit__row*) calloc(count, sizeof **rows);
+        if (*rows) {
+            *rows_num = count;
+        } else {
+            fprintf(stderr, "unit: warning: unable to allocate %zu rows of `%s`\n", count, scope->name);
+        }
+    }
+    if (count > *rows_num && *rows) {
+        // nodes are linked to the tree, so the table could not grow between runs
+        fprintf(stderr, "unit: warning: `%s` has %zu rows, only the first %zu are run\n",
+                scope->name, count, *rows_num);
+    }
+    return count < *rows_num ? count : *rows_num;
+}
+
+struct unit_test* unit__row(struct unit_test* scope, struct unit__row* rows, size_t index, const void* row) {
+    struct unit__row* r = rows + index;
+    // the name is formatted by the first run of the row
+    if (!r->node.name) {
+        if (scope->options.row_name) {
+            scope->options.row_name(r->name, sizeof r->name, row);
+            r->name[sizeof r->name - 1] = 0;
+        } else {
+            snprintf(r->name, sizeof r->name, "[%zu]", index);
+        }
+        r->node.name = r->name;
+        r->node.file = scope->file;
+        r->node.line = scope->line;
+        r->node.type = UNIT__TYPE_TEST;
+    }
+    return &r->node;
+}
+
+int unit__begin(struct unit_test* unit) {
+    // tests not selected by `--filter` are not started and not reported at all
+    if (unit->type == UNIT__TYPE_TEST && unit__opts.filter && *unit__opts.filter && !unit__filter_test(unit)) {
+        return 0;
+    }
+    // failed `before_all` fixture skips all dependent nodes, `SKIP()` or failed `REQUIRE` in the scope body does not
+    bool run = !unit->options.skip && !(unit_cur && unit_cur->fixture_failed);
+    if (unit_cur) {
+        unit_cur->state = __atomic_load_n(&unit__hot.state, __ATOMIC_RELAXED);
+        unit_cur->assertions = unit__hot.assertions;
+    }
+    __atomic_store_n(&unit__hot.state, 0, __ATOMIC_RELAXED);
+    unit__hot.assertions = 0;
+    unit->state = 0;
+    unit->status = run ? UNIT_STATUS_RUN : UNIT_STATUS_SKIPPED;
+    unit->assert_desc = NULL;
+    unit->assert_site = NULL;
+    unit->fail_record = NULL;
+    if (unit->type == UNIT__TYPE_TEST) {
+        unit__fail_pool_reset();
+    }
+    unit->assertions = 0;
+    unit->passed = 0;
+    unit->total = 0;
+    unit->fixtures_elapsed = 0;
+    unit->fixture_failed = false;
+    if (!unit->parent) {
+        add_child(unit_cur, unit);
+    }
+    unit_cur = unit;
+    unit__tls.owner = true;
+    unit__scratch_begin(unit);
+    if (run && unit->type == UNIT__TYPE_TEST) {
+        for (struct unit_test* u = unit_cur; u; u = u->parent) {
+            u->total++;
+        }
+    }
+    const int64_t t = unit__clock.now();
+    UNIT__EACH_PRINTER(BEGIN, unit, 0);
+    unit__excluded_time += unit__clock.now() - t;
+    if (run) {
+        if (unit->type == UNIT__TYPE_TEST) {
+            unit__run_before_each(unit, unit->parent);
+        } else if (unit->options.before_all) {
+            unit->fixtures_elapsed += unit__run_fixture(unit->options.before_all);
+            unit->fixture_failed = (unit__hot.state & UNIT__LEVEL_REQUIRE) != 0;
+        }
+        // failed fixture skips the test body
+        run = !(unit->type == UNIT__TYPE_TEST && (unit__hot.state & UNIT__LEVEL_REQUIRE));
+    }
+    if (unit__opts.resources) {
+        unit__sample_resources(&unit->res0);
+    }
+    unit->t0 = unit__clock.now();
+    unit->excluded_t0 = unit__excluded_time;
+    unit->cpu_t0 = unit__cpu_time();
+    return run;
+}
+
+void unit__end(struct unit_test* unit) {
+    unit__crash_land(unit);
+    // the test was filtered out by `unit__begin`
+    if (unit != unit_cur) {
+        return;
+    }
+    unit__crash_disarm(unit);
+    unit__fail_drain();
+    if (unit->status != UNIT_STATUS_SKIPPED && !unit__crash_unwinding) {
+        if (unit->type == UNIT__TYPE_TEST) {
+            unit__run_after_each(unit);
+        } else if (unit->options.after_all) {
+            unit->fixtures_elapsed += unit__run_fixture(unit->options.after_all);
+        }
+    }
+    const int64_t cpu_elapsed = unit__cpu_time() - unit->cpu_t0;
+    const int64_t t = unit__clock.now();
+    const int64_t elapsed = t - unit->t0 - unit__clock.overhead - (unit__excluded_time - unit->excluded_t0);
+    unit->elapsed = elapsed > 0 ? elapsed : 0;
+    unit->cpu_elapsed = cpu_elapsed > 0 ? cpu_elapsed : 0;
+    if (unit__opts.resources) {
+        unit__sample_resources(&unit->res);
+        unit__diff_resources(&unit->res, &unit->res0);
+    }
+    // the arena is poisoned after the timestamp, so the fill is excluded from the test time
+    unit__scratch_end(unit);
+    if (unit->status == UNIT_STATUS_RUN) {
+        unit->status = UNIT_STATUS_SUCCESS;
+        if (unit->type == UNIT__TYPE_TEST) {
+            for (struct unit_test* u = unit_cur; u; u = u->parent) {
+                u->passed++;
+            }
+        }
+    }
+    if (unit == unit__prop.node) {
+        // `break` out of the property body
+        unit__prop_stop();
+    }
+    unit->state = __atomic_load_n(&unit__hot.state, __ATOMIC_RELAXED);
+    unit->assertions = unit__hot.assertions;
+    UNIT__EACH_PRINTER(END, unit, 0);
+    unit__excluded_time += unit__clock.now() - t;
+    unit_cur = unit->parent;
+    if (unit_cur) {
+        __atomic_store_n(&unit__hot.state, unit_cur->state, __ATOMIC_RELAXED);
+        unit__hot.assertions = unit_cur->assertions;
+    }
+}
+
+void unit__echo(const char* msg) {
+    UNIT__EACH_PRINTER(ECHO, unit_cur, msg);
+}
+
+struct unit_run_options unit__opts;
+
+enum {
+    UNIT__REPORTER_CONSOLE = 0,
+    UNIT__REPORTER_XML = 1,
+    UNIT__REPORTER_JUNIT = 2,
+    UNIT__REPORTER_NDJSON = 3,
+    UNIT__REPORTERS_NUM = 4
+};
+
+static struct unit_printer unit__reporters[UNIT__REPORTERS_NUM];
+
+// opens reporters output, all selected reporters are fed from the single run
+static void unit__init_reporters(void) {
+    struct unit_printer* r = unit__reporters;
+    r[UNIT__REPORTER_CONSOLE].callback = unit__opts.trace ? printer_tracing : printer_def;
+    r[UNIT__REPORTER_CONSOLE].events = UNIT__EVENT(SETUP) | UNIT__EVENT(BEGIN) | UNIT__EVENT(END) | UNIT__EVENT(FAIL);
+    if (unit__opts.durations > 0) {
+        // prints the slowest tests and suites
+        r[UNIT__REPORTER_CONSOLE].events |= UNIT__EVENT(SHUTDOWN);
+    }
+    if (unit__opts.trace) {
+        // prints each assertion
+        r[UNIT__REPORTER_CONSOLE].events |= UNIT__EVENT(ECHO) | UNIT__EVENT(ASSERTION);
+    }
+    r[UNIT__REPORTER_XML].callback = printer_xml_doctest;
+    r[UNIT__REPORTER_XML].events = UNIT__EVENTS_ALL & ~(UNIT__EVENT(ECHO) | UNIT__EVENT(ASSERTION));
+    r[UNIT__REPORTER_JUNIT].callback = printer_junit;
+    r[UNIT__REPORTER_JUNIT].events = UNIT__EVENT(SETUP) | UNIT__EVENT(SHUTDOWN) | UNIT__EVENT(BEGIN) | UNIT__EVENT(END) |
+                                        UNIT__EVENT(FAIL);
+    r[UNIT__REPORTER_NDJSON].callback = printer_ndjson;
+    r[UNIT__REPORTER_NDJSON].events = UNIT__EVENTS_ALL & ~UNIT__EVENT(ASSERTION);
+
+    const int enabled[UNIT__REPORTERS_NUM] = {
+            unit__opts.console || !(unit__opts.doctest_xml || unit__opts.junit || unit__opts.ndjson),
+            unit__opts.doctest_xml,
+            unit__opts.junit,
+            unit__opts.ndjson
     };
-    static const char* ascii[] = {
-            "[ RUNS ]",
-            "[ PASS ]",
-            "[ SKIP ]",
-            "[ FAIL ]",
+    const char* paths[UNIT__REPORTERS_NUM] = {
+            unit__opts.console_out,
+            unit__opts.xml_out,
+            unit__opts.junit_out,
+            unit__opts.ndjson_out
     };
-    const int type = node->status;
-    const char* lbl = (unit__opts.ascii ? ascii : fancy)[type];
+    int to_stdout = 0;
+    for (int i = UNIT__REPORTERS_NUM - 1; i >= 0; --i) {
+        r[i].out = NULL;
+        if (!enabled[i]) {
+            continue;
+        }
+        if (paths[i] && paths[i][0]) {
+            r[i].out = fopen(paths[i], "w");
+            if (!r[i].out) {
+                fprintf(stderr, "unit: warning: unable to open report file `%s`\n", paths[i]);
+                continue;
+            }
+        } else if (unit__opts.quiet) {
+            continue;
+        } else {
+            r[i].out = stdout;
+            ++to_stdout;
+        }
+        r[i].next = unit__printers;
+        unit__printers = r + i;
+    }
+    if (to_stdout > 1) {
+        fputs("unit: warning: several reporters write to `stdout`, use `-r=name:FILE` to separate them\n", stderr);
+    }
+}
 
-    fputs(lbl, f);
-    fputc(' ', f);
-    begin_style(f, UNIT_COLOR_BOLD);
-    fputs(beautify_name(node->name), f);
-    end_style(f);
-    fputc(' ', f);
-    switch (node->status) {
-        case UNIT_STATUS_RUN:
-            break;
-        case UNIT_STATUS_SUCCESS:
-        case UNIT_STATUS_FAILED:
-            fprintf(f, ": passed %d/%d tests", node->passed, node->total);
-            print_elapsed_time(f, node->elapsed);
-            break;
-        default:
-            break;
+static void unit__close_reporters(void) {
+    for (int i = 0; i < UNIT__REPORTERS_NUM; ++i) {
+        if (unit__reporters[i].out && unit__reporters[i].out != stdout) {
+            fclose(unit__reporters[i].out);
+        }
+        unit__reporters[i].out = NULL;
+    }
+}
+
+// moves reporters to the reporter thread, see `async.c`
+static void unit__async_init(void);
+
+static void unit__init_printers(void) {
+    static struct unit_printer trace_events;
+    unit__printers = NULL;
+    unit__init_reporters();
+    if (unit__opts.async_report) {
+        unit__async_init();
+    }
+    if (unit__opts.durations > 0) {
+        static struct unit_printer durations;
+        durations.callback = printer_durations;
+        durations.events = UNIT__EVENT(SETUP) | UNIT__EVENT(END);
+        durations.next = unit__printers;
+        unit__printers = &durations;
+    }
+    if (unit__opts.trace_out && unit__opts.trace_out[0]) {
+        trace_events.callback = printer_trace_events;
+        trace_events.events = UNIT__EVENTS_ALL & ~UNIT__EVENT(ASSERTION);
+        trace_events.next = unit__printers;
+        unit__printers = &trace_events;
+    }
+    if (unit__opts.events_out && unit__opts.events_out[0]) {
+        static struct unit_printer events_log;
+        events_log.callback = printer_events_log;
+        events_log.events = UNIT__EVENTS_ALL & ~UNIT__EVENT(ASSERTION);
+        events_log.next = unit__printers;
+        unit__printers = &events_log;
+    }
+    if (unit__opts.profile || (unit__opts.profile_out && unit__opts.profile_out[0])) {
+        static struct unit_printer profile;
+        if (!unit__opts.profile_out || !unit__opts.profile_out[0]) {
+            unit__opts.profile_out = "unit.folded";
+        }
+        profile.callback = printer_profile;
+        profile.events = UNIT__EVENT(SETUP) | UNIT__EVENT(SHUTDOWN) | UNIT__EVENT(END);
+        profile.next = unit__printers;
+        unit__printers = &profile;
+    }
+    unit__events = 0;
+    for (struct unit_printer* p = unit__printers; p; p = p->next) {
+        unit__events |= p->events;
+    }
+}
+
+#define UNIT__MSG_VERSION "unit v" UNIT_VERSION "\n"
+#define UNIT__MSG_USAGE "usage: %s OPTIONS\n" \
+"options:\n" \
+"  --version or -v: Prints the version of `unit` library\n" \
+"  --help or -h: Prints usage help message\n" \
+"  --list or -l: Prints all available tests\n" \
+"  --ascii: Don't use colors and fancy unicode symbols in the output\n" \
+"  --quiet or -q: Disables all output\n" \
+"  --short-filenames or -S: Use only basename for displaying file-pos information\n" \
+"  -r=NAME[:FILE]: Select reporter, repeat to run several reporters at once, each writes to `stdout` or its own FILE\n" \
+"    -r=console: Human-readable report, the default one\n" \
+"    -r=xml: Special switch prints XML report in DocTest-friendly format (for CLion test run configuration)\n" \
+"    -r=junit: Print JUnit XML report\n" \
+"    -r=ndjson: Print newline-delimited JSON events report\n" \
+"  --animate or -a: Simulate waits for printing messages, just for making fancy printing animation\n" \
+"  --cpus=LIST: Pin the runner to CPU set, for example `--cpus=0,2-3`\n" \
+"  --trace-out=FILE: Write Chrome trace-event JSON timeline of the run (`chrome://tracing` or Perfetto)\n" \
+"  --events-out=FILE: Write compact binary events log, convert it to any report later with `unit-report` tool\n" \
+"  --profile[=FILE]: Sample call stacks of running tests to folded stacks file for flame graphs, `unit.folded` by default\n" \
+"  --durations=N: Print N slowest tests and N slowest suites after the run\n" \
+"  --seed=N: Seed random cases of `PROPERTY` tests, printed with the falsified property to reproduce it\n" \
+"  --filter=PATTERN: Run only tests which path `suite/describe/test` matches the glob PATTERN with `*` and `?`\n" \
+"  --resources: Report CPU time, memory, page faults and context switches for each test\n" \
+"  --clock=mono|tsc: Select time source for measurements, `mono` is default\n" \
+"  --strict-env: Refuse to run if environment is not suitable for benchmarking\n" \
+"  --env: Measure CPU frequency governor and timer jitter for the environment line\n" \
+"  --catch-crashes: Recover from crashing signals in tests, report the crash and continue with the next test\n" \
+"  --async-report: Run reporters in their own thread, so printing does not slow down the tests thread\n"
+
+static int unit__cmd(struct unit_run_options options) {
+    if (options.version) {
+        fputs(UNIT__MSG_VERSION, stdout);
+        return 0;
+    }
+    if (options.help) {
+        fprintf(stdout, UNIT__MSG_USAGE, options.program);
+        return 0;
+    }
+    if (options.list) {
+        for (struct unit_test* suite = unit_tests; suite; suite = suite->next) {
+            fputs(beautify_name(suite->name), stdout);
+            fputs("\n", stdout);
+        }
+        return 0;
     }
-    print_wait(f);
+    return 1;
 }
 
-void printer_def_begin(struct unit_test* unit) {
-    FILE* f = stdout;
-    if (!unit->parent) {
-        print_label(f, unit);
+int unit_main(struct unit_run_options options) {
+    if (!unit__cmd(options)) {
+        return 0;
     }
-}
 
-int def_depth = 0;
+    unit__opts = options;
+    srand(options.seed);
+    unit__clock_setup();
+    if (!unit__env_setup()) {
+        return EXIT_FAILURE;
+    }
+    unit__init_printers();
+    unit__output_setup();
 
-const char* unit__spaces(int delta) {
-    return get_spaces(def_depth + delta);
-}
+    UNIT__EACH_PRINTER(SETUP, 0, 0);
+    if (unit__opts.catch_crashes || unit__opts.async_report) {
+        // the reporter thread prints pending events before the crashing process is killed
+        unit__crash_install();
+    }
 
-static void print_node(struct unit_test* node) {
-    FILE* f = stdout;
-    ++def_depth;
-    const char* name = beautify_name(node->name);
-    fputs(unit__spaces(0), f);
-    if (node->type == UNIT__TYPE_CASE) {
-        if (node->status == UNIT_STATUS_SKIPPED) {
-            print_text(f, name, UNIT_COLOR_DIM);
-        } else {
-            print_text(f, name, NULL);
+    int failed = 0;
+    for (struct unit_test* suite = unit_tests; suite; suite = suite->next) {
+        UNIT_TRY_SCOPE(unit__begin(suite), unit__end(suite)) UNIT__CRASH_POINT(suite) suite->fn();
+        if (suite->status == UNIT_STATUS_FAILED) {
+            ++failed;
         }
-    } else {
-        fputs(icon(node->status), f);
-        print_text(f, name, UNIT_COLOR_DIM);
-    }
-    print_elapsed_time(f, node->elapsed);
-    fputc('\n', f);
-    print_wait(f);
-    for (struct unit_test* child = node->children; child; child = child->next) {
-        print_node(child);
     }
-    --def_depth;
+
+    unit__crash_uninstall();
+    UNIT__EACH_PRINTER(SHUTDOWN, 0, 0);
+    unit__close_reporters();
+    unit__output_flush(stdout);
+
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
-void printer_def_end(struct unit_test* unit) {
-    FILE* f = stdout;
-    if (unit->parent) {
-        if (unit->type == UNIT__TYPE_TEST) {
-            fputs(icon(unit->status), f);
-            print_wait(f);
+static void find_bool_arg(int argc, const char** argv, int* var, const char* name, const char* alias) {
+    for (int i = 0; i < argc; ++i) {
+        const char* v = argv[i];
+        if (v && v[0] == '-') {
+            ++v;
+            if (alias && alias[0] && strstr(v, alias) == v) {
+                *var = 1;
+                return;
+            } else if (name && name[0] && v[0] == '-') {
+                ++v;
+                if (strcmp(v, name) == 0) {
+                    *var = 1;
+                    return;
+                }
+            }
         }
-        return;
     }
-    // go back to the beginning of line
-    // fputc('\n', f);
-    // begin_style(f, "\033[1A\033[999D");
-    fputc('\r', f);
-    print_label(f, unit);
-    fputc('\n', f);
+}
 
-    if (unit__fails) {
-        for (struct unit_test* child = unit->children; child; child = child->next) {
-            print_node(child);
+static void find_str_arg(int argc, const char** argv, const char** var, const char* name) {
+    const size_t len = strlen(name);
+    for (int i = 0; i < argc; ++i) {
+        const char* v = argv[i];
+        if (v && v[0] == '-' && v[1] == '-' && strncmp(v + 2, name, len) == 0 && v[2 + len] == '=') {
+            *var = v + 3 + len;
+            return;
         }
-        fputc('\n', f);
-
-        const long pos = ftell(unit__fails);
-        unit__fails_mem[pos] = 0;
-        fclose(unit__fails);
-        unit__fails = 0;
-        fputs(unit__fails_mem, f);
+    }
+}
 
-        fputc('\n', f);
+static void find_int_arg(int argc, const char** argv, int* var, const char* name) {
+    const char* value = NULL;
+    find_str_arg(argc, argv, &value, name);
+    if (value) {
+        *var = atoi(value);
     }
 }
 
-static void unit__breadcrumbs(FILE* f, struct unit_test* test) {
-    if (test->parent) {
-        unit__breadcrumbs(f, test->parent);
-        print_text(f, unit__opts.ascii ? " > " : " → ", UNIT_COLOR_BOLD UNIT_COLOR_DIM);
+static void find_uint_arg(int argc, const char** argv, unsigned* var, const char* name) {
+    const char* value = NULL;
+    find_str_arg(argc, argv, &value, name);
+    if (value) {
+        *var = (unsigned) strtoul(value, NULL, 10);
     }
-    print_text(f, beautify_name(test->name), UNIT_COLOR_BOLD UNIT_COLOR_FAIL);
 }
 
-void printer_def_fail(struct unit_test* unit, const char* msg) {
-    if (unit__fails == 0) {
-        // TODO: change to `tmpfile` ?
-        unit__fails = fmemopen(unit__fails_mem, sizeof unit__fails_mem, "w");
+static bool match_reporter(const char* name, size_t len, const char* reporter, int* var) {
+    if (len == strlen(reporter) && strncmp(name, reporter, len) == 0) {
+        *var = 1;
+        return true;
     }
-    FILE* f = unit__fails;
-    fputs(unit_spaces[1], f);
-    fputs(icon(ICON_ASSERT), f);
-    unit__breadcrumbs(f, unit_cur);
-    fputc('\n', f);
-    fputc('\n', f);
-
-    fputs(unit_spaces[2], f);
-    fputs(msg, f);
-    fputc('\n', f);
-    if (unit->assert_file) {
-        fputs(unit_spaces[2], f);
-        print_text(f, "@ ", UNIT_COLOR_COMMENT UNIT_COLOR_DIM UNIT_COLOR_BOLD);
-        begin_style(f, UNIT_COLOR_COMMENT UNIT_COLOR_UNDERLINE);
-        fprintf(f, "%s:%d", beautify_filename(unit->assert_file), unit->assert_line);
-        end_style(f);
-        fputc('\n', f);
+    return false;
+}
+
+// parses all `-r=name[:FILE]` options
+static void find_reporter_args(int argc, const char** argv, struct unit_run_options* out_options) {
+    for (int i = 0; i < argc; ++i) {
+        const char* v = argv[i];
+        if (!v || strncmp(v, "-r=", 3) != 0) {
+            continue;
+        }
+        const char* name = v + 3;
+        const char* path = strchr(name, ':');
+        const size_t len = path ? (size_t) (path - name) : strlen(name);
+        if (path) {
+            ++path;
+        }
+        if (match_reporter(name, len, "console", &out_options->console)) {
+            out_options->console_out = path;
+        } else if (match_reporter(name, len, "xml", &out_options->doctest_xml)) {
+            // hack to trick CLion we are DocTest library tests
+            out_options->xml_out = path;
+        } else if (match_reporter(name, len, "junit", &out_options->junit)) {
+            out_options->junit_out = path;
+        } else if (match_reporter(name, len, "ndjson", &out_options->ndjson)) {
+            out_options->ndjson_out = path;
+        } else {
+            fprintf(stderr, "unit: warning: unknown reporter `%s`\n", name);
+        }
     }
-    fputc('\n', f);
 }
 
-// endregion reporting
+static void unit__parse_args(int argc, const char** argv, struct unit_run_options* out_options) {
+    find_bool_arg(argc, argv, &out_options->version, "version", "v");
+    find_bool_arg(argc, argv, &out_options->help, "help", "h");
+    find_bool_arg(argc, argv, &out_options->list, "list", "l");
+    find_bool_arg(argc, argv, &out_options->ascii, "ascii", NULL);
+    find_bool_arg(argc, argv, &out_options->trace, "trace", "t");
+    find_bool_arg(argc, argv, &out_options->quiet, "quiet", "q");
+    find_bool_arg(argc, argv, &out_options->animate, "animate", "a");
+    find_bool_arg(argc, argv, &out_options->short_filenames, "short-filenames", "S");
+    find_bool_arg(argc, argv, &out_options->strict_env, "strict-env", NULL);
+    find_bool_arg(argc, argv, &out_options->env, "env", NULL);
+    find_bool_arg(argc, argv, &out_options->resources, "resources", NULL);
+    find_bool_arg(argc, argv, &out_options->catch_crashes, "catch-crashes", NULL);
+    find_bool_arg(argc, argv, &out_options->async_report, "async-report", NULL);
+    find_str_arg(argc, argv, &out_options->cpus, "cpus");
+    find_str_arg(argc, argv, &out_options->clock, "clock");
+    find_str_arg(argc, argv, &out_options->trace_out, "trace-out");
+    find_str_arg(argc, argv, &out_options->events_out, "events-out");
+    find_int_arg(argc, argv, &out_options->durations, "durations");
+    find_str_arg(argc, argv, &out_options->filter, "filter");
+    find_uint_arg(argc, argv, &out_options->seed, "seed");
+    find_bool_arg(argc, argv, &out_options->profile, "profile", NULL);
+    find_str_arg(argc, argv, &out_options->profile_out, "profile");
+    find_reporter_args(argc, argv, out_options);
+}
 
-static void printer_def(int cmd, struct unit_test* unit, const char* msg) {
-    switch (cmd) {
-        case UNIT__PRINTER_SETUP:
-            fputs(unit__opts.ascii ? "\n[ unit ] v" UNIT_VERSION "\n\n" :
-                  "\n\033[1;30;42m" " ✓ηỉτ " "\033[0;30;46m" " v" UNIT_VERSION " " "\33[m\n\n", stdout);
-            print_wait(stdout);
-            break;
-        case UNIT__PRINTER_BEGIN:
-            printer_def_begin(unit);
-            break;
-        case UNIT__PRINTER_END:
-            printer_def_end(unit);
-            break;
-        case UNIT__PRINTER_FAIL:
-            printer_def_fail(unit, msg);
-            break;
-            //case UNIT__PRINTER_ASSERTION:
-            //    fputs(icon(unit->assert_status), stdout);
-            //    print_wait(stdout);
-            //    break;
-    }
+static void unit__setup_args(int argc, const char** argv, struct unit_run_options* out_options) {
+    *out_options = (struct unit_run_options) {0};
+    out_options->seed = (unsigned) time(NULL);
+    out_options->program = argc > 0 ? short_filename(argv[0]) : "<unit>";
+#ifdef UNIT_DEFAULT_ARGS
+    static const char* cargv[] = { UNIT_DEFAULT_ARGS };
+    static const int cargc = sizeof(cargv) / sizeof(cargv[0]);
+    unit__parse_args(cargc, cargv, out_options);
+#endif
+    unit__parse_args(argc, argv, out_options);
 }
 
-// region tracing printer
-static int trace_depth = 0;
+// endregion
+// region построение отчёта из журнала событий: запуск существующих принтеров без запуска тестов, из файла или в потоке отчётов
+
+struct unit__log_reader {
+    // reads exactly `size` bytes, returns false at the end of the log
+    bool (* read)(struct unit__log_reader* reader, void* data, size_t size);
+    FILE* file;
+    // printers notified by the replay
+    struct unit_printer* printers;
+    char** strings;
+    uint32_t strings_num;
+    // the last transient string, it is overwritten by the next one
+    char* transient;
+    size_t transient_cap;
+    struct unit_test** nodes;
+    uint32_t nodes_num;
+    // declared root nodes and the node being replayed
+    struct unit_test* roots;
+    struct unit_test* roots_last;
+    struct unit_test* cur;
+    // failures of the current test, they are valid until the next test begins like the failures pool
+    struct unit__fail_record fails[UNIT_FAIL_RECORDS];
+    struct unit__assert_site sites[UNIT_FAIL_RECORDS];
+    int fails_num;
+    char fails_text[UNIT_FAIL_TEXT];
+    size_t fails_text_len;
+    int failed;
+};
 
-static const char* trace_spaces(int delta) {
-    return get_spaces(trace_depth + delta);
+static bool unit__log_read_file(struct unit__log_reader* reader, void* data, size_t size) {
+    return fread(data, 1, size, reader->file) == size;
 }
 
-static void printer_tracing(int cmd, struct unit_test* unit, const char* msg) {
-    FILE* f = stdout;
-    switch (cmd) {
-        case UNIT__PRINTER_BEGIN:
-            fputs(trace_spaces(0), f);
-            print_text(f, beautify_name(unit->name), UNIT_COLOR_BOLD);
-            print_text(f, " {\n", UNIT_COLOR_DIM);
-            ++trace_depth;
-            break;
-        case UNIT__PRINTER_END:
-            --trace_depth;
-            fputs(trace_spaces(0), f);
-            print_text(f, "}\n", UNIT_COLOR_DIM);
-            break;
-        case UNIT__PRINTER_ECHO:
-            fputs(trace_spaces(0), f);
-            fputs(icon(ICON_MSG), f);
-            print_text(f, msg, UNIT_COLOR_COMMENT);
-            fputc('\n', f);
-            break;
-        case UNIT__PRINTER_FAIL:
-            fputs(trace_spaces(0), f);
-            fputs("    Failed: ", f);
-            fputs(beautify_name(unit->name), f);
-            fputc('\n', f);
+static bool unit__log_reserve(void** items, uint32_t num, size_t item_size) {
+    // ids are sequential, so the array grows when id reaches the power of two
+    if (num & (num - 1)) {
+        return true;
+    }
+    void* grown = realloc(*items, 2 * (num ? num : 1) * item_size);
+    if (!grown) {
+        return false;
+    }
+    *items = grown;
+    return true;
+}
 
-            fputs(trace_spaces(0), f);
-            fputs("    ", f);
-            fputs(msg, f);
-            fputc('\n', f);
-            break;
-        case UNIT__PRINTER_ASSERTION: {
-            fputs(trace_spaces(0), f);
-            fputs(icon(unit->assert_status), f);
+static const char* unit__log_get_string(struct unit__log_reader* reader, uint32_t id) {
+    if (id == UNIT__LOG_TRANSIENT) {
+        return reader->transient;
+    }
+    return id && id <= reader->strings_num ? reader->strings[id - 1] : NULL;
+}
 
-            const char* cm = unit->assert_comment;
-            const char* desc = (cm && cm[0] != '\0') ? cm : unit->assert_desc;
-            fputs(desc, f);
+static struct unit_test* unit__log_get_node(struct unit__log_reader* reader, uint32_t id) {
+    return id && id <= reader->nodes_num ? reader->nodes[id - 1] : NULL;
+}
 
-            fputc('\n', f);
+static bool unit__log_read_string(struct unit__log_reader* reader, const struct unit__log_record* r) {
+    const size_t size = (r->string.len + sizeof *r) / sizeof *r * sizeof *r;
+    if (r->status) {
+        if (size > reader->transient_cap) {
+            char* grown = (char*) realloc(reader->transient, size);
+            if (!grown) {
+                return false;
+            }
+            reader->transient = grown;
+            reader->transient_cap = size;
         }
-            break;
+        if (!reader->read(reader, reader->transient, size)) {
+            return false;
+        }
+        reader->transient[r->string.len] = 0;
+        return true;
+    }
+    char* str = (char*) malloc(size);
+    if (!str || !reader->read(reader, str, size) ||
+        !unit__log_reserve((void**) &reader->strings, reader->strings_num, sizeof *reader->strings)) {
+        free(str);
+        return false;
     }
+    str[r->string.len] = 0;
+    reader->strings[reader->strings_num++] = str;
+    return true;
 }
 
-// endregion
+static bool unit__log_read_node(struct unit__log_reader* reader, const struct unit__log_record* r) {
+    struct unit_test* node = (struct unit_test*) calloc(1, sizeof *node);
+    if (!node || !unit__log_reserve((void**) &reader->nodes, reader->nodes_num, sizeof *reader->nodes)) {
+        free(node);
+        return false;
+    }
+    node->type = r->status;
+    node->name = unit__log_get_string(reader, r->node.name);
+    node->file = unit__log_get_string(reader, r->node.file);
+    node->line = r->node.line;
+    struct unit_test* parent = unit__log_get_node(reader, r->node.parent);
+    if (parent) {
+        add_child(parent, node);
+    } else if (reader->roots_last) {
+        reader->roots_last->next = node;
+        reader->roots_last = node;
+    } else {
+        reader->roots = reader->roots_last = node;
+    }
+    reader->nodes[reader->nodes_num++] = node;
+    return true;
+}
 
-static const char* doctest_get_node_type(struct unit_test* node) {
-    if (node->parent) {
-        if (node->parent->parent) {
-            return "SubCase";
-        }
-        return "TestCase";
+static void unit__log_replay_setup(struct unit__log_reader* reader, const struct unit__log_record* r) {
+    const char* clock = unit__log_get_string(reader, r->setup.clock);
+    const char* governor = unit__log_get_string(reader, r->setup.governor);
+    const char* cpus = unit__log_get_string(reader, r->setup.cpus);
+    // environment of the recorded run is printed instead of the current one
+    unit__clock.name = clock ? clock : "unknown";
+    unit__clock.overhead = r->setup.overhead;
+    snprintf(unit__env.governor, sizeof unit__env.governor, "%s", governor ? governor : "unknown");
+    snprintf(unit__env.cpus, sizeof unit__env.cpus, "%s", cpus ? cpus : "");
+    unit__env.cpus_count = r->setup.cpus_count;
+    unit__env.calibration = r->setup.calibration;
+    unit__env.jitter = r->setup.jitter;
+    UNIT__EACH_PRINTER_IN(reader->printers, SETUP, 0, 0);
+}
+
+static void unit__log_replay_assert(struct unit__log_reader* reader, struct unit_test* node,
+                                    const struct unit__log_record* r) {
+    node->assert_site = NULL;
+    node->assert_level = r->fail.level;
+    node->assert_file = unit__log_get_string(reader, r->fail.file);
+    node->assert_line = r->fail.line;
+    node->assert_desc = unit__log_get_string(reader, r->fail.desc);
+    node->assert_comment = unit__log_get_string(reader, r->fail.comment);
+    node->assert_status = r->status;
+}
+
+// copies the transient text to the per-test arena, truncates it if the arena is full
+static const char* unit__log_keep_text(struct unit__log_reader* reader, const char* str) {
+    const size_t available = sizeof reader->fails_text - reader->fails_text_len;
+    if (!str || !available) {
+        return "";
     }
-    return "TestSuite";
+    size_t len = strlen(str);
+    if (len >= available) {
+        len = available - 1;
+    }
+    char* copy = reader->fails_text + reader->fails_text_len;
+    memcpy(copy, str, len);
+    copy[len] = 0;
+    reader->fails_text_len += len + 1;
+    return copy;
 }
 
-static void printer_xml_doctest(int cmd, struct unit_test* node, const char* msg) {
-    FILE* f = stdout;
-    switch (cmd) {
-        case UNIT__PRINTER_SETUP:
-            fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
-            // binary="/absolute/path/to/test/executable"
-            fprintf(f, "<unit version=\"" UNIT_VERSION "\">\n");
-            fprintf(f,
-                    "  <Options order_by=\"file\" rand_seed=\"0\" first=\"0\" last=\"4294967295\" abort_after=\"0\" subcase_filter_levels=\"2147483647\" case_sensitive=\"false\" no_throw=\"false\" no_skip=\"false\"/>\n");
-            ++def_depth;
+static void unit__log_replay_fail(struct unit__log_reader* reader, struct unit_test* node,
+                                  const struct unit__log_record* r) {
+    const int i = reader->fails_num < UNIT_FAIL_RECORDS ? reader->fails_num++ : UNIT_FAIL_RECORDS - 1;
+    struct unit__fail_record* record = reader->fails + i;
+    struct unit__assert_site* site = reader->sites + i;
+    unit__log_replay_assert(reader, node, r);
+    site->level = node->assert_level;
+    site->file = node->assert_file;
+    site->line = node->assert_line;
+    site->desc = node->assert_desc;
+    site->comment = node->assert_comment;
+    memset(record, 0, sizeof *record);
+    record->kind = UNIT__FAIL_TEXT;
+    record->site = site;
+    record->text = unit__log_keep_text(reader, r->fail.text ? unit__log_get_string(reader, r->fail.text) : site->desc);
+    node->assert_site = site;
+    node->fail_record = record;
+    UNIT__EACH_PRINTER_IN(reader->printers, FAIL, node, NULL);
+}
+
+static void unit__log_replay(struct unit__log_reader* reader, const struct unit__log_record* r) {
+    if (r->kind == UNIT__LOG_SETUP) {
+        unit__log_replay_setup(reader, r);
+        return;
+    }
+    struct unit_test* node = unit__log_get_node(reader, r->id);
+    if (!node) {
+        return;
+    }
+    switch (r->kind) {
+        case UNIT__LOG_BEGIN:
+            node->status = r->status;
+            node->state = 0;
+            node->assertions = 0;
+            node->passed = 0;
+            node->total = 0;
+            node->assert_desc = NULL;
+            node->assert_site = NULL;
+            node->fail_record = NULL;
+            if (node->type == UNIT__TYPE_TEST) {
+                reader->fails_num = 0;
+                reader->fails_text_len = 0;
+            }
+            reader->cur = node;
+            UNIT__EACH_PRINTER_IN(reader->printers, BEGIN, node, 0);
             break;
-        case UNIT__PRINTER_SHUTDOWN: {
-            int total = 0;
-            int passed = 0;
-            for (struct unit_test* u = unit_tests; u; u = u->next) {
-                passed += u->passed;
-                total += u->total;
+        case UNIT__LOG_RESOURCES:
+            node->res = r->resources;
+            break;
+        case UNIT__LOG_END:
+            node->status = r->status;
+            node->passed = r->end.passed;
+            node->total = r->end.total;
+            node->elapsed = r->end.elapsed;
+            node->cpu_elapsed = r->end.cpu_elapsed;
+            node->fixtures_elapsed = r->end.fixtures_elapsed;
+            node->assertions = r->end.assertions;
+            node->scratch_peak = (size_t) r->end.scratch_peak;
+            UNIT__EACH_PRINTER_IN(reader->printers, END, node, 0);
+            reader->cur = node->parent;
+            if (!node->parent && node->status == UNIT_STATUS_FAILED) {
+                ++reader->failed;
             }
-            fprintf(f, "  <OverallResultsTestCases successes=\"%d\" failures=\"%d\" expectedFailures=\"%d\" />\n",
-                    passed, total - passed, 0);
-        }
-            --def_depth;
-            fprintf(f, "</unit>\n");
-            fflush(f);
             break;
-        case UNIT__PRINTER_BEGIN:
-            fputs(unit__spaces(0), f);
-            fprintf(f, "<%s name=\"%s\" filename=\"%s\" line=\"%d\" skipped=\"%s\">\n", doctest_get_node_type(node),
-                    node->name, node->file,
-                    node->line, node->status == UNIT_STATUS_SKIPPED ? "true" : "false");
-            ++def_depth;
+        case UNIT__LOG_ECHO:
+            UNIT__EACH_PRINTER_IN(reader->printers, ECHO, node, unit__log_get_string(reader, r->echo.text));
             break;
-        case UNIT__PRINTER_END:
-            --def_depth;
-            fputs(unit__spaces(0), f);
-            fprintf(f, "</%s>\n", doctest_get_node_type(node));
+        case UNIT__LOG_ASSERTION:
+            unit__log_replay_assert(reader, node, r);
+            UNIT__EACH_PRINTER_IN(reader->printers, ASSERTION, node, 0);
             break;
-        case UNIT__PRINTER_FAIL:
-            fputs(unit__spaces(0), f);
-            fprintf(f, "<Expression success=\"%s\" type=\"%s\" filename=\"%s\" line=\"%d\">\n",
-                    node->status != UNIT_STATUS_FAILED ? "true" : "false", "REQUIRE",
-                    beautify_filename(node->assert_file), node->assert_line);
-            fputs(unit__spaces(1), f);
-            fprintf(f, "<Original>\n");
-            fputs(unit__spaces(1), f);
-            fprintf(f, "%s\n", node->assert_desc);
-            fputs(unit__spaces(1), f);
-            fprintf(f, "</Original>\n");
-            fputs(unit__spaces(1), f);
-            fprintf(f, "<Expanded>\n");
-            fputs(unit__spaces(1), f);
-            fprintf(f, "%s\n", node->assert_desc);
-            fputs(unit__spaces(1), f);
-            fprintf(f, "</Expanded>\n");
-            fputs(unit__spaces(0), f);
-            fprintf(f, "</Expression>\n");
+        case UNIT__LOG_FAIL:
+            unit__log_replay_fail(reader, node, r);
             break;
     }
 }
 
-
-struct unit_test* unit_tests = NULL;
-struct unit_test* unit_cur = NULL;
-
-// region утилиты для вывода
-const char* unit__vbprintf(const char* fmt, va_list args) {
-    static char s_buffer[4096];
-    vsnprintf(s_buffer, sizeof s_buffer, fmt, args);
-    return s_buffer;
+// replays records until the end of the log, returns false if the log is broken
+static bool unit__log_replay_all(struct unit__log_reader* reader) {
+    struct unit__log_record r;
+    bool valid = true;
+    // the file of crashed run is not truncated, zeroed tail reads as the header record
+    while (valid && reader->read(reader, &r, sizeof r) && r.kind != UNIT__LOG_HEADER) {
+        if (r.kind == UNIT__LOG_STRING) {
+            valid = unit__log_read_string(reader, &r);
+        } else if (r.kind == UNIT__LOG_NODE) {
+            valid = unit__log_read_node(reader, &r);
+        } else {
+            unit__log_replay(reader, &r);
+        }
+    }
+    return valid;
 }
 
-// endregion
-
-const char* unit__op_expl[] = {
-        " is true",
-        " is false",
-        " == ",
-        " != ",
-        " >= ",
-        " > ",
-        " <= ",
-        " < ",
-};
-
-const char* unit__op_nexpl[] = {
-        " is not true",
-        " is not false",
-        " != ",
-        " == ",
-        " < ",
-        " <= ",
-        " > ",
-        " >= ",
-};
-
-struct unit_printer* unit__printers;
-
-#define UNIT__EACH_PRINTER(Func, ...) \
-for(struct unit_printer* p = unit__printers; p; p = p->next) { p->callback(UNIT__PRINTER_ ## Func, __VA_ARGS__); }
-
-bool unit__prepare_assert(int level, const char* file, int line, const char* comment, const char* desc) {
-    unit_cur->assert_comment = comment;
-    unit_cur->assert_desc = desc;
-    unit_cur->assert_level = level;
-    unit_cur->assert_file = file;
-    unit_cur->assert_line = line;
-    if (unit_cur->state & UNIT__LEVEL_REQUIRE) {
-        // пропустить проверку
-        unit_cur->assert_status = UNIT_STATUS_SKIPPED;
-        UNIT__EACH_PRINTER(ASSERTION, unit_cur, 0);
-        return false;
+static void unit__log_reader_free(struct unit__log_reader* reader) {
+    for (uint32_t i = 0; i < reader->strings_num; ++i) {
+        free(reader->strings[i]);
     }
-    unit_cur->assert_status = UNIT_STATUS_SUCCESS;
-    return true;
+    for (uint32_t i = 0; i < reader->nodes_num; ++i) {
+        free(reader->nodes[i]);
+    }
+    free(reader->strings);
+    free(reader->nodes);
+    free(reader->transient);
 }
 
-static void unit__fail_impl(const char* fmt, ...) {
-    va_list args;
-    va_start(args, fmt);
-    const char* msg = unit__vbprintf(fmt, args);
-    va_end(args);
-
-    if (unit_cur->assert_level > UNIT__LEVEL_WARN) {
-        unit_cur->assert_status = UNIT_STATUS_FAILED;
-        unit_cur->state |= unit_cur->assert_level;
-        for (struct unit_test* n = unit_cur; n; n = n->parent) {
-            if (n->options.failing) {
-                break;
-            }
-            n->status = UNIT_STATUS_FAILED;
-        }
+int unit_report(const char* path, struct unit_run_options options) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "unit: error: unable to open events log `%s`\n", path);
+        return EXIT_FAILURE;
+    }
+    struct unit__log_record r;
+    if (fread(&r, sizeof r, 1, file) != 1 || r.kind != UNIT__LOG_HEADER ||
+        memcmp(r.header.magic, UNIT__LOG_MAGIC, sizeof r.header.magic) != 0 ||
+        r.header.version != UNIT__LOG_VERSION || r.header.record_size != sizeof r) {
+        fprintf(stderr, "unit: error: `%s` is not an events log of unit v" UNIT_VERSION "\n", path);
+        fclose(file);
+        return EXIT_FAILURE;
     }
-    UNIT__EACH_PRINTER(FAIL, unit_cur, msg);
-}
 
-#define UNIT__IMPLEMENT_ASSERT(Tag, Type, FormatType, BinaryOp, UnaryOp) \
-void unit__assert_ ## Tag(Type a, Type b, int op, const char* expr, const char* sa, const char* sb) { \
-    bool pass = false; \
-    switch(op) {                                                       \
-        case UNIT__OP_TRUE: pass = (UnaryOp(a, b)); break; \
-        case UNIT__OP_FALSE: pass = !(UnaryOp(a, b)); break; \
-        case UNIT__OP_EQ: pass = (BinaryOp(a, b)) == 0; break; \
-        case UNIT__OP_NE: pass = (BinaryOp(a, b)) != 0; break; \
-        case UNIT__OP_LT: pass = (BinaryOp(a, b)) < 0; break; \
-        case UNIT__OP_LE: pass = (BinaryOp(a, b)) <= 0; break; \
-        case UNIT__OP_GT: pass = (BinaryOp(a, b)) > 0; break; \
-        case UNIT__OP_GE: pass = (BinaryOp(a, b)) >= 0; break; \
-    } \
-    unit_cur->assert_status = pass ? UNIT_STATUS_SUCCESS : UNIT_STATUS_FAILED; \
-    UNIT__EACH_PRINTER(ASSERTION, unit_cur, 0); \
-    if (!pass) { \
-        const char* expl = unit__op_expl[op];                 \
-        const char* nexpl = unit__op_nexpl[op];                 \
-        if (op < UNIT__OP_EQ) unit__fail_impl("Expected " UNIT_COLOR_SUCCESS "`%s`%s" UNIT_COLOR_RESET ", but got `" UNIT_COLOR_FAIL #FormatType "%s`" UNIT_COLOR_RESET, sb, expl, b, nexpl); \
-        else unit__fail_impl("Expected " UNIT_COLOR_SUCCESS "`%s`%s`%s`" UNIT_COLOR_RESET ", but got " UNIT_COLOR_FAIL "`" #FormatType "%s" #FormatType "`" UNIT_COLOR_RESET, sa, expl, sb, a, nexpl, b); \
-    } \
+    // the report is printed by the same printers, but nothing is run or sampled
+    options.events_out = NULL;
+    options.profile = 0;
+    options.profile_out = NULL;
+    options.async_report = 0;
+    options.resources = options.resources || r.header.resources;
+    unit__opts = options;
+    unit__init_printers();
+    unit__output_setup();
+
+    static struct unit__log_reader reader;
+    memset(&reader, 0, sizeof reader);
+    reader.read = unit__log_read_file;
+    reader.file = file;
+    reader.printers = unit__printers;
+    const struct unit_clock clock = unit__clock;
+    const struct unit_env env = unit__env;
+
+    const bool valid = unit__log_replay_all(&reader);
+    if (reader.cur || !valid) {
+        fprintf(stderr, "unit: warning: events log `%s` is incomplete\n", path);
+        ++reader.failed;
+    }
+    // close nodes interrupted by the crash
+    while (reader.cur) {
+        struct unit_test* node = reader.cur;
+        node->status = UNIT_STATUS_FAILED;
+        UNIT__EACH_PRINTER_IN(reader.printers, END, node, 0);
+        reader.cur = node->parent;
+    }
+    // declared root nodes replace the list of registered suites for the summary
+    struct unit_test* const tests = unit_tests;
+    unit_tests = reader.roots;
+    UNIT__EACH_PRINTER(SHUTDOWN, 0, 0);
+    unit__close_reporters();
+    fflush(stdout);
+    unit_tests = tests;
+
+    fclose(file);
+    unit__log_reader_free(&reader);
+    unit__clock = clock;
+    unit__env = env;
+    return reader.failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
-UNIT__FOR_ASSERTS(UNIT__IMPLEMENT_ASSERT)
+// endregion
 
-/** Время **/
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
 
-double unit__time(double prev) {
-    struct timespec ts = {0};
-#ifndef UNIT_NO_TIME
-#ifdef _WIN32
-    timespec_get(&ts, TIME_UTC);
-#else // _WIN32
-    clock_gettime(CLOCK_REALTIME, &ts);
-#endif // !_WIN32
-#endif // !UNIT_NO_TIME
-    return (double) ts.tv_sec + (double) ts.tv_nsec / 1000000000.0 - prev;
-}
+#include <pthread.h>
+#include <sched.h>
 
-// region начало конец запуска каждого теста
+#define UNIT__HAS_ASYNC_REPORT 1
+
+#endif // unix && !__EMSCRIPTEN__
+
+// region поток отчётов: `--async-report`, принтеры получают записи журнала событий через кольцевой буфер
+
+#ifndef UNIT_ASYNC_RING
+// capacity of the events ring in bytes, must be the power of two
+#define UNIT_ASYNC_RING (1024 * 1024)
+#endif
+
+#ifndef UNIT_ASYNC_DRAIN_MS
+// how long the crashing process waits for the reporter thread to print pending events
+#define UNIT_ASYNC_DRAIN_MS 1000
+#endif
 
-static struct unit_test* get_last_child(struct unit_test* children) {
-    while (children && children->next) {
-        children = children->next;
+#ifdef UNIT__HAS_ASYNC_REPORT
+
+// reporters selected by `-r`, they are notified only by the reporter thread between `SETUP` and `SHUTDOWN`
+static struct unit_printer* unit__async_printers = NULL;
+static struct unit_printer unit__async_printer;
+
+// the single producer is the tests thread, the single consumer is the reporter thread
+struct unit__async_ring {
+    unsigned char data[UNIT_ASYNC_RING];
+    // positions grow monotonically, the offset in the buffer is the position modulo capacity
+    uint64_t head __attribute__((aligned(64)));
+    uint64_t tail __attribute__((aligned(64)));
+    // set by the producer after the last event
+    int closed;
+    // flush request counter of the crash handler and the last request served by the consumer
+    int flush;
+    int flushed;
+};
+
+static struct unit__async_ring unit__async_ring;
+static struct unit__log_writer unit__async_writer;
+static struct unit__log_reader unit__async_reader;
+static pthread_t unit__async_thread;
+static bool unit__async_running = false;
+static __thread bool unit__async_is_reporter = false;
+
+// yields while the other side is expected soon, then sleeps to not burn the core
+static void unit__async_wait(unsigned* spins) {
+    if (++*spins < 64) {
+        sched_yield();
+    } else {
+        const struct timespec pause = {0, 100000};
+        nanosleep(&pause, NULL);
     }
-    return children;
 }
 
-static void add_child(struct unit_test* parent, struct unit_test* child) {
-    //assert (!child->parent);
-    if (parent) {
-        struct unit_test* last = get_last_child(parent->children);
-        if (last) {
-            last->next = child;
-        } else {
-            child->next = parent->children;
-            parent->children = child;
+static void unit__async_write(struct unit__log_writer* writer, const void* data, size_t size) {
+    (void) writer;
+    struct unit__async_ring* ring = &unit__async_ring;
+    const unsigned char* src = (const unsigned char*) data;
+    unsigned spins = 0;
+    while (size) {
+        const uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+        const uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        size_t n = UNIT_ASYNC_RING - (size_t) (head - tail);
+        if (!n) {
+            // back-pressure: the tests thread waits for the reporter thread instead of dropping events
+            unit__async_wait(&spins);
+            continue;
         }
+        const size_t offset = (size_t) head & (UNIT_ASYNC_RING - 1);
+        if (n > UNIT_ASYNC_RING - offset) {
+            n = UNIT_ASYNC_RING - offset;
+        }
+        if (n > size) {
+            n = size;
+        }
+        memcpy(ring->data + offset, src, n);
+        __atomic_store_n(&ring->head, head + n, __ATOMIC_RELEASE);
+        src += n;
+        size -= n;
+        spins = 0;
     }
-    child->parent = parent;
 }
 
-int unit__begin(struct unit_test* unit) {
-    const bool run = !unit->options.skip;
-    unit->state = 0;
-    unit->status = run ? UNIT_STATUS_RUN : UNIT_STATUS_SKIPPED;
-    unit->assert_desc = NULL;
-    unit->passed = 0;
-    unit->total = 0;
-    if (!unit->parent) {
-        add_child(unit_cur, unit);
-    }
-    unit_cur = unit;
-    if (run && unit->type == UNIT__TYPE_TEST) {
-        for (struct unit_test* u = unit_cur; u; u = u->parent) {
-            u->total++;
+static void unit__async_flush(struct unit__log_reader* reader) {
+    const int flush = __atomic_load_n(&unit__async_ring.flush, __ATOMIC_ACQUIRE);
+    if (flush != unit__async_ring.flushed) {
+        for (struct unit_printer* p = reader->printers; p; p = p->next) {
+            if (p->out) {
+                fflush(p->out);
+            }
         }
+        __atomic_store_n(&unit__async_ring.flushed, flush, __ATOMIC_RELEASE);
     }
-    UNIT__EACH_PRINTER(BEGIN, unit, 0);
-    unit->t0 = unit__time(0.0);
-    return run;
 }
 
-void unit__end(struct unit_test* unit) {
-    unit->elapsed = unit__time(unit->t0);
-    if (unit->status == UNIT_STATUS_RUN) {
-        unit->status = UNIT_STATUS_SUCCESS;
-        if (unit->type == UNIT__TYPE_TEST) {
-            for (struct unit_test* u = unit_cur; u; u = u->parent) {
-                u->passed++;
+static bool unit__async_read(struct unit__log_reader* reader, void* data, size_t size) {
+    struct unit__async_ring* ring = &unit__async_ring;
+    unsigned char* dst = (unsigned char*) data;
+    unsigned spins = 0;
+    while (size) {
+        const uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+        const uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            if (__atomic_load_n(&ring->closed, __ATOMIC_ACQUIRE) &&
+                __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail) {
+                return false;
             }
+            unit__async_flush(reader);
+            unit__async_wait(&spins);
+            continue;
+        }
+        const size_t offset = (size_t) tail & (UNIT_ASYNC_RING - 1);
+        size_t n = (size_t) (head - tail);
+        if (n > UNIT_ASYNC_RING - offset) {
+            n = UNIT_ASYNC_RING - offset;
         }
+        if (n > size) {
+            n = size;
+        }
+        memcpy(dst, ring->data + offset, n);
+        __atomic_store_n(&ring->tail, tail + n, __ATOMIC_RELEASE);
+        dst += n;
+        size -= n;
+        spins = 0;
     }
-    UNIT__EACH_PRINTER(END, unit, 0);
-    unit_cur = unit->parent;
+    return true;
 }
 
-void unit__echo(const char* msg) {
-    UNIT__EACH_PRINTER(ECHO, unit_cur, msg);
+static void* unit__async_main(void* arg) {
+    (void) arg;
+    // the profiler and other signals are for the tests thread, crashes are still handled here
+    sigset_t mask;
+    sigfillset(&mask);
+    for (int i = 0; i < UNIT__CRASH_SIGNALS_NUM; ++i) {
+        sigdelset(&mask, unit__crash_signals[i]);
+    }
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+    unit__async_is_reporter = true;
+    unit__log_replay_all(&unit__async_reader);
+    return NULL;
 }
 
-struct unit_run_options unit__opts;
-
-static void unit__init_printers(void) {
-    static struct unit_printer printer;
-    printer.callback = unit__opts.trace ? printer_tracing : printer_def;
-    if (unit__opts.doctest_xml) {
-        printer.callback = printer_xml_doctest;
+static void unit__async_start(void) {
+    memset(&unit__async_ring, 0, sizeof unit__async_ring);
+    memset(&unit__async_reader, 0, sizeof unit__async_reader);
+    unit__async_reader.read = unit__async_read;
+    unit__async_reader.printers = unit__async_printers;
+    unit__async_writer.write = unit__async_write;
+    unit__log_writer_begin(&unit__async_writer);
+    if (pthread_create(&unit__async_thread, NULL, unit__async_main, NULL) != 0) {
+        fputs("unit: warning: unable to start reporter thread, reporters are notified synchronously\n", stderr);
+        unit__log_writer_end(&unit__async_writer);
+        return;
     }
-    unit__printers = unit__opts.quiet ? NULL : &printer;
+    unit__async_running = true;
 }
 
-#define UNIT__MSG_VERSION "unit v" UNIT_VERSION "\n"
-#define UNIT__MSG_USAGE "usage: %s OPTIONS\n" \
-"options:\n" \
-"  --version or -v: Prints the version of `unit` library\n" \
-"  --help or -h: Prints usage help message\n" \
-"  --list or -l: Prints all available tests\n" \
-"  --ascii: Don't use colors and fancy unicode symbols in the output\n" \
-"  --quiet or -q: Disables all output\n" \
-"  --short-filenames or -S: Use only basename for displaying file-pos information\n" \
-"  -r=xml: Special switch prints XML report in DocTest-friendly format (for CLion test run configuration)\n" \
-"  --animate or -a: Simulate waits for printing messages, just for making fancy printing animation\n"
+// waits until the reporter thread notifies reporters about all written events
+static void unit__async_stop(void) {
+    __atomic_store_n(&unit__async_ring.closed, 1, __ATOMIC_RELEASE);
+    pthread_join(unit__async_thread, NULL);
+    unit__async_running = false;
+    unit__log_writer_end(&unit__async_writer);
+    unit__log_reader_free(&unit__async_reader);
+}
 
-static int unit__cmd(struct unit_run_options options) {
-    if (options.version) {
-        fputs(UNIT__MSG_VERSION, stdout);
-        return 0;
-    }
-    if (options.help) {
-        fprintf(stdout, UNIT__MSG_USAGE, options.program);
-        return 0;
+// called by the crash handler before the process is killed, only async-signal-safe calls are made here
+static void unit__async_crash_drain(void) {
+    if (!__atomic_load_n(&unit__async_running, __ATOMIC_ACQUIRE) || unit__async_is_reporter) {
+        return;
     }
-    if (options.list) {
-        for (struct unit_test* suite = unit_tests; suite; suite = suite->next) {
-            fputs(beautify_name(suite->name), stdout);
-            fputs("\n", stdout);
-        }
-        return 0;
+    const int request = __atomic_add_fetch(&unit__async_ring.flush, 1, __ATOMIC_ACQ_REL);
+    const struct timespec pause = {0, 1000000};
+    for (int i = 0; i < UNIT_ASYNC_DRAIN_MS && __atomic_load_n(&unit__async_ring.flushed, __ATOMIC_ACQUIRE) != request;
+         ++i) {
+        nanosleep(&pause, NULL);
     }
-    return 1;
 }
 
-int unit_main(struct unit_run_options options) {
-    if (!unit__cmd(options)) {
-        return 0;
-    }
-
-    unit__opts = options;
-    srand(options.seed);
-    unit__init_printers();
-
-    UNIT__EACH_PRINTER(SETUP, 0, 0);
-
-    int failed = 0;
-    for (struct unit_test* suite = unit_tests; suite; suite = suite->next) {
-        UNIT_TRY_SCOPE(unit__begin(suite), unit__end(suite)) suite->fn();
-        if (suite->status == UNIT_STATUS_FAILED) {
-            ++failed;
-        }
+// reporters are notified synchronously if the reporter thread is not started
+static void unit__async_notify(int cmd, struct unit_test* unit, const char* msg) {
+    switch (cmd) {
+        case UNIT__PRINTER_BEGIN:
+            UNIT__EACH_PRINTER_IN(unit__async_printers, BEGIN, unit, msg);
+            break;
+        case UNIT__PRINTER_END:
+            UNIT__EACH_PRINTER_IN(unit__async_printers, END, unit, msg);
+            break;
+        case UNIT__PRINTER_ECHO:
+            UNIT__EACH_PRINTER_IN(unit__async_printers, ECHO, unit, msg);
+            break;
+        case UNIT__PRINTER_FAIL:
+            UNIT__EACH_PRINTER_IN(unit__async_printers, FAIL, unit, msg);
+            break;
+        case UNIT__PRINTER_ASSERTION:
+            UNIT__EACH_PRINTER_IN(unit__async_printers, ASSERTION, unit, msg);
+            break;
     }
-
-    UNIT__EACH_PRINTER(SHUTDOWN, 0, 0);
-
-    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
-static void find_bool_arg(int argc, const char** argv, int* var, const char* name, const char* alias) {
-    for (int i = 0; i < argc; ++i) {
-        const char* v = argv[i];
-        if (v && v[0] == '-') {
-            ++v;
-            if (alias && alias[0] && strstr(v, alias) == v) {
-                *var = 1;
-                return;
-            } else if (name && name[0] && v[0] == '-') {
-                ++v;
-                if (strstr(v, name) == v) {
-                    *var = 1;
-                    return;
-                }
+static void printer_async(int cmd, struct unit_test* unit, const char* msg) {
+    switch (cmd) {
+        case UNIT__PRINTER_SETUP:
+            UNIT__EACH_PRINTER_IN(unit__async_printers, SETUP, unit, msg);
+            unit__async_start();
+            break;
+        case UNIT__PRINTER_SHUTDOWN:
+            if (unit__async_running) {
+                unit__async_stop();
             }
-        }
+            UNIT__EACH_PRINTER_IN(unit__async_printers, SHUTDOWN, unit, msg);
+            break;
+        default:
+            if (unit__async_running) {
+                // the record is a snapshot, so reporters never read the state of the running test
+                unit__log_event(&unit__async_writer, cmd, unit, msg);
+            } else {
+                unit__async_notify(cmd, unit, msg);
+            }
+            break;
     }
 }
 
-static void unit__parse_args(int argc, const char** argv, struct unit_run_options* out_options) {
-    find_bool_arg(argc, argv, &out_options->version, "version", "v");
-    find_bool_arg(argc, argv, &out_options->help, "help", "h");
-    find_bool_arg(argc, argv, &out_options->list, "list", "l");
-    find_bool_arg(argc, argv, &out_options->ascii, "ascii", NULL);
-    find_bool_arg(argc, argv, &out_options->trace, "trace", "t");
-    find_bool_arg(argc, argv, &out_options->quiet, "quiet", "q");
-    find_bool_arg(argc, argv, &out_options->animate, "animate", "a");
-    find_bool_arg(argc, argv, &out_options->short_filenames, "short-filenames", "S");
-    // hack to trick CLion we are DocTest library tests
-    find_bool_arg(argc, argv, &out_options->doctest_xml, NULL, "r=xml");
+#elif defined(UNIT__HAS_CRASH_RECOVERY)
+
+static void unit__async_crash_drain(void) {
 }
 
-static void unit__setup_args(int argc, const char** argv, struct unit_run_options* out_options) {
-    *out_options = (struct unit_run_options) {0};
-    out_options->seed = (unsigned) time(NULL);
-    out_options->program = argc > 0 ? short_filename(argv[0]) : "<unit>";
-#ifdef UNIT_DEFAULT_ARGS
-    static const char* cargv[] = { UNIT_DEFAULT_ARGS };
-    static const int cargc = sizeof(cargv) / sizeof(cargv[0]);
-    unit__parse_args(cargc, cargv, out_options);
-#endif
-    unit__parse_args(argc, argv, out_options);
+#endif // UNIT__HAS_ASYNC_REPORT
+
+static void unit__async_init(void) {
+#ifdef UNIT__HAS_ASYNC_REPORT
+    // only reporters are in the list yet
+    unit__async_printers = unit__printers;
+    if (!unit__async_printers) {
+        return;
+    }
+    unit__async_printer.callback = printer_async;
+    unit__async_printer.events = UNIT__EVENT(SETUP) | UNIT__EVENT(SHUTDOWN);
+    for (struct unit_printer* p = unit__async_printers; p; p = p->next) {
+        unit__async_printer.events |= p->events;
+    }
+    unit__async_printer.out = NULL;
+    unit__async_printer.next = NULL;
+    unit__printers = &unit__async_printer;
+#else
+    if (!unit__opts.quiet) {
+        fputs("unit: warning: asynchronous reporting is not supported on this platform\n", stderr);
+    }
+    unit__opts.async_report = 0;
+#endif // UNIT__HAS_ASYNC_REPORT
 }
 
 // endregion
 
+
 #ifdef UNIT_MAIN
 int main(int argc, const char** argv) {
     struct unit_run_options options;
@@ -1175,6 +6641,37 @@ UNIT_SUITE(unit_internals) {
         }
     }
 
+    DESCRIBE(unit__clock) {
+        IT("is monotonic") {
+            const int64_t t0 = unit__clock.now();
+            const int64_t t1 = unit__clock.now();
+            CHECK_GE(t1, t0);
+            CHECK_GE(unit__clock.overhead, 0);
+        }
+        IT("measures thread CPU time") {
+            const int64_t t0 = unit__cpu_time();
+            volatile unsigned acc = 0;
+            for (unsigned i = 0; i < 100000; ++i) {
+                acc += i;
+            }
+            CHECK_GE(unit__cpu_time(), t0);
+        }
+    }
+
+    DESCRIBE(unit__sample_resources) {
+        IT("calculates usage delta") {
+            struct unit_resources r0;
+            struct unit_resources r1;
+            unit__sample_resources(&r0);
+            unit__sample_resources(&r1);
+            unit__diff_resources(&r1, &r0);
+            CHECK_GE(r1.user, 0);
+            CHECK_GE(r1.minflt, 0);
+            CHECK_GE(r1.nvcsw, 0);
+            CHECK_GE(r1.max_rss, r0.max_rss);
+        }
+    }
+
     DESCRIBE(find_bool_arg) {
         IT("parse short form") {
             int val = 0;
@@ -1186,6 +6683,11 @@ UNIT_SUITE(unit_internals) {
             find_bool_arg(3, (const char* []) {"", "-a", "--along"}, &val, "along", "");
             REQUIRE_EQ(val, 1);
         }
+        IT("match the whole long form") {
+            int val = 0;
+            find_bool_arg(2, (const char* []) {"--trace-out=run.json", "--traces"}, &val, "trace", "t");
+            REQUIRE_EQ(val, 0);
+        }
         IT("don't change on not found") {
             int val = 2;
             find_bool_arg(4, (const char* []) {"--etemp", "-nt", "-a", "--no-along"}, &val, "temp", "t");
@@ -1193,10 +6695,317 @@ UNIT_SUITE(unit_internals) {
         }
     }
 
+    DESCRIBE(print_json_string) {
+        IT("escapes special characters") {
+            char buf[64] = {0};
+            FILE* f = tmpfile();
+            REQUIRE((const void*) f);
+            print_json_string(f, "a\"b\\c\n\033");
+            rewind(f);
+            fread(buf, 1, sizeof buf - 1, f);
+            fclose(f);
+            CHECK_EQ(buf, "\"a\\\"b\\\\c\\n\\u001b\"");
+        }
+    }
+
+    DESCRIBE(print_xml_string) {
+        IT("escapes markup and drops control characters") {
+            char buf[64] = {0};
+            FILE* f = tmpfile();
+            REQUIRE((const void*) f);
+            print_xml_string(f, "<a href='x'>\"&\"</a>\n\033");
+            rewind(f);
+            fread(buf, 1, sizeof buf - 1, f);
+            fclose(f);
+            CHECK_EQ(buf, "&lt;a href=&apos;x&apos;&gt;&quot;&amp;&quot;&lt;/a&gt;\n");
+        }
+    }
+
+    DESCRIBE(find_str_arg) {
+        IT("parse value after `=`") {
+            const char* val = NULL;
+            find_str_arg(3, (const char* []) {"--cpu=1", "--cpus", "--cpus=0,2-3"}, &val, "cpus");
+            REQUIRE_EQ(val, "0,2-3");
+        }
+        IT("don't change on not found") {
+            const char* val = "prev";
+            find_str_arg(2, (const char* []) {"-cpus=1", "--cpus"}, &val, "cpus");
+            REQUIRE_EQ(val, "prev");
+        }
+    }
+
+    DESCRIBE(unit__env_parse_cpus) {
+        IT("parse lists and ranges") {
+            unsigned long mask[2] = {0};
+            REQUIRE_EQ(unit__env_parse_cpus("0,2-3,3", mask, 128), 3);
+            REQUIRE_EQ(mask[0], 13ul);
+        }
+        IT("reject invalid list") {
+            unsigned long mask[2] = {0};
+            CHECK_EQ(unit__env_parse_cpus("1-a", mask, 128), -1);
+            CHECK_EQ(unit__env_parse_cpus("3-1", mask, 128), -1);
+        }
+    }
+
+    DESCRIBE(unit_scratch_alloc) {
+        static unsigned char* prev = NULL;
+        IT("allocate aligned memory") {
+            unsigned char* p = (unsigned char*) unit_scratch_alloc(100, 64);
+            REQUIRE(p != NULL);
+            CHECK_EQ((int) ((uintptr_t) p % 64), 0);
+            memset(p, 1, 100);
+            unsigned char* q = (unsigned char*) unit_scratch_alloc(1, 1);
+            CHECK(q == p + 100);
+            prev = p;
+        }
+        IT("rewind at the test end") {
+#if UNIT_SCRATCH_POISON
+            CHECK_EQ((int) prev[0], UNIT__SCRATCH_POISON_BYTE);
+#endif
+            CHECK(unit_scratch_alloc(100, 64) == prev);
+        }
+        IT("return NULL when capacity is exceeded") {
+            CHECK(unit_scratch_alloc(UNIT_SCRATCH_RESERVE + 1, 1) == NULL);
+        }
+    }
+
+    DESCRIBE(unit__mismatch) {
+        static unsigned char a[300];
+        static unsigned char b[300];
+        IT("find the first different byte at any offset") {
+            memset(a, 7, sizeof a);
+            memset(b, 7, sizeof b);
+            REQUIRE_EQ(unit__mismatch(a, b, sizeof a), sizeof a);
+            bool found = true;
+            for (size_t i = 0; i < sizeof a; ++i) {
+                b[i] = 8;
+                found = found && unit__mismatch(a, b, sizeof a) == i && unit__mismatch(a, b, i) == i;
+                b[i] = 7;
+            }
+            REQUIRE(found);
+        }
+        IT("count mismatched elements") {
+            memset(b, 7, sizeof b);
+            b[1] = b[2] = 0;
+            b[100] = b[299] = 0;
+            CHECK_EQ(unit__count_mismatches(a, b, sizeof a, 1, 0), 4u);
+            CHECK_EQ(unit__count_mismatches(a, b, sizeof a, 4, 0), 3u);
+            CHECK_EQ(unit__count_mismatches(a, b, sizeof a, 4, 4), 2u);
+        }
+    }
+
+    DESCRIBE(unit__ulps) {
+        IT("measure distance between adjacent floats") {
+            CHECK_EQ(unit__ulps_flt(1.0f, 1.0f), 0ull);
+            CHECK_EQ(unit__ulps_flt(0.0f, -0.0f), 0ull);
+            CHECK_EQ(unit__ulps_flt(0.0f, 1.4e-45f), 1ull);
+            CHECK_EQ(unit__ulps_flt(-1.4e-45f, 1.4e-45f), 2ull);
+            CHECK_EQ(unit__ulps_dbl(1.0, 1.0000000000000002), 1ull);
+            CHECK_EQ(unit__ulps_dbl(-1.0, 1.0), 2ull * 0x3FF0000000000000ull);
+        }
+    }
+
+    DESCRIBE(unit__assert_pass) {
+        IT("count evaluated assertions") {
+            CHECK(1);
+            CHECK_EQ(1, 1);
+            WARN_NE(1, 2);
+            REQUIRE_EQ((int) unit__hot.assertions, 3);
+        }
+        IT("skip printers without `ASSERTION` subscribers") {
+            const unsigned events = unit__events;
+            unit__events &= ~UNIT__EVENT(ASSERTION);
+            CHECK(unit__hot.assertions == 0);
+            unit__events = events;
+            REQUIRE_EQ((int) unit__hot.assertions, 1);
+        }
+    }
+
+    DESCRIBE(unit__format_fail) {
+        IT("format typed operands without style markers") {
+            struct unit__fail_record r = {0};
+            r.kind = UNIT__FAIL_COMPARE;
+            r.op = UNIT__OP_LT;
+            r.sa = "a";
+            r.sb = "b";
+            r.a = unit__value_int(-3);
+            r.b = unit__value_uint(7u);
+            char buf[128];
+            unit__format_fail_plain(buf, sizeof buf, &r);
+            REQUIRE_EQ(buf, "Expected `a` < `b`, but got `-3 >= 7`");
+        }
+        IT("copy string operands") {
+            char str[8] = "value";
+            struct unit__value v = unit__value_str(str);
+            str[0] = 0;
+            REQUIRE_EQ(v.s, "value");
+        }
+    }
+
+    DESCRIBE(unit__fail_take) {
+        IT("take queued failures in posting order") {
+            struct unit__fail_node nodes[3];
+            for (int i = 0; i < 3; ++i) {
+                nodes[i].record.op = i;
+                unit__fail_post(&nodes[i].record);
+            }
+            struct unit__fail_node* list = unit__fail_take();
+            for (int i = 0; i < 3; ++i) {
+                REQUIRE(list == nodes + i);
+                list = list->next;
+            }
+            REQUIRE(list == NULL);
+            REQUIRE(unit__fail_take() == NULL);
+        }
+    }
+
+    DESCRIBE(unit__journal_open) {
+        IT("keep content beyond the memory buffer") {
+            FILE* journal = unit__journal_open();
+            REQUIRE((const void*) journal);
+            const int lines = 2 * UNIT_FAIL_JOURNAL / 16;
+            for (int i = 0; i < lines; ++i) {
+                fprintf(journal, "failure %06d\n", i);
+            }
+            FILE* out = tmpfile();
+            REQUIRE((const void*) out);
+            unit__journal_replay(journal, out);
+            // each line is 15 bytes
+            CHECK_EQ(ftell(out), 15L * lines);
+            char line[32] = {0};
+            fseek(out, -15L, SEEK_END);
+            fread(line, 1, 15, out);
+            fclose(out);
+            REQUIRE_EQ((const char*) line, "failure 008191\n");
+        }
+    }
+
+    DESCRIBE(unit__log_slot) {
+        IT("keep ids of interned pointers while growing") {
+            static int keys[3000];
+            struct unit__log_ids table = {0};
+            bool found = true;
+            for (uint32_t i = 0; i < 3000; ++i) {
+                uint32_t* slot = unit__log_slot(&table, keys + i);
+                REQUIRE(slot != NULL);
+                found = found && *slot == 0;
+                *slot = i + 1;
+            }
+            for (uint32_t i = 0; i < 3000; ++i) {
+                found = found && *unit__log_slot(&table, keys + i) == i + 1;
+            }
+            CHECK_EQ(table.num, 3000u);
+            unit__log_ids_free(&table);
+            REQUIRE(found);
+        }
+    }
+
+    DESCRIBE(add_child) {
+        IT("append children in order") {
+            static struct unit_test parent;
+            static struct unit_test children[1000];
+            parent = (struct unit_test) {0};
+            for (int i = 0; i < 1000; ++i) {
+                children[i] = (struct unit_test) {0};
+                add_child(&parent, children + i);
+            }
+            int num = 0;
+            bool ordered = true;
+            for (struct unit_test* child = parent.children; child; child = child->next) {
+                ordered = ordered && child == children + num && child->parent == &parent;
+                ++num;
+            }
+            CHECK_EQ(num, 1000);
+            CHECK(parent.children_last == children + 999);
+            REQUIRE(ordered);
+        }
+    }
+
+#ifdef UNIT__HAS_ASYNC_REPORT
+    DESCRIBE(unit__async_ring) {
+        IT("pass bytes across the end of the buffer") {
+            // the ring is free while the reporter thread is not running
+            REQUIRE(!unit__async_running);
+            memset(&unit__async_ring, 0, sizeof unit__async_ring);
+            unit__async_ring.head = unit__async_ring.tail = UNIT_ASYNC_RING - 5;
+            const char sent[] = "wrapped record";
+            char received[sizeof sent] = {0};
+            unit__async_write(NULL, sent, sizeof sent);
+            CHECK_EQ(unit__async_ring.head, (uint64_t) UNIT_ASYNC_RING - 5 + sizeof sent);
+            REQUIRE(unit__async_read(NULL, received, sizeof received));
+            CHECK_EQ(received, sent);
+            CHECK_EQ(unit__async_ring.tail, unit__async_ring.head);
+            unit__async_ring.closed = 1;
+            CHECK_FALSE(unit__async_read(NULL, received, 1));
+        }
+    }
+#endif // UNIT__HAS_ASYNC_REPORT
+
+    DESCRIBE(unit__durations_push) {
+        IT("keep the slowest nodes") {
+            static struct unit_test nodes[10];
+            struct unit__durations heap = {0};
+            const int64_t elapsed[10] = {5, 1, 9, 3, 7, 2, 8, 6, 4, 0};
+            for (int i = 0; i < 10; ++i) {
+                nodes[i].elapsed = elapsed[i];
+                unit__durations_push(&heap, 3, nodes + i);
+            }
+            struct unit_test* sorted[UNIT_DURATIONS_MAX];
+            REQUIRE_EQ(unit__durations_sorted(&heap, sorted), 3);
+            CHECK_EQ(sorted[0]->elapsed, (int64_t) 9);
+            CHECK_EQ(sorted[1]->elapsed, (int64_t) 8);
+            CHECK_EQ(sorted[2]->elapsed, (int64_t) 7);
+        }
+    }
+
+    DESCRIBE(unit__glob) {
+        IT("match test path") {
+            CHECK(unit__glob("unit/SKIP/*", "unit/SKIP/start skipping"));
+            CHECK(unit__glob("*skip*", "unit/SKIP/start skipping"));
+            CHECK(unit__glob("*/[?]", "each/rows/[7]"));
+            CHECK(unit__glob("*", ""));
+            CHECK_FALSE(unit__glob("unit/*/x", "unit/SKIP/y"));
+            CHECK_FALSE(unit__glob("[?]", "[10]"));
+            CHECK_FALSE(unit__glob("", "unit"));
+        }
+    }
+
+    DESCRIBE(unit__gen_int) {
+        IT("order values by the distance from zero") {
+            const uint64_t draws[] = {0, 1, 2, 3, 4, 0, 2, 0, 1};
+            const int64_t expected[] = {0, 1, -1, 2, -2, 3, 5, -3, -4};
+            const int64_t min[] = {-10, -10, -10, -10, -10, 3, 3, -5, -5};
+            const int64_t max[] = {10, 10, 10, 10, 10, 5, 5, -3, -3};
+            unit__prop.random = false;
+            memcpy(unit__prop.replay, draws, sizeof draws);
+            unit__prop.replay_num = 9;
+            unit__prop.draws_num = 0;
+            for (int i = 0; i < 9; ++i) {
+                CHECK_EQ(unit__gen_int(min[i], max[i]), expected[i]);
+            }
+            CHECK_EQ(unit__prop.draws_num, 9u);
+            CHECK_EQ(unit__gen_int(INT64_MIN, INT64_MAX), (int64_t) 0);
+        }
+    }
+
+    DESCRIBE(unit__format_count) {
+        IT("separate thousands") {
+            char buf[64];
+            const intmax_t values[] = {0, 999, 1000, 12345, -1000000, INTMAX_MIN};
+            const char* expected[] = {"0", "999", "1,000", "12,345", "-1,000,000", "-9,223,372,036,854,775,808"};
+            for (int i = 0; i < 6; ++i) {
+                struct unit__text text = {buf, sizeof buf, 0};
+                buf[0] = 0;
+                unit__format_count(&text, values[i]);
+                CHECK_EQ(buf, expected[i]);
+            }
+        }
+    }
+
     DESCRIBE(unit__parse_args) {
         IT("options") {
             struct unit_run_options options = {0};
-            unit__parse_args(6,
+            unit__parse_args(7,
                              (const char* []) {
                                      "--quiet",
                                      "--ascii",
@@ -1204,6 +7013,7 @@ UNIT_SUITE(unit_internals) {
                                      "-t",
                                      "-a",
                                      "not-found",
+                                     "-r=ndjson:run.ndjson",
                                      NULL
                              }, &options);
             REQUIRE_EQ(options.quiet, 1);
@@ -1211,6 +7021,11 @@ UNIT_SUITE(unit_internals) {
             REQUIRE_EQ(options.trace, 1);
             REQUIRE_EQ(options.doctest_xml, 1);
             REQUIRE_EQ(options.ascii, 1);
+            REQUIRE_EQ(options.ndjson, 1);
+            REQUIRE_EQ(options.ndjson_out, "run.ndjson");
+            REQUIRE_EQ(options.xml_out, (const char*) NULL);
+            REQUIRE_EQ(options.junit, 0);
+            REQUIRE_EQ(options.console, 0);
         }
     }
 }
@@ -0,0 +1,257 @@
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+
+#include <pthread.h>
+#include <sched.h>
+
+#define UNIT__HAS_ASYNC_REPORT 1
+
+#endif // unix && !__EMSCRIPTEN__
+
+// region поток отчётов: `--async-report`, принтеры получают записи журнала событий через кольцевой буфер
+
+#ifndef UNIT_ASYNC_RING
+// capacity of the events ring in bytes, must be the power of two
+#define UNIT_ASYNC_RING (1024 * 1024)
+#endif
+
+#ifndef UNIT_ASYNC_DRAIN_MS
+// how long the crashing process waits for the reporter thread to print pending events
+#define UNIT_ASYNC_DRAIN_MS 1000
+#endif
+
+#ifdef UNIT__HAS_ASYNC_REPORT
+
+// reporters selected by `-r`, they are notified only by the reporter thread between `SETUP` and `SHUTDOWN`
+static struct unit_printer* unit__async_printers = NULL;
+static struct unit_printer unit__async_printer;
+
+// the single producer is the tests thread, the single consumer is the reporter thread
+struct unit__async_ring {
+    unsigned char data[UNIT_ASYNC_RING];
+    // positions grow monotonically, the offset in the buffer is the position modulo capacity
+    uint64_t head __attribute__((aligned(64)));
+    uint64_t tail __attribute__((aligned(64)));
+    // set by the producer after the last event
+    int closed;
+    // flush request counter of the crash handler and the last request served by the consumer
+    int flush;
+    int flushed;
+};
+
+static struct unit__async_ring unit__async_ring;
+static struct unit__log_writer unit__async_writer;
+static struct unit__log_reader unit__async_reader;
+static pthread_t unit__async_thread;
+static bool unit__async_running = false;
+static __thread bool unit__async_is_reporter = false;
+
+// yields while the other side is expected soon, then sleeps to not burn the core
+static void unit__async_wait(unsigned* spins) {
+    if (++*spins < 64) {
+        sched_yield();
+    } else {
+        const struct timespec pause = {0, 100000};
+        nanosleep(&pause, NULL);
+    }
+}
+
+static void unit__async_write(struct unit__log_writer* writer, const void* data, size_t size) {
+    (void) writer;
+    struct unit__async_ring* ring = &unit__async_ring;
+    const unsigned char* src = (const unsigned char*) data;
+    unsigned spins = 0;
+    while (size) {
+        const uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+        const uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        size_t n = UNIT_ASYNC_RING - (size_t) (head - tail);
+        if (!n) {
+            // back-pressure: the tests thread waits for the reporter thread instead of dropping events
+            unit__async_wait(&spins);
+            continue;
+        }
+        const size_t offset = (size_t) head & (UNIT_ASYNC_RING - 1);
+        if (n > UNIT_ASYNC_RING - offset) {
+            n = UNIT_ASYNC_RING - offset;
+        }
+        if (n > size) {
+            n = size;
+        }
+        memcpy(ring->data + offset, src, n);
+        __atomic_store_n(&ring->head, head + n, __ATOMIC_RELEASE);
+        src += n;
+        size -= n;
+        spins = 0;
+    }
+}
+
+static void unit__async_flush(struct unit__log_reader* reader) {
+    const int flush = __atomic_load_n(&unit__async_ring.flush, __ATOMIC_ACQUIRE);
+    if (flush != unit__async_ring.flushed) {
+        for (struct unit_printer* p = reader->printers; p; p = p->next) {
+            if (p->out) {
+                fflush(p->out);
+            }
+        }
+        __atomic_store_n(&unit__async_ring.flushed, flush, __ATOMIC_RELEASE);
+    }
+}
+
+static bool unit__async_read(struct unit__log_reader* reader, void* data, size_t size) {
+    struct unit__async_ring* ring = &unit__async_ring;
+    unsigned char* dst = (unsigned char*) data;
+    unsigned spins = 0;
+    while (size) {
+        const uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_RELAXED);
+        const uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+        if (head == tail) {
+            if (__atomic_load_n(&ring->closed, __ATOMIC_ACQUIRE) &&
+                __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) == tail) {
+                return false;
+            }
+            unit__async_flush(reader);
+            unit__async_wait(&spins);
+            continue;
+        }
+        const size_t offset = (size_t) tail & (UNIT_ASYNC_RING - 1);
+        size_t n = (size_t) (head - tail);
+        if (n > UNIT_ASYNC_RING - offset) {
+            n = UNIT_ASYNC_RING - offset;
+        }
+        if (n > size) {
+            n = size;
+        }
+        memcpy(dst, ring->data + offset, n);
+        __atomic_store_n(&ring->tail, tail + n, __ATOMIC_RELEASE);
+        dst += n;
+        size -= n;
+        spins = 0;
+    }
+    return true;
+}
+
+static void* unit__async_main(void* arg) {
+    (void) arg;
+    // the profiler and other signals are for the tests thread, crashes are still handled here
+    sigset_t mask;
+    sigfillset(&mask);
+    for (int i = 0; i < UNIT__CRASH_SIGNALS_NUM; ++i) {
+        sigdelset(&mask, unit__crash_signals[i]);
+    }
+    pthread_sigmask(SIG_BLOCK, &mask, NULL);
+    unit__async_is_reporter = true;
+    unit__log_replay_all(&unit__async_reader);
+    return NULL;
+}
+
+static void unit__async_start(void) {
+    memset(&unit__async_ring, 0, sizeof unit__async_ring);
+    memset(&unit__async_reader, 0, sizeof unit__async_reader);
+    unit__async_reader.read = unit__async_read;
+    unit__async_reader.printers = unit__async_printers;
+    unit__async_writer.write = unit__async_write;
+    unit__log_writer_begin(&unit__async_writer);
+    if (pthread_create(&unit__async_thread, NULL, unit__async_main, NULL) != 0) {
+        fputs("unit: warning: unable to start reporter thread, reporters are notified synchronously\n", stderr);
+        unit__log_writer_end(&unit__async_writer);
+        return;
+    }
+    unit__async_running = true;
+}
+
+// waits until the reporter thread notifies reporters about all written events
+static void unit__async_stop(void) {
+    __atomic_store_n(&unit__async_ring.closed, 1, __ATOMIC_RELEASE);
+    pthread_join(unit__async_thread, NULL);
+    unit__async_running = false;
+    unit__log_writer_end(&unit__async_writer);
+    unit__log_reader_free(&unit__async_reader);
+}
+
+// called by the crash handler before the process is killed, only async-signal-safe calls are made here
+static void unit__async_crash_drain(void) {
+    if (!__atomic_load_n(&unit__async_running, __ATOMIC_ACQUIRE) || unit__async_is_reporter) {
+        return;
+    }
+    const int request = __atomic_add_fetch(&unit__async_ring.flush, 1, __ATOMIC_ACQ_REL);
+    const struct timespec pause = {0, 1000000};
+    for (int i = 0; i < UNIT_ASYNC_DRAIN_MS && __atomic_load_n(&unit__async_ring.flushed, __ATOMIC_ACQUIRE) != request;
+         ++i) {
+        nanosleep(&pause, NULL);
+    }
+}
+
+// reporters are notified synchronously if the reporter thread is not started
+static void unit__async_notify(int cmd, struct unit_test* unit, const char* msg) {
+    switch (cmd) {
+        case UNIT__PRINTER_BEGIN:
+            UNIT__EACH_PRINTER_IN(unit__async_printers, BEGIN, unit, msg);
+            break;
+        case UNIT__PRINTER_END:
+            UNIT__EACH_PRINTER_IN(unit__async_printers, END, unit, msg);
+            break;
+        case UNIT__PRINTER_ECHO:
+            UNIT__EACH_PRINTER_IN(unit__async_printers, ECHO, unit, msg);
+            break;
+        case UNIT__PRINTER_FAIL:
+            UNIT__EACH_PRINTER_IN(unit__async_printers, FAIL, unit, msg);
+            break;
+        case UNIT__PRINTER_ASSERTION:
+            UNIT__EACH_PRINTER_IN(unit__async_printers, ASSERTION, unit, msg);
+            break;
+    }
+}
+
+static void printer_async(int cmd, struct unit_test* unit, const char* msg) {
+    switch (cmd) {
+        case UNIT__PRINTER_SETUP:
+            UNIT__EACH_PRINTER_IN(unit__async_printers, SETUP, unit, msg);
+            unit__async_start();
+            break;
+        case UNIT__PRINTER_SHUTDOWN:
+            if (unit__async_running) {
+                unit__async_stop();
+            }
+            UNIT__EACH_PRINTER_IN(unit__async_printers, SHUTDOWN, unit, msg);
+            break;
+        default:
+            if (unit__async_running) {
+                // the record is a snapshot, so reporters never read the state of the running test
+                unit__log_event(&unit__async_writer, cmd, unit, msg);
+            } else {
+                unit__async_notify(cmd, unit, msg);
+            }
+            break;
+    }
+}
+
+#elif defined(UNIT__HAS_CRASH_RECOVERY)
+
+static void unit__async_crash_drain(void) {
+}
+
+#endif // UNIT__HAS_ASYNC_REPORT
+
+static void unit__async_init(void) {
+#ifdef UNIT__HAS_ASYNC_REPORT
+    // only reporters are in the list yet
+    unit__async_printers = unit__printers;
+    if (!unit__async_printers) {
+        return;
+    }
+    unit__async_printer.callback = printer_async;
+    unit__async_printer.events = UNIT__EVENT(SETUP) | UNIT__EVENT(SHUTDOWN);
+    for (struct unit_printer* p = unit__async_printers; p; p = p->next) {
+        unit__async_printer.events |= p->events;
+    }
+    unit__async_printer.out = NULL;
+    unit__async_printer.next = NULL;
+    unit__printers = &unit__async_printer;
+#else
+    if (!unit__opts.quiet) {
+        fputs("unit: warning: asynchronous reporting is not supported on this platform\n", stderr);
+    }
+    unit__opts.async_report = 0;
+#endif // UNIT__HAS_ASYNC_REPORT
+}
+
+// endregion
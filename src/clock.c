@@ -0,0 +1,159 @@
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <x86intrin.h>
+#include <cpuid.h>
+
+#define UNIT__HAS_TSC 1
+
+#endif // x86
+
+#if defined(_WIN32) && !defined(UNIT_NO_TIME)
+
+#include <windows.h>
+
+#endif // _WIN32
+
+// region часы: монотонное время, TSC и процессорное время потока
+
+struct unit_clock {
+    const char* name;
+    // current time in nanoseconds
+    int64_t (* now)(void);
+    // calibrated cost of the single `now()` call in nanoseconds
+    int64_t overhead;
+};
+
+#if defined(_WIN32) && !defined(UNIT_NO_TIME)
+
+// `timespec_get` gives wall clock time on Windows, performance counter is monotonic
+static int64_t unit__clock_mono(void) {
+    static int64_t frequency = 0;
+    if (!frequency) {
+        LARGE_INTEGER f;
+        QueryPerformanceFrequency(&f);
+        frequency = f.QuadPart;
+    }
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    // whole seconds and the remainder are scaled separately, so nanoseconds don't overflow
+    return counter.QuadPart / frequency * 1000000000 + counter.QuadPart % frequency * 1000000000 / frequency;
+}
+
+#else // _WIN32
+
+static int64_t unit__clock_mono(void) {
+    struct timespec ts = {0};
+#ifndef UNIT_NO_TIME
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif // !UNIT_NO_TIME
+    return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+#endif // !_WIN32
+
+#ifdef UNIT__HAS_TSC
+
+// ticks are converted to nanoseconds as `ticks * mult >> shift`, `mult` is less than 2^32
+static uint64_t unit__tsc_mult = 0;
+static unsigned unit__tsc_shift = 0;
+
+static int64_t unit__clock_tsc(void) {
+    const uint64_t ticks = __rdtsc();
+    // high and low 32-bit halves are scaled separately, so products don't overflow
+    return (int64_t) ((((ticks >> 32) * unit__tsc_mult) << (32 - unit__tsc_shift)) +
+                      (((ticks & 0xFFFFFFFFu) * unit__tsc_mult) >> unit__tsc_shift));
+}
+
+/**
+ * Invariant TSC (CPUID 0x80000007, EDX bit 8) ticks at constant rate in all P-, C- and T-states,
+ * otherwise the rate follows CPU frequency and ticks can't be converted to time
+ */
+static bool unit__tsc_invariant(void) {
+    unsigned eax, ebx, ecx, edx;
+    return __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1u << 8)) != 0;
+}
+
+static bool unit__tsc_calibrate(void) {
+    if (!unit__tsc_invariant()) {
+        return false;
+    }
+    const int64_t t0 = unit__clock_mono();
+    const uint64_t c0 = __rdtsc();
+    int64_t t1;
+    do {
+        t1 = unit__clock_mono();
+    } while (t1 - t0 < 10000000);
+    const uint64_t c1 = __rdtsc();
+    if (c1 <= c0) {
+        return false;
+    }
+    // the most precise `shift` keeping `mult` in 32 bits, elapsed time is about 2^24 ns, so it doesn't overflow
+    unsigned shift = 32;
+    uint64_t mult = ((uint64_t) (t1 - t0) << shift) / (c1 - c0);
+    while (mult >> 32 && shift > 0) {
+        --shift;
+        mult = ((uint64_t) (t1 - t0) << shift) / (c1 - c0);
+    }
+    if (!mult || mult >> 32) {
+        return false;
+    }
+    unit__tsc_mult = mult;
+    unit__tsc_shift = shift;
+    return true;
+}
+
+#endif // UNIT__HAS_TSC
+
+struct unit_clock unit__clock = {"mono", unit__clock_mono, 0};
+
+/**
+ * CPU time consumed by the calling thread in nanoseconds
+ */
+static int64_t unit__cpu_time(void) {
+#if defined(UNIT_NO_TIME)
+    return 0;
+#elif defined(CLOCK_THREAD_CPUTIME_ID)
+    struct timespec ts = {0};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (int64_t) ts.tv_sec * 1000000000 + ts.tv_nsec;
+#else
+    return (int64_t) ((double) clock() * (1000000000.0 / CLOCKS_PER_SEC));
+#endif
+}
+
+static int64_t unit__clock_measure_overhead(void) {
+    int64_t best = INT64_MAX;
+    for (int i = 0; i < 64; ++i) {
+        const int64_t t0 = unit__clock.now();
+        const int64_t t1 = unit__clock.now();
+        if (t1 - t0 < best) {
+            best = t1 - t0;
+        }
+    }
+    return best > 0 ? best : 0;
+}
+
+/**
+ * Selects time source by `--clock=` option and measures clock read overhead
+ */
+static void unit__clock_setup(void) {
+    unit__clock = (struct unit_clock) {"mono", unit__clock_mono, 0};
+    const char* name = unit__opts.clock;
+    if (name && strcmp(name, "tsc") == 0) {
+        bool selected = false;
+#ifdef UNIT__HAS_TSC
+        if (unit__tsc_calibrate()) {
+            unit__clock = (struct unit_clock) {"tsc", unit__clock_tsc, 0};
+            selected = true;
+        }
+#endif // UNIT__HAS_TSC
+        if (!selected && !unit__opts.quiet) {
+            fputs("unit: warning: invariant TSC clock is not available, fallback to monotonic clock\n", stderr);
+        }
+    } else if (name && name[0] && strcmp(name, "mono") != 0 && !unit__opts.quiet) {
+        fprintf(stderr, "unit: warning: unknown clock `%s`, fallback to monotonic clock\n", name);
+    }
+    unit__clock.overhead = unit__clock_measure_overhead();
+}
+
+// endregion
@@ -0,0 +1,487 @@
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+#define UNIT__SIMD_AVX2 1
+#define UNIT__SIMD_SSE2 1
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+#include <emmintrin.h>
+
+#define UNIT__SIMD_SSE2 1
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+#include <arm_neon.h>
+
+#define UNIT__SIMD_NEON 1
+
+#endif
+
+// region сравнение блоков памяти: `CHECK_MEM_EQ`, `CHECK_ARRAY_EQ`
+
+// number of elements printed around the first mismatch, bytes window is twice wider
+#define UNIT__DIFF_WINDOW 8
+
+/**
+ * Returns offset of the first different byte, or `size` if blocks are equal
+ */
+static size_t unit__mismatch(const unsigned char* a, const unsigned char* b, size_t size) {
+    size_t i = 0;
+#ifdef UNIT__SIMD_AVX2
+    // fast path for long equal runs: 128 bytes per iteration, exact position is found below
+    for (; i + 128 <= size; i += 128) {
+        __m256i d = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*) (a + i)),
+                                     _mm256_loadu_si256((const __m256i*) (b + i)));
+        for (size_t j = 32; j < 128; j += 32) {
+            d = _mm256_or_si256(d, _mm256_xor_si256(_mm256_loadu_si256((const __m256i*) (a + i + j)),
+                                                    _mm256_loadu_si256((const __m256i*) (b + i + j))));
+        }
+        if (!_mm256_testz_si256(d, d)) {
+            break;
+        }
+    }
+    for (; i + 32 <= size; i += 32) {
+        const __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*) (a + i)),
+                                             _mm256_loadu_si256((const __m256i*) (b + i)));
+        const unsigned mask = ~(unsigned) _mm256_movemask_epi8(eq);
+        if (mask) {
+            return i + (size_t) __builtin_ctz(mask);
+        }
+    }
+#endif // UNIT__SIMD_AVX2
+#ifdef UNIT__SIMD_SSE2
+    for (; i + 64 <= size; i += 64) {
+        __m128i d = _mm_xor_si128(_mm_loadu_si128((const __m128i*) (a + i)),
+                                  _mm_loadu_si128((const __m128i*) (b + i)));
+        for (size_t j = 16; j < 64; j += 16) {
+            d = _mm_or_si128(d, _mm_xor_si128(_mm_loadu_si128((const __m128i*) (a + i + j)),
+                                              _mm_loadu_si128((const __m128i*) (b + i + j))));
+        }
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(d, _mm_setzero_si128())) != 0xFFFF) {
+            break;
+        }
+    }
+    for (; i + 16 <= size; i += 16) {
+        const __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*) (a + i)),
+                                          _mm_loadu_si128((const __m128i*) (b + i)));
+        const unsigned mask = ~(unsigned) _mm_movemask_epi8(eq) & 0xFFFFu;
+        if (mask) {
+            return i + (size_t) __builtin_ctz(mask);
+        }
+    }
+#endif // UNIT__SIMD_SSE2
+#ifdef UNIT__SIMD_NEON
+    for (; i + 16 <= size; i += 16) {
+        const uint8x16_t eq = vceqq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+        if (vminvq_u8(eq) != 0xFF) {
+            // exact position is found by the scalar loop
+            break;
+        }
+    }
+#endif // UNIT__SIMD_NEON
+    for (; i + 8 <= size; i += 8) {
+        uint64_t x, y;
+        memcpy(&x, a + i, 8);
+        memcpy(&y, b + i, 8);
+        if (x != y) {
+            break;
+        }
+    }
+    for (; i < size; ++i) {
+        if (a[i] != b[i]) {
+            return i;
+        }
+    }
+    return size;
+}
+
+/**
+ * Counts elements with different bytes, starting from the element containing `from` offset
+ */
+static size_t unit__count_mismatches(const unsigned char* a, const unsigned char* b, size_t size, size_t elem_size,
+                                     size_t from) {
+    size_t count = 0;
+    size_t i = from;
+    while (i < size) {
+        i += unit__mismatch(a + i, b + i, size - i);
+        if (i >= size) {
+            break;
+        }
+        ++count;
+        i = (i / elem_size + 1) * elem_size;
+    }
+    return count;
+}
+
+static void unit__fail_null(const char* sa, const char* sb, const char* null_expr, const char* op) {
+    char buffer[512];
+    struct unit__text text = {buffer, sizeof buffer, 0};
+    buffer[0] = 0;
+    unit__text_printf(&text, "Expected " UNIT__MARK_SUCCESS_S "`%s` %s `%s`" UNIT__MARK_RESET_S ", but got "
+                             UNIT__MARK_FAIL_S "`%s` is NULL" UNIT__MARK_RESET_S, sa, op, sb, null_expr);
+    unit__fail_text(buffer);
+}
+
+static void unit__print_elem(struct unit__text* text, const unsigned char* p, size_t elem_size) {
+    switch (elem_size) {
+        case 1:
+            unit__text_printf(text, "%02x", p[0]);
+            break;
+        case 2: {
+            uint16_t v;
+            memcpy(&v, p, 2);
+            unit__text_printf(text, "%04x", v);
+        }
+            break;
+        case 4: {
+            uint32_t v;
+            memcpy(&v, p, 4);
+            unit__text_printf(text, "%08x", v);
+        }
+            break;
+        case 8: {
+            uint64_t v;
+            memcpy(&v, p, 8);
+            unit__text_printf(text, "%016llx", (unsigned long long) v);
+        }
+            break;
+        default:
+            for (size_t i = 0; i < elem_size && i < 16; ++i) {
+                unit__text_printf(text, "%02x", p[i]);
+            }
+            if (elem_size > 16) {
+                unit__text_printf(text, "..");
+            }
+            break;
+    }
+}
+
+/**
+ * Prints one row of hex window, mismatched elements are highlighted
+ */
+static void unit__print_window_row(struct unit__text* text, const char* name, const unsigned char* p,
+                                   const unsigned char* other, size_t begin, size_t end, size_t elem_size) {
+    unit__text_printf(text, "\n    %s:", name);
+    for (size_t i = begin; i < end; ++i) {
+        const unsigned char* e = p + i * elem_size;
+        const bool diff = memcmp(e, other + i * elem_size, elem_size) != 0;
+        unit__text_printf(text, " %s", diff ? UNIT__MARK_FAIL_S : "");
+        unit__print_elem(text, e, elem_size);
+        unit__text_printf(text, "%s", diff ? UNIT__MARK_RESET_S : "");
+    }
+}
+
+void unit__assert_mem(const void* a, const void* b, size_t size, size_t elem_size, const char* sa, const char* sb) {
+    const unsigned char* pa = (const unsigned char*) a;
+    const unsigned char* pb = (const unsigned char*) b;
+    size_t offset = size;
+    if (pa != pb && size) {
+        offset = pa && pb ? unit__mismatch(pa, pb, size) : 0;
+    }
+    if (offset == size) {
+        unit__assert_pass();
+        return;
+    }
+    if (!pa || !pb) {
+        unit__fail_null(sa, sb, pa ? sb : sa, "==");
+        return;
+    }
+    if (elem_size == 0) {
+        elem_size = 1;
+    }
+    const size_t count = size / elem_size;
+    const size_t index = offset / elem_size;
+    const size_t mismatches = unit__count_mismatches(pa, pb, size, elem_size, index * elem_size);
+    const size_t window = elem_size == 1 ? 2 * UNIT__DIFF_WINDOW : UNIT__DIFF_WINDOW;
+    const size_t begin = index > window / 2 ? index - window / 2 : 0;
+    const size_t end = begin + window < count ? begin + window : count;
+
+    char buffer[2048];
+    struct unit__text text = {buffer, sizeof buffer, 0};
+    buffer[0] = 0;
+    unit__text_printf(&text, "Expected " UNIT__MARK_SUCCESS_S "`%s` == `%s`" UNIT__MARK_RESET_S ", but got " UNIT__MARK_FAIL_S,
+                      sa, sb);
+    if (elem_size == 1) {
+        unit__text_printf(&text, "%zu of %zu bytes differ, first at offset %zu", mismatches, size, offset);
+    } else {
+        unit__text_printf(&text, "%zu of %zu elements differ, first at index %zu (byte %zu)", mismatches, count,
+                          index, offset);
+    }
+    unit__text_printf(&text, UNIT__MARK_RESET_S "\n    [%zu..%zu)", begin, end);
+    unit__print_window_row(&text, sa, pa, pb, begin, end, elem_size);
+    unit__print_window_row(&text, sb, pb, pa, begin, end, elem_size);
+    unit__fail_text(buffer);
+}
+
+// endregion
+
+// region приближённое сравнение массивов чисел с плавающей точкой: `CHECK_ARRAY_NEAR`
+
+#ifndef UNIT_NEAR_WORST
+// number of the worst elements printed on failure
+#define UNIT_NEAR_WORST 5
+#endif
+
+// default tolerance if no one is set
+#define UNIT__NEAR_DEFAULT_ULPS 4
+
+struct unit__near_stats {
+    uint64_t max_ulps;
+    double max_rel;
+    size_t fails;
+};
+
+struct unit__near_elem {
+    size_t index;
+    uint64_t ulps;
+    double rel;
+};
+
+// distance in units in the last place: bits are mapped to ordered integers, so adjacent floats differ by 1,
+// the distance fits the unsigned integer of the same width as the floating type
+#define UNIT__IMPLEMENT_NEAR(Tag, Type, Int, UInt, Abs, Format) \
+/* branch-free: the sign-magnitude bits are mapped to the two's complement, so `-0` and `+0` are 0 ulps apart */ \
+static inline UInt unit__ulps_ ## Tag(Type x, Type y) { \
+    Int ix, iy; \
+    memcpy(&ix, &x, sizeof ix); \
+    memcpy(&iy, &y, sizeof iy); \
+    const Int magnitude = (Int) (((UInt) 1 << (8 * sizeof(Int) - 1)) - 1); \
+    const Int sx = ix >> (8 * sizeof(Int) - 1); \
+    const Int sy = iy >> (8 * sizeof(Int) - 1); \
+    const Int kx = (Int) (((UInt) (ix & magnitude) ^ (UInt) sx) - (UInt) sx); \
+    const Int ky = (Int) (((UInt) (iy & magnitude) ^ (UInt) sy) - (UInt) sy); \
+    const UInt lt = -(UInt) (kx < ky); \
+    return (((UInt) kx - (UInt) ky) ^ lt) - lt; \
+} \
+\
+static inline UInt unit__bits_ ## Tag(Type x) { \
+    UInt u; \
+    memcpy(&u, &x, sizeof u); \
+    return u; \
+} \
+\
+static inline Type unit__from_bits_ ## Tag(UInt u) { \
+    Type x; \
+    memcpy(&x, &u, sizeof x); \
+    return x; \
+} \
+\
+/* tolerances in the precision of compared elements, rounded down so the comparison is exact; */ \
+/* the relative one is kept as bits: not negative floats are ordered as their bits */ \
+struct unit__near_tol_ ## Tag { \
+    UInt ulps; \
+    UInt rel; \
+    Type abs; \
+}; \
+\
+/* the conversion rounds to nearest, so one step on the bits down to the adjacent float is enough */ \
+static Type unit__near_round_down_ ## Tag(double x) { \
+    const Type t = (Type) x; \
+    if (!((double) t > x)) { \
+        return t; \
+    } \
+    const UInt u = unit__bits_ ## Tag(t); \
+    const UInt sign = (UInt) 1 << (8 * sizeof(UInt) - 1); \
+    return unit__from_bits_ ## Tag(t > 0 ? u - 1 : (t < 0 ? u + 1 : sign | 1)); \
+} \
+\
+static struct unit__near_tol_ ## Tag unit__near_tol_ ## Tag(struct unit_tolerance tol) { \
+    struct unit__near_tol_ ## Tag t; \
+    t.ulps = (UInt) tol.ulps; \
+    /* a negative relative tolerance passes nothing beyond the equal elements, which pass by 0 ulps anyway */ \
+    t.rel = unit__bits_ ## Tag(unit__near_round_down_ ## Tag(tol.rel > 0.0 ? tol.rel : 0.0)); \
+    t.abs = unit__near_round_down_ ## Tag(tol.abs); \
+    return t; \
+} \
+\
+/* `ulps` is all ones for NaN against a number, `rel` is the bits of the relative error: never NaN nor negative */ \
+struct unit__near_result_ ## Tag { \
+    UInt ulps; \
+    UInt rel; \
+    UInt pass; \
+}; \
+\
+/* every condition is a lane mask and every value is computed unconditionally, */ \
+/* so the kernel inlined into a loop is if-converted and the loop is vectorized */ \
+static inline __attribute__((always_inline)) struct unit__near_result_ ## Tag \
+unit__near_elem_ ## Tag(Type x, Type y, struct unit__near_tol_ ## Tag tol) { \
+    const Type d = Abs(x - y); \
+    const Type ax = Abs(x); \
+    const Type ay = Abs(y); \
+    const Type q = d / (ax > ay ? ax : ay); \
+    const UInt x_nan = -(UInt) (x != x); \
+    const UInt y_nan = -(UInt) (y != y); \
+    const UInt both_nan = x_nan & y_nan; \
+    const UInt nan = x_nan ^ y_nan; \
+    const UInt same = both_nan | -(UInt) (x == y); \
+    const UInt inf = nan | -(UInt) (q != q); \
+    struct unit__near_result_ ## Tag r; \
+    r.ulps = ~both_nan & (nan | unit__ulps_ ## Tag(x, y)); \
+    r.rel = ~same & ((inf & unit__bits_ ## Tag((Type) __builtin_inf())) | (~inf & unit__bits_ ## Tag(q))); \
+    r.pass = (same | (~nan & -(UInt) (d <= tol.abs)) | -(UInt) (r.rel <= tol.rel) | -(UInt) (r.ulps <= tol.ulps)) & 1; \
+    return r; \
+} \
+\
+/* one flat pass with loop-local reductions, vectorized by the compiler: for `float` with SSE2 and NEON already, */ \
+/* for `double` where 64-bit lanes compare natively (SSE4.2, AVX2, AArch64 NEON) */ \
+static struct unit__near_stats unit__near_stats_ ## Tag(const Type* a, const Type* b, size_t n, struct unit_tolerance tol) { \
+    const struct unit__near_tol_ ## Tag t = unit__near_tol_ ## Tag(tol); \
+    UInt max_ulps = 0; \
+    UInt max_rel = 0; \
+    size_t fails = 0; \
+    for (size_t i = 0; i < n; ++i) { \
+        const struct unit__near_result_ ## Tag r = unit__near_elem_ ## Tag(a[i], b[i], t); \
+        fails += r.pass ^ 1; \
+        max_ulps = r.ulps > max_ulps ? r.ulps : max_ulps; \
+        max_rel = r.rel > max_rel ? r.rel : max_rel; \
+    } \
+    struct unit__near_stats stats; \
+    stats.max_ulps = max_ulps == (UInt) -1 ? UINT64_MAX : max_ulps; \
+    stats.max_rel = unit__from_bits_ ## Tag(max_rel); \
+    stats.fails = fails; \
+    return stats; \
+} \
+\
+void unit__assert_near_ ## Tag(const Type* a, const Type* b, size_t n, struct unit_tolerance tol, const char* sa, const char* sb) { \
+    if (!tol.ulps && tol.rel == 0.0 && tol.abs == 0.0) { \
+        tol.ulps = UNIT__NEAR_DEFAULT_ULPS; \
+    } \
+    struct unit__near_stats stats = {0, 0.0, 0}; \
+    if (a != b && n) { \
+        stats = a && b ? unit__near_stats_ ## Tag(a, b, n, tol) : (struct unit__near_stats) {UINT64_MAX, 0.0, n}; \
+    } \
+    if (!stats.fails) { \
+        unit__assert_pass(); \
+        return; \
+    } \
+    if (!a || !b) { \
+        unit__fail_null(sa, sb, a ? sb : sa, "~"); \
+        return; \
+    } \
+    /* the second pass only on failure: the worst elements sorted by ULP distance */ \
+    const struct unit__near_tol_ ## Tag t = unit__near_tol_ ## Tag(tol); \
+    struct unit__near_elem worst[UNIT_NEAR_WORST]; \
+    int worst_num = 0; \
+    for (size_t i = 0; i < n; ++i) { \
+        const struct unit__near_result_ ## Tag r = unit__near_elem_ ## Tag(a[i], b[i], t); \
+        const uint64_t ulps = r.ulps == (UInt) -1 ? UINT64_MAX : r.ulps; \
+        const double rel = unit__from_bits_ ## Tag(r.rel); \
+        if (r.pass || (worst_num == UNIT_NEAR_WORST && ulps <= worst[worst_num - 1].ulps)) { \
+            continue; \
+        } \
+        int j = worst_num < UNIT_NEAR_WORST ? worst_num++ : worst_num - 1; \
+        for (; j > 0 && worst[j - 1].ulps < ulps; --j) { \
+            worst[j] = worst[j - 1]; \
+        } \
+        worst[j] = (struct unit__near_elem) {i, ulps, rel}; \
+    } \
+    char buffer[2048]; \
+    struct unit__text text = {buffer, sizeof buffer, 0}; \
+    buffer[0] = 0; \
+    unit__text_printf(&text, "Expected " UNIT__MARK_SUCCESS_S "`%s` ~ `%s` (ulps %u, rel %g, abs %g)" UNIT__MARK_RESET_S \
+                      ", but got " UNIT__MARK_FAIL_S "%zu of %zu elements out of tolerance" UNIT__MARK_RESET_S \
+                      "\n    max error: %llu ulps, rel %g", sa, sb, tol.ulps, tol.rel, tol.abs, \
+                      stats.fails, n, (unsigned long long) stats.max_ulps, stats.max_rel); \
+    for (int i = 0; i < worst_num; ++i) { \
+        const size_t k = worst[i].index; \
+        unit__text_printf(&text, "\n    [%zu] " UNIT__MARK_FAIL_S Format " != " Format UNIT__MARK_RESET_S \
+                          " (%llu ulps, rel %g)", k, a[k], b[k], (unsigned long long) worst[i].ulps, worst[i].rel); \
+    } \
+    unit__fail_text(buffer); \
+}
+
+UNIT__IMPLEMENT_NEAR(flt, float, int32_t, uint32_t, __builtin_fabsf, "%.9g")
+UNIT__IMPLEMENT_NEAR(dbl, double, int64_t, uint64_t, __builtin_fabs, "%.17g")
+
+// endregion
+
+// region проверка диапазона одним утверждением: `CHECK_ALL`, `CHECK_ALL_EQ`
+
+/**
+ * Prints integer with thousands separators: `1,000,000`
+ */
+static void unit__format_count(struct unit__text* text, intmax_t x) {
+    char digits[32];
+    const int n = snprintf(digits, sizeof digits, "%jd", x);
+    const int sign = digits[0] == '-';
+    char buf[48];
+    int len = 0;
+    for (int i = 0; i < n; ++i) {
+        if (i > sign && (n - i) % 3 == 0) {
+            buf[len++] = ',';
+        }
+        buf[len++] = digits[i];
+    }
+    buf[len] = 0;
+    unit__text_printf(text, "%s", buf);
+}
+
+void unit__all_fail(struct unit__all* all, intmax_t index) {
+    if (all->samples < UNIT_ALL_SAMPLES) {
+        all->values[all->samples] = NULL;
+        all->index[all->samples++] = index;
+    }
+    ++all->fails;
+}
+
+#define UNIT__IMPLEMENT_MIXED_ALL_FAIL(Tag, TypeA, TypeB, Rel, Unary, ValueA, ValueB) \
+void unit__all_fail_ ## Tag(struct unit__all* all, intmax_t index, TypeA a, TypeB b) { \
+    const int k = all->samples; \
+    unit__all_fail(all, index); \
+    if (k < all->samples) { \
+        const struct unit__value va = unit__value_ ## ValueA(a); \
+        const struct unit__value vb = unit__value_ ## ValueB(b); \
+        char buffer[256]; \
+        struct unit__text text = {buffer, sizeof buffer, 0}; \
+        buffer[0] = 0; \
+        unit__format_value(&text, &va); \
+        unit__text_printf(&text, " != "); \
+        unit__format_value(&text, &vb); \
+        unit__fail_strfree(va.tag == UNIT__VALUE_STR ? va.s : NULL); \
+        unit__fail_strfree(vb.tag == UNIT__VALUE_STR ? vb.s : NULL); \
+        all->values[k] = unit__fail_strdup(buffer); \
+    } \
+}
+
+#define UNIT__IMPLEMENT_ALL_FAIL(Tag, Type, Rel, Unary) UNIT__IMPLEMENT_MIXED_ALL_FAIL(Tag, Type, Type, Rel, Unary, Tag, Tag)
+
+UNIT__FOR_ASSERTS(UNIT__IMPLEMENT_ALL_FAIL)
+UNIT__FOR_MIXED_ASSERTS(UNIT__IMPLEMENT_MIXED_ALL_FAIL)
+
+void unit__all_end(const struct unit__all* all, intmax_t begin, intmax_t end, const char* var, const char* expr) {
+    if (!all->fails) {
+        unit__assert_pass();
+        return;
+    }
+    char buffer[2048];
+    struct unit__text text = {buffer, sizeof buffer, 0};
+    buffer[0] = 0;
+    unit__text_printf(&text, "Expected " UNIT__MARK_SUCCESS_S "`%s` for all %s in [", expr, var);
+    unit__format_count(&text, begin);
+    unit__text_printf(&text, ", ");
+    unit__format_count(&text, end);
+    unit__text_printf(&text, ")" UNIT__MARK_RESET_S ", but got " UNIT__MARK_FAIL_S);
+    unit__format_count(&text, all->fails);
+    unit__text_printf(&text, " of ");
+    unit__format_count(&text, end - begin);
+    unit__text_printf(&text, " failed, first at %s=%jd" UNIT__MARK_RESET_S, var, all->index[0]);
+    for (int i = 0; i < all->samples; ++i) {
+        if (all->values[i]) {
+            unit__text_printf(&text, "\n    %s=%jd: " UNIT__MARK_FAIL_S "%s" UNIT__MARK_RESET_S, var, all->index[i],
+                              all->values[i]);
+        } else {
+            unit__text_printf(&text, "%s%jd", i ? ", " : "\n    failed at: ", all->index[i]);
+        }
+    }
+    if (all->fails > all->samples) {
+        unit__text_printf(&text, "%s...", all->values[0] ? "\n    " : ", ");
+    }
+    for (int i = 0; i < all->samples; ++i) {
+        unit__fail_strfree(all->values[i]);
+    }
+    unit__fail_text(buffer);
+}
+
+// endregion
@@ -0,0 +1,254 @@
+#ifdef UNIT__HAS_CRASH_RECOVERY
+
+#include <signal.h>
+
+#if defined(__has_include)
+#if __has_include(<execinfo.h>)
+
+#include <execinfo.h>
+
+#define UNIT__CRASH_BACKTRACE 1
+
+#endif // <execinfo.h>
+#endif // __has_include
+
+#endif // UNIT__HAS_CRASH_RECOVERY
+
+// region восстановление после падения теста: `--catch-crashes`, переход к следующему тесту без перезапуска процесса
+
+#ifndef UNIT_CRASH_NODES
+// maximum nesting of recovery points, crash in deeper node is recovered by its parent
+#define UNIT_CRASH_NODES 32
+#endif
+
+#ifndef UNIT_CRASH_FRAMES
+// maximum number of frames in the crash backtrace
+#define UNIT_CRASH_FRAMES 32
+#endif
+
+#ifndef UNIT_CRASH_STACK
+// size of alternate signal stack, so stack overflow is recovered too
+#define UNIT_CRASH_STACK (64 * 1024)
+#endif
+
+// nodes are ended without fixtures while recovery unwinds them to the recovery point
+static bool unit__crash_unwinding = false;
+
+#ifdef UNIT__HAS_CRASH_RECOVERY
+
+static const int unit__crash_signals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+#define UNIT__CRASH_SIGNALS_NUM ((int) (sizeof unit__crash_signals / sizeof unit__crash_signals[0]))
+
+struct unit__crash_point {
+    sigjmp_buf jmp;
+    // node which armed the point, cleared at the node end, so returned frames are never used
+    struct unit_test* node;
+};
+
+static struct unit__crash_point unit__crash_points[UNIT_CRASH_NODES];
+// point for too deep nodes and runs without `--catch-crashes`, it is never armed
+static sigjmp_buf unit__crash_unused;
+static struct sigaction unit__crash_prev_actions[UNIT__CRASH_SIGNALS_NUM];
+static stack_t unit__crash_prev_stack;
+static char unit__crash_stack[UNIT_CRASH_STACK];
+static bool unit__crash_installed = false;
+
+// written by the signal handler before the jump
+static volatile sig_atomic_t unit__crash_recovering = 0;
+// node of the recovery point the crash jumped to, the crash is reported when the node ends
+static struct unit_test* unit__crash_jumped = NULL;
+static int unit__crash_sig;
+static void* unit__crash_addr;
+static void* unit__crash_frames[UNIT_CRASH_FRAMES];
+static int unit__crash_frames_num;
+
+// prints events pending in the reporter thread, see `async.c`
+static void unit__async_crash_drain(void);
+
+static int unit__node_depth(const struct unit_test* unit) {
+    int depth = 0;
+    for (; unit->parent; unit = unit->parent) {
+        ++depth;
+    }
+    return depth;
+}
+
+sigjmp_buf* unit__crash_point(struct unit_test* unit) {
+    if (!unit__opts.catch_crashes) {
+        return &unit__crash_unused;
+    }
+    const int depth = unit__node_depth(unit);
+    if (depth >= UNIT_CRASH_NODES) {
+        return &unit__crash_unused;
+    }
+    unit__crash_points[depth].node = unit;
+    return &unit__crash_points[depth].jmp;
+}
+
+static void unit__crash_disarm(struct unit_test* unit) {
+    const int depth = unit__node_depth(unit);
+    if (depth < UNIT_CRASH_NODES && unit__crash_points[depth].node == unit) {
+        unit__crash_points[depth].node = NULL;
+    }
+}
+
+static void unit__crash_handler(int sig, siginfo_t* info, void* context) {
+    (void) context;
+    struct unit__crash_point* point = NULL;
+    // jump is possible only to the frame of the same thread
+    if (unit__tls.owner && !unit__crash_recovering) {
+        for (struct unit_test* n = unit_cur; n && !point; n = n->parent) {
+            const int depth = unit__node_depth(n);
+            if (depth < UNIT_CRASH_NODES && unit__crash_points[depth].node == n) {
+                point = unit__crash_points + depth;
+            }
+        }
+    }
+    if (!point) {
+        // not recoverable: the default action is taken when the handler returns
+        unit__async_crash_drain();
+        unit__output_crash_drain();
+        struct sigaction action = {0};
+        action.sa_handler = SIG_DFL;
+        sigemptyset(&action.sa_mask);
+        sigaction(sig, &action, NULL);
+        raise(sig);
+        return;
+    }
+    unit__crash_sig = sig;
+    unit__crash_addr = info ? info->si_addr : NULL;
+#ifdef UNIT__CRASH_BACKTRACE
+    unit__crash_frames_num = backtrace(unit__crash_frames, UNIT_CRASH_FRAMES);
+#else
+    unit__crash_frames_num = 0;
+#endif
+    unit__crash_recovering = 1;
+    unit__crash_jumped = point->node;
+    siglongjmp(point->jmp, 1);
+}
+
+static const char* unit__signal_name(int sig) {
+    switch (sig) {
+        case SIGSEGV:
+            return "SIGSEGV";
+        case SIGBUS:
+            return "SIGBUS";
+        case SIGFPE:
+            return "SIGFPE";
+        case SIGILL:
+            return "SIGILL";
+        case SIGABRT:
+            return "SIGABRT";
+    }
+    return "signal";
+}
+
+static void unit__crash_report(struct unit_test* crashed) {
+    static struct unit__assert_site site;
+    site.level = UNIT__LEVEL_CHECK;
+    site.file = crashed->file;
+    site.line = crashed->line;
+    site.comment = "";
+    site.desc = "crash";
+    unit__tls.site = &site;
+
+    char buffer[4096];
+    struct unit__text text = {buffer, sizeof buffer, 0};
+    buffer[0] = 0;
+    unit__text_printf(&text, "Crashed with " UNIT__MARK_FAIL_S "%s" UNIT__MARK_RESET_S " (%d) at address %p",
+                      unit__signal_name(unit__crash_sig), unit__crash_sig, unit__crash_addr);
+#ifdef UNIT__CRASH_BACKTRACE
+    // skip signal handler and signal trampoline frames
+    const int skip = 2;
+    if (unit__crash_frames_num > skip) {
+        char** symbols = backtrace_symbols(unit__crash_frames + skip, unit__crash_frames_num - skip);
+        for (int i = 0; symbols && i < unit__crash_frames_num - skip; ++i) {
+            unit__text_printf(&text, "\n    #%d %s", i, symbols[i]);
+        }
+        free(symbols);
+    }
+#endif // UNIT__CRASH_BACKTRACE
+    unit__fail_text(buffer);
+}
+
+/**
+ * Continues after the jump to the recovery point of `unit`: reports the crash and ends nested nodes,
+ * the `unit` node itself is ended by the caller
+ */
+static void unit__crash_recover(struct unit_test* unit) {
+    struct unit_test* crashed = unit_cur;
+    unit__prop_crashed();
+    unit__crash_report(crashed);
+    unit__crash_unwinding = true;
+    while (unit_cur && unit_cur != unit) {
+        unit__end(unit_cur);
+    }
+    unit__crash_unwinding = false;
+    unit__crash_recovering = 0;
+}
+
+// called by `unit__end` first: the body of the jumped node was skipped by the recovery point
+static void unit__crash_land(struct unit_test* unit) {
+    if (unit__crash_jumped == unit) {
+        unit__crash_jumped = NULL;
+        unit__crash_recover(unit);
+    }
+}
+
+static void unit__crash_install(void) {
+    if (unit__crash_installed) {
+        return;
+    }
+#ifdef UNIT__CRASH_BACKTRACE
+    // `backtrace` loads unwinder lazily on the first call, it should not happen inside signal handler
+    void* warmup[1];
+    backtrace(warmup, 1);
+#endif // UNIT__CRASH_BACKTRACE
+    stack_t stack = {0};
+    stack.ss_sp = unit__crash_stack;
+    stack.ss_size = sizeof unit__crash_stack;
+    sigaltstack(&stack, &unit__crash_prev_stack);
+
+    struct sigaction action = {0};
+    action.sa_sigaction = unit__crash_handler;
+    action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+    sigemptyset(&action.sa_mask);
+    for (int i = 0; i < UNIT__CRASH_SIGNALS_NUM; ++i) {
+        sigaction(unit__crash_signals[i], &action, unit__crash_prev_actions + i);
+    }
+    unit__crash_installed = true;
+}
+
+static void unit__crash_uninstall(void) {
+    if (!unit__crash_installed) {
+        return;
+    }
+    for (int i = 0; i < UNIT__CRASH_SIGNALS_NUM; ++i) {
+        sigaction(unit__crash_signals[i], unit__crash_prev_actions + i, NULL);
+    }
+    sigaltstack(&unit__crash_prev_stack, NULL);
+    unit__crash_installed = false;
+}
+
+#else // UNIT__HAS_CRASH_RECOVERY
+
+static void unit__crash_disarm(struct unit_test* unit) {
+    (void) unit;
+}
+
+static void unit__crash_land(struct unit_test* unit) {
+    (void) unit;
+}
+
+static void unit__crash_install(void) {
+    if (!unit__opts.quiet) {
+        fputs("unit: warning: crash recovery is not supported on this platform\n", stderr);
+    }
+}
+
+static void unit__crash_uninstall(void) {
+}
+
+#endif // !UNIT__HAS_CRASH_RECOVERY
+
+// endregion
@@ -0,0 +1,85 @@
+// region самые медленные тесты: `--durations=N`, ограниченные min-heap без выделения памяти на каждый узел
+
+#ifndef UNIT_DURATIONS_MAX
+// maximum number of reported slowest tests and suites
+#define UNIT_DURATIONS_MAX 64
+#endif
+
+// min-heap by elapsed time: the root is the fastest of kept nodes, it is replaced by a slower node
+struct unit__durations {
+    struct unit_test* nodes[UNIT_DURATIONS_MAX];
+    int num;
+};
+
+static struct unit__durations unit__slowest_tests;
+static struct unit__durations unit__slowest_suites;
+
+static void unit__durations_push(struct unit__durations* heap, int limit, struct unit_test* node) {
+    struct unit_test** h = heap->nodes;
+    int i;
+    if (heap->num < limit) {
+        i = heap->num++;
+        while (i > 0 && node->elapsed < h[(i - 1) / 2]->elapsed) {
+            h[i] = h[(i - 1) / 2];
+            i = (i - 1) / 2;
+        }
+        h[i] = node;
+        return;
+    }
+    if (heap->num == 0 || node->elapsed <= h[0]->elapsed) {
+        return;
+    }
+    i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= heap->num) {
+            break;
+        }
+        if (child + 1 < heap->num && h[child + 1]->elapsed < h[child]->elapsed) {
+            ++child;
+        }
+        if (h[child]->elapsed >= node->elapsed) {
+            break;
+        }
+        h[i] = h[child];
+        i = child;
+    }
+    h[i] = node;
+}
+
+// copies kept nodes to `out` starting from the slowest one, returns the number of nodes
+static int unit__durations_sorted(const struct unit__durations* heap, struct unit_test** out) {
+    for (int i = 0; i < heap->num; ++i) {
+        struct unit_test* node = heap->nodes[i];
+        int j = i;
+        for (; j > 0 && out[j - 1]->elapsed < node->elapsed; --j) {
+            out[j] = out[j - 1];
+        }
+        out[j] = node;
+    }
+    return heap->num;
+}
+
+static void printer_durations(int cmd, struct unit_test* node, const char* msg) {
+    (void) msg;
+    const int limit = unit__opts.durations < UNIT_DURATIONS_MAX ? unit__opts.durations : UNIT_DURATIONS_MAX;
+    switch (cmd) {
+        case UNIT__PRINTER_SETUP:
+            unit__slowest_tests.num = 0;
+            unit__slowest_suites.num = 0;
+            break;
+        case UNIT__PRINTER_END:
+            if (node->status == UNIT_STATUS_SKIPPED) {
+                break;
+            }
+            if (node->type == UNIT__TYPE_TEST) {
+                unit__durations_push(&unit__slowest_tests, limit, node);
+            }
+            if (!node->parent) {
+                unit__durations_push(&unit__slowest_suites, limit, node);
+            }
+            break;
+    }
+}
+
+// endregion
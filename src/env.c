@@ -0,0 +1,191 @@
+#ifdef __linux__
+
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#endif // __linux__
+
+// region окружение запуска: привязка к CPU, governor, шум таймера
+
+#ifndef UNIT_ENV_MAX_JITTER
+// maximum allowed relative interquartile range of calibration loop timings
+#define UNIT_ENV_MAX_JITTER 0.05
+#endif
+
+#define UNIT__ENV_SAMPLES 21
+#define UNIT__ENV_MAX_CPUS 1024
+
+struct unit_env {
+    // requested cpu list from `--cpus=`, empty if process is not pinned
+    char cpus[64];
+    // number of CPUs in the effective affinity set, 0 if unknown
+    int cpus_count;
+    // `scaling_governor` shared by the CPUs, "mixed" or "unknown"
+    char governor[32];
+    // median time of calibration loop, nanoseconds, 0 if the environment is not measured
+    int64_t calibration;
+    // relative interquartile range of calibration loop timings
+    double jitter;
+    // the first reason why environment is not suitable for benchmarking, NULL if suitable
+    const char* issue;
+};
+
+struct unit_env unit__env;
+
+static unsigned long unit__env_mask[UNIT__ENV_MAX_CPUS / (8 * sizeof(unsigned long))];
+
+static int unit__env_parse_cpus(const char* list, unsigned long* mask, int max_cpus) {
+    int count = 0;
+    const char* p = list;
+    while (p && *p) {
+        char* end;
+        const long first = strtol(p, &end, 10);
+        long last = first;
+        if (end == p || first < 0) {
+            return -1;
+        }
+        p = end;
+        if (*p == '-') {
+            ++p;
+            last = strtol(p, &end, 10);
+            if (end == p || last < first) {
+                return -1;
+            }
+            p = end;
+        }
+        if (*p == ',') {
+            ++p;
+        } else if (*p) {
+            return -1;
+        }
+        for (long cpu = first; cpu <= last && cpu < max_cpus; ++cpu) {
+            const int bits = (int) (8 * sizeof mask[0]);
+            if (!(mask[cpu / bits] & (1ul << (cpu % bits)))) {
+                mask[cpu / bits] |= 1ul << (cpu % bits);
+                ++count;
+            }
+        }
+    }
+    return count;
+}
+
+static const char* unit__env_pin(const char* list) {
+    unsigned long* mask = unit__env_mask;
+    memset(unit__env_mask, 0, sizeof unit__env_mask);
+    const int count = unit__env_parse_cpus(list, mask, UNIT__ENV_MAX_CPUS);
+    if (count <= 0) {
+        return "invalid `--cpus` list";
+    }
+    unit__env.cpus_count = count;
+#ifdef __linux__
+    if (syscall(SYS_sched_setaffinity, 0, sizeof unit__env_mask, mask) != 0) {
+        return "unable to set CPU affinity";
+    }
+    return NULL;
+#else // __linux__
+    return "CPU affinity is not supported on this platform";
+#endif // !__linux__
+}
+
+static int unit__env_cpu_pinned(int cpu) {
+    if (!unit__env.cpus_count || !unit__env.cpus[0]) {
+        return 1;
+    }
+    const int bits = (int) (8 * sizeof unit__env_mask[0]);
+    return (unit__env_mask[cpu / bits] & (1ul << (cpu % bits))) != 0;
+}
+
+static void unit__env_read_governor(void) {
+    strcpy(unit__env.governor, "unknown");
+    bool found = false;
+    for (int cpu = 0; cpu < UNIT__ENV_MAX_CPUS; ++cpu) {
+        char path[96];
+        snprintf(path, sizeof path, "/sys/devices/system/cpu/cpu%d/cpufreq/scaling_governor", cpu);
+        FILE* f = fopen(path, "r");
+        if (!f) {
+            // CPUs are enumerated sequentially
+            break;
+        }
+        char governor[32] = {0};
+        if (fgets(governor, sizeof governor, f)) {
+            governor[strcspn(governor, "\r\n")] = 0;
+        }
+        fclose(f);
+        if (!unit__env_cpu_pinned(cpu)) {
+            continue;
+        }
+        if (!found) {
+            strcpy(unit__env.governor, governor);
+            found = true;
+        } else if (strcmp(unit__env.governor, governor) != 0) {
+            strcpy(unit__env.governor, "mixed");
+        }
+    }
+}
+
+static int unit__env_cmp_time(const void* a, const void* b) {
+    const int64_t x = *(const int64_t*) a;
+    const int64_t y = *(const int64_t*) b;
+    return x < y ? -1 : (x > y ? 1 : 0);
+}
+
+static void unit__env_calibrate(void) {
+    int64_t samples[UNIT__ENV_SAMPLES];
+    volatile unsigned acc = 0;
+    for (int i = 0; i < UNIT__ENV_SAMPLES; ++i) {
+        const int64_t t0 = unit__clock.now();
+        for (unsigned j = 0; j < 100000; ++j) {
+            acc = acc * 1664525u + 1013904223u;
+        }
+        samples[i] = unit__clock.now() - t0;
+    }
+    qsort(samples, UNIT__ENV_SAMPLES, sizeof samples[0], unit__env_cmp_time);
+    const int64_t q1 = samples[UNIT__ENV_SAMPLES / 4];
+    const int64_t median = samples[UNIT__ENV_SAMPLES / 2];
+    const int64_t q3 = samples[3 * UNIT__ENV_SAMPLES / 4];
+    unit__env.calibration = median;
+    // interquartile range is not affected by single preemption spikes
+    unit__env.jitter = median > 0 ? (double) (q3 - q1) / (double) median : 0.0;
+}
+
+/**
+ * Pins the runner to `--cpus`, captures frequency governor and timer jitter.
+ * Returns false if environment is not suitable for benchmarking and `--strict-env` is set.
+ */
+static bool unit__env_setup(void) {
+    unit__env = (struct unit_env) {0};
+    strcpy(unit__env.governor, "unknown");
+    if (unit__opts.cpus && unit__opts.cpus[0]) {
+        snprintf(unit__env.cpus, sizeof unit__env.cpus, "%s", unit__opts.cpus);
+        unit__env.issue = unit__env_pin(unit__opts.cpus);
+    }
+#ifdef __linux__
+    if (!unit__env.cpus_count) {
+        unit__env.cpus_count = (int) sysconf(_SC_NPROCESSORS_ONLN);
+    }
+#endif // __linux__
+    const bool benchmarking = unit__env.cpus[0] || unit__opts.strict_env;
+    if (!benchmarking && !unit__opts.env) {
+        // the governor scan and the calibration loop are not paid by regular runs
+        return true;
+    }
+    unit__env_read_governor();
+    unit__env_calibrate();
+
+    if (!unit__env.issue && strcmp(unit__env.governor, "performance") != 0 &&
+        strcmp(unit__env.governor, "unknown") != 0) {
+        unit__env.issue = "CPU frequency governor is not `performance`";
+    }
+    if (!unit__env.issue && unit__env.jitter > UNIT_ENV_MAX_JITTER) {
+        unit__env.issue = "calibration loop jitter is too high";
+    }
+
+    if (unit__env.issue && benchmarking && !unit__opts.quiet) {
+        fprintf(stderr, "unit: %s: %s (governor: %s, jitter: %0.2f%%)\n",
+                unit__opts.strict_env ? "error" : "warning", unit__env.issue,
+                unit__env.governor, 100.0 * unit__env.jitter);
+    }
+    return !(unit__env.issue && unit__opts.strict_env);
+}
+
+// endregion
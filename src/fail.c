@@ -0,0 +1,348 @@
+// region записи об ошибках: типизированные значения, форматируются каждым принтером по необходимости
+
+#ifndef UNIT_FAIL_RECORDS
+// maximum number of failure records stored for the single test, the last record is reused on overflow
+#define UNIT_FAIL_RECORDS 16
+#endif
+
+#ifndef UNIT_FAIL_TEXT
+// capacity of the per-test arena for copied string operands and bulk assertion details
+#define UNIT_FAIL_TEXT 16384
+#endif
+
+// style markers in formatted failure text: printers replace them with colors or strip them
+#define UNIT__MARK_SUCCESS '\x01'
+#define UNIT__MARK_FAIL '\x02'
+#define UNIT__MARK_RESET '\x03'
+#define UNIT__MARK_SUCCESS_S "\x01"
+#define UNIT__MARK_FAIL_S "\x02"
+#define UNIT__MARK_RESET_S "\x03"
+
+// operands are stored widened, the tag keeps the original precision for formatting
+enum {
+    UNIT__VALUE_INT = 0,
+    UNIT__VALUE_UINT = 1,
+    UNIT__VALUE_FLT = 2,
+    UNIT__VALUE_DBL = 3,
+    UNIT__VALUE_LDBL = 4,
+    UNIT__VALUE_PTR = 5,
+    UNIT__VALUE_STR = 6
+};
+
+struct unit__value {
+    int tag;
+    union {
+        intmax_t i;
+        uintmax_t u;
+        long double d;
+        const void* p;
+        const char* s;
+    };
+};
+
+enum {
+    // binary or unary comparison of two values
+    UNIT__FAIL_COMPARE = 0,
+    // pre-formatted details of bulk assertion
+    UNIT__FAIL_TEXT = 1
+};
+
+struct unit__fail_record {
+    int kind;
+    int op;
+    const struct unit__assert_site* site;
+    // stringified operand expressions
+    const char* sa;
+    const char* sb;
+    struct unit__value a;
+    struct unit__value b;
+    // marked text of `UNIT__FAIL_TEXT` record, stored in the arena
+    const char* text;
+};
+
+static struct unit__fail_record unit__fail_pool[UNIT_FAIL_RECORDS];
+static int unit__fail_pool_num = 0;
+static char unit__fail_arena[UNIT_FAIL_TEXT];
+static size_t unit__fail_arena_len = 0;
+
+static const char* unit__op_expl[] = {
+        " is true",
+        " is false",
+        " == ",
+        " != ",
+        " < ",
+        " <= ",
+        " > ",
+        " >= ",
+};
+
+static const char* unit__op_nexpl[] = {
+        " is not true",
+        " is not false",
+        " != ",
+        " == ",
+        " >= ",
+        " > ",
+        " <= ",
+        " < ",
+};
+
+// records of other threads are queued with their strings in the heap, they are freed when the queue is drained
+struct unit__fail_node {
+    struct unit__fail_record record;
+    struct unit__fail_node* next;
+};
+
+// the record of other thread when the heap is exhausted: it's not queued, but the failed level is still set
+static __thread struct unit__fail_node unit__fail_lost;
+// the string copy of other thread when the heap is exhausted
+static char unit__fail_lost_str[1];
+
+// lock-free stack of failures from other threads, drained by the tests thread at the node end
+static struct unit__fail_node* unit__fail_queue = NULL;
+
+// records are valid until the next test begins
+static void unit__fail_pool_reset(void) {
+    unit__fail_pool_num = 0;
+    unit__fail_arena_len = 0;
+}
+
+static struct unit__fail_record* unit__fail_alloc(int kind) {
+    struct unit__fail_record* r;
+    if (!unit__tls.owner) {
+        struct unit__fail_node* node = (struct unit__fail_node*) malloc(sizeof *node);
+        r = &(node ? node : &unit__fail_lost)->record;
+    } else if (unit__fail_pool_num < UNIT_FAIL_RECORDS) {
+        r = unit__fail_pool + unit__fail_pool_num++;
+    } else {
+        r = unit__fail_pool + UNIT_FAIL_RECORDS - 1;
+    }
+    memset(r, 0, sizeof *r);
+    r->kind = kind;
+    r->site = unit__tls.site;
+    return r;
+}
+
+/**
+ * Copies string to the per-test arena, truncates it if the arena is full.
+ * Other threads copy to the heap, strings are moved to the per-test arena when the queue is drained.
+ */
+static const char* unit__fail_strdup(const char* str) {
+    if (!unit__tls.owner && str) {
+        const size_t size = strlen(str) + 1;
+        char* copy = (char*) malloc(size);
+        return copy ? (const char*) memcpy(copy, str, size) : unit__fail_lost_str;
+    }
+    const size_t available = sizeof unit__fail_arena - unit__fail_arena_len;
+    if (!str || available == 0) {
+        return str ? "" : NULL;
+    }
+    size_t len = strlen(str);
+    if (len >= available) {
+        len = available - 1;
+    }
+    char* copy = unit__fail_arena + unit__fail_arena_len;
+    memcpy(copy, str, len);
+    copy[len] = 0;
+    unit__fail_arena_len += len + 1;
+    return copy;
+}
+
+/**
+ * Frees the string copied by other thread, copies of the tests thread are in the per-test arena
+ */
+static void unit__fail_strfree(const char* str) {
+    if (!unit__tls.owner && str != unit__fail_lost_str) {
+        free((void*) str);
+    }
+}
+
+static void unit__fail_free(struct unit__fail_node* node) {
+    const struct unit__fail_record* r = &node->record;
+    const char* strs[] = {r->a.tag == UNIT__VALUE_STR ? r->a.s : NULL, r->b.tag == UNIT__VALUE_STR ? r->b.s : NULL, r->text};
+    for (size_t i = 0; i < sizeof strs / sizeof *strs; ++i) {
+        if (strs[i] != unit__fail_lost_str) {
+            free((void*) strs[i]);
+        }
+    }
+    if (node != &unit__fail_lost) {
+        free(node);
+    }
+}
+
+static void unit__fail_post(struct unit__fail_record* record) {
+    struct unit__fail_node* node = (struct unit__fail_node*) record;
+    if (node == &unit__fail_lost) {
+        unit__fail_free(node);
+        return;
+    }
+    node->next = __atomic_load_n(&unit__fail_queue, __ATOMIC_RELAXED);
+    while (!__atomic_compare_exchange_n(&unit__fail_queue, &node->next, node, true, __ATOMIC_RELEASE,
+                                        __ATOMIC_RELAXED)) {
+    }
+}
+
+/**
+ * Takes all queued records in posting order
+ */
+static struct unit__fail_node* unit__fail_take(void) {
+    struct unit__fail_node* node = __atomic_exchange_n(&unit__fail_queue, NULL, __ATOMIC_ACQUIRE);
+    struct unit__fail_node* list = NULL;
+    while (node) {
+        struct unit__fail_node* next = node->next;
+        node->next = list;
+        list = node;
+        node = next;
+    }
+    return list;
+}
+
+/**
+ * Copies queued record to the pool of the tests thread
+ */
+static struct unit__fail_record* unit__fail_adopt(const struct unit__fail_record* queued) {
+    struct unit__fail_record* r = unit__fail_alloc(queued->kind);
+    *r = *queued;
+    if (r->a.tag == UNIT__VALUE_STR) {
+        r->a.s = unit__fail_strdup(r->a.s);
+    }
+    if (r->b.tag == UNIT__VALUE_STR) {
+        r->b.s = unit__fail_strdup(r->b.s);
+    }
+    r->text = unit__fail_strdup(r->text);
+    return r;
+}
+
+#define UNIT__VALUE(Tag, Type, Member, TagId) \
+static struct unit__value unit__value_ ## Tag(Type x) { \
+    struct unit__value v; \
+    v.tag = TagId; \
+    v.Member = x; \
+    return v; \
+}
+
+UNIT__VALUE(int, int, i, UNIT__VALUE_INT)
+UNIT__VALUE(uint, unsigned int, u, UNIT__VALUE_UINT)
+UNIT__VALUE(long, long, i, UNIT__VALUE_INT)
+UNIT__VALUE(ulong, unsigned long, u, UNIT__VALUE_UINT)
+UNIT__VALUE(llong, long long, i, UNIT__VALUE_INT)
+UNIT__VALUE(ullong, unsigned long long, u, UNIT__VALUE_UINT)
+UNIT__VALUE(flt, float, d, UNIT__VALUE_FLT)
+UNIT__VALUE(dbl, double, d, UNIT__VALUE_DBL)
+UNIT__VALUE(ldbl, long double, d, UNIT__VALUE_LDBL)
+UNIT__VALUE(ptr, const void*, p, UNIT__VALUE_PTR)
+UNIT__VALUE(imax, intmax_t, i, UNIT__VALUE_INT)
+UNIT__VALUE(umax, uintmax_t, u, UNIT__VALUE_UINT)
+
+static struct unit__value unit__value_str(const char* x) {
+    struct unit__value v;
+    v.tag = UNIT__VALUE_STR;
+    // operand could be freed right after the assertion
+    v.s = unit__fail_strdup(x);
+    return v;
+}
+
+struct unit__text {
+    char* data;
+    size_t cap;
+    size_t len;
+};
+
+__attribute__((format(printf, 2, 3)))
+static void unit__text_printf(struct unit__text* text, const char* fmt, ...) {
+    if (text->len + 1 >= text->cap) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    const int n = vsnprintf(text->data + text->len, text->cap - text->len, fmt, args);
+    va_end(args);
+    if (n > 0) {
+        text->len += (size_t) n;
+        if (text->len >= text->cap) {
+            text->len = text->cap - 1;
+        }
+    }
+}
+
+/**
+ * Prints the shortest representation which is parsed back to the same value
+ */
+static void unit__format_real(struct unit__text* text, long double x, int tag) {
+    char buf[64];
+    const int max_digits = tag == UNIT__VALUE_FLT ? 9 : (tag == UNIT__VALUE_DBL ? 17 : 21);
+    for (int digits = 6; digits <= max_digits; ++digits) {
+        snprintf(buf, sizeof buf, "%.*Lg", digits, x);
+        const bool exact = tag == UNIT__VALUE_FLT ? strtof(buf, NULL) == (float) x :
+                           (tag == UNIT__VALUE_DBL ? strtod(buf, NULL) == (double) x : strtold(buf, NULL) == x);
+        if (exact) {
+            break;
+        }
+    }
+    unit__text_printf(text, "%s", buf);
+}
+
+static void unit__format_value(struct unit__text* text, const struct unit__value* v) {
+    switch (v->tag) {
+        case UNIT__VALUE_INT:
+            unit__text_printf(text, "%jd", v->i);
+            break;
+        case UNIT__VALUE_UINT:
+            unit__text_printf(text, "%ju", v->u);
+            break;
+        case UNIT__VALUE_FLT:
+        case UNIT__VALUE_DBL:
+        case UNIT__VALUE_LDBL:
+            unit__format_real(text, v->d, v->tag);
+            break;
+        case UNIT__VALUE_PTR:
+            unit__text_printf(text, "%p", v->p);
+            break;
+        case UNIT__VALUE_STR:
+            unit__text_printf(text, "%s", v->s ? v->s : "(null)");
+            break;
+    }
+}
+
+/**
+ * Formats failure message with style markers
+ */
+static void unit__format_fail(struct unit__text* text, const struct unit__fail_record* r) {
+    if (r->kind == UNIT__FAIL_TEXT) {
+        unit__text_printf(text, "%s", r->text);
+        return;
+    }
+    const char* expl = unit__op_expl[r->op];
+    const char* nexpl = unit__op_nexpl[r->op];
+    if (r->op < UNIT__OP_EQ) {
+        unit__text_printf(text, "Expected " UNIT__MARK_SUCCESS_S "`%s`%s" UNIT__MARK_RESET_S ", but got "
+                                UNIT__MARK_FAIL_S "`", r->sb, expl);
+        unit__format_value(text, &r->b);
+        unit__text_printf(text, "%s`" UNIT__MARK_RESET_S, nexpl);
+    } else {
+        unit__text_printf(text, "Expected " UNIT__MARK_SUCCESS_S "`%s`%s`%s`" UNIT__MARK_RESET_S ", but got "
+                                UNIT__MARK_FAIL_S "`", r->sa, expl, r->sb);
+        unit__format_value(text, &r->a);
+        unit__text_printf(text, "%s", nexpl);
+        unit__format_value(text, &r->b);
+        unit__text_printf(text, "`" UNIT__MARK_RESET_S);
+    }
+}
+
+/**
+ * Formats failure message as plain text without style markers
+ */
+static void unit__format_fail_plain(char* buffer, size_t size, const struct unit__fail_record* r) {
+    struct unit__text text = {buffer, size, 0};
+    buffer[0] = 0;
+    unit__format_fail(&text, r);
+    char* out = buffer;
+    for (const char* p = buffer; *p; ++p) {
+        if (*p != UNIT__MARK_SUCCESS && *p != UNIT__MARK_FAIL && *p != UNIT__MARK_RESET) {
+            *(out++) = *p;
+        }
+    }
+    *out = 0;
+}
+
+// endregion
@@ -0,0 +1,448 @@
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define UNIT__LOG_MMAP 1
+
+#endif // unix && !__EMSCRIPTEN__
+
+// region бинарный журнал событий: `--events-out=run.ulog`, отчёты строятся из него позже утилитой `unit-report`
+
+#ifndef UNIT_EVENTS_LOG_CHUNK
+// initial size of the mapped events log file, it is doubled when the mapping is full
+#define UNIT_EVENTS_LOG_CHUNK (1024 * 1024)
+#endif
+
+#define UNIT__LOG_MAGIC "unit-log"
+#define UNIT__LOG_VERSION 1
+
+enum {
+    UNIT__LOG_HEADER = 0,
+    UNIT__LOG_STRING = 1,
+    UNIT__LOG_SETUP = 2,
+    UNIT__LOG_NODE = 3,
+    UNIT__LOG_BEGIN = 4,
+    UNIT__LOG_END = 5,
+    UNIT__LOG_RESOURCES = 6,
+    UNIT__LOG_ECHO = 7,
+    UNIT__LOG_FAIL = 8,
+    UNIT__LOG_ASSERTION = 9
+};
+
+// id of the last transient string: messages are referenced by the next event only, so they are not kept by readers
+#define UNIT__LOG_TRANSIENT 0xFFFFFFFFu
+
+/**
+ * Fixed-size record of the events log. Bytes of `UNIT__LOG_STRING` follow its record, padded to the record size.
+ * Strings and nodes are written once, events refer to them by id, id 0 is NULL
+ */
+struct unit__log_record {
+    uint16_t kind;
+    // node status on begin and end, assertion level on failure, node type on declaration, transient string flag
+    uint16_t status;
+    // node id, or string id of `UNIT__LOG_STRING`
+    uint32_t id;
+    // nanoseconds since the run start
+    int64_t ts;
+    union {
+        struct {
+            char magic[8];
+            uint32_t version;
+            uint32_t record_size;
+            // resources are sampled for each node
+            uint32_t resources;
+        } header;
+        struct {
+            uint32_t len;
+        } string;
+        struct {
+            uint32_t clock;
+            uint32_t governor;
+            uint32_t cpus;
+            int32_t cpus_count;
+            int64_t calibration;
+            int64_t overhead;
+            double jitter;
+        } setup;
+        struct {
+            uint32_t parent;
+            uint32_t name;
+            uint32_t file;
+            int32_t line;
+        } node;
+        struct {
+            int32_t passed;
+            int32_t total;
+            int64_t elapsed;
+            int64_t cpu_elapsed;
+            int64_t fixtures_elapsed;
+            int64_t assertions;
+            int64_t scratch_peak;
+        } end;
+        // also used by `UNIT__LOG_ASSERTION`, with assertion status and without text
+        struct {
+            uint32_t file;
+            uint32_t desc;
+            uint32_t comment;
+            uint32_t text;
+            int32_t line;
+            int32_t level;
+        } fail;
+        struct {
+            uint32_t text;
+        } echo;
+        struct unit_resources resources;
+    };
+};
+
+// open addressing table of interned node and string pointers
+struct unit__log_ids {
+    const void** keys;
+    uint32_t* ids;
+    uint32_t cap;
+    uint32_t num;
+};
+
+/**
+ * Serializes printer events to records, the same writer feeds the events log file and the asynchronous reporter
+ */
+struct unit__log_writer {
+    // sink of records, called only while the writer is active
+    void (* write)(struct unit__log_writer* writer, const void* data, size_t size);
+    struct unit__log_ids ids;
+    uint32_t nodes_num;
+    uint32_t strings_num;
+    int64_t t0;
+    bool active;
+};
+
+static struct unit__log_writer unit__log_file_writer;
+
+#ifdef UNIT__LOG_MMAP
+static int unit__log_fd = -1;
+static unsigned char* unit__log_data = NULL;
+static size_t unit__log_len = 0;
+static size_t unit__log_cap = 0;
+#else
+static FILE* unit__log_file = NULL;
+#endif // UNIT__LOG_MMAP
+
+static uint32_t unit__log_hash(const void* key, uint32_t cap) {
+    return (uint32_t) (((uintptr_t) key >> 3) * 0x9E3779B97F4A7C15ull >> 32) & (cap - 1);
+}
+
+/**
+ * Finds id slot of the pointer, the slot is 0 if the pointer is seen the first time.
+ * Slots are invalidated by the next call, NULL is returned if the table could not grow
+ */
+static uint32_t* unit__log_slot(struct unit__log_ids* table, const void* key) {
+    if (2 * (table->num + 1) > table->cap) {
+        const uint32_t cap = table->cap ? 2 * table->cap : 1024;
+        const void** keys = (const void**) calloc(cap, sizeof *keys);
+        uint32_t* ids = (uint32_t*) calloc(cap, sizeof *ids);
+        if (!keys || !ids) {
+            free(keys);
+            free(ids);
+            return NULL;
+        }
+        for (uint32_t i = 0; i < table->cap; ++i) {
+            if (table->keys[i]) {
+                uint32_t j = unit__log_hash(table->keys[i], cap);
+                while (keys[j]) {
+                    j = (j + 1) & (cap - 1);
+                }
+                keys[j] = table->keys[i];
+                ids[j] = table->ids[i];
+            }
+        }
+        free(table->keys);
+        free(table->ids);
+        table->keys = keys;
+        table->ids = ids;
+        table->cap = cap;
+    }
+    uint32_t i = unit__log_hash(key, table->cap);
+    while (table->keys[i] && table->keys[i] != key) {
+        i = (i + 1) & (table->cap - 1);
+    }
+    if (!table->keys[i]) {
+        table->keys[i] = key;
+        table->ids[i] = 0;
+        ++table->num;
+    }
+    return table->ids + i;
+}
+
+static void unit__log_ids_free(struct unit__log_ids* table) {
+    free(table->keys);
+    free(table->ids);
+    memset(table, 0, sizeof *table);
+}
+
+static void unit__log_writer_begin(struct unit__log_writer* writer) {
+    writer->nodes_num = 0;
+    writer->strings_num = 0;
+    writer->t0 = unit__clock.now();
+    writer->active = true;
+}
+
+static void unit__log_writer_end(struct unit__log_writer* writer) {
+    unit__log_ids_free(&writer->ids);
+    writer->active = false;
+}
+
+static void unit__log_write(struct unit__log_writer* writer, const void* data, size_t size) {
+    if (writer->active) {
+        writer->write(writer, data, size);
+    }
+}
+
+/**
+ * Writes the string record. Messages are transient: they are not interned and readers keep only the last one
+ */
+static uint32_t unit__log_put_string(struct unit__log_writer* writer, const char* str, bool transient) {
+    static const unsigned char zeros[sizeof(struct unit__log_record)] = {0};
+    if (!str) {
+        return 0;
+    }
+    struct unit__log_record r;
+    memset(&r, 0, sizeof r);
+    const size_t len = strlen(str);
+    r.kind = UNIT__LOG_STRING;
+    r.status = transient;
+    r.id = transient ? UNIT__LOG_TRANSIENT : ++writer->strings_num;
+    r.string.len = (uint32_t) len;
+    unit__log_write(writer, &r, sizeof r);
+    unit__log_write(writer, str, len + 1);
+    // keep records aligned
+    unit__log_write(writer, zeros, (sizeof r - (len + 1) % sizeof r) % sizeof r);
+    return r.id;
+}
+
+static uint32_t unit__log_string(struct unit__log_writer* writer, const char* str) {
+    if (!str) {
+        return 0;
+    }
+    uint32_t* slot = unit__log_slot(&writer->ids, str);
+    if (slot && *slot) {
+        return *slot;
+    }
+    const uint32_t id = unit__log_put_string(writer, str, false);
+    slot = unit__log_slot(&writer->ids, str);
+    if (slot) {
+        *slot = id;
+    }
+    return id;
+}
+
+// declares the node and its parents on the first event
+static uint32_t unit__log_node(struct unit__log_writer* writer, struct unit_test* node) {
+    if (!node) {
+        return 0;
+    }
+    uint32_t* slot = unit__log_slot(&writer->ids, node);
+    if (!slot) {
+        fputs("unit: warning: out of memory for events log, it is incomplete\n", stderr);
+        writer->active = false;
+        return 0;
+    }
+    if (*slot) {
+        return *slot;
+    }
+    struct unit__log_record r;
+    memset(&r, 0, sizeof r);
+    r.kind = UNIT__LOG_NODE;
+    r.status = (uint16_t) node->type;
+    r.node.parent = unit__log_node(writer, node->parent);
+    r.node.name = unit__log_string(writer, node->name);
+    r.node.file = unit__log_string(writer, node->file);
+    r.node.line = node->line;
+    r.id = ++writer->nodes_num;
+    unit__log_write(writer, &r, sizeof r);
+    slot = unit__log_slot(&writer->ids, node);
+    if (slot) {
+        *slot = r.id;
+    }
+    return r.id;
+}
+
+static void unit__log_setup(struct unit__log_writer* writer) {
+    struct unit__log_record r;
+    memset(&r, 0, sizeof r);
+    r.kind = UNIT__LOG_HEADER;
+    memcpy(r.header.magic, UNIT__LOG_MAGIC, sizeof r.header.magic);
+    r.header.version = UNIT__LOG_VERSION;
+    r.header.record_size = (uint32_t) sizeof r;
+    r.header.resources = (uint32_t) unit__opts.resources;
+    unit__log_write(writer, &r, sizeof r);
+
+    memset(&r, 0, sizeof r);
+    r.kind = UNIT__LOG_SETUP;
+    r.setup.clock = unit__log_string(writer, unit__clock.name);
+    r.setup.governor = unit__log_put_string(writer, unit__env.governor, false);
+    r.setup.cpus = unit__log_put_string(writer, unit__env.cpus, false);
+    r.setup.cpus_count = unit__env.cpus_count;
+    r.setup.calibration = unit__env.calibration;
+    r.setup.overhead = unit__clock.overhead;
+    r.setup.jitter = unit__env.jitter;
+    unit__log_write(writer, &r, sizeof r);
+}
+
+// writes node event, `SETUP` and `SHUTDOWN` are handled by the owner of the writer
+static void unit__log_event(struct unit__log_writer* writer, int cmd, struct unit_test* unit, const char* msg) {
+    struct unit__log_record r;
+    memset(&r, 0, sizeof r);
+    r.ts = unit__clock.now() - writer->t0;
+    r.id = unit__log_node(writer, unit);
+    switch (cmd) {
+        case UNIT__PRINTER_BEGIN:
+            r.kind = UNIT__LOG_BEGIN;
+            r.status = (uint16_t) unit->status;
+            unit__log_write(writer, &r, sizeof r);
+            break;
+        case UNIT__PRINTER_END:
+            if (unit__opts.resources) {
+                r.kind = UNIT__LOG_RESOURCES;
+                r.resources = unit->res;
+                unit__log_write(writer, &r, sizeof r);
+            }
+            r.kind = UNIT__LOG_END;
+            r.status = (uint16_t) unit->status;
+            r.end.passed = unit->passed;
+            r.end.total = unit->total;
+            r.end.elapsed = unit->elapsed;
+            r.end.cpu_elapsed = unit->cpu_elapsed;
+            r.end.fixtures_elapsed = unit->fixtures_elapsed;
+            r.end.assertions = unit->assertions;
+            r.end.scratch_peak = (int64_t) unit->scratch_peak;
+            unit__log_write(writer, &r, sizeof r);
+            break;
+        case UNIT__PRINTER_ECHO:
+            r.kind = UNIT__LOG_ECHO;
+            r.echo.text = unit__log_put_string(writer, msg, true);
+            unit__log_write(writer, &r, sizeof r);
+            break;
+        case UNIT__PRINTER_FAIL:
+        case UNIT__PRINTER_ASSERTION:
+            r.kind = cmd == UNIT__PRINTER_FAIL ? UNIT__LOG_FAIL : UNIT__LOG_ASSERTION;
+            r.status = (uint16_t) unit->assert_status;
+            r.fail.level = unit->assert_level;
+            r.fail.file = unit__log_string(writer, unit->assert_file);
+            r.fail.desc = unit__log_string(writer, unit->assert_desc);
+            r.fail.comment = unit__log_string(writer, unit->assert_comment);
+            r.fail.line = unit->assert_line;
+            if (cmd == UNIT__PRINTER_FAIL && unit->fail_record) {
+                // keep style markers, so the report is colored like the original output
+                char text[UNIT_FAIL_TEXT];
+                struct unit__text t = {text, sizeof text, 0};
+                text[0] = 0;
+                unit__format_fail(&t, unit->fail_record);
+                r.fail.text = unit__log_put_string(writer, text, true);
+            }
+            unit__log_write(writer, &r, sizeof r);
+            break;
+    }
+}
+
+static void unit__log_close(void) {
+#ifdef UNIT__LOG_MMAP
+    if (unit__log_data) {
+        munmap(unit__log_data, unit__log_cap);
+        unit__log_data = NULL;
+    }
+    if (unit__log_fd >= 0) {
+        // drop unused tail of the last mapping
+        if (ftruncate(unit__log_fd, (off_t) unit__log_len) != 0) {
+            fputs("unit: warning: unable to truncate events log\n", stderr);
+        }
+        close(unit__log_fd);
+        unit__log_fd = -1;
+    }
+#else
+    if (unit__log_file) {
+        fclose(unit__log_file);
+        unit__log_file = NULL;
+    }
+#endif // UNIT__LOG_MMAP
+    unit__log_writer_end(&unit__log_file_writer);
+}
+
+#ifdef UNIT__LOG_MMAP
+
+static bool unit__log_grow(size_t size) {
+    size_t cap = unit__log_cap ? unit__log_cap : UNIT_EVENTS_LOG_CHUNK;
+    while (cap < size) {
+        cap *= 2;
+    }
+    if (unit__log_data) {
+        munmap(unit__log_data, unit__log_cap);
+        unit__log_data = NULL;
+    }
+    if (ftruncate(unit__log_fd, (off_t) cap) != 0) {
+        return false;
+    }
+    void* data = mmap(NULL, cap, PROT_READ | PROT_WRITE, MAP_SHARED, unit__log_fd, 0);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    unit__log_data = (unsigned char*) data;
+    unit__log_cap = cap;
+    return true;
+}
+
+#endif // UNIT__LOG_MMAP
+
+static void unit__log_file_write(struct unit__log_writer* writer, const void* data, size_t size) {
+#ifdef UNIT__LOG_MMAP
+    if (unit__log_len + size > unit__log_cap && !unit__log_grow(unit__log_len + size)) {
+        fputs("unit: warning: unable to map events log, it is incomplete\n", stderr);
+        // the file is closed on shutdown
+        writer->active = false;
+        return;
+    }
+    memcpy(unit__log_data + unit__log_len, data, size);
+    unit__log_len += size;
+#else
+    (void) writer;
+    fwrite(data, 1, size, unit__log_file);
+#endif // UNIT__LOG_MMAP
+}
+
+static void unit__log_open(const char* path) {
+#ifdef UNIT__LOG_MMAP
+    unit__log_fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    const bool opened = unit__log_fd >= 0;
+    unit__log_len = 0;
+    unit__log_cap = 0;
+#else
+    unit__log_file = fopen(path, "wb");
+    const bool opened = unit__log_file != NULL;
+#endif // UNIT__LOG_MMAP
+    if (!opened) {
+        fprintf(stderr, "unit: warning: unable to open events log `%s`\n", path);
+        return;
+    }
+    unit__log_file_writer.write = unit__log_file_write;
+    unit__log_writer_begin(&unit__log_file_writer);
+    unit__log_setup(&unit__log_file_writer);
+}
+
+static void printer_events_log(int cmd, struct unit_test* unit, const char* msg) {
+    switch (cmd) {
+        case UNIT__PRINTER_SETUP:
+            unit__log_open(unit__opts.events_out);
+            break;
+        case UNIT__PRINTER_SHUTDOWN:
+            unit__log_close();
+            break;
+        default:
+            if (unit__log_file_writer.active) {
+                unit__log_event(&unit__log_file_writer, cmd, unit, msg);
+            }
+            break;
+    }
+}
+
+// endregion
@@ -0,0 +1,217 @@
+// region машинные отчёты: `-r=junit` и `-r=ndjson`, пишутся по мере завершения узлов без накопления в памяти
+
+// start time of `ndjson` report, events timestamps are relative to it
+static int64_t unit__ndjson_t0 = 0;
+
+// failures of the current test, records are valid until the next test begins
+static const struct unit__fail_record* unit__junit_fails[UNIT_FAIL_RECORDS];
+static int unit__junit_fails_num = 0;
+
+static const char* unit__level_name(int level) {
+    static const char* names[] = {"warn", "check", "require"};
+    return level >= 0 && level < 3 ? names[level] : "check";
+}
+
+static const char* unit__status_name(int status) {
+    static const char* names[] = {"run", "success", "skipped", "failed"};
+    return status >= 0 && status < 4 ? names[status] : "run";
+}
+
+// JUnit `classname`: names of enclosing nodes joined with dots
+static void unit__junit_classname(FILE* f, struct unit_test* node) {
+    if (node) {
+        if (node->parent) {
+            unit__junit_classname(f, node->parent);
+            unit__fputc('.', f);
+        }
+        print_xml_string(f, beautify_name(node->name));
+    }
+}
+
+static void unit__junit_failure(FILE* f, const struct unit__fail_record* r) {
+    char text[UNIT_FAIL_TEXT];
+    unit__format_fail_plain(text, sizeof text, r);
+    // the first line is the message, details are in the element text
+    char message[256];
+    size_t len = strcspn(text, "\n");
+    if (len >= sizeof message) {
+        len = sizeof message - 1;
+    }
+    memcpy(message, text, len);
+    message[len] = 0;
+    unit__fputs("      <failure message=\"", f);
+    print_xml_string(f, message);
+    unit__fprintf(f, "\" type=\"%s\">", unit__level_name(r->site ? r->site->level : UNIT__LEVEL_CHECK));
+    print_xml_string(f, text);
+    if (r->site) {
+        unit__fputs("\n@ ", f);
+        print_xml_string(f, beautify_filename(r->site->file));
+        unit__fprintf(f, ":%d", r->site->line);
+    }
+    unit__fputs("</failure>\n", f);
+}
+
+static void unit__junit_testcase(FILE* f, struct unit_test* node) {
+    unit__fputs("    <testcase classname=\"", f);
+    unit__junit_classname(f, node->parent);
+    unit__fputs("\" name=\"", f);
+    print_xml_string(f, beautify_name(node->name));
+    unit__fputs("\" file=\"", f);
+    print_xml_string(f, beautify_filename(node->file));
+    unit__fprintf(f, "\" line=\"%d\" time=\"%0.6f\" assertions=\"%lld\"", node->line, node->elapsed / 1e9,
+            (long long) node->assertions);
+    if (node->status == UNIT_STATUS_SKIPPED) {
+        unit__fputs(">\n      <skipped/>\n    </testcase>\n", f);
+    } else if (node->status == UNIT_STATUS_FAILED) {
+        unit__fputs(">\n", f);
+        for (int i = 0; i < unit__junit_fails_num; ++i) {
+            const struct unit__fail_record* r = unit__junit_fails[i];
+            if (!r->site || r->site->level > UNIT__LEVEL_WARN) {
+                unit__junit_failure(f, r);
+            }
+        }
+        unit__fputs("    </testcase>\n", f);
+    } else {
+        unit__fputs("/>\n", f);
+    }
+}
+
+static void printer_junit(int cmd, struct unit_test* node, const char* msg) {
+    (void) msg;
+    FILE* f = unit__printer_out;
+    switch (cmd) {
+        case UNIT__PRINTER_SETUP:
+            unit__fputs("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<testsuites name=\"unit\">\n", f);
+            break;
+        case UNIT__PRINTER_SHUTDOWN:
+            unit__fputs("</testsuites>\n", f);
+            unit__output_flush(f);
+            break;
+        case UNIT__PRINTER_BEGIN:
+            if (node->type == UNIT__TYPE_TEST) {
+                unit__junit_fails_num = 0;
+            }
+            // test counts are not known yet, consumers compute them from `testcase` elements
+            if (!node->parent) {
+                unit__fputs("  <testsuite name=\"", f);
+                print_xml_string(f, beautify_name(node->name));
+                unit__fputs("\" file=\"", f);
+                print_xml_string(f, beautify_filename(node->file));
+                unit__fputs("\">\n", f);
+            }
+            break;
+        case UNIT__PRINTER_END:
+            if (node->type == UNIT__TYPE_TEST) {
+                unit__junit_testcase(f, node);
+            }
+            if (!node->parent) {
+                unit__fputs("  </testsuite>\n", f);
+                unit__output_flush(f);
+            }
+            break;
+        case UNIT__PRINTER_FAIL:
+            if (node->fail_record && unit__junit_fails_num < UNIT_FAIL_RECORDS) {
+                unit__junit_fails[unit__junit_fails_num++] = node->fail_record;
+            }
+            break;
+    }
+}
+
+static void unit__ndjson_path(FILE* f, struct unit_test* node) {
+    if (node->parent) {
+        unit__ndjson_path(f, node->parent);
+        unit__fputc(',', f);
+    }
+    print_json_string(f, beautify_name(node->name));
+}
+
+static void unit__ndjson_begin(FILE* f, const char* event, struct unit_test* node) {
+    unit__fprintf(f, "{\"event\":\"%s\",\"ts\":%lld", event, (long long) (unit__clock.now() - unit__ndjson_t0));
+    if (node) {
+        unit__fputs(",\"path\":[", f);
+        unit__ndjson_path(f, node);
+        unit__fputc(']', f);
+    }
+}
+
+static void unit__ndjson_durations(FILE* f, const char* type, const struct unit__durations* heap) {
+    struct unit_test* nodes[UNIT_DURATIONS_MAX];
+    const int num = unit__durations_sorted(heap, nodes);
+    for (int i = 0; i < num; ++i) {
+        unit__ndjson_begin(f, "slowest", nodes[i]);
+        unit__fprintf(f, ",\"type\":\"%s\",\"file\":", type);
+        print_json_string(f, beautify_filename(nodes[i]->file));
+        unit__fprintf(f, ",\"line\":%d,\"elapsed_ms\":%0.6f}\n", nodes[i]->line, nodes[i]->elapsed / 1e6);
+    }
+}
+
+static void printer_ndjson(int cmd, struct unit_test* node, const char* msg) {
+    FILE* f = unit__printer_out;
+    switch (cmd) {
+        case UNIT__PRINTER_SETUP:
+            unit__ndjson_t0 = unit__clock.now();
+            unit__ndjson_begin(f, "setup", NULL);
+            unit__fputs(",\"version\":\"" UNIT_VERSION "\",\"cpus\":", f);
+            print_json_string(f, unit__env.cpus[0] ? unit__env.cpus : "any");
+            unit__fputs(",\"governor\":", f);
+            print_json_string(f, unit__env.governor);
+            unit__fprintf(f, ",\"jitter\":%0.4f,\"clock\":\"%s\"}\n", unit__env.jitter, unit__clock.name);
+            break;
+        case UNIT__PRINTER_SHUTDOWN: {
+            int total = 0;
+            int passed = 0;
+            for (struct unit_test* u = unit_tests; u; u = u->next) {
+                passed += u->passed;
+                total += u->total;
+            }
+            unit__ndjson_durations(f, "test", &unit__slowest_tests);
+            unit__ndjson_durations(f, "suite", &unit__slowest_suites);
+            unit__ndjson_begin(f, "shutdown", NULL);
+            unit__fprintf(f, ",\"passed\":%d,\"total\":%d}\n", passed, total);
+            unit__output_flush(f);
+        }
+            break;
+        case UNIT__PRINTER_BEGIN:
+            unit__ndjson_begin(f, "begin", node);
+            unit__fprintf(f, ",\"type\":\"%s\",\"file\":", !node->parent ? "suite" :
+                                                     (node->type == UNIT__TYPE_TEST ? "test" : "case"));
+            print_json_string(f, beautify_filename(node->file));
+            unit__fprintf(f, ",\"line\":%d}\n", node->line);
+            break;
+        case UNIT__PRINTER_END:
+            unit__ndjson_begin(f, "end", node);
+            unit__fprintf(f, ",\"status\":\"%s\",\"elapsed_ms\":%0.6f,\"cpu_ms\":%0.6f,\"fixtures_ms\":%0.6f,"
+                       "\"assertions\":%lld,\"passed\":%d,\"total\":%d,\"scratch\":%zu}\n",
+                    unit__status_name(node->status), node->elapsed / 1e6, node->cpu_elapsed / 1e6,
+                    node->fixtures_elapsed / 1e6, (long long) node->assertions, node->passed, node->total,
+                    node->scratch_peak);
+            if (!node->parent) {
+                unit__output_flush(f);
+            }
+            break;
+        case UNIT__PRINTER_ECHO:
+            unit__ndjson_begin(f, "echo", node);
+            unit__fputs(",\"message\":", f);
+            print_json_string(f, msg);
+            unit__fputs("}\n", f);
+            break;
+        case UNIT__PRINTER_FAIL:
+            unit__ndjson_begin(f, "fail", node);
+            unit__fprintf(f, ",\"level\":\"%s\",\"file\":", unit__level_name(node->assert_level));
+            print_json_string(f, beautify_filename(node->assert_file));
+            unit__fprintf(f, ",\"line\":%d,\"desc\":", node->assert_line);
+            print_json_string(f, node->assert_desc);
+            unit__fputs(",\"message\":", f);
+            if (node->fail_record) {
+                char text[UNIT_FAIL_TEXT];
+                unit__format_fail_plain(text, sizeof text, node->fail_record);
+                print_json_string(f, text);
+            } else {
+                print_json_string(f, node->assert_desc);
+            }
+            unit__fputs("}\n", f);
+            break;
+    }
+}
+
+// endregion
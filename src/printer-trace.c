@@ -0,0 +1,210 @@
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <unistd.h>
+
+#endif // unix
+
+// region Chrome trace-event printer: `--trace-out=run.json`, loads in `chrome://tracing` or Perfetto
+
+#ifndef UNIT_TRACE_BUFFER
+// number of events buffered in memory before writing them to the file
+#define UNIT_TRACE_BUFFER 4096
+#endif
+
+// node values are copied when the event happens: the node is changed by the next run of the suite, or reused
+// by the next row of `IT_EACH`, before buffered events are written
+struct unit__trace_event {
+    int64_t ts;
+    long tid;
+    union {
+        struct {
+            const char* file;
+            int line;
+            int type;
+        } begin;
+        struct {
+            int64_t cpu_elapsed;
+            int64_t fixtures_elapsed;
+            int64_t assertions;
+            size_t scratch_peak;
+            int status;
+            int passed;
+            int total;
+        } end;
+    };
+    // offsets of node name and message copies in `unit__trace_strings`, -1 if there is no string
+    int name;
+    int msg;
+    // `B`egin, `E`nd or instant event: `F`ail or `M`essage
+    char kind;
+};
+
+static struct unit__trace_event unit__trace_events[UNIT_TRACE_BUFFER];
+static int unit__trace_events_num = 0;
+static char unit__trace_strings[UNIT_TRACE_BUFFER * 16];
+static int unit__trace_strings_len = 0;
+static FILE* unit__trace_file = NULL;
+static int64_t unit__trace_t0 = 0;
+static bool unit__trace_first = true;
+
+static long unit__trace_pid(void) {
+#if defined(__unix__) || defined(__APPLE__)
+    return (long) getpid();
+#else
+    return 1;
+#endif
+}
+
+static long unit__trace_tid(void) {
+#ifdef __linux__
+    // the system call is made once per thread
+    static __thread long tid = 0;
+    if (!tid) {
+        tid = (long) syscall(SYS_gettid);
+    }
+    return tid;
+#else
+    return unit__trace_pid();
+#endif
+}
+
+static const char* unit__trace_string(int offset) {
+    return offset >= 0 ? unit__trace_strings + offset : NULL;
+}
+
+static void unit__trace_flush(void) {
+    FILE* f = unit__trace_file;
+    const long pid = unit__trace_pid();
+    for (int i = 0; i < unit__trace_events_num; ++i) {
+        const struct unit__trace_event* e = unit__trace_events + i;
+        fputs(unit__trace_first ? "\n" : ",\n", f);
+        unit__trace_first = false;
+        const char ph = (e->kind == 'B' || e->kind == 'E') ? e->kind : 'i';
+        fprintf(f, "{\"ph\":\"%c\",\"pid\":%ld,\"tid\":%ld,\"ts\":%0.3f", ph, pid, e->tid, e->ts / 1000.0);
+        switch (e->kind) {
+            case 'B':
+                fputs(",\"cat\":\"", f);
+                fputs(e->begin.type == UNIT__TYPE_TEST ? "test" : "case", f);
+                fputs("\",\"name\":", f);
+                print_json_string(f, beautify_name(unit__trace_string(e->name)));
+                fprintf(f, ",\"args\":{\"file\":");
+                print_json_string(f, beautify_filename(e->begin.file));
+                fprintf(f, ",\"line\":%d}", e->begin.line);
+                break;
+            case 'E':
+                fprintf(f, ",\"args\":{\"status\":%d,\"passed\":%d,\"total\":%d,\"cpu_ms\":%0.3f,\"fixtures_ms\":%0.3f,\"scratch\":%zu,\"assertions\":%lld}",
+                        e->end.status, e->end.passed, e->end.total, e->end.cpu_elapsed / 1000000.0,
+                        e->end.fixtures_elapsed / 1000000.0, e->end.scratch_peak, (long long) e->end.assertions);
+                break;
+            case 'F':
+            case 'M':
+                fputs(e->kind == 'F' ? ",\"cat\":\"fail\"" : ",\"cat\":\"echo\"", f);
+                fputs(",\"s\":\"t\",\"name\":", f);
+                print_json_string(f, unit__trace_string(e->msg));
+                fputs(",\"args\":{\"test\":", f);
+                print_json_string(f, beautify_name(unit__trace_string(e->name)));
+                fputc('}', f);
+                break;
+        }
+        fputc('}', f);
+    }
+    unit__trace_events_num = 0;
+    unit__trace_strings_len = 0;
+}
+
+// copies the string to the strings buffer, huge strings are truncated to fit the half of it
+static int unit__trace_copy(const char* str) {
+    if (!str) {
+        return -1;
+    }
+    const int max_len = (int) sizeof unit__trace_strings / 2;
+    const int size = (int) strnlen(str, (size_t) max_len - 1) + 1;
+    const int offset = unit__trace_strings_len;
+    memcpy(unit__trace_strings + offset, str, (size_t) size - 1);
+    unit__trace_strings[offset + size - 1] = 0;
+    unit__trace_strings_len += size;
+    return offset;
+}
+
+static void unit__trace_push(char kind, struct unit_test* node, const char* msg) {
+    const size_t max_len = sizeof unit__trace_strings / 2;
+    const size_t strings_len = (node && node->name ? strnlen(node->name, max_len) + 1 : 0) +
+                               (msg ? strnlen(msg, max_len) + 1 : 0);
+    if (unit__trace_events_num == UNIT_TRACE_BUFFER ||
+        unit__trace_strings_len + strings_len > sizeof unit__trace_strings) {
+        unit__trace_flush();
+    }
+    struct unit__trace_event* e = unit__trace_events + unit__trace_events_num++;
+    e->ts = unit__clock.now() - unit__trace_t0;
+    e->tid = unit__trace_tid();
+    e->kind = kind;
+    e->name = unit__trace_copy(node ? node->name : NULL);
+    e->msg = unit__trace_copy(msg);
+    if (kind == 'B') {
+        e->begin.file = node->file;
+        e->begin.line = node->line;
+        e->begin.type = node->type;
+    } else if (kind == 'E') {
+        e->end.cpu_elapsed = node->cpu_elapsed;
+        e->end.fixtures_elapsed = node->fixtures_elapsed;
+        e->end.assertions = node->assertions;
+        e->end.scratch_peak = node->scratch_peak;
+        e->end.status = node->status;
+        e->end.passed = node->passed;
+        e->end.total = node->total;
+    }
+}
+
+static void printer_trace_events(int cmd, struct unit_test* unit, const char* msg) {
+    switch (cmd) {
+        case UNIT__PRINTER_SETUP:
+            unit__trace_file = fopen(unit__opts.trace_out, "w");
+            if (!unit__trace_file) {
+                fprintf(stderr, "unit: warning: unable to open trace file `%s`\n", unit__opts.trace_out);
+                break;
+            }
+            unit__trace_t0 = unit__clock.now();
+            unit__trace_first = true;
+            unit__trace_events_num = 0;
+            unit__trace_strings_len = 0;
+            fputs("{\"displayTimeUnit\":\"ms\",\"otherData\":{\"version\":\"" UNIT_VERSION "\",\"governor\":", unit__trace_file);
+            print_json_string(unit__trace_file, unit__env.governor);
+            fprintf(unit__trace_file, ",\"jitter\":%0.4f,\"clock\":\"%s\"},\"traceEvents\":[", unit__env.jitter,
+                    unit__clock.name);
+            break;
+        case UNIT__PRINTER_SHUTDOWN:
+            if (unit__trace_file) {
+                unit__trace_flush();
+                fprintf(unit__trace_file,
+                        "%s{\"ph\":\"M\",\"pid\":%ld,\"tid\":%ld,\"name\":\"thread_name\",\"args\":{\"name\":\"unit\"}}\n]}\n",
+                        unit__trace_first ? "\n" : ",\n", unit__trace_pid(), unit__trace_tid());
+                fclose(unit__trace_file);
+                unit__trace_file = NULL;
+            }
+            break;
+        case UNIT__PRINTER_BEGIN:
+            if (unit__trace_file) {
+                unit__trace_push('B', unit, NULL);
+            }
+            break;
+        case UNIT__PRINTER_END:
+            if (unit__trace_file) {
+                unit__trace_push('E', unit, NULL);
+            }
+            break;
+        case UNIT__PRINTER_ECHO:
+            if (unit__trace_file) {
+                unit__trace_push('M', unit, msg);
+            }
+            break;
+        case UNIT__PRINTER_FAIL:
+            if (unit__trace_file && unit->fail_record) {
+                char text[UNIT_FAIL_TEXT];
+                unit__format_fail_plain(text, sizeof text, unit->fail_record);
+                unit__trace_push('F', unit, text);
+            }
+            break;
+    }
+}
+
+// endregion
@@ -1,4 +1,8 @@
-#include "fmemopen.c"
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <unistd.h>
+
+#endif // unix
 
 // region Цвета, текстовые сообщения и логи
 
@@ -63,34 +67,246 @@ static void unit__sleep(double seconds) {
 #endif
 }
 
-static void print_wait(FILE* f) {
+#ifndef UNIT_OUTPUT_BUFFER
+// size of the library buffer for `stdout` output, it is written when the suite ends or the buffer is full
+#define UNIT_OUTPUT_BUFFER (64 * 1024)
+#endif
+
+#ifndef UNIT_OUTPUT_TICK
+// interval between progress flushes in nanoseconds, if output is a terminal
+#define UNIT_OUTPUT_TICK 50000000
+#endif
+
+// printers output to `stdout` is collected here and written with `fwrite`, the buffering mode of `stdout`
+// belongs to the program, and the pending output is written at exit and by the crash handler
+static char unit__output_buffer[UNIT_OUTPUT_BUFFER];
+static size_t unit__output_size = 0;
+// destination of the notified printer, reporters selected with `-r=name:FILE` write to their own files,
+// it is per thread because reporters may be notified by the reporter thread, see `--async-report`
+static __thread FILE* unit__printer_out = NULL;
+static bool unit__output_tty = false;
+static int64_t unit__output_flushed = 0;
+
+static bool unit__is_tty(FILE* f) {
+#if defined(__unix__) || defined(__APPLE__)
+    return isatty(fileno(f)) != 0;
+#elif defined(_WIN32)
+    return _isatty(_fileno(f)) != 0;
+#else
+    (void) f;
+    return false;
+#endif
+}
+
+static void unit__output_write(void) {
+    if (unit__output_size) {
+        fwrite(unit__output_buffer, 1, unit__output_size, stdout);
+        unit__output_size = 0;
+    }
+}
+
+static void unit__output_flush(FILE* f) {
+    if (f == stdout) {
+        unit__output_write();
+    }
     fflush(f);
+    unit__output_flushed = unit__clock.now();
+}
+
+static void unit__output_exit(void) {
+    unit__output_flush(stdout);
+}
+
+/**
+ * Writes pending output from the crash handler before the default action kills the process,
+ * only `write` is async-signal-safe there
+ */
+static void unit__output_crash_drain(void) {
+#if defined(__unix__) || defined(__APPLE__)
+    size_t written = 0;
+    while (written < unit__output_size) {
+        const ssize_t n = write(STDOUT_FILENO, unit__output_buffer + written, unit__output_size - written);
+        if (n <= 0) {
+            break;
+        }
+        written += (size_t) n;
+    }
+    unit__output_size = 0;
+#endif
+}
+
+static void unit__output_setup(void) {
+    static bool registered = false;
+    if (!registered) {
+        atexit(unit__output_exit);
+        registered = true;
+    }
+    unit__output_tty = unit__is_tty(stdout);
+    unit__output_flushed = unit__clock.now();
+}
+
+static void unit__fwrite(const void* data, size_t size, FILE* f) {
+    if (f != stdout) {
+        fwrite(data, 1, size, f);
+        return;
+    }
+    if (unit__output_size + size > sizeof unit__output_buffer) {
+        unit__output_write();
+        if (size > sizeof unit__output_buffer) {
+            fwrite(data, 1, size, stdout);
+            return;
+        }
+    }
+    memcpy(unit__output_buffer + unit__output_size, data, size);
+    unit__output_size += size;
+}
+
+static void unit__fputs(const char* text, FILE* f) {
+    unit__fwrite(text, strlen(text), f);
+}
+
+static void unit__fputc(int c, FILE* f) {
+    const char ch = (char) c;
+    unit__fwrite(&ch, 1, f);
+}
+
+__attribute__((format(printf, 2, 3)))
+static void unit__fprintf(FILE* f, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    if (f != stdout) {
+        vfprintf(f, format, args);
+    } else {
+        va_list retry;
+        va_copy(retry, args);
+        const size_t space = sizeof unit__output_buffer - unit__output_size;
+        const int n = vsnprintf(unit__output_buffer + unit__output_size, space, format, args);
+        if (n >= 0 && (size_t) n < space) {
+            unit__output_size += (size_t) n;
+        } else if (n >= 0) {
+            // the text is truncated: write the buffer and format the text again, directly if it's too long
+            unit__output_write();
+            if ((size_t) n < sizeof unit__output_buffer) {
+                unit__output_size = (size_t) vsnprintf(unit__output_buffer, sizeof unit__output_buffer, format, retry);
+            } else {
+                vfprintf(stdout, format, retry);
+            }
+        }
+        va_end(retry);
+    }
+    va_end(args);
+}
+
+/**
+ * Called after each printed fragment: flushes every fragment only for `--animate`,
+ * and shows progress on terminal not more often than `UNIT_OUTPUT_TICK`
+ */
+static void print_wait(FILE* f) {
     if (unit__opts.animate) {
+        unit__output_flush(f);
         unit__sleep(0.1);
+    } else if (unit__output_tty && f == stdout && unit__clock.now() - unit__output_flushed >= UNIT_OUTPUT_TICK) {
+        unit__output_flush(f);
     }
 }
 
 void begin_style(FILE* file, const char* style) {
     if (style && !unit__opts.ascii) {
-        fputs(style, file);
+        unit__fputs(style, file);
     }
 }
 
 void end_style(FILE* file) {
     if (!unit__opts.ascii) {
-        fputs(UNIT_COLOR_RESET, file);
+        unit__fputs(UNIT_COLOR_RESET, file);
     }
 }
 
 void print_text(FILE* file, const char* text, const char* style) {
     begin_style(file, style);
-    fputs(text, file);
+    unit__fputs(text, file);
     end_style(file);
 }
 
-static char unit__fails_mem[4096];
+/**
+ * Prints failure text, replacing style markers with colors
+ */
+static void print_marked(FILE* f, const char* text) {
+    for (const char* p = text; *p; ++p) {
+        switch (*p) {
+            case UNIT__MARK_SUCCESS:
+                begin_style(f, UNIT_COLOR_SUCCESS);
+                break;
+            case UNIT__MARK_FAIL:
+                begin_style(f, UNIT_COLOR_FAIL);
+                break;
+            case UNIT__MARK_RESET:
+                end_style(f);
+                break;
+            default:
+                unit__fputc(*p, f);
+                break;
+        }
+    }
+}
+
+static void print_fail_message(FILE* f, struct unit_test* unit) {
+    if (unit->fail_record) {
+        char buffer[UNIT_FAIL_TEXT];
+        struct unit__text text = {buffer, sizeof buffer, 0};
+        buffer[0] = 0;
+        unit__format_fail(&text, unit->fail_record);
+        print_marked(f, buffer);
+    }
+}
+
+#ifndef UNIT_FAIL_JOURNAL
+// failures of the suite are kept in memory up to this size, and spill to anonymous temporary file beyond it
+#define UNIT_FAIL_JOURNAL (64 * 1024)
+#endif
+
+// failures are printed after the suite progress line
+static char unit__journal_mem[UNIT_FAIL_JOURNAL];
 static FILE* unit__fails = 0;
 
+/**
+ * Opens anonymous read-write file: in-memory `memfd` on Linux or `tmpfile`,
+ * data is written to the file only when the memory buffer is full
+ */
+static FILE* unit__journal_open(void) {
+    FILE* f = NULL;
+#if defined(__linux__) && defined(SYS_memfd_create)
+    const int fd = (int) syscall(SYS_memfd_create, "unit-fails", 0);
+    if (fd >= 0) {
+        f = fdopen(fd, "w+");
+        if (!f) {
+            close(fd);
+        }
+    }
+#endif // memfd
+    if (!f) {
+        f = tmpfile();
+    }
+    if (f) {
+        setvbuf(f, unit__journal_mem, _IOFBF, sizeof unit__journal_mem);
+    }
+    return f;
+}
+
+/**
+ * Copies all journal content to the output and closes the journal
+ */
+static void unit__journal_replay(FILE* journal, FILE* out) {
+    char chunk[4096];
+    fflush(journal);
+    rewind(journal);
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof chunk, journal)) > 0) {
+        unit__fwrite(chunk, n, out);
+    }
+    fclose(journal);
+}
+
 static const char* unit_spaces[8] = {
         "",
         "  ",
@@ -109,10 +325,31 @@ static const char* get_spaces(int n) {
     return unit_spaces[n];
 }
 
-void print_elapsed_time(FILE* f, double elapsed_time) {
-    if (elapsed_time >= 0.00001) {
+void print_elapsed_time(FILE* f, struct unit_test* node) {
+    if (node->elapsed >= 10000) {
+        begin_style(f, UNIT_COLOR_DIM);
+        unit__fprintf(f, " (%0.2f ms, cpu %0.2f ms)", node->elapsed / 1000000.0, node->cpu_elapsed / 1000000.0);
+        end_style(f);
+    }
+    if (node->fixtures_elapsed >= 10000) {
+        begin_style(f, UNIT_COLOR_DIM);
+        unit__fprintf(f, " (fixtures %0.2f ms)", node->fixtures_elapsed / 1000000.0);
+        end_style(f);
+    }
+    if (node->scratch_peak) {
         begin_style(f, UNIT_COLOR_DIM);
-        fprintf(f, " (%0.2f ms)", 1000.0 * elapsed_time);
+        unit__fprintf(f, " (scratch %0.1f KB)", node->scratch_peak / 1024.0);
+        end_style(f);
+    }
+}
+
+static void print_resources(FILE* f, struct unit_test* node) {
+    if (unit__opts.resources) {
+        const struct unit_resources* r = &node->res;
+        begin_style(f, UNIT_COLOR_DIM);
+        unit__fprintf(f, " [user %0.2f ms, sys %0.2f ms, rss %+0.1f KB, max rss %0.1f MB, faults %lld/%lld, csw %lld/%lld]",
+                r->user / 1000000.0, r->sys / 1000000.0, r->rss / 1024.0, r->max_rss / (1024.0 * 1024.0),
+                (long long) r->minflt, (long long) r->majflt, (long long) r->nvcsw, (long long) r->nivcsw);
         end_style(f);
     }
 }
@@ -121,6 +358,74 @@ static const char* beautify_name(const char* name) {
     return (name && name[0]) ? name : "(anonymous)";
 }
 
+static void print_json_string(FILE* f, const char* str) {
+    unit__fputc('"', f);
+    for (const char* p = str ? str : ""; *p; ++p) {
+        const unsigned char c = (unsigned char) *p;
+        switch (c) {
+            case '"':
+                unit__fputs("\\\"", f);
+                break;
+            case '\\':
+                unit__fputs("\\\\", f);
+                break;
+            case '\n':
+                unit__fputs("\\n", f);
+                break;
+            case '\r':
+                unit__fputs("\\r", f);
+                break;
+            case '\t':
+                unit__fputs("\\t", f);
+                break;
+            default:
+                if (c < 0x20) {
+                    unit__fprintf(f, "\\u%04x", c);
+                } else {
+                    unit__fputc(c, f);
+                }
+                break;
+        }
+    }
+    unit__fputc('"', f);
+}
+
+/**
+ * Prints string escaped for XML attribute or text, control characters which are not allowed in XML 1.0 are dropped
+ */
+static void print_xml_string(FILE* f, const char* str) {
+    for (const char* p = str ? str : ""; *p; ++p) {
+        const unsigned char c = (unsigned char) *p;
+        switch (c) {
+            case '&':
+                unit__fputs("&amp;", f);
+                break;
+            case '<':
+                unit__fputs("&lt;", f);
+                break;
+            case '>':
+                unit__fputs("&gt;", f);
+                break;
+            case '"':
+                unit__fputs("&quot;", f);
+                break;
+            case '\'':
+                unit__fputs("&apos;", f);
+                break;
+            case '\n':
+            case '\r':
+            case '\t':
+                unit__fputc(c, f);
+                break;
+            default:
+                if (c >= 0x20) {
+                    unit__fputc(c, f);
+                }
+                break;
+        }
+    }
+}
+
 static const char* short_filename(const char* file) {
     if (file) {
         const char* p = strrchr(file, '/');
@@ -135,6 +440,17 @@ static const char* beautify_filename(const char* file) {
     return unit__opts.short_filenames ? short_filename(file) : file;
 }
 
+static void print_env(FILE* f) {
+    begin_style(f, UNIT_COLOR_DIM);
+    unit__fprintf(f, "cpus: %s (%d) | ", unit__env.cpus[0] ? unit__env.cpus : "any", unit__env.cpus_count);
+    if (unit__env.calibration) {
+        unit__fprintf(f, "governor: %s | jitter: %0.2f%% | ", unit__env.governor, 100.0 * unit__env.jitter);
+    }
+    unit__fprintf(f, "clock: %s (%d ns)", unit__clock.name, (int) unit__clock.overhead);
+    end_style(f);
+    unit__fputc('\n', f);
+}
+
 static void print_label(FILE* f, struct unit_test* node) {
     static const char* fancy[] = {
             UNIT_COLOR_LABEL_RUNS " RUNS " UNIT_COLOR_RESET,
@@ -151,19 +467,20 @@ static void print_label(FILE* f, struct unit_test* node) {
     const int type = node->status;
     const char* lbl = (unit__opts.ascii ? ascii : fancy)[type];
 
-    fputs(lbl, f);
-    fputc(' ', f);
+    unit__fputs(lbl, f);
+    unit__fputc(' ', f);
     begin_style(f, UNIT_COLOR_BOLD);
-    fputs(beautify_name(node->name), f);
+    unit__fputs(beautify_name(node->name), f);
     end_style(f);
-    fputc(' ', f);
+    unit__fputc(' ', f);
     switch (node->status) {
         case UNIT_STATUS_RUN:
             break;
         case UNIT_STATUS_SUCCESS:
         case UNIT_STATUS_FAILED:
-            fprintf(f, ": passed %d/%d tests", node->passed, node->total);
-            print_elapsed_time(f, node->elapsed);
+            unit__fprintf(f, ": passed %d/%d tests", node->passed, node->total);
+            print_elapsed_time(f, node);
+            print_resources(f, node);
             break;
         default:
             break;
@@ -172,7 +489,7 @@ static void print_label(FILE* f, struct unit_test* node) {
 }
 
 void printer_def_begin(struct unit_test* unit) {
-    FILE* f = stdout;
+    FILE* f = unit__printer_out;
     if (!unit->parent) {
         print_label(f, unit);
     }
@@ -185,10 +502,10 @@ const char* unit__spaces(int delta) {
 }
 
 static void print_node(struct unit_test* node) {
-    FILE* f = stdout;
+    FILE* f = unit__printer_out;
     ++def_depth;
     const char* name = beautify_name(node->name);
-    fputs(unit__spaces(0), f);
+    unit__fputs(unit__spaces(0), f);
     if (node->type == UNIT__TYPE_CASE) {
         if (node->status == UNIT_STATUS_SKIPPED) {
             print_text(f, name, UNIT_COLOR_DIM);
@@ -196,11 +513,12 @@ static void print_node(struct unit_test* node) {
             print_text(f, name, NULL);
         }
     } else {
-        fputs(icon(node->status), f);
+        unit__fputs(icon(node->status), f);
         print_text(f, name, UNIT_COLOR_DIM);
     }
-    print_elapsed_time(f, node->elapsed);
-    fputc('\n', f);
+    print_elapsed_time(f, node);
+    print_resources(f, node);
+    unit__fputc('\n', f);
     print_wait(f);
     for (struct unit_test* child = node->children; child; child = child->next) {
         print_node(child);
@@ -209,69 +527,98 @@ static void print_node(struct unit_test* node) {
 }
 
 void printer_def_end(struct unit_test* unit) {
-    FILE* f = stdout;
+    FILE* f = unit__printer_out;
     if (unit->parent) {
         if (unit->type == UNIT__TYPE_TEST) {
-            fputs(icon(unit->status), f);
+            unit__fputs(icon(unit->status), f);
             print_wait(f);
         }
         return;
     }
     // go back to the beginning of line
-    // fputc('\n', f);
+    // unit__fputc('\n', f);
     // begin_style(f, "\033[1A\033[999D");
-    fputc('\r', f);
+    unit__fputc('\r', f);
     print_label(f, unit);
-    fputc('\n', f);
+    unit__fputc('\n', f);
 
     if (unit__fails) {
         for (struct unit_test* child = unit->children; child; child = child->next) {
             print_node(child);
         }
-        fputc('\n', f);
+        unit__fputc('\n', f);
 
-        const long pos = ftell(unit__fails);
-        unit__fails_mem[pos] = 0;
-        fclose(unit__fails);
+        if (unit__fails != f) {
+            unit__journal_replay(unit__fails, f);
+        }
         unit__fails = 0;
-        fputs(unit__fails_mem, f);
 
-        fputc('\n', f);
+        unit__fputc('\n', f);
     }
+    unit__output_flush(f);
 }
 
-static void unit__breadcrumbs(FILE* f, struct unit_test* test) {
+static void unit__breadcrumbs(FILE* f, struct unit_test* test, const char* style) {
     if (test->parent) {
-        unit__breadcrumbs(f, test->parent);
+        unit__breadcrumbs(f, test->parent, style);
         print_text(f, unit__opts.ascii ? " > " : " → ", UNIT_COLOR_BOLD UNIT_COLOR_DIM);
     }
-    print_text(f, beautify_name(test->name), UNIT_COLOR_BOLD UNIT_COLOR_FAIL);
+    print_text(f, beautify_name(test->name), style);
 }
 
-void printer_def_fail(struct unit_test* unit, const char* msg) {
+void printer_def_fail(struct unit_test* unit) {
     if (unit__fails == 0) {
-        // TODO: change to `tmpfile` ?
-        unit__fails = fmemopen(unit__fails_mem, sizeof unit__fails_mem, "w");
+        unit__fails = unit__journal_open();
+        if (!unit__fails) {
+            // print immediately rather than lose the failure
+            unit__fails = unit__printer_out;
+            unit__fputc('\n', unit__printer_out);
+        }
     }
     FILE* f = unit__fails;
-    fputs(unit_spaces[1], f);
-    fputs(icon(ICON_ASSERT), f);
-    unit__breadcrumbs(f, unit_cur);
-    fputc('\n', f);
-    fputc('\n', f);
-
-    fputs(unit_spaces[2], f);
-    fputs(msg, f);
-    fputc('\n', f);
+    unit__fputs(unit_spaces[1], f);
+    unit__fputs(icon(ICON_ASSERT), f);
+    unit__breadcrumbs(f, unit, UNIT_COLOR_BOLD UNIT_COLOR_FAIL);
+    unit__fputc('\n', f);
+    unit__fputc('\n', f);
+
+    unit__fputs(unit_spaces[2], f);
+    print_fail_message(f, unit);
+    unit__fputc('\n', f);
     if (unit->assert_file) {
-        fputs(unit_spaces[2], f);
+        unit__fputs(unit_spaces[2], f);
         print_text(f, "@ ", UNIT_COLOR_COMMENT UNIT_COLOR_DIM UNIT_COLOR_BOLD);
         begin_style(f, UNIT_COLOR_COMMENT UNIT_COLOR_UNDERLINE);
-        fprintf(f, "%s:%d", beautify_filename(unit->assert_file), unit->assert_line);
+        unit__fprintf(f, "%s:%d", beautify_filename(unit->assert_file), unit->assert_line);
+        end_style(f);
+        unit__fputc('\n', f);
+    }
+    unit__fputc('\n', f);
+}
+
+static void print_durations(FILE* f, const char* title, const struct unit__durations* heap) {
+    struct unit_test* nodes[UNIT_DURATIONS_MAX];
+    const int num = unit__durations_sorted(heap, nodes);
+    if (!num) {
+        return;
+    }
+    print_text(f, title, UNIT_COLOR_BOLD);
+    unit__fputc('\n', f);
+    for (int i = 0; i < num; ++i) {
+        struct unit_test* node = nodes[i];
+        unit__fputs(unit_spaces[1], f);
+        begin_style(f, UNIT_COLOR_DESC);
+        unit__fprintf(f, "%10.2f ms", node->elapsed / 1000000.0);
+        end_style(f);
+        unit__fputs("  ", f);
+        unit__breadcrumbs(f, node, UNIT_COLOR_BOLD);
+        print_text(f, " @ ", UNIT_COLOR_COMMENT UNIT_COLOR_DIM UNIT_COLOR_BOLD);
+        begin_style(f, UNIT_COLOR_COMMENT UNIT_COLOR_UNDERLINE);
+        unit__fprintf(f, "%s:%d", beautify_filename(node->file), node->line);
         end_style(f);
-        fputc('\n', f);
+        unit__fputc('\n', f);
     }
-    fputc('\n', f);
+    unit__fputc('\n', f);
 }
 
 // endregion reporting
@@ -279,9 +626,16 @@ void printer_def_fail(struct unit_test* unit, const char* msg) {
 static void printer_def(int cmd, struct unit_test* unit, const char* msg) {
     switch (cmd) {
         case UNIT__PRINTER_SETUP:
-            fputs(unit__opts.ascii ? "\n[ unit ] v" UNIT_VERSION "\n\n" :
-                  "\n\033[1;30;42m" " ✓ηỉτ " "\033[0;30;46m" " v" UNIT_VERSION " " "\33[m\n\n", stdout);
-            print_wait(stdout);
+            unit__fputs(unit__opts.ascii ? "\n[ unit ] v" UNIT_VERSION "\n\n" :
+                  "\n\033[1;30;42m" " ✓ηỉτ " "\033[0;30;46m" " v" UNIT_VERSION " " "\33[m\n\n", unit__printer_out);
+            print_env(unit__printer_out);
+            unit__fputc('\n', unit__printer_out);
+            print_wait(unit__printer_out);
+            break;
+        case UNIT__PRINTER_SHUTDOWN:
+            print_durations(unit__printer_out, "slowest tests:", &unit__slowest_tests);
+            print_durations(unit__printer_out, "slowest suites:", &unit__slowest_suites);
+            unit__output_flush(unit__printer_out);
             break;
         case UNIT__PRINTER_BEGIN:
             printer_def_begin(unit);
@@ -290,10 +644,10 @@ static void printer_def(int cmd, struct unit_test* unit, const char* msg) {
             printer_def_end(unit);
             break;
         case UNIT__PRINTER_FAIL:
-            printer_def_fail(unit, msg);
+            printer_def_fail(unit);
             break;
             //case UNIT__PRINTER_ASSERTION:
-            //    fputs(icon(unit->assert_status), stdout);
+            //    unit__fputs(icon(unit->assert_status), stdout);
             //    print_wait(stdout);
             //    break;
     }
@@ -307,45 +661,59 @@ static const char* trace_spaces(int delta) {
 }
 
 static void printer_tracing(int cmd, struct unit_test* unit, const char* msg) {
-    FILE* f = stdout;
+    FILE* f = unit__printer_out;
     switch (cmd) {
+        case UNIT__PRINTER_SETUP:
+            print_env(f);
+            break;
+        case UNIT__PRINTER_SHUTDOWN:
+            unit__fputc('\n', f);
+            print_durations(f, "slowest tests:", &unit__slowest_tests);
+            print_durations(f, "slowest suites:", &unit__slowest_suites);
+            break;
         case UNIT__PRINTER_BEGIN:
-            fputs(trace_spaces(0), f);
+            unit__fputs(trace_spaces(0), f);
             print_text(f, beautify_name(unit->name), UNIT_COLOR_BOLD);
             print_text(f, " {\n", UNIT_COLOR_DIM);
             ++trace_depth;
             break;
         case UNIT__PRINTER_END:
             --trace_depth;
-            fputs(trace_spaces(0), f);
-            print_text(f, "}\n", UNIT_COLOR_DIM);
+            unit__fputs(trace_spaces(0), f);
+            print_text(f, "}", UNIT_COLOR_DIM);
+            print_elapsed_time(f, unit);
+            print_resources(f, unit);
+            unit__fputc('\n', f);
+            if (!unit->parent) {
+                unit__output_flush(f);
+            }
             break;
         case UNIT__PRINTER_ECHO:
-            fputs(trace_spaces(0), f);
-            fputs(icon(ICON_MSG), f);
+            unit__fputs(trace_spaces(0), f);
+            unit__fputs(icon(ICON_MSG), f);
             print_text(f, msg, UNIT_COLOR_COMMENT);
-            fputc('\n', f);
+            unit__fputc('\n', f);
             break;
         case UNIT__PRINTER_FAIL:
-            fputs(trace_spaces(0), f);
-            fputs("    Failed: ", f);
-            fputs(beautify_name(unit->name), f);
-            fputc('\n', f);
-
-            fputs(trace_spaces(0), f);
-            fputs("    ", f);
-            fputs(msg, f);
-            fputc('\n', f);
+            unit__fputs(trace_spaces(0), f);
+            unit__fputs("    Failed: ", f);
+            unit__fputs(beautify_name(unit->name), f);
+            unit__fputc('\n', f);
+
+            unit__fputs(trace_spaces(0), f);
+            unit__fputs("    ", f);
+            print_fail_message(f, unit);
+            unit__fputc('\n', f);
             break;
         case UNIT__PRINTER_ASSERTION: {
-            fputs(trace_spaces(0), f);
-            fputs(icon(unit->assert_status), f);
+            unit__fputs(trace_spaces(0), f);
+            unit__fputs(icon(unit->assert_status), f);
 
             const char* cm = unit->assert_comment;
             const char* desc = (cm && cm[0] != '\0') ? cm : unit->assert_desc;
-            fputs(desc, f);
+            unit__fputs(desc, f);
 
-            fputc('\n', f);
+            unit__fputc('\n', f);
         }
             break;
     }
@@ -353,6 +721,12 @@ static void printer_tracing(int cmd, struct unit_test* unit, const char* msg) {
 
 // endregion
 
+static int doctest_depth = 0;
+
+static const char* doctest_spaces(int delta) {
+    return get_spaces(doctest_depth + delta);
+}
+
 static const char* doctest_get_node_type(struct unit_test* node) {
     if (node->parent) {
         if (node->parent->parent) {
@@ -363,16 +737,39 @@ static const char* doctest_get_node_type(struct unit_test* node) {
     return "TestSuite";
 }
 
+static void print_xml_path(FILE* f, struct unit_test* node) {
+    if (node->parent) {
+        print_xml_path(f, node->parent);
+        unit__fputs(" &gt; ", f);
+    }
+    print_xml_string(f, beautify_name(node->name));
+}
+
+static void print_xml_durations(FILE* f, const char* type, const struct unit__durations* heap) {
+    struct unit_test* nodes[UNIT_DURATIONS_MAX];
+    const int num = unit__durations_sorted(heap, nodes);
+    for (int i = 0; i < num; ++i) {
+        unit__fprintf(f, "  <Slowest type=\"%s\" path=\"", type);
+        print_xml_path(f, nodes[i]);
+        unit__fputs("\" filename=\"", f);
+        print_xml_string(f, beautify_filename(nodes[i]->file));
+        unit__fprintf(f, "\" line=\"%d\" duration=\"%0.6f\"/>\n", nodes[i]->line, nodes[i]->elapsed / 1e9);
+    }
+}
+
 static void printer_xml_doctest(int cmd, struct unit_test* node, const char* msg) {
-    FILE* f = stdout;
+    FILE* f = unit__printer_out;
     switch (cmd) {
         case UNIT__PRINTER_SETUP:
-            fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+            unit__fprintf(f, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
             // binary="/absolute/path/to/test/executable"
-            fprintf(f, "<unit version=\"" UNIT_VERSION "\">\n");
-            fprintf(f,
+            unit__fprintf(f, "<unit version=\"" UNIT_VERSION "\">\n");
+            unit__fprintf(f, "  <!-- cpus=\"%s\" cpus_count=\"%d\" governor=\"%s\" jitter=\"%0.4f\" clock=\"%s\" -->\n",
+                    unit__env.cpus[0] ? unit__env.cpus : "any", unit__env.cpus_count,
+                    unit__env.governor, unit__env.jitter, unit__clock.name);
+            unit__fprintf(f,
                     "  <Options order_by=\"file\" rand_seed=\"0\" first=\"0\" last=\"4294967295\" abort_after=\"0\" subcase_filter_levels=\"2147483647\" case_sensitive=\"false\" no_throw=\"false\" no_skip=\"false\"/>\n");
-            ++def_depth;
+            ++doctest_depth;
             break;
         case UNIT__PRINTER_SHUTDOWN: {
             int total = 0;
@@ -381,44 +778,65 @@ static void printer_xml_doctest(int cmd, struct unit_test* node, const char* msg
                 passed += u->passed;
                 total += u->total;
             }
-            fprintf(f, "  <OverallResultsTestCases successes=\"%d\" failures=\"%d\" expectedFailures=\"%d\" />\n",
+            unit__fprintf(f, "  <OverallResultsTestCases successes=\"%d\" failures=\"%d\" expectedFailures=\"%d\" />\n",
                     passed, total - passed, 0);
+            print_xml_durations(f, "test", &unit__slowest_tests);
+            print_xml_durations(f, "suite", &unit__slowest_suites);
         }
-            --def_depth;
-            fprintf(f, "</unit>\n");
-            fflush(f);
+            --doctest_depth;
+            unit__fprintf(f, "</unit>\n");
+            unit__output_flush(f);
             break;
         case UNIT__PRINTER_BEGIN:
-            fputs(unit__spaces(0), f);
-            fprintf(f, "<%s name=\"%s\" filename=\"%s\" line=\"%d\" skipped=\"%s\">\n", doctest_get_node_type(node),
-                    node->name, node->file,
-                    node->line, node->status == UNIT_STATUS_SKIPPED ? "true" : "false");
-            ++def_depth;
+            unit__fputs(doctest_spaces(0), f);
+            unit__fprintf(f, "<%s name=\"", doctest_get_node_type(node));
+            print_xml_string(f, node->name);
+            unit__fputs("\" filename=\"", f);
+            print_xml_string(f, node->file);
+            unit__fprintf(f, "\" line=\"%d\" skipped=\"%s\">\n", node->line,
+                    node->status == UNIT_STATUS_SKIPPED ? "true" : "false");
+            ++doctest_depth;
             break;
         case UNIT__PRINTER_END:
-            --def_depth;
-            fputs(unit__spaces(0), f);
-            fprintf(f, "</%s>\n", doctest_get_node_type(node));
+            if (unit__opts.resources) {
+                const struct unit_resources* r = &node->res;
+                unit__fputs(doctest_spaces(0), f);
+                unit__fprintf(f, "<!-- user_ns=\"%lld\" sys_ns=\"%lld\" rss_delta=\"%lld\" max_rss=\"%lld\" minflt=\"%lld\" majflt=\"%lld\" nvcsw=\"%lld\" nivcsw=\"%lld\" -->\n",
+                        (long long) r->user, (long long) r->sys, (long long) r->rss, (long long) r->max_rss,
+                        (long long) r->minflt, (long long) r->majflt, (long long) r->nvcsw, (long long) r->nivcsw);
+            }
+            --doctest_depth;
+            unit__fputs(doctest_spaces(0), f);
+            unit__fprintf(f, "</%s>\n", doctest_get_node_type(node));
             break;
         case UNIT__PRINTER_FAIL:
-            fputs(unit__spaces(0), f);
-            fprintf(f, "<Expression success=\"%s\" type=\"%s\" filename=\"%s\" line=\"%d\">\n",
-                    node->status != UNIT_STATUS_FAILED ? "true" : "false", "REQUIRE",
-                    beautify_filename(node->assert_file), node->assert_line);
-            fputs(unit__spaces(1), f);
-            fprintf(f, "<Original>\n");
-            fputs(unit__spaces(1), f);
-            fprintf(f, "%s\n", node->assert_desc);
-            fputs(unit__spaces(1), f);
-            fprintf(f, "</Original>\n");
-            fputs(unit__spaces(1), f);
-            fprintf(f, "<Expanded>\n");
-            fputs(unit__spaces(1), f);
-            fprintf(f, "%s\n", node->assert_desc);
-            fputs(unit__spaces(1), f);
-            fprintf(f, "</Expanded>\n");
-            fputs(unit__spaces(0), f);
-            fprintf(f, "</Expression>\n");
+            unit__fputs(doctest_spaces(0), f);
+            unit__fprintf(f, "<Expression success=\"%s\" type=\"%s\" filename=\"",
+                    node->status != UNIT_STATUS_FAILED ? "true" : "false", "REQUIRE");
+            print_xml_string(f, beautify_filename(node->assert_file));
+            unit__fprintf(f, "\" line=\"%d\">\n", node->assert_line);
+            unit__fputs(doctest_spaces(1), f);
+            unit__fprintf(f, "<Original>\n");
+            unit__fputs(doctest_spaces(1), f);
+            print_xml_string(f, node->assert_desc);
+            unit__fputc('\n', f);
+            unit__fputs(doctest_spaces(1), f);
+            unit__fprintf(f, "</Original>\n");
+            unit__fputs(doctest_spaces(1), f);
+            unit__fprintf(f, "<Expanded>\n");
+            unit__fputs(doctest_spaces(1), f);
+            if (node->fail_record) {
+                char expanded[UNIT_FAIL_TEXT];
+                unit__format_fail_plain(expanded, sizeof expanded, node->fail_record);
+                print_xml_string(f, expanded);
+            } else {
+                print_xml_string(f, node->assert_desc);
+            }
+            unit__fputc('\n', f);
+            unit__fputs(doctest_spaces(1), f);
+            unit__fprintf(f, "</Expanded>\n");
+            unit__fputs(doctest_spaces(0), f);
+            unit__fprintf(f, "</Expression>\n");
             break;
     }
 }
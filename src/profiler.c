@@ -0,0 +1,248 @@
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__) && defined(__has_include)
+#if __has_include(<execinfo.h>)
+
+#include <errno.h>
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/time.h>
+
+#define UNIT__HAS_PROFILER 1
+
+#endif // <execinfo.h>
+#endif // unix
+
+// region профилировщик: `--profile`, сэмплы SIGPROF в folded stacks для flame graphs
+
+#ifndef UNIT_PROFILE_SAMPLES
+// capacity of the samples ring, drained after each node
+#define UNIT_PROFILE_SAMPLES 4096
+#endif
+
+#ifndef UNIT_PROFILE_DEPTH
+// maximum number of captured frames for the single sample
+#define UNIT_PROFILE_DEPTH 48
+#endif
+
+#ifndef UNIT_PROFILE_HZ
+#define UNIT_PROFILE_HZ 1000
+#endif
+
+#ifdef UNIT__HAS_PROFILER
+
+struct unit__sample {
+    struct unit_test* node;
+    int depth;
+    void* frames[UNIT_PROFILE_DEPTH];
+};
+
+static struct unit__sample unit__profile_ring[UNIT_PROFILE_SAMPLES];
+// written only by signal handler
+static unsigned unit__profile_head = 0;
+// written only by the runner when samples are drained
+static unsigned unit__profile_tail = 0;
+static unsigned unit__profile_dropped = 0;
+static FILE* unit__profile_file = NULL;
+static struct sigaction unit__profile_prev_action;
+
+static void unit__profile_handler(int sig) {
+    (void) sig;
+    const int prev_errno = errno;
+    const unsigned head = __atomic_load_n(&unit__profile_head, __ATOMIC_RELAXED);
+    const unsigned tail = __atomic_load_n(&unit__profile_tail, __ATOMIC_ACQUIRE);
+    if (head - tail < UNIT_PROFILE_SAMPLES) {
+        struct unit__sample* sample = unit__profile_ring + head % UNIT_PROFILE_SAMPLES;
+        sample->node = unit_cur;
+        sample->depth = backtrace(sample->frames, UNIT_PROFILE_DEPTH);
+        __atomic_store_n(&unit__profile_head, head + 1, __ATOMIC_RELEASE);
+    } else {
+        __atomic_fetch_add(&unit__profile_dropped, 1, __ATOMIC_RELAXED);
+    }
+    errno = prev_errno;
+}
+
+#define UNIT__PROFILE_LINE 4096
+
+struct unit__profile_line {
+    char text[UNIT__PROFILE_LINE];
+    size_t len;
+};
+
+static void unit__profile_append(struct unit__profile_line* line, const char* str, size_t len) {
+    for (size_t i = 0; i < len && str[i] && line->len + 1 < UNIT__PROFILE_LINE; ++i) {
+        // `;` separates frames in folded format
+        const char c = str[i] == ';' ? ':' : str[i];
+        line->text[line->len++] = c == '\n' ? ' ' : c;
+    }
+    line->text[line->len] = 0;
+}
+
+static void unit__profile_append_separator(struct unit__profile_line* line) {
+    if (line->len + 1 < UNIT__PROFILE_LINE) {
+        line->text[line->len++] = ';';
+        line->text[line->len] = 0;
+    }
+}
+
+static void unit__profile_append_path(struct unit__profile_line* line, struct unit_test* node) {
+    if (node) {
+        if (node->parent) {
+            unit__profile_append_path(line, node->parent);
+            unit__profile_append_separator(line);
+        }
+        const char* name = beautify_name(node->name);
+        unit__profile_append(line, name, strlen(name));
+    } else {
+        unit__profile_append(line, "(runner)", 8);
+    }
+}
+
+/**
+ * Extracts function name from `backtrace_symbols` format: `module(function+0x1f) [0xaddress]`,
+ * falls back to `module+offset` for symbols which are not exported
+ */
+static void unit__profile_append_symbol(struct unit__profile_line* line, const char* symbol) {
+    const char* begin = strchr(symbol, '(');
+    const char* end = begin ? strpbrk(begin, "+)") : NULL;
+    if (begin && end && end > begin + 1) {
+        unit__profile_append(line, begin + 1, (size_t) (end - begin - 1));
+        return;
+    }
+    const char* module = short_filename(symbol);
+    const char* module_end = strpbrk(module, "( ");
+    unit__profile_append(line, module, module_end ? (size_t) (module_end - module) : strlen(module));
+    const char* offset = begin ? strchr(begin, '+') : NULL;
+    if (offset) {
+        const char* offset_end = strchr(offset, ')');
+        unit__profile_append(line, offset, offset_end ? (size_t) (offset_end - offset) : strlen(offset));
+    }
+}
+
+/**
+ * Formats folded stack: test path as root frames, then call stack from the outermost frame
+ */
+static void unit__profile_format(struct unit__profile_line* line, const struct unit__sample* sample) {
+    line->len = 0;
+    unit__profile_append_path(line, sample->node);
+    // skip signal handler and signal trampoline frames
+    const int skip = 2;
+    if (sample->depth > skip) {
+        char** symbols = backtrace_symbols(sample->frames + skip, sample->depth - skip);
+        for (int i = sample->depth - skip - 1; symbols && i >= 0; --i) {
+            unit__profile_append_separator(line);
+            unit__profile_append_symbol(line, symbols[i]);
+        }
+        free(symbols);
+    }
+}
+
+/**
+ * Writes collected samples, equal consecutive stacks are merged to single line
+ */
+static void unit__profile_drain(void) {
+    static struct unit__profile_line lines[2];
+    const unsigned head = __atomic_load_n(&unit__profile_head, __ATOMIC_ACQUIRE);
+    unsigned tail = unit__profile_tail;
+    struct unit__profile_line* prev = NULL;
+    int count = 0;
+    for (; tail != head; ++tail) {
+        struct unit__profile_line* line = lines + (prev == lines ? 1 : 0);
+        unit__profile_format(line, unit__profile_ring + tail % UNIT_PROFILE_SAMPLES);
+        if (prev && prev->len == line->len && memcmp(prev->text, line->text, line->len) == 0) {
+            ++count;
+            continue;
+        }
+        if (prev) {
+            fprintf(unit__profile_file, "%s %d\n", prev->text, count);
+        }
+        prev = line;
+        count = 1;
+    }
+    if (prev) {
+        fprintf(unit__profile_file, "%s %d\n", prev->text, count);
+    }
+    __atomic_store_n(&unit__profile_tail, head, __ATOMIC_RELEASE);
+}
+
+/**
+ * Drains samples of the ended node with the timer paused: symbolizing calls `malloc` and `dladdr`,
+ * and `unit_cur` is still the ended node, so its samples would be counted against the test
+ */
+static void unit__profile_drain_paused(void) {
+    const struct itimerval paused = {{0, 0}, {0, 0}};
+    struct itimerval timer;
+    setitimer(ITIMER_PROF, &paused, &timer);
+    unit__profile_drain();
+    if (timer.it_value.tv_sec == 0 && timer.it_value.tv_usec == 0) {
+        // zero remaining time would disarm the timer
+        timer.it_value = timer.it_interval;
+    }
+    setitimer(ITIMER_PROF, &timer, NULL);
+}
+
+static void unit__profile_start(void) {
+    unit__profile_file = fopen(unit__opts.profile_out, "w");
+    if (!unit__profile_file) {
+        fprintf(stderr, "unit: warning: unable to open profile file `%s`\n", unit__opts.profile_out);
+        return;
+    }
+    // `backtrace` loads unwinder lazily on the first call, it should not happen inside signal handler
+    void* warmup[1];
+    backtrace(warmup, 1);
+    unit__profile_head = 0;
+    unit__profile_tail = 0;
+    unit__profile_dropped = 0;
+
+    struct sigaction action = {0};
+    action.sa_handler = unit__profile_handler;
+    action.sa_flags = SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, &unit__profile_prev_action);
+
+    const long interval = 1000000 / UNIT_PROFILE_HZ;
+    struct itimerval timer = {{0, interval}, {0, interval}};
+    setitimer(ITIMER_PROF, &timer, NULL);
+}
+
+static void unit__profile_stop(void) {
+    if (!unit__profile_file) {
+        return;
+    }
+    struct itimerval timer = {{0, 0}, {0, 0}};
+    setitimer(ITIMER_PROF, &timer, NULL);
+    sigaction(SIGPROF, &unit__profile_prev_action, NULL);
+    unit__profile_drain();
+    fclose(unit__profile_file);
+    unit__profile_file = NULL;
+    if (unit__profile_dropped && !unit__opts.quiet) {
+        fprintf(stderr, "unit: warning: profiler dropped %u samples, increase UNIT_PROFILE_SAMPLES\n",
+                unit__profile_dropped);
+    }
+}
+
+#endif // UNIT__HAS_PROFILER
+
+static void printer_profile(int cmd, struct unit_test* unit, const char* msg) {
+    (void) unit;
+    (void) msg;
+#ifdef UNIT__HAS_PROFILER
+    switch (cmd) {
+        case UNIT__PRINTER_SETUP:
+            unit__profile_start();
+            break;
+        case UNIT__PRINTER_SHUTDOWN:
+            unit__profile_stop();
+            break;
+        case UNIT__PRINTER_END:
+            if (unit__profile_file) {
+                unit__profile_drain_paused();
+            }
+            break;
+    }
+#else // UNIT__HAS_PROFILER
+    if (cmd == UNIT__PRINTER_SETUP && !unit__opts.quiet) {
+        fputs("unit: warning: `--profile` is not supported on this platform\n", stderr);
+    }
+#endif // !UNIT__HAS_PROFILER
+}
+
+// endregion
@@ -0,0 +1,578 @@
+// region тесты свойств: `PROPERTY`, генераторы поверх записанных выборов xoshiro256** и сжатие контрпримера
+
+#ifndef UNIT_PROPERTY_DRAWS
+// maximum number of random draws recorded for the single case, longer cases are reported without shrinking
+#define UNIT_PROPERTY_DRAWS 4096
+#endif
+
+#ifndef UNIT_PROPERTY_SHRINKS
+// maximum number of runs spent on shrinking the failed case
+#define UNIT_PROPERTY_SHRINKS 10000
+#endif
+
+#ifndef UNIT_PROPERTY_EXAMPLE
+// capacity of the printed counterexample
+#define UNIT_PROPERTY_EXAMPLE 1024
+#endif
+
+// the largest chunk of draws deleted or zeroed by the single shrink step
+#define UNIT__SHRINK_CHUNK 8
+
+enum {
+    UNIT__PROP_START = 0,
+    UNIT__PROP_GENERATE = 1,
+    UNIT__PROP_SHRINK = 2,
+    UNIT__PROP_REPORT = 3,
+
+    UNIT__SHRINK_DELETE = 0,
+    UNIT__SHRINK_ZERO = 1,
+    UNIT__SHRINK_MINIMIZE = 2,
+    UNIT__SHRINK_SWEEP = 3,
+};
+
+// every generated value is made from recorded draws, so the case is shrunk by simplifying draws and running it again:
+// generators map smaller draws to simpler values and the zero draw to the simplest one
+struct unit__prop {
+    // running property node, NULL outside of `PROPERTY`
+    struct unit_test* node;
+    int phase;
+    // failures of probing runs are counted without reporting
+    bool probing;
+    bool failed;
+    // draws are taken from `rng` or replayed from `replay`
+    bool random;
+    // the case took more draws than recorded
+    bool overflow;
+    int64_t cases;
+    int64_t cases_num;
+    int64_t failed_case;
+    int shrinks;
+    uint64_t seed;
+    uint64_t rng[4];
+    uint64_t draws[UNIT_PROPERTY_DRAWS];
+    // marks draws of lengths, the length is decremented together with deleted elements
+    unsigned char lens[UNIT_PROPERTY_DRAWS];
+    uint32_t draws_num;
+    uint64_t replay[UNIT_PROPERTY_DRAWS];
+    uint32_t replay_num;
+    // the simplest failed case found so far, it's regenerated from the seed if its draws were not recorded
+    uint64_t best[UNIT_PROPERTY_DRAWS];
+    unsigned char best_lens[UNIT_PROPERTY_DRAWS];
+    uint32_t best_num;
+    bool best_random;
+    // shrink cursor: the pass, the chunk at `index`, the search range of the draw at `index` without its lowest bit
+    int pass;
+    uint32_t size;
+    uint32_t index;
+    bool adjust;
+    uint64_t lo;
+    uint64_t hi;
+    bool improved;
+    // printers events and the node state are restored for the reported run
+    unsigned events;
+    int state;
+    struct unit__text example;
+    char example_data[UNIT_PROPERTY_EXAMPLE];
+};
+
+static struct unit__prop unit__prop;
+
+// reports the counterexample with the last failed assertion site, see `unit.c`
+static void unit__fail_text(const char* text);
+
+static void unit__format_path(char* path, size_t size, struct unit_test* parent, const char* name);
+
+static uint64_t unit__splitmix64(uint64_t* x) {
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static inline uint64_t unit__rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// xoshiro256** by David Blackman and Sebastiano Vigna
+static inline uint64_t unit__xoshiro(uint64_t* s) {
+    const uint64_t result = unit__rotl(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = unit__rotl(s[3], 45);
+    return result;
+}
+
+// each case has its own stream, so the case is regenerated from the seed and its index alone
+static void unit__prop_seed(uint64_t* s, uint64_t seed, int64_t index) {
+    uint64_t x = seed ^ ((uint64_t) index * 0xD1B54A32D192ED03ull);
+    for (int i = 0; i < 4; ++i) {
+        s[i] = unit__splitmix64(&x);
+    }
+}
+
+static uint64_t unit__prop_draw(void) {
+    struct unit__prop* p = &unit__prop;
+    if (p->draws_num >= UNIT_PROPERTY_DRAWS) {
+        p->overflow = true;
+        return p->random ? unit__xoshiro(p->rng) : 0;
+    }
+    // replayed case is completed with zero draws, they give the simplest values
+    const uint64_t v = p->random ? unit__xoshiro(p->rng) :
+                       (p->draws_num < p->replay_num ? p->replay[p->draws_num] : 0);
+    p->lens[p->draws_num] = 0;
+    p->draws[p->draws_num++] = v;
+    return v;
+}
+
+// the draw reduced to `[0, span]` is recorded instead of the raw one, so shrinking searches the index of the value
+static uint64_t unit__prop_draw_index(uint64_t span) {
+    struct unit__prop* p = &unit__prop;
+    const uint32_t at = p->draws_num;
+    const uint64_t v = unit__prop_draw();
+    const uint64_t k = span == UINT64_MAX ? v : v % (span + 1);
+    if (at < p->draws_num) {
+        p->draws[at] = k;
+    }
+    return k;
+}
+
+__attribute__((format(printf, 1, 2)))
+static void unit__prop_example(const char* fmt, ...) {
+    struct unit__prop* p = &unit__prop;
+    if (!p->node || p->phase != UNIT__PROP_REPORT) {
+        return;
+    }
+    struct unit__text* text = &p->example;
+    if (text->len) {
+        unit__text_printf(text, ", ");
+    }
+    if (text->len + 1 >= text->cap) {
+        return;
+    }
+    va_list args;
+    va_start(args, fmt);
+    const int n = vsnprintf(text->data + text->len, text->cap - text->len, fmt, args);
+    va_end(args);
+    if (n > 0) {
+        text->len += (size_t) n;
+        if (text->len >= text->cap) {
+            text->len = text->cap - 1;
+        }
+    }
+}
+
+// maps the draw to the range, values are ordered by the distance from zero clamped to the range: 0, 1, -1, 2, -2...
+static int64_t unit__gen_int(int64_t min, int64_t max) {
+    if (max <= min) {
+        return min;
+    }
+    const uint64_t k = unit__prop_draw_index((uint64_t) max - (uint64_t) min);
+    const int64_t origin = min > 0 ? min : (max < 0 ? max : 0);
+    const uint64_t up = (uint64_t) max - (uint64_t) origin;
+    const uint64_t down = (uint64_t) origin - (uint64_t) min;
+    const uint64_t m = up < down ? up : down;
+    if (k <= 2 * m) {
+        return (int64_t) (k & 1 ? (uint64_t) origin + (k + 1) / 2 : (uint64_t) origin - k / 2);
+    }
+    // one side of the range is exhausted, the rest is on the other side
+    return (int64_t) (up > down ? (uint64_t) origin + (k - m) : (uint64_t) origin - (k - m));
+}
+
+int64_t unit_gen_int(int64_t min, int64_t max) {
+    const int64_t x = unit__gen_int(min, max);
+    unit__prop_example("%lld", (long long) x);
+    return x;
+}
+
+uint64_t unit_gen_uint(uint64_t min, uint64_t max) {
+    if (max <= min) {
+        return min;
+    }
+    const uint64_t x = min + unit__prop_draw_index(max - min);
+    unit__prop_example("%llu", (unsigned long long) x);
+    return x;
+}
+
+double unit_gen_double(double min, double max) {
+    if (!(max > min)) {
+        return min;
+    }
+    const uint64_t v = unit__prop_draw();
+    const double origin = min > 0.0 ? min : (max < 0.0 ? max : 0.0);
+    const double up = max - origin;
+    const double down = origin - min;
+    const double m = up < down ? up : down;
+    // the distance is uniform in the unfolded range, the lowest bit selects the side while both sides have room
+    const double d = (double) (v >> 11) * 0x1p-53 * (max - min);
+    double x;
+    if (d < 2.0 * m) {
+        x = v & 1 ? origin - 0.5 * d : origin + 0.5 * d;
+    } else {
+        x = up > down ? origin + (d - m) : origin - (d - m);
+    }
+    x = x < min ? min : (x > max ? max : x);
+    unit__prop_example("%.17g", x);
+    return x;
+}
+
+void unit_gen_bytes(void* buf, size_t size) {
+    unsigned char* dst = (unsigned char*) buf;
+    for (size_t i = 0; i < size; i += 8) {
+        const uint64_t v = unit__prop_draw();
+        const size_t n = size - i < 8 ? size - i : 8;
+        for (size_t j = 0; j < n; ++j) {
+            dst[i + j] = (unsigned char) (v >> (8 * j));
+        }
+    }
+    if (unit__prop.node && unit__prop.phase == UNIT__PROP_REPORT) {
+        char hex[3 * 32 + 1];
+        struct unit__text text = {hex, sizeof hex, 0};
+        hex[0] = 0;
+        for (size_t i = 0; i < size && i < 32; ++i) {
+            unit__text_printf(&text, i ? " %02x" : "%02x", dst[i]);
+        }
+        unit__prop_example(size > 32 ? "[%s ... (%zu bytes)]" : "[%s]", hex, size);
+    }
+}
+
+static size_t unit__gen_len(size_t max) {
+    struct unit__prop* p = &unit__prop;
+    const uint32_t at = p->draws_num;
+    const size_t n = (size_t) unit__gen_int(0, (int64_t) max);
+    if (at < p->draws_num) {
+        p->lens[at] = 1;
+    }
+    return n;
+}
+
+size_t unit_gen_len(size_t max) {
+    const size_t n = unit__gen_len(max);
+    unit__prop_example("len %zu", n);
+    return n;
+}
+
+size_t unit_gen_str(char* buf, size_t size, const char* alphabet) {
+    if (!size) {
+        return 0;
+    }
+    // printable ASCII, the first character is the simplest one
+    static const char printable[] = "a !\"#$%&'()*+,-./0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVWXYZ[\\]^_`bcdefghijklmnopqrstuvwxyz{|}~";
+    const char* chars = alphabet && *alphabet ? alphabet : printable;
+    const int64_t chars_num = (int64_t) strlen(chars);
+    const size_t len = unit__gen_len(size - 1);
+    for (size_t i = 0; i < len; ++i) {
+        buf[i] = chars[unit__gen_int(0, chars_num - 1)];
+    }
+    buf[len] = 0;
+    unit__prop_example("\"%s\"", buf);
+    return len;
+}
+
+// shortlex order: shorter sequence of draws is simpler, then the lexicographically smaller one
+static bool unit__prop_simpler(const uint64_t* a, uint32_t a_num, const uint64_t* b, uint32_t b_num) {
+    if (a_num != b_num) {
+        return a_num < b_num;
+    }
+    for (uint32_t i = 0; i < a_num; ++i) {
+        if (a[i] != b[i]) {
+            return a[i] < b[i];
+        }
+    }
+    return false;
+}
+
+static void unit__prop_keep(struct unit__prop* p) {
+    memcpy(p->best, p->draws, p->draws_num * sizeof *p->draws);
+    memcpy(p->best_lens, p->lens, p->draws_num);
+    p->best_num = p->draws_num;
+}
+
+static void unit__prop_sweep(struct unit__prop* p) {
+    p->pass = UNIT__SHRINK_DELETE;
+    p->size = UNIT__SHRINK_CHUNK;
+    p->index = 0;
+    p->adjust = false;
+    p->improved = false;
+}
+
+// the nearest length drawn before `index`, elements of the sequence follow its length
+static bool unit__prop_find_len(const struct unit__prop* p, uint32_t* at) {
+    for (uint32_t i = p->index; i-- > 0;) {
+        if (p->best_lens[i]) {
+            *at = i;
+            return p->best[i] >= p->size;
+        }
+    }
+    return false;
+}
+
+// builds the next candidate from the best failed case, returns false if the last sweep made no progress
+static bool unit__prop_candidate(struct unit__prop* p) {
+    for (;;) {
+        const uint32_t n = p->best_num;
+        if (p->pass == UNIT__SHRINK_DELETE || p->pass == UNIT__SHRINK_ZERO) {
+            if (p->index + p->size > n) {
+                if (p->size > 1) {
+                    p->size /= 2;
+                } else {
+                    ++p->pass;
+                    p->size = UNIT__SHRINK_CHUNK;
+                    p->adjust = false;
+                    p->lo = 0;
+                    p->hi = n ? p->best[0] >> 1 : 0;
+                }
+                p->index = 0;
+                continue;
+            }
+            memcpy(p->replay, p->best, n * sizeof *p->best);
+            if (p->pass == UNIT__SHRINK_DELETE) {
+                uint32_t len = 0;
+                if (p->adjust) {
+                    // the shorter sequence keeps the following draws in place
+                    if (!unit__prop_find_len(p, &len)) {
+                        p->adjust = false;
+                        ++p->index;
+                        continue;
+                    }
+                    p->replay[len] -= p->size;
+                }
+                memmove(p->replay + p->index, p->replay + p->index + p->size,
+                        (n - p->index - p->size) * sizeof *p->replay);
+                p->replay_num = n - p->size;
+                return true;
+            }
+            uint64_t any = 0;
+            for (uint32_t i = p->index; i < p->index + p->size; ++i) {
+                any |= p->replay[i];
+                p->replay[i] = 0;
+            }
+            if (any) {
+                p->replay_num = n;
+                return true;
+            }
+            ++p->index;
+        } else if (p->pass == UNIT__SHRINK_MINIMIZE) {
+            if (p->index >= n) {
+                ++p->pass;
+            } else if (p->lo < p->hi) {
+                // binary search of the smallest failing draw with the same lowest bit: it's the sign of zig-zagged
+                // integers and the side of doubles, so the value goes monotonically towards the origin
+                memcpy(p->replay, p->best, n * sizeof *p->best);
+                p->replay[p->index] = (p->lo + (p->hi - p->lo) / 2) << 1 | (p->best[p->index] & 1);
+                p->replay_num = n;
+                return true;
+            } else if (!p->adjust && p->best[p->index]) {
+                // the adjacent smaller draw flips the lowest bit: the boundary value of the other parity
+                memcpy(p->replay, p->best, n * sizeof *p->best);
+                p->replay[p->index] = p->best[p->index] - 1;
+                p->replay_num = n;
+                p->adjust = true;
+                return true;
+            } else {
+                ++p->index;
+                p->adjust = false;
+                p->lo = 0;
+                p->hi = p->index < n ? p->best[p->index] >> 1 : 0;
+            }
+        } else {
+            if (!p->improved) {
+                return false;
+            }
+            unit__prop_sweep(p);
+        }
+    }
+}
+
+// moves the shrink cursor after the candidate run
+static void unit__prop_shrunk(struct unit__prop* p, bool accepted) {
+    if (accepted) {
+        unit__prop_keep(p);
+        p->improved = true;
+    }
+    switch (p->pass) {
+        case UNIT__SHRINK_DELETE:
+            // the next chunk has moved to the same index, the rejected chunk is deleted with its length then
+            if (accepted || p->adjust) {
+                p->index += accepted ? 0 : 1;
+                p->adjust = false;
+            } else {
+                p->adjust = true;
+            }
+            break;
+        case UNIT__SHRINK_ZERO:
+            ++p->index;
+            break;
+        case UNIT__SHRINK_MINIMIZE:
+            if (p->adjust) {
+                // the smaller draw of the other parity is searched again
+                p->adjust = !accepted;
+                p->lo = 0;
+                p->hi = accepted && p->index < p->best_num ? p->best[p->index] >> 1 : 0;
+            } else if (accepted) {
+                p->hi = p->index < p->best_num ? p->best[p->index] >> 1 : 0;
+            } else {
+                p->lo = (p->replay[p->index] >> 1) + 1;
+            }
+            break;
+    }
+}
+
+static void unit__prop_stop(void) {
+    struct unit__prop* p = &unit__prop;
+    if (p->node) {
+        unit__events = p->events;
+        p->probing = false;
+        p->node = NULL;
+    }
+}
+
+static void unit__prop_fail(struct unit__prop* p, const char* what) {
+    static struct unit__assert_site site;
+    site.level = UNIT__LEVEL_CHECK;
+    site.file = p->node->file;
+    site.line = p->node->line;
+    site.comment = "";
+    site.desc = "property";
+    unit__tls.site = &site;
+
+    char path[512];
+    unit__format_path(path, sizeof path, p->node->parent, p->node->name);
+    char buffer[UNIT_PROPERTY_EXAMPLE + 1024];
+    struct unit__text text = {buffer, sizeof buffer, 0};
+    buffer[0] = 0;
+    unit__text_printf(&text, "%s case %lld of %lld", what, (long long) p->failed_case + 1, (long long) p->cases_num);
+    if (p->phase == UNIT__PROP_REPORT) {
+        unit__text_printf(&text, ", shrunk in %d runs to " UNIT__MARK_FAIL_S "(%s)" UNIT__MARK_RESET_S, p->shrinks,
+                          p->example.data);
+    }
+    unit__text_printf(&text, "\n    Reproduce with " UNIT__MARK_SUCCESS_S "`--seed=%u --filter=\"%s\"`" UNIT__MARK_RESET_S,
+                      unit__opts.seed, path);
+    unit__fail_text(buffer);
+}
+
+// the crash inside the case is reported by `--catch-crashes`, the case is reported to reproduce it
+static void unit__prop_crashed(void) {
+    struct unit__prop* p = &unit__prop;
+    if (p->node) {
+        const bool probing = p->probing;
+        if (p->phase == UNIT__PROP_GENERATE) {
+            p->failed_case = p->cases;
+        }
+        unit__events = p->events;
+        p->probing = false;
+        if (probing) {
+            unit__prop_fail(p, "Crashed at");
+        }
+        p->node = NULL;
+    }
+}
+
+void unit__prop_begin(struct unit_test* unit, int64_t cases) {
+    struct unit__prop* p = &unit__prop;
+    char path[512];
+    unit__format_path(path, sizeof path, unit->parent, unit->name);
+    // the stream depends on `--seed` and the test path, so cases don't change when other tests are added
+    uint64_t hash = 0xCBF29CE484222325ull;
+    for (const char* c = path; *c; ++c) {
+        hash = (hash ^ (unsigned char) *c) * 0x100000001B3ull;
+    }
+    uint64_t x = unit__opts.seed;
+    p->seed = hash ^ unit__splitmix64(&x);
+    p->node = unit;
+    p->phase = UNIT__PROP_START;
+    p->cases = 0;
+    p->cases_num = cases;
+    p->shrinks = 0;
+    p->failed = false;
+    p->events = unit__events;
+    p->state = __atomic_load_n(&unit__hot.state, __ATOMIC_RELAXED);
+    p->example = (struct unit__text) {p->example_data, sizeof p->example_data, 0};
+    p->example_data[0] = 0;
+    // passing assertions and echo of probing runs are not printed
+    p->probing = true;
+    unit__events &= ~(UNIT__EVENT(ASSERTION) | UNIT__EVENT(ECHO));
+}
+
+// failures posted by threads of the probing run fail its case without reporting, as failures of the tests thread do
+static void unit__prop_drain(struct unit__prop* p) {
+    struct unit__fail_node* node = unit__fail_take();
+    while (node) {
+        struct unit__fail_node* next = node->next;
+        p->failed = p->failed || node->record.site->level > UNIT__LEVEL_WARN;
+        unit__fail_free(node);
+        node = next;
+    }
+}
+
+bool unit__prop_next(void) {
+    struct unit__prop* p = &unit__prop;
+    if (!p->node) {
+        return false;
+    }
+    if (p->probing) {
+        unit__prop_drain(p);
+    }
+    switch (p->phase) {
+        case UNIT__PROP_START:
+            p->phase = UNIT__PROP_GENERATE;
+            break;
+        case UNIT__PROP_GENERATE:
+            if (p->failed) {
+                p->failed_case = p->cases;
+                unit__prop_keep(p);
+                p->best_random = p->overflow;
+                p->phase = p->overflow ? UNIT__PROP_REPORT : UNIT__PROP_SHRINK;
+                unit__prop_sweep(p);
+            } else if (++p->cases >= p->cases_num) {
+                unit__prop_stop();
+                return false;
+            }
+            break;
+        case UNIT__PROP_SHRINK:
+            ++p->shrinks;
+            unit__prop_shrunk(p, p->failed && !p->overflow &&
+                                 unit__prop_simpler(p->draws, p->draws_num, p->best, p->best_num));
+            break;
+        case UNIT__PROP_REPORT:
+            unit__prop_fail(p, "Falsified by");
+            unit__prop_stop();
+            return false;
+    }
+    if (p->phase == UNIT__PROP_SHRINK && (p->shrinks >= UNIT_PROPERTY_SHRINKS || !unit__prop_candidate(p))) {
+        p->phase = UNIT__PROP_REPORT;
+    }
+
+    p->failed = false;
+    p->overflow = false;
+    p->draws_num = 0;
+    __atomic_store_n(&unit__hot.state, p->state, __ATOMIC_RELAXED);
+    unit__fail_pool_reset();
+    switch (p->phase) {
+        case UNIT__PROP_GENERATE:
+            p->random = true;
+            unit__prop_seed(p->rng, p->seed, p->cases);
+            break;
+        case UNIT__PROP_SHRINK:
+            p->random = false;
+            break;
+        case UNIT__PROP_REPORT:
+            // the simplest case is run once more with printers to report its failures and values
+            unit__events = p->events;
+            p->probing = false;
+            p->random = p->best_random;
+            if (p->best_random) {
+                unit__prop_seed(p->rng, p->seed, p->failed_case);
+            } else {
+                memcpy(p->replay, p->best, p->best_num * sizeof *p->best);
+                p->replay_num = p->best_num;
+            }
+            break;
+    }
+    return true;
+}
+
+// endregion
@@ -0,0 +1,317 @@
+// region построение отчёта из журнала событий: запуск существующих принтеров без запуска тестов, из файла или в потоке отчётов
+
+struct unit__log_reader {
+    // reads exactly `size` bytes, returns false at the end of the log
+    bool (* read)(struct unit__log_reader* reader, void* data, size_t size);
+    FILE* file;
+    // printers notified by the replay
+    struct unit_printer* printers;
+    char** strings;
+    uint32_t strings_num;
+    // the last transient string, it is overwritten by the next one
+    char* transient;
+    size_t transient_cap;
+    struct unit_test** nodes;
+    uint32_t nodes_num;
+    // declared root nodes and the node being replayed
+    struct unit_test* roots;
+    struct unit_test* roots_last;
+    struct unit_test* cur;
+    // failures of the current test, they are valid until the next test begins like the failures pool
+    struct unit__fail_record fails[UNIT_FAIL_RECORDS];
+    struct unit__assert_site sites[UNIT_FAIL_RECORDS];
+    int fails_num;
+    char fails_text[UNIT_FAIL_TEXT];
+    size_t fails_text_len;
+    int failed;
+};
+
+static bool unit__log_read_file(struct unit__log_reader* reader, void* data, size_t size) {
+    return fread(data, 1, size, reader->file) == size;
+}
+
+static bool unit__log_reserve(void** items, uint32_t num, size_t item_size) {
+    // ids are sequential, so the array grows when id reaches the power of two
+    if (num & (num - 1)) {
+        return true;
+    }
+    void* grown = realloc(*items, 2 * (num ? num : 1) * item_size);
+    if (!grown) {
+        return false;
+    }
+    *items = grown;
+    return true;
+}
+
+static const char* unit__log_get_string(struct unit__log_reader* reader, uint32_t id) {
+    if (id == UNIT__LOG_TRANSIENT) {
+        return reader->transient;
+    }
+    return id && id <= reader->strings_num ? reader->strings[id - 1] : NULL;
+}
+
+static struct unit_test* unit__log_get_node(struct unit__log_reader* reader, uint32_t id) {
+    return id && id <= reader->nodes_num ? reader->nodes[id - 1] : NULL;
+}
+
+static bool unit__log_read_string(struct unit__log_reader* reader, const struct unit__log_record* r) {
+    const size_t size = (r->string.len + sizeof *r) / sizeof *r * sizeof *r;
+    if (r->status) {
+        if (size > reader->transient_cap) {
+            char* grown = (char*) realloc(reader->transient, size);
+            if (!grown) {
+                return false;
+            }
+            reader->transient = grown;
+            reader->transient_cap = size;
+        }
+        if (!reader->read(reader, reader->transient, size)) {
+            return false;
+        }
+        reader->transient[r->string.len] = 0;
+        return true;
+    }
+    char* str = (char*) malloc(size);
+    if (!str || !reader->read(reader, str, size) ||
+        !unit__log_reserve((void**) &reader->strings, reader->strings_num, sizeof *reader->strings)) {
+        free(str);
+        return false;
+    }
+    str[r->string.len] = 0;
+    reader->strings[reader->strings_num++] = str;
+    return true;
+}
+
+static bool unit__log_read_node(struct unit__log_reader* reader, const struct unit__log_record* r) {
+    struct unit_test* node = (struct unit_test*) calloc(1, sizeof *node);
+    if (!node || !unit__log_reserve((void**) &reader->nodes, reader->nodes_num, sizeof *reader->nodes)) {
+        free(node);
+        return false;
+    }
+    node->type = r->status;
+    node->name = unit__log_get_string(reader, r->node.name);
+    node->file = unit__log_get_string(reader, r->node.file);
+    node->line = r->node.line;
+    struct unit_test* parent = unit__log_get_node(reader, r->node.parent);
+    if (parent) {
+        add_child(parent, node);
+    } else if (reader->roots_last) {
+        reader->roots_last->next = node;
+        reader->roots_last = node;
+    } else {
+        reader->roots = reader->roots_last = node;
+    }
+    reader->nodes[reader->nodes_num++] = node;
+    return true;
+}
+
+static void unit__log_replay_setup(struct unit__log_reader* reader, const struct unit__log_record* r) {
+    const char* clock = unit__log_get_string(reader, r->setup.clock);
+    const char* governor = unit__log_get_string(reader, r->setup.governor);
+    const char* cpus = unit__log_get_string(reader, r->setup.cpus);
+    // environment of the recorded run is printed instead of the current one
+    unit__clock.name = clock ? clock : "unknown";
+    unit__clock.overhead = r->setup.overhead;
+    snprintf(unit__env.governor, sizeof unit__env.governor, "%s", governor ? governor : "unknown");
+    snprintf(unit__env.cpus, sizeof unit__env.cpus, "%s", cpus ? cpus : "");
+    unit__env.cpus_count = r->setup.cpus_count;
+    unit__env.calibration = r->setup.calibration;
+    unit__env.jitter = r->setup.jitter;
+    UNIT__EACH_PRINTER_IN(reader->printers, SETUP, 0, 0);
+}
+
+static void unit__log_replay_assert(struct unit__log_reader* reader, struct unit_test* node,
+                                    const struct unit__log_record* r) {
+    node->assert_site = NULL;
+    node->assert_level = r->fail.level;
+    node->assert_file = unit__log_get_string(reader, r->fail.file);
+    node->assert_line = r->fail.line;
+    node->assert_desc = unit__log_get_string(reader, r->fail.desc);
+    node->assert_comment = unit__log_get_string(reader, r->fail.comment);
+    node->assert_status = r->status;
+}
+
+// copies the transient text to the per-test arena, truncates it if the arena is full
+static const char* unit__log_keep_text(struct unit__log_reader* reader, const char* str) {
+    const size_t available = sizeof reader->fails_text - reader->fails_text_len;
+    if (!str || !available) {
+        return "";
+    }
+    size_t len = strlen(str);
+    if (len >= available) {
+        len = available - 1;
+    }
+    char* copy = reader->fails_text + reader->fails_text_len;
+    memcpy(copy, str, len);
+    copy[len] = 0;
+    reader->fails_text_len += len + 1;
+    return copy;
+}
+
+static void unit__log_replay_fail(struct unit__log_reader* reader, struct unit_test* node,
+                                  const struct unit__log_record* r) {
+    const int i = reader->fails_num < UNIT_FAIL_RECORDS ? reader->fails_num++ : UNIT_FAIL_RECORDS - 1;
+    struct unit__fail_record* record = reader->fails + i;
+    struct unit__assert_site* site = reader->sites + i;
+    unit__log_replay_assert(reader, node, r);
+    site->level = node->assert_level;
+    site->file = node->assert_file;
+    site->line = node->assert_line;
+    site->desc = node->assert_desc;
+    site->comment = node->assert_comment;
+    memset(record, 0, sizeof *record);
+    record->kind = UNIT__FAIL_TEXT;
+    record->site = site;
+    record->text = unit__log_keep_text(reader, r->fail.text ? unit__log_get_string(reader, r->fail.text) : site->desc);
+    node->assert_site = site;
+    node->fail_record = record;
+    UNIT__EACH_PRINTER_IN(reader->printers, FAIL, node, NULL);
+}
+
+static void unit__log_replay(struct unit__log_reader* reader, const struct unit__log_record* r) {
+    if (r->kind == UNIT__LOG_SETUP) {
+        unit__log_replay_setup(reader, r);
+        return;
+    }
+    struct unit_test* node = unit__log_get_node(reader, r->id);
+    if (!node) {
+        return;
+    }
+    switch (r->kind) {
+        case UNIT__LOG_BEGIN:
+            node->status = r->status;
+            node->state = 0;
+            node->assertions = 0;
+            node->passed = 0;
+            node->total = 0;
+            node->assert_desc = NULL;
+            node->assert_site = NULL;
+            node->fail_record = NULL;
+            if (node->type == UNIT__TYPE_TEST) {
+                reader->fails_num = 0;
+                reader->fails_text_len = 0;
+            }
+            reader->cur = node;
+            UNIT__EACH_PRINTER_IN(reader->printers, BEGIN, node, 0);
+            break;
+        case UNIT__LOG_RESOURCES:
+            node->res = r->resources;
+            break;
+        case UNIT__LOG_END:
+            node->status = r->status;
+            node->passed = r->end.passed;
+            node->total = r->end.total;
+            node->elapsed = r->end.elapsed;
+            node->cpu_elapsed = r->end.cpu_elapsed;
+            node->fixtures_elapsed = r->end.fixtures_elapsed;
+            node->assertions = r->end.assertions;
+            node->scratch_peak = (size_t) r->end.scratch_peak;
+            UNIT__EACH_PRINTER_IN(reader->printers, END, node, 0);
+            reader->cur = node->parent;
+            if (!node->parent && node->status == UNIT_STATUS_FAILED) {
+                ++reader->failed;
+            }
+            break;
+        case UNIT__LOG_ECHO:
+            UNIT__EACH_PRINTER_IN(reader->printers, ECHO, node, unit__log_get_string(reader, r->echo.text));
+            break;
+        case UNIT__LOG_ASSERTION:
+            unit__log_replay_assert(reader, node, r);
+            UNIT__EACH_PRINTER_IN(reader->printers, ASSERTION, node, 0);
+            break;
+        case UNIT__LOG_FAIL:
+            unit__log_replay_fail(reader, node, r);
+            break;
+    }
+}
+
+// replays records until the end of the log, returns false if the log is broken
+static bool unit__log_replay_all(struct unit__log_reader* reader) {
+    struct unit__log_record r;
+    bool valid = true;
+    // the file of crashed run is not truncated, zeroed tail reads as the header record
+    while (valid && reader->read(reader, &r, sizeof r) && r.kind != UNIT__LOG_HEADER) {
+        if (r.kind == UNIT__LOG_STRING) {
+            valid = unit__log_read_string(reader, &r);
+        } else if (r.kind == UNIT__LOG_NODE) {
+            valid = unit__log_read_node(reader, &r);
+        } else {
+            unit__log_replay(reader, &r);
+        }
+    }
+    return valid;
+}
+
+static void unit__log_reader_free(struct unit__log_reader* reader) {
+    for (uint32_t i = 0; i < reader->strings_num; ++i) {
+        free(reader->strings[i]);
+    }
+    for (uint32_t i = 0; i < reader->nodes_num; ++i) {
+        free(reader->nodes[i]);
+    }
+    free(reader->strings);
+    free(reader->nodes);
+    free(reader->transient);
+}
+
+int unit_report(const char* path, struct unit_run_options options) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "unit: error: unable to open events log `%s`\n", path);
+        return EXIT_FAILURE;
+    }
+    struct unit__log_record r;
+    if (fread(&r, sizeof r, 1, file) != 1 || r.kind != UNIT__LOG_HEADER ||
+        memcmp(r.header.magic, UNIT__LOG_MAGIC, sizeof r.header.magic) != 0 ||
+        r.header.version != UNIT__LOG_VERSION || r.header.record_size != sizeof r) {
+        fprintf(stderr, "unit: error: `%s` is not an events log of unit v" UNIT_VERSION "\n", path);
+        fclose(file);
+        return EXIT_FAILURE;
+    }
+
+    // the report is printed by the same printers, but nothing is run or sampled
+    options.events_out = NULL;
+    options.profile = 0;
+    options.profile_out = NULL;
+    options.async_report = 0;
+    options.resources = options.resources || r.header.resources;
+    unit__opts = options;
+    unit__init_printers();
+    unit__output_setup();
+
+    static struct unit__log_reader reader;
+    memset(&reader, 0, sizeof reader);
+    reader.read = unit__log_read_file;
+    reader.file = file;
+    reader.printers = unit__printers;
+    const struct unit_clock clock = unit__clock;
+    const struct unit_env env = unit__env;
+
+    const bool valid = unit__log_replay_all(&reader);
+    if (reader.cur || !valid) {
+        fprintf(stderr, "unit: warning: events log `%s` is incomplete\n", path);
+        ++reader.failed;
+    }
+    // close nodes interrupted by the crash
+    while (reader.cur) {
+        struct unit_test* node = reader.cur;
+        node->status = UNIT_STATUS_FAILED;
+        UNIT__EACH_PRINTER_IN(reader.printers, END, node, 0);
+        reader.cur = node->parent;
+    }
+    // declared root nodes replace the list of registered suites for the summary
+    struct unit_test* const tests = unit_tests;
+    unit_tests = reader.roots;
+    UNIT__EACH_PRINTER(SHUTDOWN, 0, 0);
+    unit__close_reporters();
+    fflush(stdout);
+    unit_tests = tests;
+
+    fclose(file);
+    unit__log_reader_free(&reader);
+    unit__clock = clock;
+    unit__env = env;
+    return reader.failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// endregion
@@ -0,0 +1,69 @@
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#define UNIT__HAS_RUSAGE 1
+
+#if defined(__linux__) && !defined(RUSAGE_THREAD)
+// available without `_GNU_SOURCE` since Linux 2.6.26
+#define RUSAGE_THREAD 1
+#endif
+
+#endif // unix
+
+// region использование ресурсов: время CPU, память, page faults, переключения контекста
+
+static int64_t unit__read_rss(void) {
+    int64_t rss = 0;
+#ifdef __linux__
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (f) {
+        long size = 0;
+        long resident = 0;
+        if (fscanf(f, "%ld %ld", &size, &resident) == 2) {
+            rss = (int64_t) resident * sysconf(_SC_PAGESIZE);
+        }
+        fclose(f);
+    }
+#endif // __linux__
+    return rss;
+}
+
+static void unit__sample_resources(struct unit_resources* out) {
+    *out = (struct unit_resources) {0};
+#ifdef UNIT__HAS_RUSAGE
+    struct rusage ru = {0};
+#ifdef RUSAGE_THREAD
+    if (getrusage(RUSAGE_THREAD, &ru) != 0)
+#endif // RUSAGE_THREAD
+        getrusage(RUSAGE_SELF, &ru);
+    out->user = (int64_t) ru.ru_utime.tv_sec * 1000000000 + (int64_t) ru.ru_utime.tv_usec * 1000;
+    out->sys = (int64_t) ru.ru_stime.tv_sec * 1000000000 + (int64_t) ru.ru_stime.tv_usec * 1000;
+#ifdef __APPLE__
+    out->max_rss = ru.ru_maxrss;
+#else // __APPLE__
+    out->max_rss = (int64_t) ru.ru_maxrss * 1024;
+#endif // !__APPLE__
+    out->minflt = ru.ru_minflt;
+    out->majflt = ru.ru_majflt;
+    out->nvcsw = ru.ru_nvcsw;
+    out->nivcsw = ru.ru_nivcsw;
+#endif // UNIT__HAS_RUSAGE
+    out->rss = unit__read_rss();
+}
+
+/**
+ * Converts `end` snapshot to usage delta since `begin`, peak RSS stays absolute
+ */
+static void unit__diff_resources(struct unit_resources* end, const struct unit_resources* begin) {
+    end->user -= begin->user;
+    end->sys -= begin->sys;
+    end->rss -= begin->rss;
+    end->minflt -= begin->minflt;
+    end->majflt -= begin->majflt;
+    end->nvcsw -= begin->nvcsw;
+    end->nivcsw -= begin->nivcsw;
+}
+
+// endregion
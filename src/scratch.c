@@ -0,0 +1,177 @@
+#if defined(_WIN32)
+
+#include <windows.h>
+
+#define UNIT__SCRATCH_VIRTUAL_ALLOC 1
+
+#elif (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+
+#include <sys/mman.h>
+#include <pthread.h>
+
+#define UNIT__SCRATCH_MMAP 1
+
+#endif
+
+// region scratch-арена: временная память теста, освобождается в конце теста
+
+#ifndef UNIT_SCRATCH_RESERVE
+// address space reserved for each thread's arena, pages are committed on demand
+#if defined(UNIT__SCRATCH_MMAP) || defined(UNIT__SCRATCH_VIRTUAL_ALLOC)
+#define UNIT_SCRATCH_RESERVE ((size_t) 1 << 30)
+#else
+#define UNIT_SCRATCH_RESERVE ((size_t) 64 << 20)
+#endif
+#endif // !UNIT_SCRATCH_RESERVE
+
+#ifndef UNIT_SCRATCH_POISON
+// fill rewound memory to catch use of scratch memory after the test end
+#ifdef NDEBUG
+#define UNIT_SCRATCH_POISON 0
+#else
+#define UNIT_SCRATCH_POISON 1
+#endif
+#endif // !UNIT_SCRATCH_POISON
+
+#define UNIT__SCRATCH_POISON_BYTE 0xDD
+#define UNIT__SCRATCH_COMMIT_CHUNK ((size_t) 1 << 20)
+
+struct unit__arena {
+    char* base;
+    size_t top;
+    // high-water mark since the current node begin
+    size_t high;
+    // committed bytes (`VirtualAlloc` only)
+    size_t committed;
+    // test end counter when arena was rewound
+    unsigned epoch;
+};
+
+static __thread struct unit__arena unit__scratch;
+// incremented at each test end, arenas of other threads are rewound lazily
+static unsigned unit__scratch_epoch = 0;
+
+#ifdef UNIT__SCRATCH_MMAP
+
+// arenas of threads spawned by tests are unmapped at the thread exit
+static pthread_key_t unit__scratch_key;
+static pthread_once_t unit__scratch_key_once = PTHREAD_ONCE_INIT;
+
+static void unit__scratch_release(void* ptr) {
+    struct unit__arena* arena = (struct unit__arena*) ptr;
+    munmap(arena->base, UNIT_SCRATCH_RESERVE);
+    arena->base = NULL;
+    arena->top = 0;
+    arena->high = 0;
+}
+
+static void unit__scratch_key_create(void) {
+    pthread_key_create(&unit__scratch_key, unit__scratch_release);
+}
+
+#endif // UNIT__SCRATCH_MMAP
+
+static bool unit__arena_reserve(struct unit__arena* arena) {
+#if defined(UNIT__SCRATCH_MMAP)
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_NORESERVE
+    flags |= MAP_NORESERVE;
+#endif // MAP_NORESERVE
+    void* base = mmap(NULL, UNIT_SCRATCH_RESERVE, PROT_READ | PROT_WRITE, flags, -1, 0);
+    arena->base = base == MAP_FAILED ? NULL : (char*) base;
+    if (arena->base) {
+        pthread_once(&unit__scratch_key_once, unit__scratch_key_create);
+        pthread_setspecific(unit__scratch_key, arena);
+    }
+#elif defined(UNIT__SCRATCH_VIRTUAL_ALLOC)
+    arena->base = (char*) VirtualAlloc(NULL, UNIT_SCRATCH_RESERVE, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    arena->base = (char*) malloc(UNIT_SCRATCH_RESERVE);
+#endif
+    return arena->base != NULL;
+}
+
+static bool unit__arena_commit(struct unit__arena* arena, size_t size) {
+#ifdef UNIT__SCRATCH_VIRTUAL_ALLOC
+    if (size > arena->committed) {
+        size_t end = (size + UNIT__SCRATCH_COMMIT_CHUNK - 1) & ~(UNIT__SCRATCH_COMMIT_CHUNK - 1);
+        if (end > UNIT_SCRATCH_RESERVE) {
+            end = UNIT_SCRATCH_RESERVE;
+        }
+        if (!VirtualAlloc(arena->base + arena->committed, end - arena->committed, MEM_COMMIT, PAGE_READWRITE)) {
+            return false;
+        }
+        arena->committed = end;
+    }
+#else // UNIT__SCRATCH_VIRTUAL_ALLOC
+    (void) arena;
+    (void) size;
+#endif // !UNIT__SCRATCH_VIRTUAL_ALLOC
+    return true;
+}
+
+static void unit__arena_rewind(struct unit__arena* arena, size_t mark) {
+    if (arena->top > mark) {
+#if UNIT_SCRATCH_POISON
+        memset(arena->base + mark, UNIT__SCRATCH_POISON_BYTE, arena->top - mark);
+#endif // UNIT_SCRATCH_POISON
+        arena->top = mark;
+    }
+}
+
+/**
+ * Allocates temporary memory for the current test.
+ * Memory is valid until the end of the test, there is no need to free it.
+ * Each thread has own arena, so the function could be used from threads spawned by the test.
+ * Returns NULL if arena capacity `UNIT_SCRATCH_RESERVE` is exceeded.
+ */
+void* unit_scratch_alloc(size_t size, size_t align) {
+    struct unit__arena* arena = &unit__scratch;
+    if (!arena->base && !unit__arena_reserve(arena)) {
+        return NULL;
+    }
+    const unsigned epoch = __atomic_load_n(&unit__scratch_epoch, __ATOMIC_ACQUIRE);
+    if (arena->epoch != epoch) {
+        // memory allocated by this thread during the previous test
+        unit__arena_rewind(arena, 0);
+        arena->high = 0;
+        arena->epoch = epoch;
+    }
+    if (align == 0 || (align & (align - 1)) != 0) {
+        align = sizeof(void*);
+    }
+    const size_t begin = (arena->top + align - 1) & ~(align - 1);
+    if (begin > UNIT_SCRATCH_RESERVE || size > UNIT_SCRATCH_RESERVE - begin ||
+        !unit__arena_commit(arena, begin + size)) {
+        return NULL;
+    }
+    arena->top = begin + size;
+    if (arena->top > arena->high) {
+        arena->high = arena->top;
+    }
+    return arena->base + begin;
+}
+
+static void unit__scratch_begin(struct unit_test* unit) {
+    struct unit__arena* arena = &unit__scratch;
+    arena->epoch = unit__scratch_epoch;
+    unit->scratch_mark = arena->top;
+    unit->scratch_peak = arena->high;
+    arena->high = arena->top;
+}
+
+static void unit__scratch_end(struct unit_test* unit) {
+    struct unit__arena* arena = &unit__scratch;
+    const size_t high = arena->high;
+    // parent's high-water mark is saved in `scratch_peak` until the node end
+    const size_t parent_high = unit->scratch_peak;
+    unit->scratch_peak = high - unit->scratch_mark;
+    arena->high = high > parent_high ? high : parent_high;
+    unit__arena_rewind(arena, unit->scratch_mark);
+    if (unit->type == UNIT__TYPE_TEST) {
+        __atomic_add_fetch(&unit__scratch_epoch, 1, __ATOMIC_RELEASE);
+        arena->epoch = unit__scratch_epoch;
+    }
+}
+
+// endregion
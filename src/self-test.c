@@ -32,6 +32,37 @@ UNIT_SUITE(unit_internals) {
         }
     }
 
+    DESCRIBE(unit__clock) {
+        IT("is monotonic") {
+            const int64_t t0 = unit__clock.now();
+            const int64_t t1 = unit__clock.now();
+            CHECK_GE(t1, t0);
+            CHECK_GE(unit__clock.overhead, 0);
+        }
+        IT("measures thread CPU time") {
+            const int64_t t0 = unit__cpu_time();
+            volatile unsigned acc = 0;
+            for (unsigned i = 0; i < 100000; ++i) {
+                acc += i;
+            }
+            CHECK_GE(unit__cpu_time(), t0);
+        }
+    }
+
+    DESCRIBE(unit__sample_resources) {
+        IT("calculates usage delta") {
+            struct unit_resources r0;
+            struct unit_resources r1;
+            unit__sample_resources(&r0);
+            unit__sample_resources(&r1);
+            unit__diff_resources(&r1, &r0);
+            CHECK_GE(r1.user, 0);
+            CHECK_GE(r1.minflt, 0);
+            CHECK_GE(r1.nvcsw, 0);
+            CHECK_GE(r1.max_rss, r0.max_rss);
+        }
+    }
+
     DESCRIBE(find_bool_arg) {
         IT("parse short form") {
             int val = 0;
@@ -43,6 +74,11 @@ UNIT_SUITE(unit_internals) {
             find_bool_arg(3, (const char* []) {"", "-a", "--along"}, &val, "along", "");
             REQUIRE_EQ(val, 1);
         }
+        IT("match the whole long form") {
+            int val = 0;
+            find_bool_arg(2, (const char* []) {"--trace-out=run.json", "--traces"}, &val, "trace", "t");
+            REQUIRE_EQ(val, 0);
+        }
         IT("don't change on not found") {
             int val = 2;
             find_bool_arg(4, (const char* []) {"--etemp", "-nt", "-a", "--no-along"}, &val, "temp", "t");
@@ -50,10 +86,317 @@ UNIT_SUITE(unit_internals) {
         }
     }
 
+    DESCRIBE(print_json_string) {
+        IT("escapes special characters") {
+            char buf[64] = {0};
+            FILE* f = tmpfile();
+            REQUIRE((const void*) f);
+            print_json_string(f, "a\"b\\c\n\033");
+            rewind(f);
+            fread(buf, 1, sizeof buf - 1, f);
+            fclose(f);
+            CHECK_EQ(buf, "\"a\\\"b\\\\c\\n\\u001b\"");
+        }
+    }
+
+    DESCRIBE(print_xml_string) {
+        IT("escapes markup and drops control characters") {
+            char buf[64] = {0};
+            FILE* f = tmpfile();
+            REQUIRE((const void*) f);
+            print_xml_string(f, "<a href='x'>\"&\"</a>\n\033");
+            rewind(f);
+            fread(buf, 1, sizeof buf - 1, f);
+            fclose(f);
+            CHECK_EQ(buf, "&lt;a href=&apos;x&apos;&gt;&quot;&amp;&quot;&lt;/a&gt;\n");
+        }
+    }
+
+    DESCRIBE(find_str_arg) {
+        IT("parse value after `=`") {
+            const char* val = NULL;
+            find_str_arg(3, (const char* []) {"--cpu=1", "--cpus", "--cpus=0,2-3"}, &val, "cpus");
+            REQUIRE_EQ(val, "0,2-3");
+        }
+        IT("don't change on not found") {
+            const char* val = "prev";
+            find_str_arg(2, (const char* []) {"-cpus=1", "--cpus"}, &val, "cpus");
+            REQUIRE_EQ(val, "prev");
+        }
+    }
+
+    DESCRIBE(unit__env_parse_cpus) {
+        IT("parse lists and ranges") {
+            unsigned long mask[2] = {0};
+            REQUIRE_EQ(unit__env_parse_cpus("0,2-3,3", mask, 128), 3);
+            REQUIRE_EQ(mask[0], 13ul);
+        }
+        IT("reject invalid list") {
+            unsigned long mask[2] = {0};
+            CHECK_EQ(unit__env_parse_cpus("1-a", mask, 128), -1);
+            CHECK_EQ(unit__env_parse_cpus("3-1", mask, 128), -1);
+        }
+    }
+
+    DESCRIBE(unit_scratch_alloc) {
+        static unsigned char* prev = NULL;
+        IT("allocate aligned memory") {
+            unsigned char* p = (unsigned char*) unit_scratch_alloc(100, 64);
+            REQUIRE(p != NULL);
+            CHECK_EQ((int) ((uintptr_t) p % 64), 0);
+            memset(p, 1, 100);
+            unsigned char* q = (unsigned char*) unit_scratch_alloc(1, 1);
+            CHECK(q == p + 100);
+            prev = p;
+        }
+        IT("rewind at the test end") {
+#if UNIT_SCRATCH_POISON
+            CHECK_EQ((int) prev[0], UNIT__SCRATCH_POISON_BYTE);
+#endif
+            CHECK(unit_scratch_alloc(100, 64) == prev);
+        }
+        IT("return NULL when capacity is exceeded") {
+            CHECK(unit_scratch_alloc(UNIT_SCRATCH_RESERVE + 1, 1) == NULL);
+        }
+    }
+
+    DESCRIBE(unit__mismatch) {
+        static unsigned char a[300];
+        static unsigned char b[300];
+        IT("find the first different byte at any offset") {
+            memset(a, 7, sizeof a);
+            memset(b, 7, sizeof b);
+            REQUIRE_EQ(unit__mismatch(a, b, sizeof a), sizeof a);
+            bool found = true;
+            for (size_t i = 0; i < sizeof a; ++i) {
+                b[i] = 8;
+                found = found && unit__mismatch(a, b, sizeof a) == i && unit__mismatch(a, b, i) == i;
+                b[i] = 7;
+            }
+            REQUIRE(found);
+        }
+        IT("count mismatched elements") {
+            memset(b, 7, sizeof b);
+            b[1] = b[2] = 0;
+            b[100] = b[299] = 0;
+            CHECK_EQ(unit__count_mismatches(a, b, sizeof a, 1, 0), 4u);
+            CHECK_EQ(unit__count_mismatches(a, b, sizeof a, 4, 0), 3u);
+            CHECK_EQ(unit__count_mismatches(a, b, sizeof a, 4, 4), 2u);
+        }
+    }
+
+    DESCRIBE(unit__ulps) {
+        IT("measure distance between adjacent floats") {
+            CHECK_EQ(unit__ulps_flt(1.0f, 1.0f), 0ull);
+            CHECK_EQ(unit__ulps_flt(0.0f, -0.0f), 0ull);
+            CHECK_EQ(unit__ulps_flt(0.0f, 1.4e-45f), 1ull);
+            CHECK_EQ(unit__ulps_flt(-1.4e-45f, 1.4e-45f), 2ull);
+            CHECK_EQ(unit__ulps_dbl(1.0, 1.0000000000000002), 1ull);
+            CHECK_EQ(unit__ulps_dbl(-1.0, 1.0), 2ull * 0x3FF0000000000000ull);
+        }
+    }
+
+    DESCRIBE(unit__assert_pass) {
+        IT("count evaluated assertions") {
+            CHECK(1);
+            CHECK_EQ(1, 1);
+            WARN_NE(1, 2);
+            REQUIRE_EQ((int) unit__hot.assertions, 3);
+        }
+        IT("skip printers without `ASSERTION` subscribers") {
+            const unsigned events = unit__events;
+            unit__events &= ~UNIT__EVENT(ASSERTION);
+            CHECK(unit__hot.assertions == 0);
+            unit__events = events;
+            REQUIRE_EQ((int) unit__hot.assertions, 1);
+        }
+    }
+
+    DESCRIBE(unit__format_fail) {
+        IT("format typed operands without style markers") {
+            struct unit__fail_record r = {0};
+            r.kind = UNIT__FAIL_COMPARE;
+            r.op = UNIT__OP_LT;
+            r.sa = "a";
+            r.sb = "b";
+            r.a = unit__value_int(-3);
+            r.b = unit__value_uint(7u);
+            char buf[128];
+            unit__format_fail_plain(buf, sizeof buf, &r);
+            REQUIRE_EQ(buf, "Expected `a` < `b`, but got `-3 >= 7`");
+        }
+        IT("copy string operands") {
+            char str[8] = "value";
+            struct unit__value v = unit__value_str(str);
+            str[0] = 0;
+            REQUIRE_EQ(v.s, "value");
+        }
+    }
+
+    DESCRIBE(unit__fail_take) {
+        IT("take queued failures in posting order") {
+            struct unit__fail_node nodes[3];
+            for (int i = 0; i < 3; ++i) {
+                nodes[i].record.op = i;
+                unit__fail_post(&nodes[i].record);
+            }
+            struct unit__fail_node* list = unit__fail_take();
+            for (int i = 0; i < 3; ++i) {
+                REQUIRE(list == nodes + i);
+                list = list->next;
+            }
+            REQUIRE(list == NULL);
+            REQUIRE(unit__fail_take() == NULL);
+        }
+    }
+
+    DESCRIBE(unit__journal_open) {
+        IT("keep content beyond the memory buffer") {
+            FILE* journal = unit__journal_open();
+            REQUIRE((const void*) journal);
+            const int lines = 2 * UNIT_FAIL_JOURNAL / 16;
+            for (int i = 0; i < lines; ++i) {
+                fprintf(journal, "failure %06d\n", i);
+            }
+            FILE* out = tmpfile();
+            REQUIRE((const void*) out);
+            unit__journal_replay(journal, out);
+            // each line is 15 bytes
+            CHECK_EQ(ftell(out), 15L * lines);
+            char line[32] = {0};
+            fseek(out, -15L, SEEK_END);
+            fread(line, 1, 15, out);
+            fclose(out);
+            REQUIRE_EQ((const char*) line, "failure 008191\n");
+        }
+    }
+
+    DESCRIBE(unit__log_slot) {
+        IT("keep ids of interned pointers while growing") {
+            static int keys[3000];
+            struct unit__log_ids table = {0};
+            bool found = true;
+            for (uint32_t i = 0; i < 3000; ++i) {
+                uint32_t* slot = unit__log_slot(&table, keys + i);
+                REQUIRE(slot != NULL);
+                found = found && *slot == 0;
+                *slot = i + 1;
+            }
+            for (uint32_t i = 0; i < 3000; ++i) {
+                found = found && *unit__log_slot(&table, keys + i) == i + 1;
+            }
+            CHECK_EQ(table.num, 3000u);
+            unit__log_ids_free(&table);
+            REQUIRE(found);
+        }
+    }
+
+    DESCRIBE(add_child) {
+        IT("append children in order") {
+            static struct unit_test parent;
+            static struct unit_test children[1000];
+            parent = (struct unit_test) {0};
+            for (int i = 0; i < 1000; ++i) {
+                children[i] = (struct unit_test) {0};
+                add_child(&parent, children + i);
+            }
+            int num = 0;
+            bool ordered = true;
+            for (struct unit_test* child = parent.children; child; child = child->next) {
+                ordered = ordered && child == children + num && child->parent == &parent;
+                ++num;
+            }
+            CHECK_EQ(num, 1000);
+            CHECK(parent.children_last == children + 999);
+            REQUIRE(ordered);
+        }
+    }
+
+#ifdef UNIT__HAS_ASYNC_REPORT
+    DESCRIBE(unit__async_ring) {
+        IT("pass bytes across the end of the buffer") {
+            // the ring is free while the reporter thread is not running
+            REQUIRE(!unit__async_running);
+            memset(&unit__async_ring, 0, sizeof unit__async_ring);
+            unit__async_ring.head = unit__async_ring.tail = UNIT_ASYNC_RING - 5;
+            const char sent[] = "wrapped record";
+            char received[sizeof sent] = {0};
+            unit__async_write(NULL, sent, sizeof sent);
+            CHECK_EQ(unit__async_ring.head, (uint64_t) UNIT_ASYNC_RING - 5 + sizeof sent);
+            REQUIRE(unit__async_read(NULL, received, sizeof received));
+            CHECK_EQ(received, sent);
+            CHECK_EQ(unit__async_ring.tail, unit__async_ring.head);
+            unit__async_ring.closed = 1;
+            CHECK_FALSE(unit__async_read(NULL, received, 1));
+        }
+    }
+#endif // UNIT__HAS_ASYNC_REPORT
+
+    DESCRIBE(unit__durations_push) {
+        IT("keep the slowest nodes") {
+            static struct unit_test nodes[10];
+            struct unit__durations heap = {0};
+            const int64_t elapsed[10] = {5, 1, 9, 3, 7, 2, 8, 6, 4, 0};
+            for (int i = 0; i < 10; ++i) {
+                nodes[i].elapsed = elapsed[i];
+                unit__durations_push(&heap, 3, nodes + i);
+            }
+            struct unit_test* sorted[UNIT_DURATIONS_MAX];
+            REQUIRE_EQ(unit__durations_sorted(&heap, sorted), 3);
+            CHECK_EQ(sorted[0]->elapsed, (int64_t) 9);
+            CHECK_EQ(sorted[1]->elapsed, (int64_t) 8);
+            CHECK_EQ(sorted[2]->elapsed, (int64_t) 7);
+        }
+    }
+
+    DESCRIBE(unit__glob) {
+        IT("match test path") {
+            CHECK(unit__glob("unit/SKIP/*", "unit/SKIP/start skipping"));
+            CHECK(unit__glob("*skip*", "unit/SKIP/start skipping"));
+            CHECK(unit__glob("*/[?]", "each/rows/[7]"));
+            CHECK(unit__glob("*", ""));
+            CHECK_FALSE(unit__glob("unit/*/x", "unit/SKIP/y"));
+            CHECK_FALSE(unit__glob("[?]", "[10]"));
+            CHECK_FALSE(unit__glob("", "unit"));
+        }
+    }
+
+    DESCRIBE(unit__gen_int) {
+        IT("order values by the distance from zero") {
+            const uint64_t draws[] = {0, 1, 2, 3, 4, 0, 2, 0, 1};
+            const int64_t expected[] = {0, 1, -1, 2, -2, 3, 5, -3, -4};
+            const int64_t min[] = {-10, -10, -10, -10, -10, 3, 3, -5, -5};
+            const int64_t max[] = {10, 10, 10, 10, 10, 5, 5, -3, -3};
+            unit__prop.random = false;
+            memcpy(unit__prop.replay, draws, sizeof draws);
+            unit__prop.replay_num = 9;
+            unit__prop.draws_num = 0;
+            for (int i = 0; i < 9; ++i) {
+                CHECK_EQ(unit__gen_int(min[i], max[i]), expected[i]);
+            }
+            CHECK_EQ(unit__prop.draws_num, 9u);
+            CHECK_EQ(unit__gen_int(INT64_MIN, INT64_MAX), (int64_t) 0);
+        }
+    }
+
+    DESCRIBE(unit__format_count) {
+        IT("separate thousands") {
+            char buf[64];
+            const intmax_t values[] = {0, 999, 1000, 12345, -1000000, INTMAX_MIN};
+            const char* expected[] = {"0", "999", "1,000", "12,345", "-1,000,000", "-9,223,372,036,854,775,808"};
+            for (int i = 0; i < 6; ++i) {
+                struct unit__text text = {buf, sizeof buf, 0};
+                buf[0] = 0;
+                unit__format_count(&text, values[i]);
+                CHECK_EQ(buf, expected[i]);
+            }
+        }
+    }
+
     DESCRIBE(unit__parse_args) {
         IT("options") {
             struct unit_run_options options = {0};
-            unit__parse_args(6,
+            unit__parse_args(7,
                              (const char* []) {
                                      "--quiet",
                                      "--ascii",
@@ -61,6 +404,7 @@ UNIT_SUITE(unit_internals) {
                                      "-t",
                                      "-a",
                                      "not-found",
+                                     "-r=ndjson:run.ndjson",
                                      NULL
                              }, &options);
             REQUIRE_EQ(options.quiet, 1);
@@ -68,6 +412,11 @@ UNIT_SUITE(unit_internals) {
             REQUIRE_EQ(options.trace, 1);
             REQUIRE_EQ(options.doctest_xml, 1);
             REQUIRE_EQ(options.ascii, 1);
+            REQUIRE_EQ(options.ndjson, 1);
+            REQUIRE_EQ(options.ndjson_out, "run.ndjson");
+            REQUIRE_EQ(options.xml_out, (const char*) NULL);
+            REQUIRE_EQ(options.junit, 0);
+            REQUIRE_EQ(options.console, 0);
         }
     }
 }
\ No newline at end of file
@@ -3,6 +3,9 @@
 #define DESCRIBE(...) UNIT_DESCRIBE(__VA_ARGS__)
 #define IT(...) UNIT_TEST(__VA_ARGS__)
 #define TEST(...) UNIT_TEST(__VA_ARGS__)
+#define IT_EACH(...) UNIT_TEST_EACH(__VA_ARGS__)
+#define TEST_EACH(...) UNIT_TEST_EACH(__VA_ARGS__)
+#define PROPERTY(...) UNIT_PROPERTY(__VA_ARGS__)
 #define ECHO(...) UNIT_ECHO(__VA_ARGS__)
 
 #define WARN(...)       UNIT_WARN(__VA_ARGS__)
@@ -32,4 +35,29 @@
 #define REQUIRE_LT(...)    UNIT_REQUIRE_LT(__VA_ARGS__)
 #define REQUIRE_LE(...)    UNIT_REQUIRE_LE(__VA_ARGS__)
 
+#define WARN_MEM_EQ(...) UNIT_WARN_MEM_EQ(__VA_ARGS__)
+#define WARN_ARRAY_EQ(...) UNIT_WARN_ARRAY_EQ(__VA_ARGS__)
+#define CHECK_MEM_EQ(...) UNIT_CHECK_MEM_EQ(__VA_ARGS__)
+#define CHECK_ARRAY_EQ(...) UNIT_CHECK_ARRAY_EQ(__VA_ARGS__)
+#define REQUIRE_MEM_EQ(...) UNIT_REQUIRE_MEM_EQ(__VA_ARGS__)
+#define REQUIRE_ARRAY_EQ(...) UNIT_REQUIRE_ARRAY_EQ(__VA_ARGS__)
+#define WARN_ARRAY_NEAR(...) UNIT_WARN_ARRAY_NEAR(__VA_ARGS__)
+#define CHECK_ARRAY_NEAR(...) UNIT_CHECK_ARRAY_NEAR(__VA_ARGS__)
+#define REQUIRE_ARRAY_NEAR(...) UNIT_REQUIRE_ARRAY_NEAR(__VA_ARGS__)
+#define WARN_ALL(...) UNIT_WARN_ALL(__VA_ARGS__)
+#define CHECK_ALL(...) UNIT_CHECK_ALL(__VA_ARGS__)
+#define REQUIRE_ALL(...) UNIT_REQUIRE_ALL(__VA_ARGS__)
+#define WARN_ALL_EQ(...) UNIT_WARN_ALL_EQ(__VA_ARGS__)
+#define CHECK_ALL_EQ(...) UNIT_CHECK_ALL_EQ(__VA_ARGS__)
+#define REQUIRE_ALL_EQ(...) UNIT_REQUIRE_ALL_EQ(__VA_ARGS__)
+
+#define FIXTURE(...) UNIT_FIXTURE(__VA_ARGS__)
+#define BEFORE_ALL(...) UNIT_BEFORE_ALL(__VA_ARGS__)
+#define AFTER_ALL(...) UNIT_AFTER_ALL(__VA_ARGS__)
+#define BEFORE_EACH(...) UNIT_BEFORE_EACH(__VA_ARGS__)
+#define AFTER_EACH(...) UNIT_AFTER_EACH(__VA_ARGS__)
+#define ROW_NAME(...) UNIT_ROW_NAME(__VA_ARGS__)
+
+#define GEN_ARRAY(...) UNIT_GEN_ARRAY(__VA_ARGS__)
+
 #define SKIP(...) UNIT_SKIP(__VA_ARGS__)
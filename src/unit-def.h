@@ -15,7 +15,20 @@
 #include <string.h>
 #include <time.h>
 
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+
+#include <setjmp.h>
+
+#define UNIT__HAS_CRASH_RECOVERY 1
+
+#endif // unix
+
 #ifdef __cplusplus
+// `std::begin` and `std::next` for the rows of `UNIT_TEST_EACH`
+#include <iterator>
+// signedness of operands for mixed comparisons
+#include <type_traits>
+
 extern "C" {
 #endif
 
@@ -61,6 +74,39 @@ struct unit__options {
     bool dummy__;
     bool failing;
     bool skip;
+
+    // fixtures for `SUITE` / `DESCRIBE` scope: once per scope, or once per each test in the scope
+    void (* before_all)(void);
+    void (* after_all)(void);
+    void (* before_each)(void);
+    void (* after_each)(void);
+
+    // names the row of `UNIT_TEST_EACH` in reports, the row index is used by default
+    void (* row_name)(char* buf, size_t size, const void* row);
+};
+
+// static description of the assertion call site
+struct unit__assert_site {
+    int level;
+    const char* file;
+    int line;
+    const char* comment;
+    const char* desc;
+};
+
+struct unit_resources {
+    // user and system CPU time in nanoseconds
+    int64_t user;
+    int64_t sys;
+    // resident set size and peak resident set size in bytes
+    int64_t rss;
+    int64_t max_rss;
+    // minor and major page faults
+    int64_t minflt;
+    int64_t majflt;
+    // voluntary and involuntary context switches
+    int64_t nvcsw;
+    int64_t nivcsw;
 };
 
 struct unit_test {
@@ -73,22 +119,46 @@ struct unit_test {
     int type;
     struct unit__options options;
 
-    double t0;
-    double elapsed;
+    // wall and thread CPU time in nanoseconds, printers work is excluded
+    int64_t t0;
+    int64_t elapsed;
+    int64_t cpu_t0;
+    int64_t cpu_elapsed;
+    int64_t excluded_t0;
+    // time spent in fixtures of this node, not included in `elapsed`
+    int64_t fixtures_elapsed;
+    // `before_all` fixture of this node failed, its children are skipped
+    bool fixture_failed;
+
+    // sampled only with `--resources` option: snapshot on begin, and usage delta on end
+    struct unit_resources res0;
+    struct unit_resources res;
+
+    // scratch arena top on begin, and high-water mark of scratch memory used by this node in bytes
+    size_t scratch_mark;
+    size_t scratch_peak;
 
     struct unit_test* next;
     struct unit_test* children;
+    // the last child, so children are appended in constant time
+    struct unit_test* children_last;
     struct unit_test* parent;
 
     int total;
     int passed;
+    // number of evaluated assertions, counted in `unit__hot` while the node is running
+    int64_t assertions;
 
     // test
     // status of current assertion
     int status;
-    // state for this test scope
+    // state for this test scope, kept in `unit__hot` while the node is running
     // позволять ли дальше работать другим проверкам в рамках этого теста
     int state;
+    // current assertion, fields below are expanded from it only for printers
+    const struct unit__assert_site* assert_site;
+    // the last failure of this node, valid until the next test begins
+    const struct unit__fail_record* fail_record;
     const char* assert_comment;
     const char* assert_desc;
     const char* assert_file;
@@ -110,14 +180,50 @@ struct unit_run_options {
     int animate;
     int doctest_xml;
     int short_filenames;
+    // seeds `srand` and cases of `PROPERTY` tests together with the test path
     unsigned seed;
     const char* program;
+    // new options are appended after existing ones, so positional initializers keep their meaning
+    int strict_env;
+    const char* cpus;
+    const char* clock;
+    int resources;
+    const char* trace_out;
+    int profile;
+    const char* profile_out;
+    int catch_crashes;
+    int junit;
+    int ndjson;
+    // binary events log, reports are printed from it by `unit_report`
+    const char* events_out;
+    // human-readable reporter, enabled by default if no other reporter is selected
+    int console;
+    // destination files of reporters selected with `-r=name:FILE`, `stdout` if not set
+    const char* console_out;
+    const char* xml_out;
+    const char* junit_out;
+    const char* ndjson_out;
+    // reporters are notified by their own thread
+    int async_report;
+    // number of the slowest tests and suites to report
+    int durations;
+    // runs only tests which path matches the glob pattern
+    const char* filter;
+    // measures frequency governor and timer jitter for the environment line, implied by `strict_env` and `cpus`
+    int env;
 };
 
 extern struct unit_run_options unit__opts;
 
+#define UNIT__EVENT(Cmd) (1u << UNIT__PRINTER_ ## Cmd)
+#define UNIT__EVENTS_ALL 0x7Fu
+
 struct unit_printer {
     void (* callback)(int cmd, struct unit_test* unit, const char* msg);
+    // mask of `UNIT__EVENT(Cmd)` the printer is interested in
+    unsigned events;
+    // output of the reporter, NULL for printers writing their own files
+    FILE* out;
 
     struct unit_printer* next;
 };
@@ -128,8 +234,18 @@ void unit__end(struct unit_test* unit);
 
 void unit__echo(const char* msg);
 
+// union of all printers events, passing assertions don't call printers without `ASSERTION` subscriber
+extern unsigned unit__events;
+
+void* unit_scratch_alloc(size_t size, size_t align);
+
 int unit_main(struct unit_run_options options);
 
+/**
+ * Prints report of the run from the events log written with `--events-out`, using printers selected by `options`
+ */
+int unit_report(const char* path, struct unit_run_options options);
+
 // https://gcc.gnu.org/onlinedocs/cpp/Stringizing.html
 #define UNIT__STR(x) #x
 #define UNIT__X_STR(x) UNIT__STR(x)
@@ -146,7 +262,7 @@ int unit_main(struct unit_run_options options);
 #define UNIT__SUITE(Var, Name, ...) \
     static void Var(void); \
     __attribute__((constructor)) static void UNIT__CONCAT(Var, _ctor)(void) { \
-        static struct unit_test u = (struct unit_test){ .name=Name, .file=__FILE__, .line=__LINE__, .fn=Var, .type=UNIT__TYPE_CASE, .options=(struct unit__options){ __VA_ARGS__ } }; \
+        static struct unit_test u = { .name=Name, .file=__FILE__, .line=__LINE__, .fn=Var, .type=UNIT__TYPE_CASE, .options={ __VA_ARGS__ } }; \
         u.next = unit_tests; unit_tests = &u; \
     } \
     static void Var(void)
@@ -154,54 +270,310 @@ int unit_main(struct unit_run_options options);
 #define UNIT_SUITE_(Name, ...) UNIT__SUITE(UNIT__X_CONCAT(unit__, __COUNTER__), Name, __VA_ARGS__)
 #define UNIT_SUITE(Name, ...) UNIT__SUITE(UNIT__X_CONCAT(unit__, __COUNTER__), #Name, __VA_ARGS__)
 
+#ifdef UNIT__HAS_CRASH_RECOVERY
+
+sigjmp_buf* unit__crash_point(struct unit_test* unit);
+
+// with `--catch-crashes` each node is a recovery point: crash inside jumps back here, the body is skipped
+// and `unit__end` reports the crash; `sigsetjmp` is the whole controlling expression as C11 7.13.1.1 requires
+#define UNIT__CRASH_POINT(Unit) switch (sigsetjmp(*unit__crash_point(Unit), unit__opts.catch_crashes)) case 0:
+
+#else
+
+#define UNIT__CRASH_POINT(Unit)
+
+#endif // UNIT__HAS_CRASH_RECOVERY
+
 #define UNIT__DECL(Type, Var, Name, ...) \
-    static struct unit_test Var = (struct unit_test){ .name=Name, .file=__FILE__, .line=__LINE__, .fn=NULL, .type=Type, .options=(struct unit__options){ __VA_ARGS__ } }; \
-    UNIT_TRY_SCOPE(unit__begin(&Var), unit__end(&Var))
+    static struct unit_test Var = { .name=Name, .file=__FILE__, .line=__LINE__, .fn=NULL, .type=Type, .options={ __VA_ARGS__ } }; \
+    UNIT_TRY_SCOPE(unit__begin(&Var), unit__end(&Var)) UNIT__CRASH_POINT(&Var)
 
 #define UNIT_DESCRIBE(Name, ...) UNIT__DECL(UNIT__TYPE_CASE, UNIT__X_CONCAT(u__, __COUNTER__), #Name, __VA_ARGS__)
 #define UNIT_TEST(Name, ...) UNIT__DECL(UNIT__TYPE_TEST, UNIT__X_CONCAT(u__, __COUNTER__), "" Name, __VA_ARGS__)
 
-bool unit__prepare_assert(int level, const char* file, int line, const char* comment, const char* desc);
+#ifndef UNIT_ROW_NAME_MAX
+// maximum length of the row name of `UNIT_TEST_EACH`
+#define UNIT_ROW_NAME_MAX 64
+#endif
+
+// result node of the table row, nodes are allocated once for all rows of the table
+struct unit__row {
+    struct unit_test node;
+    char name[UNIT_ROW_NAME_MAX];
+};
+
+size_t unit__rows(struct unit_test* scope, struct unit__row** rows, size_t* rows_num, size_t count);
+
+struct unit_test* unit__row(struct unit_test* scope, struct unit__row* rows, size_t index, const void* row);
+
+#ifdef __cplusplus
+// `Row` is the iterator of the array or the container: the table is bound once per run, so the temporary container
+// lives through all rows, and the iterator is advanced row by row, so lists are not walked from the beginning
+#define UNIT__ROWS_BIND(Var, Rows) \
+    for (int UNIT__CONCAT(Var, _bind) = 1; UNIT__CONCAT(Var, _bind);) \
+    for (auto&& UNIT__CONCAT(Var, _table) = Rows; UNIT__CONCAT(Var, _bind); UNIT__CONCAT(Var, _bind) = 0) \
+    for (auto UNIT__CONCAT(Var, _it) = std::begin(UNIT__CONCAT(Var, _table)); UNIT__CONCAT(Var, _bind); UNIT__CONCAT(Var, _bind) = 0)
+#define UNIT__ROWS_NUM(Var, Rows) \
+    ((size_t) std::distance(std::begin(UNIT__CONCAT(Var, _table)), std::end(UNIT__CONCAT(Var, _table))))
+#define UNIT__ROW_NEXT(Var) ++UNIT__CONCAT(Var, _it)
+#define UNIT__ROW_VAR(Row, Var, Rows) auto Row = UNIT__CONCAT(Var, _it)
+#else
+// `Row` is the pointer to the array element
+#define UNIT__ROWS_BIND(Var, Rows)
+#define UNIT__ROWS_NUM(Var, Rows) (sizeof(Rows) / sizeof((Rows)[0]))
+#define UNIT__ROW_NEXT(Var) (void) 0
+#define UNIT__ROW_VAR(Row, Var, Rows) __typeof__(&(Rows)[0]) Row = &(Rows)[UNIT__CONCAT(Var, _i)]
+#endif // __cplusplus
+
+#define UNIT__EACH(Var, Name, Rows, Row, ...) \
+    static struct unit_test Var = { .name=Name, .file=__FILE__, .line=__LINE__, .fn=NULL, .type=UNIT__TYPE_CASE, .options={ __VA_ARGS__ } }; \
+    static struct unit__row* UNIT__CONCAT(Var, _rows) = NULL; \
+    static size_t UNIT__CONCAT(Var, _rows_num) = 0; \
+    UNIT_TRY_SCOPE(unit__begin(&Var), unit__end(&Var)) UNIT__CRASH_POINT(&Var) \
+    UNIT__ROWS_BIND(Var, Rows) \
+    for (size_t UNIT__CONCAT(Var, _i) = 0, UNIT__CONCAT(Var, _once) = 1, \
+            UNIT__CONCAT(Var, _n) = unit__rows(&Var, &UNIT__CONCAT(Var, _rows), &UNIT__CONCAT(Var, _rows_num), UNIT__ROWS_NUM(Var, Rows)); \
+         UNIT__CONCAT(Var, _i) < UNIT__CONCAT(Var, _n); ++UNIT__CONCAT(Var, _i), UNIT__ROW_NEXT(Var), UNIT__CONCAT(Var, _once) = 1) \
+    for (UNIT__ROW_VAR(Row, Var, Rows); UNIT__CONCAT(Var, _once); UNIT__CONCAT(Var, _once) = 0) \
+    UNIT_TRY_SCOPE(unit__begin(unit__row(&Var, UNIT__CONCAT(Var, _rows), UNIT__CONCAT(Var, _i), &*Row)), \
+                   unit__end(&UNIT__CONCAT(Var, _rows)[UNIT__CONCAT(Var, _i)].node)) \
+    UNIT__CRASH_POINT(&UNIT__CONCAT(Var, _rows)[UNIT__CONCAT(Var, _i)].node)
+
+// runs the body for each row of the table `Rows`: the array, or any container in C++,
+// each row is the test of its own, so it is reported, timed and selected by `--filter` separately
+#define UNIT_TEST_EACH(Name, Rows, Row, ...) UNIT__EACH(UNIT__X_CONCAT(u__, __COUNTER__), "" Name, Rows, Row, __VA_ARGS__)
+
+// generators of `UNIT_PROPERTY` cases, values shrink to zero clamped to the range, empty buffers and strings
+int64_t unit_gen_int(int64_t min, int64_t max);
+
+uint64_t unit_gen_uint(uint64_t min, uint64_t max);
+
+double unit_gen_double(double min, double max);
+
+void unit_gen_bytes(void* buf, size_t size);
+
+// length in `[0, max]`
+size_t unit_gen_len(size_t max);
+
+// fills `buf` with the null-terminated string of `alphabet` characters, printable ASCII if `alphabet` is NULL
+size_t unit_gen_str(char* buf, size_t size, const char* alphabet);
+
+// fills the array with `Gen` values, returns the length in `[0, Capacity]`
+#define UNIT_GEN_ARRAY(Array, Capacity, Gen) ({ \
+    const size_t n__ = unit_gen_len(Capacity); \
+    for (size_t i__ = 0; i__ < n__; ++i__) (Array)[i__] = (Gen); \
+    n__; \
+})
+
+void unit__prop_begin(struct unit_test* unit, int64_t cases);
+
+bool unit__prop_next(void);
+
+#define UNIT__PROPERTY(Var, Name, Cases, ...) \
+    static struct unit_test Var = { .name=Name, .file=__FILE__, .line=__LINE__, .fn=NULL, .type=UNIT__TYPE_TEST, .options={ __VA_ARGS__ } }; \
+    UNIT_TRY_SCOPE(unit__begin(&Var), unit__end(&Var)) UNIT__CRASH_POINT(&Var) \
+    for (unit__prop_begin(&Var, Cases); unit__prop_next();)
+
+// runs the body for `Cases` random cases made by `unit_gen_*` generators, the failed case is shrunk
+// to the simplest one and reported with its values and the seed to reproduce it
+#define UNIT_PROPERTY(Name, Cases, ...) UNIT__PROPERTY(UNIT__X_CONCAT(u__, __COUNTER__), "" Name, Cases, __VA_ARGS__)
+
+// assertion state of the calling thread: tests could assert from threads they spawn
+struct unit__thread {
+    // call site of the current assertion
+    const struct unit__assert_site* site;
+    // thread running the tests, other threads count assertions atomically and queue failures
+    bool owner;
+};
+
+extern __thread struct unit__thread unit__tls;
+
+// fields of the running node written by every assertion, kept in the single cache line apart from cold node data,
+// they are stored to the node when the nested node begins or the node ends
+struct unit__hot {
+    int64_t assertions;
+    int state;
+} __attribute__((aligned(64)));
+
+extern struct unit__hot unit__hot;
+
+void unit__skip_assert(void);
+
+void unit__notify_assert(int status);
+
+void unit__assert_pass_thread(void);
+
+static inline bool unit__prepare_assert(const struct unit__assert_site* site) {
+    unit__tls.site = site;
+    if (__atomic_load_n(&unit__hot.state, __ATOMIC_RELAXED) & UNIT__LEVEL_REQUIRE) {
+        unit__skip_assert();
+        return false;
+    }
+    return true;
+}
+
+static inline void unit__assert_pass(void) {
+    if (__builtin_expect(!unit__tls.owner, 0)) {
+        unit__assert_pass_thread();
+        return;
+    }
+    ++unit__hot.assertions;
+    if (unit__events & UNIT__EVENT(ASSERTION)) {
+        unit__notify_assert(UNIT_STATUS_SUCCESS);
+    }
+}
 
 // устанавливает читаемое описание проверки, в случае нормального состояния выполняет проверку,
 // если установлено состояние пропускать тесты - НЕ ВЫЧИСЛЯЕТ аргументы для проверки
 #define UNIT__ASSERT_LAZY(Assertion, Level, Comment, Description) \
-if(unit__prepare_assert(Level, __FILE__, __LINE__, Comment, Description)) Assertion
+if(unit__prepare_assert(({ \
+    static const struct unit__assert_site s__ = {Level, __FILE__, __LINE__, Comment, Description}; \
+    &s__; \
+}))) Assertion
 
 #define UNIT__IS_TRUE(_, x) (!!(x))
 #define UNIT__IS_NOT_EMPTY_STR(_, x) ((x) && (x)[0])
-#define UNIT__CMP(a, b) ((a) == (b) ? 0 : ((a) > (b) ? 1 : -1))
+#define UNIT__REL(a, b, Rel) ((a) Rel (b))
 #define UNIT__STRCMP(a, b) ((a) == (b) ? 0 : strcmp((a) ? (a) : "", (b) ? (b) : ""))
+#define UNIT__STRREL(a, b, Rel) (UNIT__STRCMP(a, b) Rel 0)
 
+// Tag, Type, binary relation, unary predicate
 #define UNIT__FOR_ASSERTS(macro) \
-macro(int, intmax_t, %jd, UNIT__CMP, UNIT__IS_TRUE) \
-macro(uint, uintmax_t, %ju, UNIT__CMP, UNIT__IS_TRUE) \
-macro(dbl, long double, %Lg, UNIT__CMP, UNIT__IS_TRUE) \
-macro(ptr, const void*, %p, UNIT__CMP, UNIT__IS_TRUE) \
-macro(str, const char*, %s, UNIT__STRCMP, UNIT__IS_NOT_EMPTY_STR)
+macro(int, int, UNIT__REL, UNIT__IS_TRUE) \
+macro(uint, unsigned int, UNIT__REL, UNIT__IS_TRUE) \
+macro(long, long, UNIT__REL, UNIT__IS_TRUE) \
+macro(ulong, unsigned long, UNIT__REL, UNIT__IS_TRUE) \
+macro(llong, long long, UNIT__REL, UNIT__IS_TRUE) \
+macro(ullong, unsigned long long, UNIT__REL, UNIT__IS_TRUE) \
+macro(flt, float, UNIT__REL, UNIT__IS_TRUE) \
+macro(dbl, double, UNIT__REL, UNIT__IS_TRUE) \
+macro(ldbl, long double, UNIT__REL, UNIT__IS_TRUE) \
+macro(ptr, const void*, UNIT__REL, UNIT__IS_TRUE) \
+macro(str, const char*, UNIT__STRREL, UNIT__IS_NOT_EMPTY_STR)
+
+// signed and unsigned integers are compared by value, not in the unsigned common type:
+// a negative operand is less than any unsigned one, otherwise both are compared as `uintmax_t`
+static inline int unit__cmp_su(intmax_t a, uintmax_t b) {
+    return a < 0 ? -1 : ((uintmax_t) a > b) - ((uintmax_t) a < b);
+}
+
+#define UNIT__SU_REL(a, b, Rel) (unit__cmp_su(a, b) Rel 0)
+#define UNIT__US_REL(a, b, Rel) (0 Rel unit__cmp_su(b, a))
+
+// Tag, Type of `a`, Type of `b`, binary relation, unary predicate, value tags of `a` and `b`
+#define UNIT__FOR_MIXED_ASSERTS(macro) \
+macro(su, intmax_t, uintmax_t, UNIT__SU_REL, UNIT__IS_TRUE, imax, umax) \
+macro(us, uintmax_t, intmax_t, UNIT__US_REL, UNIT__IS_TRUE, umax, imax)
+
+// comparison is inlined at the call site, only failure is reported out of line,
+// `Op` enum name is a part of the function name: `unit__assert_int_UNIT__OP_EQ`
+#define UNIT__ASSERT_KERNEL(Tag, TypeA, TypeB, Op, Pass) \
+static inline void unit__assert_ ## Tag ## _ ## Op(TypeA a, TypeB b, const char* sa, const char* sb) { \
+    (void) a; \
+    if (Pass) { \
+        unit__assert_pass(); \
+    } else { \
+        unit__fail_ ## Tag(a, b, Op, sa, sb); \
+    } \
+}
+
+#define UNIT__DEFINE_MIXED_ASSERT(Tag, TypeA, TypeB, Rel, Unary, ...) \
+void unit__fail_ ## Tag(TypeA a, TypeB b, int op, const char* sa, const char* sb); \
+UNIT__ASSERT_KERNEL(Tag, TypeA, TypeB, UNIT__OP_TRUE, Unary(a, b)) \
+UNIT__ASSERT_KERNEL(Tag, TypeA, TypeB, UNIT__OP_FALSE, !Unary(a, b)) \
+UNIT__ASSERT_KERNEL(Tag, TypeA, TypeB, UNIT__OP_EQ, Rel(a, b, ==)) \
+UNIT__ASSERT_KERNEL(Tag, TypeA, TypeB, UNIT__OP_NE, Rel(a, b, !=)) \
+UNIT__ASSERT_KERNEL(Tag, TypeA, TypeB, UNIT__OP_LT, Rel(a, b, <)) \
+UNIT__ASSERT_KERNEL(Tag, TypeA, TypeB, UNIT__OP_LE, Rel(a, b, <=)) \
+UNIT__ASSERT_KERNEL(Tag, TypeA, TypeB, UNIT__OP_GT, Rel(a, b, >)) \
+UNIT__ASSERT_KERNEL(Tag, TypeA, TypeB, UNIT__OP_GE, Rel(a, b, >=))
 
-#define UNIT__DEFINE_ASSERT(Tag, Type, ...) \
-void unit__assert_ ## Tag(Type a, Type b, int op, const char* expr, const char* sa, const char* sb);
+#define UNIT__DEFINE_ASSERT(Tag, Type, Rel, Unary) UNIT__DEFINE_MIXED_ASSERT(Tag, Type, Type, Rel, Unary)
 
 UNIT__FOR_ASSERTS(UNIT__DEFINE_ASSERT)
+UNIT__FOR_MIXED_ASSERTS(UNIT__DEFINE_MIXED_ASSERT)
+
+// operands are compared in their common type: `1 ? a : b` applies usual arithmetic conversions,
+// or gives composite pointer type, so `char`, `short` and `bool` are promoted to `int` without losses;
+// only a signed integer converted to the unsigned common type would change its value, such pairs go to
+// `unit__assert_su_*` or `unit__assert_us_*`, so `CHECK_GT(size, -1)` passes and `-1` is printed as `-1`
+
+#ifdef __cplusplus
+
+// `_Generic` is not available for C++ sources, select assertion by overloading
+}
+extern "C++" {
+#define UNIT__SELECT_ASSERT_CXX_OP(TypeA, TypeB, Tag, Op) \
+static inline void unit__assert_ ## Op(TypeA a, TypeB b, const char* sa, const char* sb) { unit__assert_ ## Tag ## _ ## Op(a, b, sa, sb); }
+
+#define UNIT__SELECT_MIXED_ASSERT_CXX(Tag, TypeA, TypeB, ...) \
+UNIT__SELECT_ASSERT_CXX_OP(TypeA, TypeB, Tag, UNIT__OP_TRUE) \
+UNIT__SELECT_ASSERT_CXX_OP(TypeA, TypeB, Tag, UNIT__OP_FALSE) \
+UNIT__SELECT_ASSERT_CXX_OP(TypeA, TypeB, Tag, UNIT__OP_EQ) \
+UNIT__SELECT_ASSERT_CXX_OP(TypeA, TypeB, Tag, UNIT__OP_NE) \
+UNIT__SELECT_ASSERT_CXX_OP(TypeA, TypeB, Tag, UNIT__OP_LT) \
+UNIT__SELECT_ASSERT_CXX_OP(TypeA, TypeB, Tag, UNIT__OP_LE) \
+UNIT__SELECT_ASSERT_CXX_OP(TypeA, TypeB, Tag, UNIT__OP_GT) \
+UNIT__SELECT_ASSERT_CXX_OP(TypeA, TypeB, Tag, UNIT__OP_GE)
+
+#define UNIT__SELECT_ASSERT_CXX(Tag, Type, ...) UNIT__SELECT_MIXED_ASSERT_CXX(Tag, Type, Type)
+
+UNIT__FOR_ASSERTS(UNIT__SELECT_ASSERT_CXX)
+UNIT__FOR_MIXED_ASSERTS(UNIT__SELECT_MIXED_ASSERT_CXX)
+// `bool` is not promoted by the conditional operator in C++
+UNIT__SELECT_ASSERT_CXX(int, bool)
+
+// operand `T` is a signed integer converted to the unsigned common type `Common`
+template<class T, class Common>
+struct unit__sign_mix : std::integral_constant<bool,
+    std::is_integral<typename std::decay<T>::type>::value && std::is_signed<typename std::decay<T>::type>::value &&
+    std::is_unsigned<typename std::decay<Common>::type>::value> {};
+
+// type of operand `T` compared with operand `Other`: the common type, or `intmax_t` and `uintmax_t` for mixed signs
+template<class T, class Other, class Common>
+struct unit__operand : std::conditional<unit__sign_mix<T, Common>::value, intmax_t,
+    typename std::conditional<unit__sign_mix<Other, Common>::value, uintmax_t, Common>::type> {};
+}
+extern "C" {
+
+// operands are converted at the call site, where `0` is still a null pointer constant
+#define UNIT__OPERAND_CXX(x, y, a, b) (unit__operand<decltype(x), decltype(y), decltype(1 ? (a) : (b))>::type) (x)
+
+#define UNIT__CALL_ASSERT(Op, a, b) unit__assert_ ## Op(UNIT__OPERAND_CXX(a, b, a, b), UNIT__OPERAND_CXX(b, a, a, b), #a, #b)
+
+#else
+
+#define UNIT__IS_SIGNED_INT(x) _Generic((x), char: 1, signed char: 1, short: 1, int: 1, long: 1, long long: 1, default: 0)
+#define UNIT__IS_UNSIGNED_INT(x) _Generic((x), unsigned int: 1, unsigned long: 1, unsigned long long: 1, default: 0)
+
+// 1 if only `a` is signed, 2 if only `b` is, and 0 if the common type keeps values of both
+#define UNIT__SIGN_MIX(a, b) (UNIT__IS_UNSIGNED_INT(1 ? (a) : (b)) * (UNIT__IS_SIGNED_INT(a) + 2 * UNIT__IS_SIGNED_INT(b)))
 
-#define UNIT__SELECT_ASSERT(x) \
-    _Generic((x), \
-        void*: unit__assert_ptr, \
-        const void*: unit__assert_ptr, \
-        char*: unit__assert_str, \
-        const char*: unit__assert_str, \
-        bool: unit__assert_int, \
-        int: unit__assert_int, \
-        long long: unit__assert_int, \
-        unsigned int: unit__assert_uint, \
-        unsigned long: unit__assert_uint, \
-        unsigned long long: unit__assert_uint, \
-        float: unit__assert_dbl, \
-        double: unit__assert_dbl, \
-        long double: unit__assert_dbl)
-
-#define UNIT__ASSERT(Level, Op, a, b, Desc, ...)  UNIT__ASSERT_LAZY(UNIT__SELECT_ASSERT(b)(a, b, Op, Desc, #a, #b), Level, "" #__VA_ARGS__, Desc)
+// the sign mix is an integer constant, so it selects by the size of the array type
+#define UNIT__SELECT_MIXED(a, b, Su, Us, Common) \
+    _Generic((char (*)[1 + UNIT__SIGN_MIX(a, b)]) 0, char (*)[2]: Su, char (*)[3]: Us, default: Common)
+
+#define UNIT__CALL_ASSERT(Op, a, b) \
+    UNIT__SELECT_MIXED(a, b, unit__assert_su_ ## Op, unit__assert_us_ ## Op, UNIT__SELECT_ASSERT(Op, a, b))(a, b, #a, #b)
+
+#define UNIT__SELECT_ASSERT(Op, a, b) \
+    _Generic(1 ? (a) : (b), \
+        int: unit__assert_int_ ## Op, \
+        unsigned int: unit__assert_uint_ ## Op, \
+        long: unit__assert_long_ ## Op, \
+        unsigned long: unit__assert_ulong_ ## Op, \
+        long long: unit__assert_llong_ ## Op, \
+        unsigned long long: unit__assert_ullong_ ## Op, \
+        float: unit__assert_flt_ ## Op, \
+        double: unit__assert_dbl_ ## Op, \
+        long double: unit__assert_ldbl_ ## Op, \
+        char*: unit__assert_str_ ## Op, \
+        const char*: unit__assert_str_ ## Op, \
+        default: unit__assert_ptr_ ## Op)
+
+#endif // __cplusplus
+
+#define UNIT__ASSERT(Level, Op, a, b, Desc, ...)  UNIT__ASSERT_LAZY(UNIT__CALL_ASSERT(Op, a, b), Level, "" #__VA_ARGS__, Desc)
 
 #define UNIT_WARN(x, ...)       UNIT__ASSERT(UNIT__LEVEL_WARN, UNIT__OP_TRUE,  0, x, "warn " #x, __VA_ARGS__)
 #define UNIT_WARN_FALSE(x, ...) UNIT__ASSERT(UNIT__LEVEL_WARN, UNIT__OP_FALSE, 0, x, "warn " #x " is not true", __VA_ARGS__)
@@ -230,7 +602,164 @@ UNIT__FOR_ASSERTS(UNIT__DEFINE_ASSERT)
 #define UNIT_REQUIRE_LT(a, b, ...) UNIT__ASSERT(UNIT__LEVEL_REQUIRE, UNIT__OP_LT, a, b, "require " #a " < " #b, __VA_ARGS__)
 #define UNIT_REQUIRE_LE(a, b, ...) UNIT__ASSERT(UNIT__LEVEL_REQUIRE, UNIT__OP_LE, a, b, "require " #a " <= " #b, __VA_ARGS__)
 
-#define UNIT_SKIP() unit_cur->state |= UNIT__LEVEL_REQUIRE
+void unit__assert_mem(const void* a, const void* b, size_t size, size_t elem_size, const char* sa, const char* sb);
+
+// size of array element, arrays with different element types could not be compared
+#define UNIT__ELEM_SIZE(a, b) (sizeof *(a) + 0 * sizeof(char[sizeof *(a) == sizeof *(b) ? 1 : -1]))
+
+#define UNIT__ASSERT_MEM(Level, a, b, Size, ElemSize, Desc, ...) \
+    UNIT__ASSERT_LAZY(unit__assert_mem(a, b, Size, ElemSize, #a, #b), Level, "" #__VA_ARGS__, Desc)
+
+#define UNIT_WARN_MEM_EQ(a, b, n, ...) UNIT__ASSERT_MEM(UNIT__LEVEL_WARN, a, b, n, 1, "warn " #a " == " #b " (" #n " bytes)", __VA_ARGS__)
+#define UNIT_CHECK_MEM_EQ(a, b, n, ...) UNIT__ASSERT_MEM(UNIT__LEVEL_CHECK, a, b, n, 1, "check " #a " == " #b " (" #n " bytes)", __VA_ARGS__)
+#define UNIT_REQUIRE_MEM_EQ(a, b, n, ...) UNIT__ASSERT_MEM(UNIT__LEVEL_REQUIRE, a, b, n, 1, "require " #a " == " #b " (" #n " bytes)", __VA_ARGS__)
+
+#define UNIT_WARN_ARRAY_EQ(a, b, count, ...) UNIT__ASSERT_MEM(UNIT__LEVEL_WARN, a, b, (count) * UNIT__ELEM_SIZE(a, b), UNIT__ELEM_SIZE(a, b), "warn " #a " == " #b " (" #count " elements)", __VA_ARGS__)
+#define UNIT_CHECK_ARRAY_EQ(a, b, count, ...) UNIT__ASSERT_MEM(UNIT__LEVEL_CHECK, a, b, (count) * UNIT__ELEM_SIZE(a, b), UNIT__ELEM_SIZE(a, b), "check " #a " == " #b " (" #count " elements)", __VA_ARGS__)
+#define UNIT_REQUIRE_ARRAY_EQ(a, b, count, ...) UNIT__ASSERT_MEM(UNIT__LEVEL_REQUIRE, a, b, (count) * UNIT__ELEM_SIZE(a, b), UNIT__ELEM_SIZE(a, b), "require " #a " == " #b " (" #count " elements)", __VA_ARGS__)
+
+// tolerances for `UNIT_CHECK_ARRAY_NEAR`, element passes if it is within any of them
+struct unit_tolerance {
+    // maximum distance in units in the last place
+    unsigned ulps;
+    // maximum relative error
+    double rel;
+    // maximum absolute error
+    double abs;
+};
+
+void unit__assert_near_flt(const float* a, const float* b, size_t n, struct unit_tolerance tol, const char* sa, const char* sb);
+
+void unit__assert_near_dbl(const double* a, const double* b, size_t n, struct unit_tolerance tol, const char* sa, const char* sb);
+
+#ifdef __cplusplus
+}
+extern "C++" {
+static inline decltype(&unit__assert_near_flt) unit__select_near(float) { return unit__assert_near_flt; }
+static inline decltype(&unit__assert_near_dbl) unit__select_near(double) { return unit__assert_near_dbl; }
+}
+extern "C" {
+#define UNIT__SELECT_NEAR(x) unit__select_near(x)
+#else
+#define UNIT__SELECT_NEAR(x) _Generic((x), float: unit__assert_near_flt, double: unit__assert_near_dbl)
+#endif // __cplusplus
+
+// options are `struct unit_tolerance` fields: `UNIT_CHECK_ARRAY_NEAR(a, b, n, .ulps=4, .rel=1e-6)`, 4 ULPs by default
+#define UNIT__ASSERT_NEAR(Level, a, b, n, Desc, ...) \
+    UNIT__ASSERT_LAZY(UNIT__SELECT_NEAR(*(a))(a, b, n, (struct unit_tolerance) { __VA_ARGS__ }, #a, #b), Level, "", Desc)
+
+#define UNIT_WARN_ARRAY_NEAR(a, b, n, ...) UNIT__ASSERT_NEAR(UNIT__LEVEL_WARN, a, b, n, "warn " #a " ~ " #b " (" #n " elements)", __VA_ARGS__)
+#define UNIT_CHECK_ARRAY_NEAR(a, b, n, ...) UNIT__ASSERT_NEAR(UNIT__LEVEL_CHECK, a, b, n, "check " #a " ~ " #b " (" #n " elements)", __VA_ARGS__)
+#define UNIT_REQUIRE_ARRAY_NEAR(a, b, n, ...) UNIT__ASSERT_NEAR(UNIT__LEVEL_REQUIRE, a, b, n, "require " #a " ~ " #b " (" #n " elements)", __VA_ARGS__)
+
+#ifndef UNIT_ALL_SAMPLES
+// number of the first failing indices reported by `UNIT_CHECK_ALL`
+#define UNIT_ALL_SAMPLES 8
+#endif
+
+// failures of the range assertion, only the first samples are kept
+struct unit__all {
+    intmax_t fails;
+    int samples;
+    intmax_t index[UNIT_ALL_SAMPLES];
+    // formatted operands for `UNIT_CHECK_ALL_EQ`, stored in the per-test arena
+    const char* values[UNIT_ALL_SAMPLES];
+};
+
+void unit__all_fail(struct unit__all* all, intmax_t index);
+
+void unit__all_end(const struct unit__all* all, intmax_t begin, intmax_t end, const char* var, const char* expr);
+
+#define UNIT__DEFINE_MIXED_ALL_EQ(Tag, TypeA, TypeB, Rel, ...) \
+void unit__all_fail_ ## Tag(struct unit__all* all, intmax_t index, TypeA a, TypeB b); \
+static inline void unit__all_eq_ ## Tag(struct unit__all* all, intmax_t index, TypeA a, TypeB b) { \
+    if (__builtin_expect(!Rel(a, b, ==), 0)) { \
+        unit__all_fail_ ## Tag(all, index, a, b); \
+    } \
+}
+
+#define UNIT__DEFINE_ALL_EQ(Tag, Type, Rel, Unary) UNIT__DEFINE_MIXED_ALL_EQ(Tag, Type, Type, Rel, Unary)
+
+UNIT__FOR_ASSERTS(UNIT__DEFINE_ALL_EQ)
+UNIT__FOR_MIXED_ASSERTS(UNIT__DEFINE_MIXED_ALL_EQ)
+
+#ifdef __cplusplus
+}
+extern "C++" {
+#define UNIT__SELECT_MIXED_ALL_EQ_CXX(Tag, TypeA, TypeB, ...) \
+static inline void unit__all_eq(struct unit__all* all, intmax_t index, TypeA a, TypeB b) { unit__all_eq_ ## Tag(all, index, a, b); }
+
+#define UNIT__SELECT_ALL_EQ_CXX(Tag, Type, ...) UNIT__SELECT_MIXED_ALL_EQ_CXX(Tag, Type, Type)
+
+UNIT__FOR_ASSERTS(UNIT__SELECT_ALL_EQ_CXX)
+UNIT__FOR_MIXED_ASSERTS(UNIT__SELECT_MIXED_ALL_EQ_CXX)
+UNIT__SELECT_ALL_EQ_CXX(int, bool)
+}
+extern "C" {
+#define UNIT__CALL_ALL_EQ(All, Index, a, b) unit__all_eq(All, Index, UNIT__OPERAND_CXX(a, b, a, b), UNIT__OPERAND_CXX(b, a, a, b))
+#else
+#define UNIT__CALL_ALL_EQ(All, Index, a, b) \
+    UNIT__SELECT_MIXED(a, b, unit__all_eq_su, unit__all_eq_us, UNIT__SELECT_ALL_EQ(a, b))(All, Index, a, b)
+
+#define UNIT__SELECT_ALL_EQ(a, b) \
+    _Generic(1 ? (a) : (b), \
+        int: unit__all_eq_int, \
+        unsigned int: unit__all_eq_uint, \
+        long: unit__all_eq_long, \
+        unsigned long: unit__all_eq_ulong, \
+        long long: unit__all_eq_llong, \
+        unsigned long long: unit__all_eq_ullong, \
+        float: unit__all_eq_flt, \
+        double: unit__all_eq_dbl, \
+        long double: unit__all_eq_ldbl, \
+        char*: unit__all_eq_str, \
+        const char*: unit__all_eq_str, \
+        default: unit__all_eq_ptr)
+#endif // __cplusplus
+
+// the whole range is a single assertion: the loop body is the inlined check, failures are counted out of line
+#define UNIT__ALL_LOOP(Var, Begin, End, Check, Expr) \
+do { \
+    struct unit__all all__; \
+    all__.fails = 0; \
+    all__.samples = 0; \
+    const intmax_t begin__ = (Begin); \
+    const intmax_t end__ = (End); \
+    for (intmax_t Var = begin__; Var < end__; ++Var) { \
+        Check; \
+    } \
+    unit__all_end(&all__, begin__, end__, #Var, Expr); \
+} while (0)
+
+#define UNIT__ALL_PRED(Var, Pred) if (__builtin_expect(!(Pred), 0)) unit__all_fail(&all__, Var)
+
+#define UNIT__ASSERT_ALL(Level, Var, Begin, End, Pred, Desc) \
+    UNIT__ASSERT_LAZY(UNIT__ALL_LOOP(Var, Begin, End, UNIT__ALL_PRED(Var, Pred), #Pred), Level, "", Desc)
+
+#define UNIT__ASSERT_ALL_EQ(Level, Var, Begin, End, a, b, Desc) \
+    UNIT__ASSERT_LAZY(UNIT__ALL_LOOP(Var, Begin, End, UNIT__CALL_ALL_EQ(&all__, Var, a, b), #a " == " #b), Level, "", Desc)
+
+// `UNIT_CHECK_ALL(i, 0, n, out[i] >= 0)` checks the predicate for each index in `[begin, end)`
+#define UNIT_WARN_ALL(i, begin, end, pred) UNIT__ASSERT_ALL(UNIT__LEVEL_WARN, i, begin, end, pred, "warn all " #i " in [" #begin ", " #end "): " #pred)
+#define UNIT_CHECK_ALL(i, begin, end, pred) UNIT__ASSERT_ALL(UNIT__LEVEL_CHECK, i, begin, end, pred, "check all " #i " in [" #begin ", " #end "): " #pred)
+#define UNIT_REQUIRE_ALL(i, begin, end, pred) UNIT__ASSERT_ALL(UNIT__LEVEL_REQUIRE, i, begin, end, pred, "require all " #i " in [" #begin ", " #end "): " #pred)
+
+// `UNIT_CHECK_ALL_EQ(i, 0, n, out[i], ref[i])` also reports values of the first failed elements
+#define UNIT_WARN_ALL_EQ(i, begin, end, a, b) UNIT__ASSERT_ALL_EQ(UNIT__LEVEL_WARN, i, begin, end, a, b, "warn all " #i " in [" #begin ", " #end "): " #a " == " #b)
+#define UNIT_CHECK_ALL_EQ(i, begin, end, a, b) UNIT__ASSERT_ALL_EQ(UNIT__LEVEL_CHECK, i, begin, end, a, b, "check all " #i " in [" #begin ", " #end "): " #a " == " #b)
+#define UNIT_REQUIRE_ALL_EQ(i, begin, end, a, b) UNIT__ASSERT_ALL_EQ(UNIT__LEVEL_REQUIRE, i, begin, end, a, b, "require all " #i " in [" #begin ", " #end "): " #a " == " #b)
+
+// fixture function declaration: `UNIT_FIXTURE(open_db) { ... }`
+#define UNIT_FIXTURE(Name) static void Name(void)
+
+// fixture options: `SUITE(db, UNIT_BEFORE_ALL(open_db), UNIT_AFTER_ALL(close_db))`
+#define UNIT_BEFORE_ALL(Fixture) .before_all=(Fixture)
+#define UNIT_AFTER_ALL(Fixture) .after_all=(Fixture)
+#define UNIT_BEFORE_EACH(Fixture) .before_each=(Fixture)
+#define UNIT_AFTER_EACH(Fixture) .after_each=(Fixture)
+#define UNIT_ROW_NAME(Formatter) .row_name=(Formatter)
+
+#define UNIT_SKIP() ((void) __atomic_or_fetch(&unit__hot.state, UNIT__LEVEL_REQUIRE, __ATOMIC_RELAXED))
 #define UNIT_ECHO(msg) unit__echo(msg)
 
 #ifdef __cplusplus
@@ -1,40 +1,108 @@
 
+#include <stddef.h>
+#include <stdint.h>
+
 #define UNIT__NOOP (void)(0)
+// operands of disabled assertions are referenced in the unevaluated `sizeof`, so values computed only to be checked
+// and helpers called only from assertions are not reported as unused
+#define UNIT__REF(a) ((void) sizeof((void) (a), 0))
+#define UNIT__REF2(a, b) ((void) sizeof((void) (a), (void) (b), 0))
+#define UNIT__REF3(a, b, c) ((void) sizeof((void) (a), (void) (b), (void) (c), 0))
+// the index range is the dead loop, so the predicate can reference the index
+#define UNIT__REF_ALL(i, begin, end, x) do { if (0) for (intmax_t i = (begin); i < (end); ++i) (void) (x); } while (0)
 #define UNIT__CONCAT_(a, b) a ## b
 #define UNIT__CONCAT(a, b) UNIT__CONCAT_(a, b)
 #define UNIT_SUITE(Name, ...) __attribute__((unused)) static void UNIT__CONCAT(unit__, __COUNTER__)(void)
 #define UNIT_DESCRIBE(Name, ...) while(0)
 #define UNIT_TEST(Description, ...) while(0)
 
+// options are only type-checked, so functions referenced by them are not reported as unused
+struct unit__options {
+    int dummy__;
+    int failing;
+    int skip;
+    void (* before_all)(void);
+    void (* after_all)(void);
+    void (* before_each)(void);
+    void (* after_each)(void);
+    void (* row_name)(char* buf, size_t size, const void* row);
+};
+#define UNIT__OPTIONS_REF(...) ((void) sizeof((struct unit__options){ __VA_ARGS__ }), 0)
+
+// `Row` is declared for the body, the body is never run
+#ifdef __cplusplus
+#include <iterator>
+#define UNIT_TEST_EACH(Description, Rows, Row, ...) \
+    for (auto Row = std::begin(Rows); ((void) Row, UNIT__OPTIONS_REF(__VA_ARGS__));)
+#else
+#define UNIT_TEST_EACH(Description, Rows, Row, ...) \
+    for (__typeof__(&(Rows)[0]) Row = (Rows); ((void) Row, UNIT__OPTIONS_REF(__VA_ARGS__));)
+#endif
+
+#define UNIT_PROPERTY(Description, Cases, ...) while (UNIT__OPTIONS_REF(__VA_ARGS__))
+
 #define UNIT_ECHO(...) UNIT__NOOP
 
-#define UNIT_WARN(x, ...) UNIT__NOOP
-#define UNIT_WARN_FALSE(x, ...) UNIT__NOOP
-#define UNIT_WARN_EQ(a, b, ...) UNIT__NOOP
-#define UNIT_WARN_NE(a, b, ...) UNIT__NOOP
-#define UNIT_WARN_GT(a, b, ...) UNIT__NOOP
-#define UNIT_WARN_GE(a, b, ...) UNIT__NOOP
-#define UNIT_WARN_LT(a, b, ...) UNIT__NOOP
-#define UNIT_WARN_LE(a, b, ...) UNIT__NOOP
-
-#define UNIT_CHECK(x, ...) UNIT__NOOP
-#define UNIT_CHECK_FALSE(x, ...) UNIT__NOOP
-#define UNIT_CHECK_EQ(a, b, ...) UNIT__NOOP
-#define UNIT_CHECK_NE(a, b, ...) UNIT__NOOP
-#define UNIT_CHECK_GT(a, b, ...) UNIT__NOOP
-#define UNIT_CHECK_GE(a, b, ...) UNIT__NOOP
-#define UNIT_CHECK_LT(a, b, ...) UNIT__NOOP
-#define UNIT_CHECK_LE(a, b, ...) UNIT__NOOP
-
-#define UNIT_REQUIRE(x, ...) UNIT__NOOP
-#define UNIT_REQUIRE_FALSE(x, ...) UNIT__NOOP
-#define UNIT_REQUIRE_EQ(a, b, ...) UNIT__NOOP
-#define UNIT_REQUIRE_NE(a, b, ...) UNIT__NOOP
-#define UNIT_REQUIRE_GT(a, b, ...) UNIT__NOOP
-#define UNIT_REQUIRE_GE(a, b, ...) UNIT__NOOP
-#define UNIT_REQUIRE_LT(a, b, ...) UNIT__NOOP
-#define UNIT_REQUIRE_LE(a, b, ...) UNIT__NOOP
+#define UNIT_WARN(x, ...) UNIT__REF(x)
+#define UNIT_WARN_FALSE(x, ...) UNIT__REF(x)
+#define UNIT_WARN_EQ(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_WARN_NE(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_WARN_GT(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_WARN_GE(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_WARN_LT(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_WARN_LE(a, b, ...) UNIT__REF2(a, b)
+
+#define UNIT_CHECK(x, ...) UNIT__REF(x)
+#define UNIT_CHECK_FALSE(x, ...) UNIT__REF(x)
+#define UNIT_CHECK_EQ(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_CHECK_NE(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_CHECK_GT(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_CHECK_GE(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_CHECK_LT(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_CHECK_LE(a, b, ...) UNIT__REF2(a, b)
+
+#define UNIT_REQUIRE(x, ...) UNIT__REF(x)
+#define UNIT_REQUIRE_FALSE(x, ...) UNIT__REF(x)
+#define UNIT_REQUIRE_EQ(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_REQUIRE_NE(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_REQUIRE_GT(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_REQUIRE_GE(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_REQUIRE_LT(a, b, ...) UNIT__REF2(a, b)
+#define UNIT_REQUIRE_LE(a, b, ...) UNIT__REF2(a, b)
+
+#define UNIT_WARN_MEM_EQ(a, b, n, ...) UNIT__REF3(a, b, n)
+#define UNIT_WARN_ARRAY_EQ(a, b, count, ...) UNIT__REF3(a, b, count)
+#define UNIT_CHECK_MEM_EQ(a, b, n, ...) UNIT__REF3(a, b, n)
+#define UNIT_CHECK_ARRAY_EQ(a, b, count, ...) UNIT__REF3(a, b, count)
+#define UNIT_REQUIRE_MEM_EQ(a, b, n, ...) UNIT__REF3(a, b, n)
+#define UNIT_REQUIRE_ARRAY_EQ(a, b, count, ...) UNIT__REF3(a, b, count)
+#define UNIT_WARN_ARRAY_NEAR(a, b, n, ...) UNIT__REF3(a, b, n)
+#define UNIT_CHECK_ARRAY_NEAR(a, b, n, ...) UNIT__REF3(a, b, n)
+#define UNIT_REQUIRE_ARRAY_NEAR(a, b, n, ...) UNIT__REF3(a, b, n)
+#define UNIT_WARN_ALL(i, begin, end, pred) UNIT__REF_ALL(i, begin, end, pred)
+#define UNIT_CHECK_ALL(i, begin, end, pred) UNIT__REF_ALL(i, begin, end, pred)
+#define UNIT_REQUIRE_ALL(i, begin, end, pred) UNIT__REF_ALL(i, begin, end, pred)
+#define UNIT_WARN_ALL_EQ(i, begin, end, a, b) UNIT__REF_ALL(i, begin, end, ((void) (a), (void) (b)))
+#define UNIT_CHECK_ALL_EQ(i, begin, end, a, b) UNIT__REF_ALL(i, begin, end, ((void) (a), (void) (b)))
+#define UNIT_REQUIRE_ALL_EQ(i, begin, end, a, b) UNIT__REF_ALL(i, begin, end, ((void) (a), (void) (b)))
+
+#define UNIT_FIXTURE(Name) __attribute__((unused)) static void Name(void)
+#define UNIT_BEFORE_ALL(Fixture) .before_all=(Fixture)
+#define UNIT_AFTER_ALL(Fixture) .after_all=(Fixture)
+#define UNIT_BEFORE_EACH(Fixture) .before_each=(Fixture)
+#define UNIT_AFTER_EACH(Fixture) .after_each=(Fixture)
+#define UNIT_ROW_NAME(Formatter) .row_name=(Formatter)
 
 #define UNIT_SKIP(...) UNIT__NOOP
 
+#define unit_scratch_alloc(size, align) ((void*)0)
+
+#define unit_gen_int(min, max) (min)
+#define unit_gen_uint(min, max) (min)
+#define unit_gen_double(min, max) (min)
+#define unit_gen_bytes(buf, size) UNIT__REF2(buf, size)
+#define unit_gen_len(max) ((size_t) 0)
+#define unit_gen_str(buf, size, alphabet) (UNIT__REF3(buf, size, alphabet), (size_t) 0)
+#define UNIT_GEN_ARRAY(Array, Capacity, Gen) ((void) sizeof((Array)[0] = (Gen)), (size_t) 0)
+
 #define unit_main(...) (0)
@@ -5,72 +5,91 @@
 extern "C" {
 #endif
 
+#include "clock.c"
+#include "env.c"
+#include "resources.c"
+#include "scratch.c"
+#include "fail.c"
+#include "durations.c"
 #include "printer.c"
+#include "printer-trace.c"
+#include "printer-report.c"
+#include "printer-log.c"
+#include "profiler.c"
+#include "property.c"
 
 struct unit_test* unit_tests = NULL;
 struct unit_test* unit_cur = NULL;
 
-// region утилиты для вывода
-const char* unit__vbprintf(const char* fmt, va_list args) {
-    static char s_buffer[4096];
-    vsnprintf(s_buffer, sizeof s_buffer, fmt, args);
-    return s_buffer;
+struct unit_printer* unit__printers;
+unsigned unit__events = 0;
+
+#define UNIT__EACH_PRINTER_IN(List, Func, ...) \
+for(struct unit_printer* p = (List); p; p = p->next) { \
+    if (p->events & UNIT__EVENT(Func)) { unit__printer_out = p->out; p->callback(UNIT__PRINTER_ ## Func, __VA_ARGS__); } \
 }
 
-// endregion
+#define UNIT__EACH_PRINTER(Func, ...) \
+if (unit__events & UNIT__EVENT(Func)) UNIT__EACH_PRINTER_IN(unit__printers, Func, __VA_ARGS__)
 
-const char* unit__op_expl[] = {
-        " is true",
-        " is false",
-        " == ",
-        " != ",
-        " >= ",
-        " > ",
-        " <= ",
-        " < ",
-};
+// total time spent in printers and fixtures, excluded from measured time of running nodes
+static int64_t unit__excluded_time = 0;
 
-const char* unit__op_nexpl[] = {
-        " is not true",
-        " is not false",
-        " != ",
-        " == ",
-        " < ",
-        " <= ",
-        " > ",
-        " >= ",
-};
+__thread struct unit__thread unit__tls;
 
-struct unit_printer* unit__printers;
+struct unit__hot unit__hot;
 
-#define UNIT__EACH_PRINTER(Func, ...) \
-for(struct unit_printer* p = unit__printers; p; p = p->next) { p->callback(UNIT__PRINTER_ ## Func, __VA_ARGS__); }
-
-bool unit__prepare_assert(int level, const char* file, int line, const char* comment, const char* desc) {
-    unit_cur->assert_comment = comment;
-    unit_cur->assert_desc = desc;
-    unit_cur->assert_level = level;
-    unit_cur->assert_file = file;
-    unit_cur->assert_line = line;
-    if (unit_cur->state & UNIT__LEVEL_REQUIRE) {
-        // пропустить проверку
-        unit_cur->assert_status = UNIT_STATUS_SKIPPED;
+// assertions passed in other threads, added to the current node when failures are drained
+static int64_t unit__thread_assertions = 0;
+
+// fills assertion fields for printers, hot path stores only the call site pointer
+static void unit__expand_site(const struct unit__assert_site* site, int status) {
+    unit_cur->assert_site = site;
+    unit_cur->assert_comment = site->comment;
+    unit_cur->assert_desc = site->desc;
+    unit_cur->assert_level = site->level;
+    unit_cur->assert_file = site->file;
+    unit_cur->assert_line = site->line;
+    unit_cur->assert_status = status;
+}
+
+void unit__skip_assert(void) {
+    // пропустить проверку
+    if (unit__tls.owner && (unit__events & UNIT__EVENT(ASSERTION))) {
+        unit__expand_site(unit__tls.site, UNIT_STATUS_SKIPPED);
         UNIT__EACH_PRINTER(ASSERTION, unit_cur, 0);
-        return false;
     }
-    unit_cur->assert_status = UNIT_STATUS_SUCCESS;
-    return true;
 }
 
-static void unit__fail_impl(const char* fmt, ...) {
-    va_list args;
-    va_start(args, fmt);
-    const char* msg = unit__vbprintf(fmt, args);
-    va_end(args);
+void unit__notify_assert(int status) {
+    unit__expand_site(unit__tls.site, status);
+    UNIT__EACH_PRINTER(ASSERTION, unit_cur, 0);
+}
+
+void unit__assert_pass_thread(void) {
+    __atomic_add_fetch(&unit__thread_assertions, 1, __ATOMIC_RELAXED);
+}
 
-    if (unit_cur->assert_level > UNIT__LEVEL_WARN) {
-        unit_cur->assert_status = UNIT_STATUS_FAILED;
-        unit_cur->state |= unit_cur->assert_level;
+static void unit__fail(struct unit__fail_record* record) {
+    const int level = record->site->level;
+    if (level > UNIT__LEVEL_WARN) {
+        // failed `REQUIRE` stops assertions in all threads immediately
+        __atomic_or_fetch(&unit__hot.state, level, __ATOMIC_RELAXED);
+    }
+    if (unit__prop.probing && unit__tls.owner) {
+        // the case is reported only after it's shrunk
+        unit__prop.failed = unit__prop.failed || level > UNIT__LEVEL_WARN;
+        return;
+    }
+    if (!unit__tls.owner) {
+        // printers are not thread-safe, the failure is reported by the tests thread
+        unit__fail_post(record);
+        return;
+    }
+    ++unit__hot.assertions;
+    unit__expand_site(record->site, UNIT_STATUS_FAILED);
+    UNIT__EACH_PRINTER(ASSERTION, unit_cur, 0);
+    if (level > UNIT__LEVEL_WARN) {
         for (struct unit_test* n = unit_cur; n; n = n->parent) {
             if (n->options.failing) {
                 break;
@@ -78,94 +97,262 @@ static void unit__fail_impl(const char* fmt, ...) {
             n->status = UNIT_STATUS_FAILED;
         }
     }
-    UNIT__EACH_PRINTER(FAIL, unit_cur, msg);
-}
-
-#define UNIT__IMPLEMENT_ASSERT(Tag, Type, FormatType, BinaryOp, UnaryOp) \
-void unit__assert_ ## Tag(Type a, Type b, int op, const char* expr, const char* sa, const char* sb) { \
-    bool pass = false; \
-    switch(op) {                                                       \
-        case UNIT__OP_TRUE: pass = (UnaryOp(a, b)); break; \
-        case UNIT__OP_FALSE: pass = !(UnaryOp(a, b)); break; \
-        case UNIT__OP_EQ: pass = (BinaryOp(a, b)) == 0; break; \
-        case UNIT__OP_NE: pass = (BinaryOp(a, b)) != 0; break; \
-        case UNIT__OP_LT: pass = (BinaryOp(a, b)) < 0; break; \
-        case UNIT__OP_LE: pass = (BinaryOp(a, b)) <= 0; break; \
-        case UNIT__OP_GT: pass = (BinaryOp(a, b)) > 0; break; \
-        case UNIT__OP_GE: pass = (BinaryOp(a, b)) >= 0; break; \
-    } \
-    unit_cur->assert_status = pass ? UNIT_STATUS_SUCCESS : UNIT_STATUS_FAILED; \
-    UNIT__EACH_PRINTER(ASSERTION, unit_cur, 0); \
-    if (!pass) { \
-        const char* expl = unit__op_expl[op];                 \
-        const char* nexpl = unit__op_nexpl[op];                 \
-        if (op < UNIT__OP_EQ) unit__fail_impl("Expected " UNIT_COLOR_SUCCESS "`%s`%s" UNIT_COLOR_RESET ", but got `" UNIT_COLOR_FAIL #FormatType "%s`" UNIT_COLOR_RESET, sb, expl, b, nexpl); \
-        else unit__fail_impl("Expected " UNIT_COLOR_SUCCESS "`%s`%s`%s`" UNIT_COLOR_RESET ", but got " UNIT_COLOR_FAIL "`" #FormatType "%s" #FormatType "`" UNIT_COLOR_RESET, sa, expl, sb, a, nexpl, b); \
-    } \
+    unit_cur->fail_record = record;
+    UNIT__EACH_PRINTER(FAIL, unit_cur, NULL);
 }
 
-UNIT__FOR_ASSERTS(UNIT__IMPLEMENT_ASSERT)
+// reports failures and counts assertions of other threads in the current node
+static void unit__fail_drain(void) {
+    unit__hot.assertions += __atomic_exchange_n(&unit__thread_assertions, 0, __ATOMIC_RELAXED);
+    struct unit__fail_node* node = unit__fail_take();
+    while (node) {
+        struct unit__fail_node* next = node->next;
+        unit__fail(unit__fail_adopt(&node->record));
+        unit__fail_free(node);
+        node = next;
+    }
+}
 
-/** Время **/
+// failure with pre-formatted marked text
+static void unit__fail_text(const char* text) {
+    struct unit__fail_record* r = unit__fail_alloc(UNIT__FAIL_TEXT);
+    r->text = unit__fail_strdup(text);
+    unit__fail(r);
+}
 
-double unit__time(double prev) {
-    struct timespec ts = {0};
-#ifndef UNIT_NO_TIME
-#ifdef _WIN32
-    timespec_get(&ts, TIME_UTC);
-#else // _WIN32
-    clock_gettime(CLOCK_REALTIME, &ts);
-#endif // !_WIN32
-#endif // !UNIT_NO_TIME
-    return (double) ts.tv_sec + (double) ts.tv_nsec / 1000000000.0 - prev;
+// each operand is formatted with its own signedness
+#define UNIT__IMPLEMENT_MIXED_ASSERT(Tag, TypeA, TypeB, Rel, Unary, ValueA, ValueB) \
+void unit__fail_ ## Tag(TypeA a, TypeB b, int op, const char* sa, const char* sb) { \
+    struct unit__fail_record* r = unit__fail_alloc(UNIT__FAIL_COMPARE); \
+    r->op = op; \
+    r->sa = sa; \
+    r->sb = sb; \
+    r->a = unit__value_ ## ValueA(a); \
+    r->b = unit__value_ ## ValueB(b); \
+    unit__fail(r); \
 }
 
-// region начало конец запуска каждого теста
+#define UNIT__IMPLEMENT_ASSERT(Tag, Type, Rel, Unary) UNIT__IMPLEMENT_MIXED_ASSERT(Tag, Type, Type, Rel, Unary, Tag, Tag)
 
-static struct unit_test* get_last_child(struct unit_test* children) {
-    while (children && children->next) {
-        children = children->next;
-    }
-    return children;
-}
+UNIT__FOR_ASSERTS(UNIT__IMPLEMENT_ASSERT)
+UNIT__FOR_MIXED_ASSERTS(UNIT__IMPLEMENT_MIXED_ASSERT)
+
+#include "compare.c"
+#include "crash.c"
+
+// region начало конец запуска каждого теста
 
 static void add_child(struct unit_test* parent, struct unit_test* child) {
     //assert (!child->parent);
     if (parent) {
-        struct unit_test* last = get_last_child(parent->children);
-        if (last) {
-            last->next = child;
+        if (parent->children_last) {
+            parent->children_last->next = child;
         } else {
-            child->next = parent->children;
             parent->children = child;
         }
+        parent->children_last = child;
     }
     child->parent = parent;
 }
 
+static int64_t unit__run_fixture(void (* fixture)(void)) {
+    const int64_t t0 = unit__clock.now();
+    fixture();
+    const int64_t elapsed = unit__clock.now() - t0;
+    unit__excluded_time += elapsed;
+    return elapsed;
+}
+
+// runs `before_each` fixtures of all enclosing scopes, from the outermost one
+static void unit__run_before_each(struct unit_test* test, struct unit_test* scope) {
+    if (scope) {
+        unit__run_before_each(test, scope->parent);
+        if (scope->options.before_each && !(unit__hot.state & UNIT__LEVEL_REQUIRE)) {
+            test->fixtures_elapsed += unit__run_fixture(scope->options.before_each);
+        }
+    }
+}
+
+// runs `after_each` fixtures of all enclosing scopes, from the innermost one
+static void unit__run_after_each(struct unit_test* test) {
+    for (struct unit_test* scope = test->parent; scope; scope = scope->parent) {
+        if (scope->options.after_each) {
+            test->fixtures_elapsed += unit__run_fixture(scope->options.after_each);
+        }
+    }
+}
+
+// `*` matches any substring, `?` matches any single character, the whole string should match
+static bool unit__glob(const char* pattern, const char* str) {
+    const char* star = NULL;
+    const char* resume = NULL;
+    while (*str) {
+        if (*pattern == '?' || (*pattern != '*' && *pattern == *str)) {
+            ++pattern;
+            ++str;
+        } else if (*pattern == '*') {
+            star = pattern++;
+            resume = str;
+        } else if (star) {
+            pattern = star + 1;
+            str = ++resume;
+        } else {
+            return false;
+        }
+    }
+    while (*pattern == '*') {
+        ++pattern;
+    }
+    return !*pattern;
+}
+
+#ifndef UNIT_FILTER_DEPTH
+// maximum depth of the test path matched by `--filter`
+#define UNIT_FILTER_DEPTH 64
+#endif
+
+// the path is names of enclosing nodes and the test joined with `/`, the test could be not linked to the tree yet
+static void unit__format_path(char* path, size_t size, struct unit_test* parent, const char* name) {
+    const char* names[UNIT_FILTER_DEPTH];
+    int depth = 0;
+    names[depth++] = beautify_name(name);
+    for (struct unit_test* u = parent; u && depth < UNIT_FILTER_DEPTH; u = u->parent) {
+        names[depth++] = beautify_name(u->name);
+    }
+    size_t len = 0;
+    path[0] = 0;
+    while (depth-- > 0 && len < size) {
+        len += (size_t) snprintf(path + len, size - len, depth ? "%s/" : "%s", names[depth]);
+    }
+}
+
+static bool unit__filter_test(struct unit_test* test) {
+    char path[1024];
+    unit__format_path(path, sizeof path, unit_cur, test->name);
+    return unit__glob(unit__opts.filter, path);
+}
+
+size_t unit__rows(struct unit_test* scope, struct unit__row** rows, size_t* rows_num, size_t count) {
+    if (!*rows && count) {
+        // nodes are linked to the tree, so they live until the process exits
+        *rows = (struct unit__row*) calloc(count, sizeof **rows);
+        if (*rows) {
+            *rows_num = count;
+        } else {
+            fprintf(stderr, "unit: warning: unable to allocate %zu rows of `%s`\n", count, scope->name);
+        }
+    }
+    if (count > *rows_num && *rows) {
+        // nodes are linked to the tree, so the table could not grow between runs
+        fprintf(stderr, "unit: warning: `%s` has %zu rows, only the first %zu are run\n",
+                scope->name, count, *rows_num);
+    }
+    return count < *rows_num ? count : *rows_num;
+}
+
+struct unit_test* unit__row(struct unit_test* scope, struct unit__row* rows, size_t index, const void* row) {
+    struct unit__row* r = rows + index;
+    // the name is formatted by the first run of the row
+    if (!r->node.name) {
+        if (scope->options.row_name) {
+            scope->options.row_name(r->name, sizeof r->name, row);
+            r->name[sizeof r->name - 1] = 0;
+        } else {
+            snprintf(r->name, sizeof r->name, "[%zu]", index);
+        }
+        r->node.name = r->name;
+        r->node.file = scope->file;
+        r->node.line = scope->line;
+        r->node.type = UNIT__TYPE_TEST;
+    }
+    return &r->node;
+}
+
 int unit__begin(struct unit_test* unit) {
-    const bool run = !unit->options.skip;
+    // tests not selected by `--filter` are not started and not reported at all
+    if (unit->type == UNIT__TYPE_TEST && unit__opts.filter && *unit__opts.filter && !unit__filter_test(unit)) {
+        return 0;
+    }
+    // failed `before_all` fixture skips all dependent nodes, `SKIP()` or failed `REQUIRE` in the scope body does not
+    bool run = !unit->options.skip && !(unit_cur && unit_cur->fixture_failed);
+    if (unit_cur) {
+        unit_cur->state = __atomic_load_n(&unit__hot.state, __ATOMIC_RELAXED);
+        unit_cur->assertions = unit__hot.assertions;
+    }
+    __atomic_store_n(&unit__hot.state, 0, __ATOMIC_RELAXED);
+    unit__hot.assertions = 0;
     unit->state = 0;
     unit->status = run ? UNIT_STATUS_RUN : UNIT_STATUS_SKIPPED;
     unit->assert_desc = NULL;
+    unit->assert_site = NULL;
+    unit->fail_record = NULL;
+    if (unit->type == UNIT__TYPE_TEST) {
+        unit__fail_pool_reset();
+    }
+    unit->assertions = 0;
     unit->passed = 0;
     unit->total = 0;
+    unit->fixtures_elapsed = 0;
+    unit->fixture_failed = false;
     if (!unit->parent) {
         add_child(unit_cur, unit);
     }
     unit_cur = unit;
+    unit__tls.owner = true;
+    unit__scratch_begin(unit);
     if (run && unit->type == UNIT__TYPE_TEST) {
         for (struct unit_test* u = unit_cur; u; u = u->parent) {
             u->total++;
         }
     }
+    const int64_t t = unit__clock.now();
     UNIT__EACH_PRINTER(BEGIN, unit, 0);
-    unit->t0 = unit__time(0.0);
+    unit__excluded_time += unit__clock.now() - t;
+    if (run) {
+        if (unit->type == UNIT__TYPE_TEST) {
+            unit__run_before_each(unit, unit->parent);
+        } else if (unit->options.before_all) {
+            unit->fixtures_elapsed += unit__run_fixture(unit->options.before_all);
+            unit->fixture_failed = (unit__hot.state & UNIT__LEVEL_REQUIRE) != 0;
+        }
+        // failed fixture skips the test body
+        run = !(unit->type == UNIT__TYPE_TEST && (unit__hot.state & UNIT__LEVEL_REQUIRE));
+    }
+    if (unit__opts.resources) {
+        unit__sample_resources(&unit->res0);
+    }
+    unit->t0 = unit__clock.now();
+    unit->excluded_t0 = unit__excluded_time;
+    unit->cpu_t0 = unit__cpu_time();
     return run;
 }
 
 void unit__end(struct unit_test* unit) {
-    unit->elapsed = unit__time(unit->t0);
+    unit__crash_land(unit);
+    // the test was filtered out by `unit__begin`
+    if (unit != unit_cur) {
+        return;
+    }
+    unit__crash_disarm(unit);
+    unit__fail_drain();
+    if (unit->status != UNIT_STATUS_SKIPPED && !unit__crash_unwinding) {
+        if (unit->type == UNIT__TYPE_TEST) {
+            unit__run_after_each(unit);
+        } else if (unit->options.after_all) {
+            unit->fixtures_elapsed += unit__run_fixture(unit->options.after_all);
+        }
+    }
+    const int64_t cpu_elapsed = unit__cpu_time() - unit->cpu_t0;
+    const int64_t t = unit__clock.now();
+    const int64_t elapsed = t - unit->t0 - unit__clock.overhead - (unit__excluded_time - unit->excluded_t0);
+    unit->elapsed = elapsed > 0 ? elapsed : 0;
+    unit->cpu_elapsed = cpu_elapsed > 0 ? cpu_elapsed : 0;
+    if (unit__opts.resources) {
+        unit__sample_resources(&unit->res);
+        unit__diff_resources(&unit->res, &unit->res0);
+    }
+    // the arena is poisoned after the timestamp, so the fill is excluded from the test time
+    unit__scratch_end(unit);
     if (unit->status == UNIT_STATUS_RUN) {
         unit->status = UNIT_STATUS_SUCCESS;
         if (unit->type == UNIT__TYPE_TEST) {
@@ -174,8 +361,19 @@ void unit__end(struct unit_test* unit) {
             }
         }
     }
+    if (unit == unit__prop.node) {
+        // `break` out of the property body
+        unit__prop_stop();
+    }
+    unit->state = __atomic_load_n(&unit__hot.state, __ATOMIC_RELAXED);
+    unit->assertions = unit__hot.assertions;
     UNIT__EACH_PRINTER(END, unit, 0);
+    unit__excluded_time += unit__clock.now() - t;
     unit_cur = unit->parent;
+    if (unit_cur) {
+        __atomic_store_n(&unit__hot.state, unit_cur->state, __ATOMIC_RELAXED);
+        unit__hot.assertions = unit_cur->assertions;
+    }
 }
 
 void unit__echo(const char* msg) {
@@ -184,13 +382,128 @@ void unit__echo(const char* msg) {
 
 struct unit_run_options unit__opts;
 
+enum {
+    UNIT__REPORTER_CONSOLE = 0,
+    UNIT__REPORTER_XML = 1,
+    UNIT__REPORTER_JUNIT = 2,
+    UNIT__REPORTER_NDJSON = 3,
+    UNIT__REPORTERS_NUM = 4
+};
+
+static struct unit_printer unit__reporters[UNIT__REPORTERS_NUM];
+
+// opens reporters output, all selected reporters are fed from the single run
+static void unit__init_reporters(void) {
+    struct unit_printer* r = unit__reporters;
+    r[UNIT__REPORTER_CONSOLE].callback = unit__opts.trace ? printer_tracing : printer_def;
+    r[UNIT__REPORTER_CONSOLE].events = UNIT__EVENT(SETUP) | UNIT__EVENT(BEGIN) | UNIT__EVENT(END) | UNIT__EVENT(FAIL);
+    if (unit__opts.durations > 0) {
+        // prints the slowest tests and suites
+        r[UNIT__REPORTER_CONSOLE].events |= UNIT__EVENT(SHUTDOWN);
+    }
+    if (unit__opts.trace) {
+        // prints each assertion
+        r[UNIT__REPORTER_CONSOLE].events |= UNIT__EVENT(ECHO) | UNIT__EVENT(ASSERTION);
+    }
+    r[UNIT__REPORTER_XML].callback = printer_xml_doctest;
+    r[UNIT__REPORTER_XML].events = UNIT__EVENTS_ALL & ~(UNIT__EVENT(ECHO) | UNIT__EVENT(ASSERTION));
+    r[UNIT__REPORTER_JUNIT].callback = printer_junit;
+    r[UNIT__REPORTER_JUNIT].events = UNIT__EVENT(SETUP) | UNIT__EVENT(SHUTDOWN) | UNIT__EVENT(BEGIN) | UNIT__EVENT(END) |
+                                        UNIT__EVENT(FAIL);
+    r[UNIT__REPORTER_NDJSON].callback = printer_ndjson;
+    r[UNIT__REPORTER_NDJSON].events = UNIT__EVENTS_ALL & ~UNIT__EVENT(ASSERTION);
+
+    const int enabled[UNIT__REPORTERS_NUM] = {
+            unit__opts.console || !(unit__opts.doctest_xml || unit__opts.junit || unit__opts.ndjson),
+            unit__opts.doctest_xml,
+            unit__opts.junit,
+            unit__opts.ndjson
+    };
+    const char* paths[UNIT__REPORTERS_NUM] = {
+            unit__opts.console_out,
+            unit__opts.xml_out,
+            unit__opts.junit_out,
+            unit__opts.ndjson_out
+    };
+    int to_stdout = 0;
+    for (int i = UNIT__REPORTERS_NUM - 1; i >= 0; --i) {
+        r[i].out = NULL;
+        if (!enabled[i]) {
+            continue;
+        }
+        if (paths[i] && paths[i][0]) {
+            r[i].out = fopen(paths[i], "w");
+            if (!r[i].out) {
+                fprintf(stderr, "unit: warning: unable to open report file `%s`\n", paths[i]);
+                continue;
+            }
+        } else if (unit__opts.quiet) {
+            continue;
+        } else {
+            r[i].out = stdout;
+            ++to_stdout;
+        }
+        r[i].next = unit__printers;
+        unit__printers = r + i;
+    }
+    if (to_stdout > 1) {
+        fputs("unit: warning: several reporters write to `stdout`, use `-r=name:FILE` to separate them\n", stderr);
+    }
+}
+
+static void unit__close_reporters(void) {
+    for (int i = 0; i < UNIT__REPORTERS_NUM; ++i) {
+        if (unit__reporters[i].out && unit__reporters[i].out != stdout) {
+            fclose(unit__reporters[i].out);
+        }
+        unit__reporters[i].out = NULL;
+    }
+}
+
+// moves reporters to the reporter thread, see `async.c`
+static void unit__async_init(void);
+
 static void unit__init_printers(void) {
-    static struct unit_printer printer;
-    printer.callback = unit__opts.trace ? printer_tracing : printer_def;
-    if (unit__opts.doctest_xml) {
-        printer.callback = printer_xml_doctest;
+    static struct unit_printer trace_events;
+    unit__printers = NULL;
+    unit__init_reporters();
+    if (unit__opts.async_report) {
+        unit__async_init();
+    }
+    if (unit__opts.durations > 0) {
+        static struct unit_printer durations;
+        durations.callback = printer_durations;
+        durations.events = UNIT__EVENT(SETUP) | UNIT__EVENT(END);
+        durations.next = unit__printers;
+        unit__printers = &durations;
+    }
+    if (unit__opts.trace_out && unit__opts.trace_out[0]) {
+        trace_events.callback = printer_trace_events;
+        trace_events.events = UNIT__EVENTS_ALL & ~UNIT__EVENT(ASSERTION);
+        trace_events.next = unit__printers;
+        unit__printers = &trace_events;
+    }
+    if (unit__opts.events_out && unit__opts.events_out[0]) {
+        static struct unit_printer events_log;
+        events_log.callback = printer_events_log;
+        events_log.events = UNIT__EVENTS_ALL & ~UNIT__EVENT(ASSERTION);
+        events_log.next = unit__printers;
+        unit__printers = &events_log;
+    }
+    if (unit__opts.profile || (unit__opts.profile_out && unit__opts.profile_out[0])) {
+        static struct unit_printer profile;
+        if (!unit__opts.profile_out || !unit__opts.profile_out[0]) {
+            unit__opts.profile_out = "unit.folded";
+        }
+        profile.callback = printer_profile;
+        profile.events = UNIT__EVENT(SETUP) | UNIT__EVENT(SHUTDOWN) | UNIT__EVENT(END);
+        profile.next = unit__printers;
+        unit__printers = &profile;
+    }
+    unit__events = 0;
+    for (struct unit_printer* p = unit__printers; p; p = p->next) {
+        unit__events |= p->events;
     }
-    unit__printers = unit__opts.quiet ? NULL : &printer;
 }
 
 #define UNIT__MSG_VERSION "unit v" UNIT_VERSION "\n"
@@ -202,8 +515,25 @@ static void unit__init_printers(void) {
 "  --ascii: Don't use colors and fancy unicode symbols in the output\n" \
 "  --quiet or -q: Disables all output\n" \
 "  --short-filenames or -S: Use only basename for displaying file-pos information\n" \
-"  -r=xml: Special switch prints XML report in DocTest-friendly format (for CLion test run configuration)\n" \
-"  --animate or -a: Simulate waits for printing messages, just for making fancy printing animation\n"
+"  -r=NAME[:FILE]: Select reporter, repeat to run several reporters at once, each writes to `stdout` or its own FILE\n" \
+"    -r=console: Human-readable report, the default one\n" \
+"    -r=xml: Special switch prints XML report in DocTest-friendly format (for CLion test run configuration)\n" \
+"    -r=junit: Print JUnit XML report\n" \
+"    -r=ndjson: Print newline-delimited JSON events report\n" \
+"  --animate or -a: Simulate waits for printing messages, just for making fancy printing animation\n" \
+"  --cpus=LIST: Pin the runner to CPU set, for example `--cpus=0,2-3`\n" \
+"  --trace-out=FILE: Write Chrome trace-event JSON timeline of the run (`chrome://tracing` or Perfetto)\n" \
+"  --events-out=FILE: Write compact binary events log, convert it to any report later with `unit-report` tool\n" \
+"  --profile[=FILE]: Sample call stacks of running tests to folded stacks file for flame graphs, `unit.folded` by default\n" \
+"  --durations=N: Print N slowest tests and N slowest suites after the run\n" \
+"  --seed=N: Seed random cases of `PROPERTY` tests, printed with the falsified property to reproduce it\n" \
+"  --filter=PATTERN: Run only tests which path `suite/describe/test` matches the glob PATTERN with `*` and `?`\n" \
+"  --resources: Report CPU time, memory, page faults and context switches for each test\n" \
+"  --clock=mono|tsc: Select time source for measurements, `mono` is default\n" \
+"  --strict-env: Refuse to run if environment is not suitable for benchmarking\n" \
+"  --env: Measure CPU frequency governor and timer jitter for the environment line\n" \
+"  --catch-crashes: Recover from crashing signals in tests, report the crash and continue with the next test\n" \
+"  --async-report: Run reporters in their own thread, so printing does not slow down the tests thread\n"
 
 static int unit__cmd(struct unit_run_options options) {
     if (options.version) {
@@ -231,19 +561,31 @@ int unit_main(struct unit_run_options options) {
 
     unit__opts = options;
     srand(options.seed);
+    unit__clock_setup();
+    if (!unit__env_setup()) {
+        return EXIT_FAILURE;
+    }
     unit__init_printers();
+    unit__output_setup();
 
     UNIT__EACH_PRINTER(SETUP, 0, 0);
+    if (unit__opts.catch_crashes || unit__opts.async_report) {
+        // the reporter thread prints pending events before the crashing process is killed
+        unit__crash_install();
+    }
 
     int failed = 0;
     for (struct unit_test* suite = unit_tests; suite; suite = suite->next) {
-        UNIT_TRY_SCOPE(unit__begin(suite), unit__end(suite)) suite->fn();
+        UNIT_TRY_SCOPE(unit__begin(suite), unit__end(suite)) UNIT__CRASH_POINT(suite) suite->fn();
         if (suite->status == UNIT_STATUS_FAILED) {
             ++failed;
         }
     }
 
+    unit__crash_uninstall();
     UNIT__EACH_PRINTER(SHUTDOWN, 0, 0);
+    unit__close_reporters();
+    unit__output_flush(stdout);
 
     return failed ? EXIT_FAILURE : EXIT_SUCCESS;
 }
@@ -258,7 +600,7 @@ static void find_bool_arg(int argc, const char** argv, int* var, const char* nam
                 return;
             } else if (name && name[0] && v[0] == '-') {
                 ++v;
-                if (strstr(v, name) == v) {
+                if (strcmp(v, name) == 0) {
                     *var = 1;
                     return;
                 }
@@ -267,6 +609,69 @@ static void find_bool_arg(int argc, const char** argv, int* var, const char* nam
     }
 }
 
+static void find_str_arg(int argc, const char** argv, const char** var, const char* name) {
+    const size_t len = strlen(name);
+    for (int i = 0; i < argc; ++i) {
+        const char* v = argv[i];
+        if (v && v[0] == '-' && v[1] == '-' && strncmp(v + 2, name, len) == 0 && v[2 + len] == '=') {
+            *var = v + 3 + len;
+            return;
+        }
+    }
+}
+
+static void find_int_arg(int argc, const char** argv, int* var, const char* name) {
+    const char* value = NULL;
+    find_str_arg(argc, argv, &value, name);
+    if (value) {
+        *var = atoi(value);
+    }
+}
+
+static void find_uint_arg(int argc, const char** argv, unsigned* var, const char* name) {
+    const char* value = NULL;
+    find_str_arg(argc, argv, &value, name);
+    if (value) {
+        *var = (unsigned) strtoul(value, NULL, 10);
+    }
+}
+
+static bool match_reporter(const char* name, size_t len, const char* reporter, int* var) {
+    if (len == strlen(reporter) && strncmp(name, reporter, len) == 0) {
+        *var = 1;
+        return true;
+    }
+    return false;
+}
+
+// parses all `-r=name[:FILE]` options
+static void find_reporter_args(int argc, const char** argv, struct unit_run_options* out_options) {
+    for (int i = 0; i < argc; ++i) {
+        const char* v = argv[i];
+        if (!v || strncmp(v, "-r=", 3) != 0) {
+            continue;
+        }
+        const char* name = v + 3;
+        const char* path = strchr(name, ':');
+        const size_t len = path ? (size_t) (path - name) : strlen(name);
+        if (path) {
+            ++path;
+        }
+        if (match_reporter(name, len, "console", &out_options->console)) {
+            out_options->console_out = path;
+        } else if (match_reporter(name, len, "xml", &out_options->doctest_xml)) {
+            // hack to trick CLion we are DocTest library tests
+            out_options->xml_out = path;
+        } else if (match_reporter(name, len, "junit", &out_options->junit)) {
+            out_options->junit_out = path;
+        } else if (match_reporter(name, len, "ndjson", &out_options->ndjson)) {
+            out_options->ndjson_out = path;
+        } else {
+            fprintf(stderr, "unit: warning: unknown reporter `%s`\n", name);
+        }
+    }
+}
+
 static void unit__parse_args(int argc, const char** argv, struct unit_run_options* out_options) {
     find_bool_arg(argc, argv, &out_options->version, "version", "v");
     find_bool_arg(argc, argv, &out_options->help, "help", "h");
@@ -276,8 +681,21 @@ static void unit__parse_args(int argc, const char** argv, struct unit_run_option
     find_bool_arg(argc, argv, &out_options->quiet, "quiet", "q");
     find_bool_arg(argc, argv, &out_options->animate, "animate", "a");
     find_bool_arg(argc, argv, &out_options->short_filenames, "short-filenames", "S");
-    // hack to trick CLion we are DocTest library tests
-    find_bool_arg(argc, argv, &out_options->doctest_xml, NULL, "r=xml");
+    find_bool_arg(argc, argv, &out_options->strict_env, "strict-env", NULL);
+    find_bool_arg(argc, argv, &out_options->env, "env", NULL);
+    find_bool_arg(argc, argv, &out_options->resources, "resources", NULL);
+    find_bool_arg(argc, argv, &out_options->catch_crashes, "catch-crashes", NULL);
+    find_bool_arg(argc, argv, &out_options->async_report, "async-report", NULL);
+    find_str_arg(argc, argv, &out_options->cpus, "cpus");
+    find_str_arg(argc, argv, &out_options->clock, "clock");
+    find_str_arg(argc, argv, &out_options->trace_out, "trace-out");
+    find_str_arg(argc, argv, &out_options->events_out, "events-out");
+    find_int_arg(argc, argv, &out_options->durations, "durations");
+    find_str_arg(argc, argv, &out_options->filter, "filter");
+    find_uint_arg(argc, argv, &out_options->seed, "seed");
+    find_bool_arg(argc, argv, &out_options->profile, "profile", NULL);
+    find_str_arg(argc, argv, &out_options->profile_out, "profile");
+    find_reporter_args(argc, argv, out_options);
 }
 
 static void unit__setup_args(int argc, const char** argv, struct unit_run_options* out_options) {
@@ -294,6 +712,9 @@ static void unit__setup_args(int argc, const char** argv, struct unit_run_option
 
 // endregion
 
+#include "report.c"
+#include "async.c"
+
 #ifdef UNIT_MAIN
 
 #include "unit-main.c"
@@ -0,0 +1,134 @@
+#define UNIT_IMPLEMENT
+
+#include <unit.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define CRASH_REPORT "test-crash.ndjson"
+
+static int crash__survived = 0;
+static int crash__segv_line = 0;
+static int crash__abort_line = 0;
+static int crash__fpe_line = 0;
+static int crash__overflow_line = 0;
+
+static void crash__recurse(volatile char* prev);
+
+// the recursion goes through the pointer, so it's neither optimized out nor diagnosed as infinite
+static void (* volatile crash__recurse_ptr)(volatile char*) = crash__recurse;
+
+static void crash__recurse(volatile char* prev) {
+    volatile char frame[1024];
+    frame[0] = prev ? prev[0] : 1;
+    crash__recurse_ptr(frame);
+}
+
+// crashed tests are marked failed, so the suite is expected to fail
+SUITE(crash, .failing=1) {
+    crash__segv_line = __LINE__ + 1;
+    IT("recovers from null dereference") {
+        volatile int* p = NULL;
+        *p = 1;
+        ++crash__survived;
+    }
+
+    crash__abort_line = __LINE__ + 1;
+    IT("recovers from abort") {
+        abort();
+    }
+
+    DESCRIBE(nested) {
+        crash__fpe_line = __LINE__ + 1;
+        IT("recovers from floating point exception") {
+            raise(SIGFPE);
+        }
+
+        crash__overflow_line = __LINE__ + 1;
+        IT("recovers from stack overflow") {
+            crash__recurse(NULL);
+        }
+
+        IT("continues with the next sibling") {
+            ++crash__survived;
+        }
+    }
+
+    IT("continues after nested crash") {
+        ++crash__survived;
+    }
+}
+
+static char* crash__read(const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) {
+        return NULL;
+    }
+    fseek(f, 0, SEEK_END);
+    const long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    char* data = size >= 0 ? (char*) malloc((size_t) size + 1) : NULL;
+    if (data) {
+        data[fread(data, 1, (size_t) size, f)] = 0;
+    }
+    fclose(f);
+    return data;
+}
+
+// the test is marked failed, its failure names the signal, the location of the test and the backtrace
+static int crash__reported(char* report, const char* test, const char* signal, int line) {
+    char path[128];
+    char location[64];
+    char message[64];
+    snprintf(path, sizeof path, ",\"%s\"]", test);
+    snprintf(location, sizeof location, "\"line\":%d,", line);
+    snprintf(message, sizeof message, "\"message\":\"Crashed with %s (", signal);
+    int fail = 0;
+    int end = 0;
+    for (char* s = strtok(report, "\n"); s; s = strtok(NULL, "\n")) {
+        if (!strstr(s, path)) {
+            continue;
+        }
+        if (strstr(s, "\"event\":\"fail\"")) {
+            fail = strstr(s, location) && strstr(s, message) && strstr(s, "main.c\"");
+#ifdef UNIT__CRASH_BACKTRACE
+            fail = fail && strstr(s, "\\n    #0 ");
+#endif // UNIT__CRASH_BACKTRACE
+        } else if (strstr(s, "\"event\":\"end\"")) {
+            end = strstr(s, "\"status\":\"failed\"") != NULL;
+        }
+    }
+    if (!fail || !end) {
+        fprintf(stderr, "crash of `%s` is not reported as %s at line %d\n", test, signal, line);
+    }
+    return fail && end;
+}
+
+static int crash__check(const char* test, const char* signal, int line) {
+    char* report = crash__read(CRASH_REPORT);
+    const int ok = report && crash__reported(report, test, signal, line);
+    free(report);
+    return ok;
+}
+
+int main(int argc, const char** argv) {
+    (void) argc;
+    (void) argv;
+    int result = 0;
+    for (int i = 0; i < 2; ++i) {
+        crash__survived = 0;
+        result |= unit_main((struct unit_run_options) {.catch_crashes = 1, .quiet = i});
+        if (crash__survived != 2) {
+            return EXIT_FAILURE;
+        }
+    }
+    result |= unit_main((struct unit_run_options) {.catch_crashes = 1, .quiet = 1, .ndjson = 1, .ndjson_out = CRASH_REPORT});
+    if (!crash__check("recovers from null dereference", "SIGSEGV", crash__segv_line) ||
+        !crash__check("recovers from abort", "SIGABRT", crash__abort_line) ||
+        !crash__check("recovers from floating point exception", "SIGFPE", crash__fpe_line) ||
+        !crash__check("recovers from stack overflow", "SIGSEGV", crash__overflow_line)) {
+        return EXIT_FAILURE;
+    }
+    return result;
+}
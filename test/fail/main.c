@@ -7,3 +7,11 @@ SUITE(fail) {
         REQUIRE(0);
     }
 }
+
+SUITE(sign) {
+    IT("prints each operand with its own sign") {
+        const size_t n = 3;
+        const int i = -1;
+        CHECK_LT(n, i);
+    }
+}
@@ -1,6 +1,9 @@
 // Проверяем, что компиляция заголовка возможна в более чем одной единице сборки (Translation Unit)
 #include <unit.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
 
 SUITE(asserts) {
     IT("evaluated only once!") {
@@ -189,6 +192,109 @@ SUITE(asserts) {
         REQUIRE_NE(ptr, zero);
     }
 
+    IT("has full integer and floating types support") {
+        const char c = 'a';
+        const short s = -2;
+        const bool b = true;
+        const int8_t i8 = -1;
+        const uint16_t u16 = 65535;
+        const uint64_t u64 = (1ull << 63) + 1;
+        const size_t z = 3;
+        const long l = -5;
+        const float f = 0.5f;
+        const double d = 0.1;
+        const long double ld = 1.0L;
+        const double nan = 0.0 / 0.0;
+
+        CHECK_EQ(c, 'a');
+        CHECK_LT(s, 0);
+        CHECK(b);
+        CHECK_EQ(i8, -1);
+        CHECK_GT(u16, 255);
+        // compared without precision loss
+        CHECK_NE(u64, 1ull << 63);
+        CHECK_EQ(z, 3);
+        CHECK_LT(l, 0);
+        CHECK_EQ(f, 0.5f);
+        CHECK_GT(f, d);
+        CHECK_EQ(ld, 1.0L);
+        CHECK_NE(nan, nan);
+        CHECK_FALSE(nan == nan);
+    }
+
+    IT("has memory and array support") {
+        static unsigned char a[1000];
+        static unsigned char b[1000];
+        const int ia[5] = {1, 2, 3, 4, 5};
+        const int ib[5] = {1, 2, 3, 4, 5};
+        for (int i = 0; i < 1000; ++i) {
+            a[i] = b[i] = (unsigned char) i;
+        }
+        REQUIRE_MEM_EQ(a, b, sizeof a);
+        REQUIRE_MEM_EQ(a, b, 0);
+        REQUIRE_ARRAY_EQ(ia, ib, 5);
+        CHECK_ARRAY_EQ(ia + 1, ib + 1, 4);
+        WARN_ARRAY_EQ(ia, ib, 0);
+    }
+
+    IT("has approximate float arrays support") {
+        float fa[100];
+        float fb[100];
+        double da[100];
+        double db[100];
+        for (int i = 0; i < 100; ++i) {
+            fa[i] = fb[i] = 0.1f * (float) i;
+            da[i] = db[i] = 0.1 * i;
+        }
+        // the next representable float
+        int32_t bits;
+        memcpy(&bits, fa + 10, sizeof bits);
+        ++bits;
+        memcpy(fb + 10, &bits, sizeof bits);
+        db[20] = da[20] * (1.0 + 1e-9);
+        REQUIRE_ARRAY_NEAR(fa, fb, 100);
+        REQUIRE_ARRAY_NEAR(fa, fb, 100, .ulps=1);
+        REQUIRE_ARRAY_NEAR(da, db, 100, .rel=1e-8);
+        CHECK_ARRAY_NEAR(da, db, 100, .abs=1e-6);
+        WARN_ARRAY_NEAR(da, db, 0);
+    }
+
+    IT("checks index range as one assertion") {
+        int squares[1000];
+        for (int i = 0; i < 1000; ++i) {
+            squares[i] = i * i;
+        }
+        const char* names[3] = {"a", "b", "c"};
+        const char* copies[3] = {"a", "b", "c"};
+        REQUIRE_ALL(i, 0, 1000, squares[i] >= 0);
+        REQUIRE_ALL(i, 1, 1000, squares[i] > squares[i - 1]);
+        CHECK_ALL_EQ(i, 0, 1000, squares[i], (int) (i * i));
+        CHECK_ALL_EQ(k, 0, 3, names[k], copies[k]);
+        WARN_ALL(i, 10, 0, false);
+
+        int evaluated = 0;
+        SKIP();
+        CHECK_ALL(i, 0, 1000, ++evaluated > 0);
+        if (evaluated != 0) exit(EXIT_FAILURE);
+    }
+
+    IT("compares signed and unsigned integers by value") {
+        size_t n = 3;
+        int i = -1;
+        long long l = -5;
+        unsigned char c = 200;
+
+        CHECK_GT(n, -1);
+        CHECK_LT(i, n);
+        CHECK_NE(i, n);
+        CHECK_LE(l, 0u);
+        CHECK_GE(n, l);
+        CHECK_FALSE(n == (size_t) -1);
+        CHECK_EQ(c, 200);
+        CHECK_GT(c, i);
+        CHECK_ALL_EQ(k, 0, 3, (size_t) k, (int) k);
+    }
+
     IT("fail cases", .failing=1) {
         const void* zero = NULL;
         const char* str = NULL;
@@ -206,5 +312,22 @@ SUITE(asserts) {
         CHECK_GT(s, 0);
         CHECK(f);
         CHECK_GT(f, 0.0);
+        CHECK_LT(u, s);
+        CHECK_GE(s, u);
+
+        const short sa[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+        const short sb[10] = {0, 1, 2, 3, 4, 5, 7, 7, 8, 0};
+        CHECK_MEM_EQ(sa, sb, sizeof sa);
+        CHECK_ARRAY_EQ(sa, sb, 10);
+        CHECK_ARRAY_EQ(sa, (const short*) zero, 10);
+
+        const float fa[4] = {1.0f, 2.0f, 3.0f, 4.0f};
+        const float fb[4] = {1.0f, 2.001f, 3.0f, 4.1f};
+        CHECK_ARRAY_NEAR(fa, fb, 4, .rel=1e-4);
+        CHECK_ARRAY_NEAR(fa, fb, 4);
+
+        CHECK_ALL(i, 0, 1000000, i % 81 != 17);
+        CHECK_ALL_EQ(i, 0, 100, i / 10, (intmax_t) 0);
+        CHECK_ALL_EQ(i, 0, 3, (const char*) (i ? "x" : "y"), "x");
     }
 }
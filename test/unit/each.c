@@ -0,0 +1,48 @@
+#include <unit.h>
+#include <stdio.h>
+#include <string.h>
+
+struct each__row {
+    const char* str;
+    size_t len;
+};
+
+static const struct each__row each__rows[] = {
+        {"", 0},
+        {"a", 1},
+        {"unit", 4},
+        {"table-driven", 12},
+};
+
+static int each__runs = 0;
+
+static void each__row_name(char* buf, size_t size, const void* row) {
+    snprintf(buf, size, "\"%s\"", ((const struct each__row*) row)->str);
+}
+
+SUITE(each) {
+    IT_EACH("string length", each__rows, row) {
+        REQUIRE_EQ(strlen(row->str), row->len);
+    }
+
+    IT_EACH("named rows", each__rows, row, ROW_NAME(each__row_name)) {
+        REQUIRE_LE(row->len, 12);
+    }
+
+    DESCRIBE(rows) {
+        IT("are counted before") {
+            each__runs = 0;
+        }
+        IT_EACH("run each row once", each__rows, row) {
+            REQUIRE_EQ(row - each__rows, each__runs);
+            ++each__runs;
+        }
+        IT("are counted after") {
+            REQUIRE_EQ(each__runs, 4);
+        }
+    }
+
+    IT_EACH("skip all rows", each__rows, row, .skip=1) {
+        REQUIRE(0, skipped);
+    }
+}
@@ -0,0 +1,97 @@
+#include <unit.h>
+
+static int fixtures__table[256];
+static int fixtures__before_all = 0;
+static int fixtures__after_all = 0;
+static int fixtures__before_each = 0;
+static int fixtures__after_each = 0;
+static int fixtures__failed_runs = 0;
+static int fixtures__scope_runs = 0;
+
+FIXTURE(fixtures_fill_table) {
+    // suite could be run several times
+    ++fixtures__before_all;
+    fixtures__before_each = 0;
+    fixtures__after_each = 0;
+    fixtures__failed_runs = 0;
+    fixtures__scope_runs = 0;
+    for (int i = 0; i < 256; ++i) {
+        fixtures__table[i] = i * i;
+    }
+}
+
+FIXTURE(fixtures_clear_table) {
+    ++fixtures__after_all;
+}
+
+FIXTURE(fixtures_count_before) {
+    ++fixtures__before_each;
+}
+
+FIXTURE(fixtures_count_after) {
+    ++fixtures__after_each;
+}
+
+FIXTURE(fixtures_fail) {
+    REQUIRE(0, fixture failure);
+}
+
+SUITE(fixtures, BEFORE_ALL(fixtures_fill_table), AFTER_ALL(fixtures_clear_table)) {
+    IT("runs `before_all` once before tests") {
+        REQUIRE_EQ(fixtures__before_all, fixtures__after_all + 1);
+        REQUIRE_EQ(fixtures__table[16], 256);
+    }
+
+    DESCRIBE(each, BEFORE_EACH(fixtures_count_before), AFTER_EACH(fixtures_count_after)) {
+        IT("runs `before_each` for the first test") {
+            REQUIRE_EQ(fixtures__before_each, 1);
+            REQUIRE_EQ(fixtures__after_each, 0);
+        }
+        DESCRIBE(nested) {
+            IT("runs fixtures of enclosing scopes") {
+                REQUIRE_EQ(fixtures__before_each, 2);
+                REQUIRE_EQ(fixtures__after_each, 1);
+            }
+        }
+    }
+
+    IT("runs `after_each` after each test in the scope") {
+        REQUIRE_EQ(fixtures__before_each, 2);
+        REQUIRE_EQ(fixtures__after_each, 2);
+        REQUIRE_EQ(fixtures__after_all, fixtures__before_all - 1);
+    }
+
+    DESCRIBE(failed fixture, .failing=1, BEFORE_ALL(fixtures_fail)) {
+        IT("skips dependent tests") {
+            ++fixtures__failed_runs;
+        }
+    }
+
+    DESCRIBE(failed each fixture, .failing=1, BEFORE_EACH(fixtures_fail)) {
+        IT("skips the test body") {
+            ++fixtures__failed_runs;
+        }
+    }
+
+    IT("doesn't run tests depending on failed fixtures") {
+        REQUIRE_EQ(fixtures__failed_runs, 0);
+    }
+
+    DESCRIBE(skipped scope body) {
+        SKIP();
+        IT("runs nested tests") {
+            ++fixtures__scope_runs;
+        }
+    }
+
+    DESCRIBE(failed scope body, .failing=1) {
+        REQUIRE(0, failure outside of fixtures);
+        IT("runs nested tests too") {
+            ++fixtures__scope_runs;
+        }
+    }
+
+    IT("runs tests of scopes which body is skipped or failed") {
+        REQUIRE_EQ(fixtures__scope_runs, 2);
+    }
+}
@@ -15,6 +15,8 @@ int main(int argc, const char** argv) {
     result |= unit_main((struct unit_run_options){0, 0, 0, 0, 0, 1, 0, 0});
     result |= unit_main((struct unit_run_options){0, 0, 0, 1, 0, 0, 1, 0});
     result |= unit_main((struct unit_run_options){0, 0, 0, 0, 0, 0, 0, 1});
+    result |= unit_main((struct unit_run_options){.junit=1});
+    result |= unit_main((struct unit_run_options){.ndjson=1});
     return result;
 }
 
@@ -1,8 +1,57 @@
 #include <unit.h>
 #include <cstring>
+#include <list>
+#include <string>
+#include <vector>
+
+static std::list<int> make_rows() {
+    return {1, 2, 3};
+}
+
+static int rows_sum = 0;
 
 SUITE(unit.cpp) {
     IT("should compile as c++ source code") {
         REQUIRE(strstr(__PRETTY_FUNCTION__, __FUNCTION__));
     }
+
+    IT("selects assertion by common type of operands") {
+        const char c = 'a';
+        const unsigned long long u = ~0ull;
+        const float f = 0.5f;
+        const char* s = "str";
+        CHECK_EQ(c, 'a');
+        CHECK_GT(u, 1);
+        CHECK_LT(f, 1.0);
+        CHECK_EQ(s, "str");
+        CHECK(s);
+        CHECK(true);
+        CHECK_ALL(i, 0, 4, s[i % 3] != 0);
+        CHECK_ALL_EQ(i, 0, 4, s, "str");
+    }
+
+    IT("compares signed and unsigned integers by value") {
+        const size_t n = 3;
+        const int i = -1;
+        CHECK_GT(n, -1);
+        CHECK_LT(i, n);
+        CHECK_NE(n, i);
+        CHECK_ALL_EQ(k, 0, 3, (size_t) k, (int) k);
+    }
+
+    static const std::vector<std::string> rows = {"a", "bb", "ccc"};
+    IT_EACH("iterates rows of container", rows, row) {
+        REQUIRE_GT(row->size(), 0);
+    }
+
+    IT_EACH("iterates rows of temporary list", make_rows(), row) {
+        rows_sum += *row;
+        REQUIRE_GT(*row, 0);
+    }
+
+    IT("visits each row of the list once") {
+        const int sum = rows_sum;
+        rows_sum = 0;
+        REQUIRE_EQ(sum, 6);
+    }
 }
@@ -0,0 +1,80 @@
+#include <unit.h>
+#include <stdint.h>
+#include <string.h>
+
+static int property__sorted(const int* a, size_t n) {
+    for (size_t i = 1; i < n; ++i) {
+        if (a[i - 1] > a[i]) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void property__sort(int* a, size_t n) {
+    for (size_t i = 1; i < n; ++i) {
+        const int x = a[i];
+        size_t j = i;
+        for (; j > 0 && a[j - 1] > x; --j) {
+            a[j] = a[j - 1];
+        }
+        a[j] = x;
+    }
+}
+
+// the counterexamples reported by failing properties, checked out of the `.failing` scope
+static int64_t property__shrunk = 0;
+static int64_t property__shrunk_signed = 0;
+static int64_t property__shrunk_sum[2] = {0, 0};
+static int property__runs = 0;
+
+SUITE(property) {
+    PROPERTY("generates values in range", 1000) {
+        const int64_t i = unit_gen_int(-5, 7);
+        const double d = unit_gen_double(-1.0, 0.5);
+        char str[16];
+        const size_t len = unit_gen_str(str, sizeof str, "ab");
+        REQUIRE_GE(i, -5);
+        REQUIRE_LE(i, 7);
+        REQUIRE_GE(d, -1.0);
+        REQUIRE_LE(d, 0.5);
+        REQUIRE_EQ(strlen(str), len);
+        REQUIRE_EQ(strspn(str, "ab"), len);
+    }
+
+    PROPERTY("insertion sort orders arrays", 1000) {
+        int a[32];
+        const size_t n = GEN_ARRAY(a, 32, (int) unit_gen_int(-100, 100));
+        property__sort(a, n);
+        REQUIRE(property__sorted(a, n));
+    }
+
+    DESCRIBE(shrinking, .failing=1) {
+        PROPERTY("finds the smallest counterexample", 1000) {
+            const int64_t x = unit_gen_int(0, 1000000);
+            property__shrunk = x;
+            REQUIRE_LT(x, 1000);
+        }
+        PROPERTY("finds the smallest zig-zagged counterexample", 1000) {
+            const int64_t x = unit_gen_int(-1000000, 1000000);
+            property__shrunk_signed = x;
+            REQUIRE_LT(x, 1000);
+        }
+        PROPERTY("finds the boundary of the sum", 1000) {
+            ++property__runs;
+            property__shrunk_sum[0] = unit_gen_int(0, 100);
+            property__shrunk_sum[1] = unit_gen_int(0, 100);
+            REQUIRE_LT(property__shrunk_sum[0] + property__shrunk_sum[1], 150);
+        }
+    }
+
+    IT("shrinks counterexamples to the boundary") {
+        // the test binary runs all suites several times
+        const int runs = property__runs;
+        property__runs = 0;
+        REQUIRE_EQ(property__shrunk, (int64_t) 1000);
+        REQUIRE_EQ(property__shrunk_signed, (int64_t) 1000);
+        REQUIRE_EQ(property__shrunk_sum[0] + property__shrunk_sum[1], (int64_t) 150);
+        REQUIRE_LT(runs, 1000);
+    }
+}
@@ -0,0 +1,77 @@
+#include <unit.h>
+
+#if (defined(__unix__) || defined(__APPLE__)) && !defined(__EMSCRIPTEN__)
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define THREADS_NUM 4
+
+static void* threads__check_range(void* arg) {
+    const int n = *(const int*) arg;
+    for (int i = 0; i < n; ++i) {
+        CHECK_GE(i, 0);
+        CHECK_EQ(i % 7 == 3, (i - 3) % 7 == 0, with_rank);
+    }
+    return NULL;
+}
+
+static void* threads__fail(void* arg) {
+    const int n = *(const int*) arg;
+    char name[16];
+    snprintf(name, sizeof name, "worker %d", n);
+    CHECK_EQ((const char*) name, "main");
+    REQUIRE_LT(n, 0);
+    return NULL;
+}
+
+static int64_t threads__shrunk = 0;
+
+static void* threads__check_small(void* arg) {
+    const int64_t x = *(const int64_t*) arg;
+    CHECK_LT(x, 1000);
+    return NULL;
+}
+
+static void threads__run(void* (* fn)(void*), int* args) {
+    pthread_t threads[THREADS_NUM];
+    for (int i = 0; i < THREADS_NUM; ++i) {
+        pthread_create(threads + i, NULL, fn, args + i);
+    }
+    for (int i = 0; i < THREADS_NUM; ++i) {
+        pthread_join(threads[i], NULL);
+    }
+}
+
+SUITE(threads) {
+    IT("asserts from spawned threads") {
+        int args[THREADS_NUM] = {1000, 2000, 3000, 4000};
+        threads__run(threads__check_range, args);
+    }
+
+    IT("reports failures of spawned threads at the test end", .failing=1) {
+        int args[THREADS_NUM] = {1, 2, 3, 4};
+        threads__run(threads__fail, args);
+        // failed `REQUIRE` in any thread skips the following assertions
+        int evaluated = 0;
+        REQUIRE(++evaluated);
+        if (evaluated != 0) exit(EXIT_FAILURE);
+    }
+
+    DESCRIBE(property, .failing=1) {
+        PROPERTY("fails the case by failures of spawned threads", 1000) {
+            int64_t x = unit_gen_int(0, 1000000);
+            threads__shrunk = x;
+            pthread_t thread;
+            pthread_create(&thread, NULL, threads__check_small, &x);
+            pthread_join(thread, NULL);
+        }
+    }
+
+    IT("shrinks the case failed by spawned threads") {
+        REQUIRE_EQ(threads__shrunk, (int64_t) 1000);
+    }
+}
+
+#endif // unix
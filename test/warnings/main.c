@@ -0,0 +1,3 @@
+#define UNIT_MAIN
+
+#include <unit.h>
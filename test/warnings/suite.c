@@ -0,0 +1,29 @@
+#include <unit.h>
+
+// node macros expand cleanly in user code built with `-Wall -Wextra -Werror`
+
+static const int warnings__rows[] = {1, 2, 3};
+
+static int warnings__flag = 0;
+
+SUITE(warnings) {
+    IT("without body");
+
+    DESCRIBE(nested) {
+        IT("without body too");
+    }
+
+    IT_EACH("row", warnings__rows, row);
+
+    IT("with `if` statement body") if (warnings__flag) { REQUIRE(0); } else { REQUIRE_EQ(warnings__flag, 0); }
+}
+
+SUITE(warnings_sign) {
+    IT("compares mixed signs without conversion warnings") {
+        const size_t n = 3;
+        const int i = -1;
+        CHECK_GT(n, -1);
+        CHECK_LT(i, n);
+        CHECK_ALL_EQ(k, 0, 3, (size_t) k, (int) k);
+    }
+}
@@ -0,0 +1,27 @@
+#define UNIT_IMPLEMENT
+
+#include <unit.h>
+
+#define UNIT_REPORT_USAGE "usage: %s [OPTIONS] FILE\n" \
+"Prints report from the events log written by test program with `--events-out=FILE` option.\n" \
+"Report options are the same as for test program: `-r=junit`, `-r=ndjson`, `-r=xml`, `--trace`, `--trace-out=FILE`\n"
+
+int main(int argc, const char** argv) {
+    struct unit_run_options options;
+    unit__setup_args(argc, argv, &options);
+    const char* path = NULL;
+    for (int i = 1; i < argc; ++i) {
+        if (argv[i][0] != '-') {
+            path = argv[i];
+        }
+    }
+    if (options.version) {
+        fputs(UNIT__MSG_VERSION, stdout);
+        return EXIT_SUCCESS;
+    }
+    if (options.help || !path) {
+        fprintf(options.help ? stdout : stderr, UNIT_REPORT_USAGE, options.program);
+        return options.help ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+    return unit_report(path, options);
+}